@@ -6,7 +6,7 @@ MAKE_COMMAND=make
 # Makefile for IFI VeX Cortex Microcontroller (STM32F103VD series)
 DEVICE=VexCortex
 # Libraries to include in the link (use -L and -l) e.g. -lm, -lmyLib
-LIBRARIES=$(ROOT)/firmware/libpros.a -lgcc -lm
+LIBRARIES=$(ROOT)/firmware/libpros.a -lgcc
 # Prefix for ARM tools (must be on the path)
 MCUPREFIX=arm-none-eabi-
 # Flags for the assembler
@@ -37,7 +37,9 @@ ARFLAGS:=$(MCUCFLAGS)
 CCFLAGS:=-c -Wall $(MCUCFLAGS) -Os -ffunction-sections -fsigned-char -fomit-frame-pointer -fsingle-precision-constant
 CFLAGS:=$(CCFLAGS) -std=gnu99 -Werror=implicit-function-declaration
 CPPFLAGS:=$(CCFLAGS) -fno-exceptions -fno-rtti -felide-constructors
-LDFLAGS:=-Wall $(MCUCFLAGS) $(MCULFLAGS) -Wl,--gc-sections
+# The serial output functions are wrapped to count their bytes (see src/uartWrap.c)
+UARTWRAP=-Wl,--wrap=fputc,--wrap=fwrite,--wrap=lcdSetText,--wrap=lcdPrint,--wrap=lcdClear
+LDFLAGS:=-Wall $(MCUCFLAGS) $(MCULFLAGS) -Wl,--gc-sections $(UARTWRAP)
 
 # Tools used in program
 AR:=$(MCUPREFIX)ar
@@ -0,0 +1,699 @@
+/** @file autontool.c
+ * @brief File for the command line tool that manages autonomous slots from a computer
+ *
+ * Talks to the serial shell on the robot (see serialShell.c) to list, pull, push and sync
+ * autonomous files, and converts autonomous files to and from CSV so that they can be looked at
+ * and edited in a spreadsheet. "pull" copies a slot from the robot to the computer (the robot's
+ * upload command) and "push" copies a file from the computer to the robot (the robot's download
+ * command).
+ */
+
+#include "link.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Number of regular autonomous slots on the robot (MAX_AUTON_SLOTS in autonrecorder.h)
+ */
+#define AUTON_SLOTS 10
+
+/**
+ * Number of programming skills sections on the robot (PROGSKILL_TIME / AUTON_TIME in autonrecorder.h)
+ */
+#define SKILLS_SECTIONS 4
+
+/**
+ * Number of slots exchanged in a sync session
+ */
+#define SYNC_SLOTS (AUTON_SLOTS + SKILLS_SECTIONS)
+
+/**
+ * Number of joystick states in an autonomous file (AUTON_TIME * JOY_POLL_FREQ in autonrecorder.h)
+ */
+#define AUTON_STATES 750
+
+/**
+ * Number of bytes in each joystick state of an autonomous file
+ */
+#define AUTON_STATE_SIZE 5
+
+/**
+ * Number of bytes in an autonomous file
+ */
+#define AUTON_FILE_SIZE (AUTON_STATES * AUTON_STATE_SIZE)
+
+/**
+ * Largest file that can be sent in a transfer (the size field is 2 bytes)
+ */
+#define MAX_FILE_SIZE 65535
+
+/**
+ * Line printed by the robot before and after the bytes of a text upload
+ */
+#define TEXT_UPLOAD_MARKER "----------"
+
+/**
+ * Start of the line printed by the robot when it is ready for the bytes of a text download
+ */
+#define TEXT_DOWNLOAD_PROMPT "Please input"
+
+/**
+ * Start of the line printed by the robot when it is ready for the frames of a binary download
+ */
+#define BINARY_DOWNLOAD_PROMPT "Waiting for binary"
+
+/**
+ * Number of milliseconds to wait for each byte of a text upload
+ */
+#define TEXT_BYTE_TIMEOUT 2000
+
+/**
+ * Number of milliseconds to wait for the robot to start sending a stream
+ */
+#define STREAM_START_TIMEOUT 10000
+
+/**
+ * The contents of a file being transferred
+ */
+typedef struct transfer_file {
+	/**
+	 * The bytes of the file
+	 */
+	uint8_t data[MAX_FILE_SIZE];
+
+	/**
+	 * The number of bytes in the file
+	 */
+	int size;
+
+	/**
+	 * The number of bytes that have been sent or received
+	 */
+	int offset;
+
+	/**
+	 * The running CRC of the bytes that have been sent or received
+	 */
+	uint32_t crc;
+} transfer_file;
+
+/**
+ * The file of a single slot transfer
+ */
+static transfer_file single;
+
+/**
+ * The state of one slot during a sync session
+ */
+typedef struct sync_slot {
+	/**
+	 * Whether or not the slot holds a file on the robot
+	 */
+	bool onRobot;
+
+	/**
+	 * The size of the file on the robot
+	 */
+	int robotSize;
+
+	/**
+	 * The CRC-32 of the file on the robot
+	 */
+	uint32_t robotCrc;
+
+	/**
+	 * The planned action (SYNC_SEND, SYNC_RECEIVE, SYNC_REMOVE), or SYNC_EMPTY for none
+	 */
+	uint8_t action;
+
+	/**
+	 * The file in the sync directory
+	 */
+	transfer_file file;
+
+	/**
+	 * Whether or not the slot holds a file in the sync directory
+	 */
+	bool local;
+} sync_slot;
+
+/**
+ * Every slot of a sync session
+ */
+static sync_slot syncSlots[SYNC_SLOTS];
+
+/**
+ * Whether or not every planned slot has been handled
+ */
+static bool syncPlanSent;
+
+/**
+ * The slot whose data is being sent in a sync session
+ */
+static int syncIndex;
+
+/**
+ * Reads a whole file into a transfer_file
+ *
+ * @param path The path of the file
+ * @param file The transfer_file to read into
+ *
+ * @return true if the file was read, false if it does not exist or is too large
+ */
+static bool readFile(const char* path, transfer_file* file) {
+	FILE* in = fopen(path, "rb");
+	if (in == NULL) {
+		return false;
+	}
+	file->size = fread(file->data, 1, MAX_FILE_SIZE, in);
+	bool tooLarge = fgetc(in) != EOF;
+	fclose(in);
+	if (tooLarge) {
+		fprintf(stderr, "%s is too large to transfer.\n", path);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Writes bytes to a file, replacing it
+ *
+ * @param path The path of the file
+ * @param data The bytes to write
+ * @param size The number of bytes
+ *
+ * @return true if the file was written, false otherwise
+ */
+static bool writeFile(const char* path, const uint8_t* data, int size) {
+	FILE* out = fopen(path, "wb");
+	if (out == NULL) {
+		perror(path);
+		return false;
+	}
+	bool success = fwrite(data, 1, size, out) == (size_t) size;
+	success = (fclose(out) == 0) && success;
+	if (!success) {
+		perror(path);
+	}
+	return success;
+}
+
+/**
+ * Gets the name of the file that backs a slot index of a sync session
+ *
+ * @param index The slot index (0 - 9 for a1 - a10, 10 - 13 for p0 - p3)
+ * @param name The buffer to write the name into (at least 4 bytes)
+ */
+static void syncSlotName(int index, char* name) {
+	if (index < AUTON_SLOTS) {
+		sprintf(name, "a%d", index + 1);
+	} else {
+		sprintf(name, "p%d", index - AUTON_SLOTS);
+	}
+}
+
+/**
+ * Lists every slot on the robot
+ */
+static bool listSlots() {
+	linkCommand("list");
+	return linkFinish(true);
+}
+
+/**
+ * Handles the frames of a binary upload from the robot
+ */
+static int pullSink(const frame_decoder* frame) {
+	if (frame->type == FRAME_BEGIN && frame->length >= 2) {
+		single.size = frame->payload[0] | (frame->payload[1] << 8);
+		single.offset = 0;
+		single.crc = 0xFFFF;
+		return 1;
+	} else if (frame->type == FRAME_DATA && single.offset + frame->length <= single.size) {
+		memcpy(single.data + single.offset, frame->payload, frame->length);
+		single.crc = frameCrc16(single.crc, frame->payload, frame->length);
+		single.offset += frame->length;
+		return 1;
+	} else if (frame->type == FRAME_END && frame->length >= 2 && single.offset == single.size) {
+		if ((frame->payload[0] | (frame->payload[1] << 8)) != single.crc) {
+			fprintf(stderr, "The file from the robot failed its CRC check.\n");
+			return -1;
+		}
+		return 0;
+	}
+	fprintf(stderr, "Unexpected frame %c %d from the robot.\n", frame->type, frame->seq);
+	return -1;
+}
+
+/**
+ * Copies a slot from the robot to a file on the computer
+ *
+ * @param slot The slot, as typed into the robot's shell
+ * @param path The file to write
+ * @param text Whether or not to use the text transfer instead of the binary one
+ */
+static bool pullSlot(const char* slot, const char* path, bool text) {
+	char command[64];
+	snprintf(command, sizeof(command), text ? "upload %s" : "upload %s bin", slot);
+	linkCommand(command);
+
+	if (text) {
+		char line[LINK_LINE_MAX_LENGTH];
+		do {
+			if (!linkReadLine(line, LINK_COMMAND_TIMEOUT) || strncmp(line, "ERR", 3) == 0) {
+				fprintf(stderr, "The robot did not start the upload%s%s.\n", line[0] ? ": " : "", line);
+				return false;
+			}
+		} while (strcmp(line, TEXT_UPLOAD_MARKER) != 0);
+
+		for (single.size = 0; single.size < AUTON_FILE_SIZE; single.size++) {
+			int c = linkReadByte(TEXT_BYTE_TIMEOUT);
+			if (c < 0) {
+				fprintf(stderr, "The upload ended after %d bytes.\n", single.size);
+				return false;
+			}
+			single.data[single.size] = c;
+		}
+	} else if (!linkReceiveStream(&pullSink, STREAM_START_TIMEOUT)) {
+		linkFinish(false);
+		return false;
+	}
+	return linkFinish(false) && writeFile(path, single.data, single.size);
+}
+
+/**
+ * Builds the frames of a binary download to the robot: BEGIN, the data blocks, then END
+ */
+static int pushSource(uint8_t* type, uint8_t* payload, uint16_t* length) {
+	if (single.offset < 0) {
+		payload[0] = single.size & 0xFF;
+		payload[1] = single.size >> 8;
+		*type = FRAME_BEGIN;
+		*length = 2;
+		single.offset = 0;
+	} else if (single.offset < single.size) {
+		int blockLength = single.size - single.offset;
+		if (blockLength > TRANSFER_BLOCK_SIZE) {
+			blockLength = TRANSFER_BLOCK_SIZE;
+		}
+		memcpy(payload, single.data + single.offset, blockLength);
+		single.crc = frameCrc16(single.crc, payload, blockLength);
+		*type = FRAME_DATA;
+		*length = blockLength;
+		single.offset += blockLength;
+	} else if (single.offset == single.size) {
+		payload[0] = single.crc & 0xFF;
+		payload[1] = (single.crc >> 8) & 0xFF;
+		*type = FRAME_END;
+		*length = 2;
+		single.offset++;
+	} else {
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * Copies a file from the computer to a slot on the robot
+ *
+ * @param slot The slot, as typed into the robot's shell
+ * @param path The file to send
+ * @param text Whether or not to use the text transfer instead of the binary one
+ */
+static bool pushSlot(const char* slot, const char* path, bool text) {
+	if (!readFile(path, &single)) {
+		fprintf(stderr, "Could not read %s.\n", path);
+		return false;
+	} else if (single.size != AUTON_FILE_SIZE) {
+		fprintf(stderr, "%s is %d bytes, but an autonomous file is %d bytes.\n", path, single.size, AUTON_FILE_SIZE);
+		return false;
+	}
+
+	char command[64];
+	snprintf(command, sizeof(command), text ? "download %s" : "download %s bin", slot);
+	linkCommand(command);
+
+	// Wait for the robot to be ready, or the file would be read by the shell as a command if the download failed to start
+	const char* prompt = text ? TEXT_DOWNLOAD_PROMPT : BINARY_DOWNLOAD_PROMPT;
+	char line[LINK_LINE_MAX_LENGTH];
+	do {
+		if (!linkReadLine(line, LINK_COMMAND_TIMEOUT) || strncmp(line, "ERR", 3) == 0) {
+			fprintf(stderr, "The robot did not start the download%s%s.\n", line[0] ? ": " : "", line);
+			return false;
+		}
+	} while (strncmp(line, prompt, strlen(prompt)) != 0);
+
+	if (text) {
+		linkWrite(single.data, single.size);
+	} else {
+		single.offset = -1;
+		single.crc = 0xFFFF;
+		if (!linkSendStream(&pushSource)) {
+			linkFinish(false);
+			return false;
+		}
+	}
+	return linkFinish(false);
+}
+
+/**
+ * Handles the manifest that starts a sync session
+ */
+static int manifestSink(const frame_decoder* frame) {
+	if (frame->type != FRAME_MANIFEST) {
+		fprintf(stderr, "Expected a manifest from the robot.\n");
+		return -1;
+	}
+	for (int i = 0; i + SYNC_ENTRY_SIZE <= frame->length; i += SYNC_ENTRY_SIZE) {
+		const uint8_t* entry = frame->payload + i;
+		if (entry[0] < SYNC_SLOTS) {
+			sync_slot* slot = &syncSlots[entry[0]];
+			slot->onRobot = entry[1] == SYNC_PRESENT;
+			slot->robotSize = entry[2] | (entry[3] << 8);
+			slot->robotCrc = entry[4] | (entry[5] << 8) | ((uint32_t) entry[6] << 16) | ((uint32_t) entry[7] << 24);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Builds the frames sent to the robot in a sync session: the plan, the slots the robot receives, then END
+ */
+static int planSource(uint8_t* type, uint8_t* payload, uint16_t* length) {
+	if (!syncPlanSent) {
+		*length = 0;
+		for (int index = 0; index < SYNC_SLOTS; index++) {
+			sync_slot* slot = &syncSlots[index];
+			if (slot->action != SYNC_EMPTY) {
+				uint8_t* entry = payload + *length;
+				int size = (slot->action == SYNC_RECEIVE) ? slot->file.size : slot->robotSize;
+				uint32_t crc = (slot->action == SYNC_RECEIVE) ? slot->file.crc : slot->robotCrc;
+				entry[0] = index;
+				entry[1] = slot->action;
+				entry[2] = size & 0xFF;
+				entry[3] = size >> 8;
+				for (int i = 0; i < 4; i++) {
+					entry[4 + i] = (crc >> (8 * i)) & 0xFF;
+				}
+				*length += SYNC_ENTRY_SIZE;
+			}
+		}
+		*type = FRAME_PLAN;
+		syncPlanSent = true;
+		syncIndex = 0;
+		return 1;
+	}
+
+	while (syncIndex < SYNC_SLOTS && (syncSlots[syncIndex].action != SYNC_RECEIVE ||
+			syncSlots[syncIndex].file.offset >= syncSlots[syncIndex].file.size)) {
+		syncIndex++;
+	}
+	if (syncIndex > SYNC_SLOTS) {
+		return 0;
+	} else if (syncIndex == SYNC_SLOTS) {
+		*type = FRAME_END;
+		*length = 0;
+		syncIndex++;
+		return 1;
+	}
+
+	transfer_file* file = &syncSlots[syncIndex].file;
+	int blockLength = file->size - file->offset;
+	if (blockLength > TRANSFER_BLOCK_SIZE) {
+		blockLength = TRANSFER_BLOCK_SIZE;
+	}
+	payload[0] = syncIndex;
+	payload[1] = file->offset & 0xFF;
+	payload[2] = file->offset >> 8;
+	memcpy(payload + SYNC_DATA_HEADER, file->data + file->offset, blockLength);
+	*type = FRAME_DATA;
+	*length = SYNC_DATA_HEADER + blockLength;
+	file->offset += blockLength;
+	return 1;
+}
+
+/**
+ * Handles the slots sent by the robot at the end of a sync session
+ */
+static int syncReceiveSink(const frame_decoder* frame) {
+	if (frame->type == FRAME_END) {
+		return 0;
+	} else if (frame->type != FRAME_DATA || frame->length < SYNC_DATA_HEADER || frame->payload[0] >= SYNC_SLOTS) {
+		fprintf(stderr, "Unexpected frame %c %d from the robot.\n", frame->type, frame->seq);
+		return -1;
+	}
+
+	sync_slot* slot = &syncSlots[frame->payload[0]];
+	int offset = frame->payload[1] | (frame->payload[2] << 8);
+	int length = frame->length - SYNC_DATA_HEADER;
+	if (slot->action != SYNC_SEND || offset != slot->file.offset || offset + length > MAX_FILE_SIZE) {
+		fprintf(stderr, "Unexpected data for slot %d from the robot.\n", frame->payload[0]);
+		return -1;
+	}
+	memcpy(slot->file.data + offset, frame->payload + SYNC_DATA_HEADER, length);
+	slot->file.offset += length;
+	return 1;
+}
+
+/**
+ * Runs a sync session that makes either the robot or a directory match the other
+ *
+ * @param direction "push" to make the robot match the directory, or "pull" to make the directory match the robot
+ * @param directory The directory holding a1 - a10 and p0 - p3
+ */
+static bool syncSlotsWith(const char* direction, const char* directory) {
+	bool push = strcmp(direction, "push") == 0;
+	if (!push && strcmp(direction, "pull") != 0) {
+		fprintf(stderr, "Sync direction must be push or pull.\n");
+		return false;
+	}
+
+	for (int index = 0; index < SYNC_SLOTS; index++) {
+		char name[8];
+		char path[4096];
+		syncSlotName(index, name);
+		snprintf(path, sizeof(path), "%s/%s", directory, name);
+		sync_slot* slot = &syncSlots[index];
+		slot->local = readFile(path, &slot->file);
+		slot->file.crc = slot->local ? frameCrc32(0, slot->file.data, slot->file.size) : 0;
+		slot->file.offset = 0;
+		slot->action = SYNC_EMPTY;
+		if (push && slot->local && slot->file.size != AUTON_FILE_SIZE) {
+			// The robot would refuse the whole plan, so the session is not started
+			fprintf(stderr, "%s is %d bytes, but an autonomous file is %d bytes.\n", path, slot->file.size, AUTON_FILE_SIZE);
+			return false;
+		}
+	}
+
+	linkCommand("sync");
+	if (!linkReceiveStream(&manifestSink, STREAM_START_TIMEOUT)) {
+		linkFinish(false);
+		return false;
+	}
+
+	int changes = 0;
+	for (int index = 0; index < SYNC_SLOTS; index++) {
+		sync_slot* slot = &syncSlots[index];
+		bool same = slot->local && slot->onRobot && slot->file.size == slot->robotSize && slot->file.crc == slot->robotCrc;
+		if (same || (!slot->local && !slot->onRobot)) {
+			continue;
+		} else if (push) {
+			slot->action = slot->local ? SYNC_RECEIVE : SYNC_REMOVE;
+		} else if (slot->onRobot) {
+			slot->action = SYNC_SEND;
+			slot->file.size = slot->robotSize;
+		} else {
+			// Removing a file from the directory does not involve the robot
+			char name[8];
+			char path[4096];
+			syncSlotName(index, name);
+			snprintf(path, sizeof(path), "%s/%s", directory, name);
+			if (unlink(path) != 0) {
+				perror(path);
+			}
+			printf("%s: removed\n", name);
+		}
+		changes++;
+	}
+
+	syncPlanSent = false;
+	if (!linkSendStream(&planSource) || !linkReceiveStream(&syncReceiveSink, STREAM_START_TIMEOUT)) {
+		linkFinish(false);
+		return false;
+	}
+
+	bool success = true;
+	for (int index = 0; index < SYNC_SLOTS; index++) {
+		sync_slot* slot = &syncSlots[index];
+		char name[8];
+		syncSlotName(index, name);
+		if (slot->action == SYNC_SEND) {
+			char path[4096];
+			snprintf(path, sizeof(path), "%s/%s", directory, name);
+			if (slot->file.offset != slot->robotSize || frameCrc32(0, slot->file.data, slot->file.offset) != slot->robotCrc) {
+				fprintf(stderr, "%s did not arrive intact.\n", name);
+				success = false;
+			} else if (writeFile(path, slot->file.data, slot->file.offset)) {
+				printf("%s: pulled (%d bytes)\n", name, slot->file.offset);
+			} else {
+				success = false;
+			}
+		} else if (slot->action == SYNC_RECEIVE) {
+			printf("%s: pushed (%d bytes)\n", name, slot->file.size);
+		} else if (slot->action == SYNC_REMOVE) {
+			printf("%s: removed from robot\n", name);
+		}
+	}
+	if (changes == 0) {
+		printf("Already in sync.\n");
+	}
+	return linkFinish(false) && success;
+}
+
+/**
+ * Converts an autonomous file to CSV with one row per joystick state
+ *
+ * @param inPath The autonomous file
+ * @param outPath The CSV file to write
+ */
+static bool autonToCsv(const char* inPath, const char* outPath) {
+	if (!readFile(inPath, &single)) {
+		fprintf(stderr, "Could not read %s.\n", inPath);
+		return false;
+	} else if (single.size % AUTON_STATE_SIZE != 0) {
+		fprintf(stderr, "%s is not a whole number of joystick states.\n", inPath);
+		return false;
+	}
+
+	FILE* out = fopen(outPath, "w");
+	if (out == NULL) {
+		perror(outPath);
+		return false;
+	}
+	fprintf(out, "state,spd,horizontal,turn,sht,lift\n");
+	for (int i = 0; i < single.size / AUTON_STATE_SIZE; i++) {
+		const int8_t* state = (const int8_t*) single.data + i * AUTON_STATE_SIZE;
+		fprintf(out, "%d,%d,%d,%d,%d,%d\n", i, state[0], state[1], state[2], state[3], state[4]);
+	}
+	return fclose(out) == 0;
+}
+
+/**
+ * Converts a CSV file with one row per joystick state back to an autonomous file
+ * Missing states at the end are filled with zeros (the robot standing still).
+ *
+ * @param inPath The CSV file, with a header row and the columns state,spd,horizontal,turn,sht,lift
+ * @param outPath The autonomous file to write
+ */
+static bool csvToAuton(const char* inPath, const char* outPath) {
+	FILE* in = fopen(inPath, "r");
+	if (in == NULL) {
+		perror(inPath);
+		return false;
+	}
+
+	memset(single.data, 0, AUTON_FILE_SIZE);
+	char line[256];
+	int lineNumber = 0;
+	int states = 0;
+	bool success = true;
+	while (success && fgets(line, sizeof(line), in) != NULL) {
+		lineNumber++;
+		int values[6];
+		if (sscanf(line, "%d,%d,%d,%d,%d,%d", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]) != 6) {
+			if (lineNumber == 1 || line[strspn(line, " \t\r\n")] == 0) {
+				continue;
+			}
+			fprintf(stderr, "%s:%d: expected state,spd,horizontal,turn,sht,lift\n", inPath, lineNumber);
+			success = false;
+		} else if (values[0] != states || states >= AUTON_STATES) {
+			fprintf(stderr, "%s:%d: expected state %d of %d\n", inPath, lineNumber, states, AUTON_STATES);
+			success = false;
+		} else {
+			for (int i = 1; i < 6; i++) {
+				if (values[i] < -128 || values[i] > 127) {
+					fprintf(stderr, "%s:%d: %d does not fit in a joystick value\n", inPath, lineNumber, values[i]);
+					success = false;
+				}
+				single.data[states * AUTON_STATE_SIZE + i - 1] = (uint8_t) values[i];
+			}
+			states++;
+		}
+	}
+	fclose(in);
+	return success && writeFile(outPath, single.data, AUTON_FILE_SIZE);
+}
+
+/**
+ * Prints how to use the tool
+ */
+static void printUsage() {
+	fprintf(stderr,
+		"Usage: autontool [-p port] [-v] command\n"
+		"  list                        list the slots on the robot\n"
+		"  pull <slot> <file> [text]   copy a slot from the robot to a file\n"
+		"  push <slot> <file> [text]   copy a file to a slot on the robot\n"
+		"  sync push|pull <directory>  make the robot or the directory (a1-a10, p0-p3) match the other\n"
+		"  tocsv <file> <csv>          convert an autonomous file to CSV\n"
+		"  fromcsv <csv> <file>        convert CSV to an autonomous file\n"
+		"Slots are 1-10, a1-a10 or p0-p3. The port defaults to $AUTONTOOL_PORT or /dev/ttyACM0.\n");
+}
+
+int main(int argc, char** argv) {
+	const char* port = getenv("AUTONTOOL_PORT");
+	if (port == NULL) {
+		port = "/dev/ttyACM0";
+	}
+	int option;
+	while ((option = getopt(argc, argv, "p:v")) != -1) {
+		if (option == 'p') {
+			port = optarg;
+		} else if (option == 'v') {
+			linkVerbose = true;
+		} else {
+			printUsage();
+			return 2;
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc < 1) {
+		printUsage();
+		return 2;
+	}
+
+	const char* command = argv[0];
+	if (strcmp(command, "tocsv") == 0 && argc == 3) {
+		return autonToCsv(argv[1], argv[2]) ? 0 : 1;
+	} else if (strcmp(command, "fromcsv") == 0 && argc == 3) {
+		return csvToAuton(argv[1], argv[2]) ? 0 : 1;
+	}
+
+	bool list = strcmp(command, "list") == 0;
+	bool text = argc == 4 && strcmp(argv[3], "text") == 0;
+	if (list ? argc != 1 : (strcmp(command, "pull") != 0 && strcmp(command, "push") != 0 && strcmp(command, "sync") != 0)) {
+		printUsage();
+		return 2;
+	} else if (!list && argc != 3 && !(text && strcmp(command, "sync") != 0)) {
+		printUsage();
+		return 2;
+	}
+
+	if (!linkOpen(port)) {
+		return 1;
+	}
+	bool success;
+	if (list) {
+		success = listSlots();
+	} else if (strcmp(command, "pull") == 0) {
+		success = pullSlot(argv[1], argv[2], text);
+	} else if (strcmp(command, "push") == 0) {
+		success = pushSlot(argv[1], argv[2], text);
+	} else {
+		success = syncSlotsWith(argv[1], argv[2]);
+	}
+	linkClose();
+	return success ? 0 : 1;
+}
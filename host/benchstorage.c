@@ -0,0 +1,303 @@
+/** @file benchstorage.c
+ * @brief File for the storage benchmark of the autonomous recorder
+ *
+ * Runs the recorder's save, load, playback, programming skills stitching and serial transfer
+ * paths on the simulated PROS API with flash and serial costs charged to the virtual clock, and
+ * prints for each one the robot time it took, how much of that went to flash and to serial
+ * output (the rest is sleeping), the operations it made and the bytes it moved.
+ *
+ * Usage: benchstorage [-z] [-c cost=nanoseconds]...
+ * -z starts from free flash and serial instead of the Cortex estimates in simCortexIoCosts, and
+ * -c changes one cost (for example -c serialByte=0 to see the time without logging).
+ */
+
+#include "main.h"
+#include "frame.h"
+#include "serialTransfer.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Number of bytes in an autonomous file
+ */
+#define BENCH_FILE_SIZE (AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE)
+
+/**
+ * The computer's end of the serial monitor
+ */
+static int peerFd = -1;
+
+/**
+ * Decoder for the frames the robot sends to the computer
+ */
+static frame_decoder peerDecoder;
+
+/**
+ * Prints a line of the report to standard output
+ *
+ * @param format The format string, as for printf
+ */
+static void report(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (write(STDOUT_FILENO, line, MIN(length, (int) sizeof(line) - 1)) < 0) {
+		exit(1);
+	}
+}
+
+/**
+ * Reads what the robot printed and acknowledges every frame it sent, as autontool would
+ */
+static void answerRobot() {
+	uint8_t data[1024];
+	ssize_t length;
+	while ((length = read(peerFd, data, sizeof(data))) > 0) {
+		for (int i = 0; i < length; i++) {
+			if (frameDecoderFeed(&peerDecoder, data[i]) == FRAME_READY &&
+					peerDecoder.type != FRAME_ACK && peerDecoder.type != FRAME_NAK) {
+				uint8_t ack[FRAME_HEADER_LENGTH + FRAME_CRC_LENGTH];
+				simSerialInput(ack, frameEncode(ack, FRAME_ACK, peerDecoder.seq, NULL, 0));
+			}
+		}
+	}
+}
+
+/**
+ * Fills a buffer with a random autonomous file
+ *
+ * @param data The buffer, BENCH_FILE_SIZE bytes long
+ */
+static void randomFile(uint8_t* data) {
+	for (int i = 0; i < BENCH_FILE_SIZE; i++) {
+		data[i] = rand();
+	}
+}
+
+/**
+ * Fills the states array with a random routine
+ */
+static void randomStates() {
+	randomFile((uint8_t*) states);
+}
+
+/**
+ * Saves a random routine to slot 1
+ */
+static void saveSlot() {
+	randomStates();
+	saveAutonToSlot(1);
+}
+
+/**
+ * Loads slot 1
+ */
+static void loadSlot() {
+	autonLoaded = 0;
+	loadAuton(1);
+}
+
+/**
+ * Plays back the loaded slot
+ */
+static void playSlot() {
+	playbackAuton();
+}
+
+/**
+ * Fills the programming skills sections with random routines and loads the first one
+ */
+static void loadSkills() {
+	uint8_t data[BENCH_FILE_SIZE];
+	for (int section = 0; section < PROGSKILL_TIME / AUTON_TIME; section++) {
+		char filename[AUTON_FILENAME_MAX_LENGTH];
+		snprintf(filename, sizeof(filename), "p%d", section);
+		randomFile(data);
+		simFlashWrite(filename, data, sizeof(data));
+	}
+	autonLoaded = 0;
+	loadAuton(MAX_AUTON_SLOTS + 1);
+}
+
+/**
+ * Plays back programming skills, loading each following section while the one before plays
+ */
+static void playSkills() {
+	playbackAuton();
+}
+
+/**
+ * Sends slot 1 to the computer as text
+ */
+static void uploadText() {
+	uploadAutonToComputer(1);
+}
+
+/**
+ * Receives a random routine into slot 2 as text
+ */
+static void downloadText() {
+	uint8_t data[BENCH_FILE_SIZE];
+	randomFile(data);
+	simSerialInput(data, sizeof(data));
+	downloadAutonFromComputer(2);
+}
+
+/**
+ * Sends slot 1 to the computer as frames
+ */
+static void uploadBinary() {
+	uploadAutonBinary(1);
+}
+
+/**
+ * Receives a random routine into slot 2 as frames
+ */
+static void downloadBinary() {
+	uint8_t data[BENCH_FILE_SIZE];
+	uint8_t frame[FRAME_MAX_LENGTH];
+	uint8_t seq = 0;
+	uint8_t header[2] = { BENCH_FILE_SIZE & 0xFF, BENCH_FILE_SIZE >> 8 };
+	randomFile(data);
+	simSerialInput(frame, frameEncode(frame, FRAME_BEGIN, seq++, header, 2));
+	for (int offset = 0; offset < BENCH_FILE_SIZE; offset += TRANSFER_BLOCK_SIZE) {
+		simSerialInput(frame, frameEncode(frame, FRAME_DATA, seq++, data + offset, MIN(TRANSFER_BLOCK_SIZE, BENCH_FILE_SIZE - offset)));
+	}
+	uint16_t crc = frameCrc16(0xFFFF, data, sizeof(data));
+	uint8_t footer[2] = { crc & 0xFF, crc >> 8 };
+	simSerialInput(frame, frameEncode(frame, FRAME_END, seq++, footer, 2));
+	downloadAutonBinary(2);
+}
+
+/**
+ * An operation of the benchmark
+ */
+typedef struct bench_operation {
+	/**
+	 * The name printed in the report
+	 */
+	const char* name;
+
+	/**
+	 * The function that runs the operation
+	 */
+	void (*run)();
+} bench_operation;
+
+/**
+ * Every operation, in the order they run (later ones use the files made by earlier ones)
+ */
+static const bench_operation operations[] = {
+	{ "save", &saveSlot },
+	{ "load", &loadSlot },
+	{ "playback", &playSlot },
+	{ "skills load", &loadSkills },
+	{ "skills playback", &playSkills },
+	{ "text upload", &uploadText },
+	{ "text download", &downloadText },
+	{ "binary upload", &uploadBinary },
+	{ "binary download", &downloadBinary },
+};
+
+/**
+ * Runs an operation and prints a row of the report
+ *
+ * @param operation The operation
+ */
+static void measure(const bench_operation* operation) {
+	struct timespec hostStart, hostEnd;
+	simResetIoStats();
+	uint64_t start = simMicros();
+	clock_gettime(CLOCK_MONOTONIC, &hostStart);
+	operation->run();
+	clock_gettime(CLOCK_MONOTONIC, &hostEnd);
+	uint64_t robotTime = simMicros() - start;
+	long hostTime = (hostEnd.tv_sec - hostStart.tv_sec) * 1000000L + (hostEnd.tv_nsec - hostStart.tv_nsec) / 1000;
+
+	sim_io_stats stats;
+	simGetIoStats(&stats);
+	uint64_t sleepTime = robotTime - MIN(robotTime, stats.flashTime + stats.serialTime);
+	report("%-16s %9.1f %9.1f %9.1f %9.1f %5lu %5lu %5lu %6lu %6lu %7lu %5lu %7lu %8ld\n", operation->name,
+			robotTime / 1000.0, stats.flashTime / 1000.0, stats.serialTime / 1000.0, sleepTime / 1000.0,
+			stats.flashOpens, stats.flashSeeks, stats.flashReads, stats.flashBytesRead, stats.flashWrites,
+			stats.flashBytesWritten, stats.flashPagesErased, stats.serialBytesOut, hostTime);
+}
+
+/**
+ * Changes one cost of the model
+ *
+ * @param costs The costs
+ * @param setting The "name=nanoseconds" setting
+ *
+ * @return true if the setting named a cost, false otherwise
+ */
+static bool setCost(sim_io_costs* costs, const char* setting) {
+	static const struct {
+		const char* name;
+		size_t offset;
+	} names[] = {
+		{ "flashOpen", offsetof(sim_io_costs, flashOpen) },
+		{ "flashClose", offsetof(sim_io_costs, flashClose) },
+		{ "flashErase", offsetof(sim_io_costs, flashErase) },
+		{ "flashSeek", offsetof(sim_io_costs, flashSeek) },
+		{ "flashCall", offsetof(sim_io_costs, flashCall) },
+		{ "flashReadByte", offsetof(sim_io_costs, flashReadByte) },
+		{ "flashWriteByte", offsetof(sim_io_costs, flashWriteByte) },
+		{ "serialCall", offsetof(sim_io_costs, serialCall) },
+		{ "serialByte", offsetof(sim_io_costs, serialByte) },
+	};
+	const char* value = strchr(setting, '=');
+	for (size_t i = 0; value != NULL && i < sizeof(names) / sizeof(names[0]); i++) {
+		if (strlen(names[i].name) == (size_t) (value - setting) && strncmp(names[i].name, setting, value - setting) == 0) {
+			*(unsigned long*) ((char*) costs + names[i].offset) = strtoul(value + 1, NULL, 10);
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char** argv) {
+	sim_io_costs costs = simCortexIoCosts;
+	int option;
+	while ((option = getopt(argc, argv, "zc:")) != -1) {
+		if (option == 'z') {
+			memset(&costs, 0, sizeof(costs));
+		} else if (option != 'c' || !setCost(&costs, optarg)) {
+			simLog("Usage: benchstorage [-z] [-c cost=nanoseconds]...");
+			return 2;
+		}
+	}
+	simSetIoCosts(&costs);
+
+	int serial[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, serial);
+	peerFd = serial[1];
+	fcntl(peerFd, F_SETFL, O_NONBLOCK);
+	frameDecoderReset(&peerDecoder);
+	simSerialOpen(serial[0]);
+	simAddTickHook(&answerRobot);
+	srand(750);
+	initAutonRecorder();
+
+	report("Costs (ns): open %lu, close %lu, erase %lu, seek %lu, call %lu, read byte %lu, write byte %lu, "
+			"serial call %lu, serial byte %lu\n", costs.flashOpen, costs.flashClose, costs.flashErase, costs.flashSeek,
+			costs.flashCall, costs.flashReadByte, costs.flashWriteByte, costs.serialCall, costs.serialByte);
+	report("%-16s %9s %9s %9s %9s %5s %5s %5s %6s %6s %7s %5s %7s %8s\n", "operation", "robot ms", "flash ms",
+			"serial ms", "sleep ms", "opens", "seeks", "reads", "read B", "writes", "write B", "erase",
+			"out B", "host us");
+	for (size_t i = 0; i < sizeof(operations) / sizeof(operations[0]); i++) {
+		measure(&operations[i]);
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+/** @file benchtick.c
+ * @brief File for the benchmark of the functions that run every tick of the robot program
+ *
+ * Times the functions in benchCases (benchmark.h) against the simulated PROS API with the
+ * computer's clock, the same way the "Benchmark" LCD menu times them on the Cortex with micros().
+ * The joystick holds the stick part way over, so every input curve gives a non-zero output. The
+ * results are for this computer: use them to compare changes, and the LCD menu for Cortex times.
+ *
+ * Usage: benchtick [-n calls]
+ * -n sets the number of calls per round (BENCH_ROUNDS rounds of each function).
+ */
+
+#include "main.h"
+#include "sim.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Prints a line of the report to standard output
+ *
+ * @param format The format string, as for printf
+ */
+static void report(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (write(STDOUT_FILENO, line, MIN(length, (int) sizeof(line) - 1)) < 0) {
+		exit(1);
+	}
+}
+
+/**
+ * Gets the time on this computer
+ *
+ * @return the monotonic time in nanoseconds
+ */
+static uint64_t hostClock() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+	unsigned int calls = 200000;
+	int option;
+	while ((option = getopt(argc, argv, "n:")) != -1) {
+		if (option == 'n') {
+			calls = MAX(1, strtoul(optarg, NULL, 10));
+		} else {
+			simLog("Usage: benchtick [-n calls]");
+			return 2;
+		}
+	}
+
+	simSerialOpen(-1);
+	initInputCurves();
+	initLCDMenu();
+	simJoystickSetAnalog(1, 3, 60);
+	simJoystickSetAnalog(1, 4, 100);
+	simJoystickSetAnalog(1, 1, -30);
+
+	report("%d rounds of %u calls per function, on this computer\n", BENCH_ROUNDS, calls);
+	report("%-18s %12s %12s %12s %12s\n", "function", "ns/call", "deviation", "min", "max");
+	double tick = 0;
+	for (int i = 0; i < BENCH_CASES; i++) {
+		const bench_case* benchCase = &benchCases[i];
+		bench_result result;
+		benchMeasure(benchCase, calls, &hostClock, &result);
+		report("%-18s %12.1f %12.1f %12.1f %12.1f\n", benchCase->name, result.mean / 10.0, result.deviation / 10.0,
+				result.min / 10.0, result.max / 10.0);
+		if (strcmp(benchCase->name, "recordJoyInfo") == 0 || strcmp(benchCase->name, "moveRobot") == 0 ||
+				strcmp(benchCase->name, "updateLCDMenu") == 0) {
+			tick += result.mean / 10.0;
+		}
+	}
+	report("Operator control tick (recordJoyInfo, moveRobot and updateLCDMenu): %.1f ns\n", tick);
+	return 0;
+}
@@ -0,0 +1,880 @@
+/** @file checksim.c
+ * @brief File for the checks of the simulated PROS API and its virtual clock
+ *
+ * Each check runs a few tasks on the virtual clock and compares what happened with what the
+ * firmware would do. The last checks boot the whole robot program and drive it through the
+ * joystick and serial monitor, and the drivetrain model is checked against simple moves.
+ *
+ * Usage: checksim
+ */
+
+#include "main.h"
+#include "mecanum.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Whether or not any check has failed
+ */
+static bool failed = false;
+
+/**
+ * Times recorded by the tasks of a check
+ */
+static unsigned long times[8];
+
+/**
+ * Number of entries in times
+ */
+static int numTimes = 0;
+
+/**
+ * What the second LCD line shows when the file to pick is selected, or empty to pick the first
+ */
+static char lcdChoice[SIM_LCD_LINE_LENGTH] = "";
+
+/**
+ * The LCD buttons held down while the robot is not asking for a file
+ */
+static unsigned int lcdPress = 0;
+
+/**
+ * Milliseconds that the robot has spent playing back
+ */
+static unsigned long playbackTime = 0;
+
+/**
+ * Height of the lift model in potentiometer counts above the bottom, and its speed in counts per second
+ */
+static double liftModelHeight = 0.0, liftModelSpeed = 0.0;
+
+/**
+ * Potentiometer reading of the lift model at the bottom, and its height at the top stop
+ */
+#define LIFT_MODEL_BOTTOM 600
+#define LIFT_MODEL_TOP 1500
+
+/**
+ * Mutex shared by the tasks of the mutex check
+ */
+static Mutex sharedMutex;
+
+/**
+ * Reports whether a check passed
+ *
+ * @param name The name of the check
+ * @param passed Whether or not the check passed
+ */
+static void check(const char* name, bool passed) {
+	simLog("%s %s", passed ? "PASS" : "FAIL", name);
+	failed |= !passed;
+}
+
+/**
+ * Records the virtual time in milliseconds
+ */
+static void recordTime() {
+	if (numTimes < 8) {
+		times[numTimes++] = millis();
+	}
+}
+
+/**
+ * Sleeps with delay() and records when it wakes up
+ *
+ * @param parameters Unused
+ */
+static void delayTask(void* parameters) {
+	delay(20);
+	recordTime();
+	delay(35);
+	recordTime();
+}
+
+/**
+ * Spends time as if busy, then runs at a fixed period and records each wake up
+ *
+ * @param parameters Unused
+ */
+static void periodicTask(void* parameters) {
+	unsigned long wakeTime = millis();
+	delayMicroseconds(7000);
+	for (int i = 0; i < 3; i++) {
+		taskDelayUntil(&wakeTime, 10);
+		recordTime();
+	}
+}
+
+/**
+ * Records its priority as the time, so the order in which tasks ran can be checked
+ *
+ * @param parameters Unused
+ */
+static void priorityTask(void* parameters) {
+	times[numTimes++] = taskPriorityGet(NULL);
+}
+
+/**
+ * Holds the shared mutex for 50 milliseconds
+ *
+ * @param parameters Unused
+ */
+static void holdMutexTask(void* parameters) {
+	mutexTake(sharedMutex, 0);
+	delay(50);
+	mutexGive(sharedMutex);
+}
+
+/**
+ * Tries to take the shared mutex, giving up after 20 milliseconds, then waits for it
+ *
+ * @param parameters Unused
+ */
+static void takeMutexTask(void* parameters) {
+	times[numTimes++] = mutexTake(sharedMutex, 20);
+	recordTime();
+	times[numTimes++] = mutexTake(sharedMutex, 1000);
+	recordTime();
+	mutexGive(sharedMutex);
+}
+
+/**
+ * Checks the virtual clock and the task functions
+ */
+static void checkTasks() {
+	unsigned long start = millis();
+	numTimes = 0;
+	taskCreate(&delayTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(100);
+	check("delay wakes up on time", numTimes == 2 && times[0] == start + 20 && times[1] == start + 55);
+	check("clock stops with simRun", millis() == start + 100);
+
+	start = millis();
+	numTimes = 0;
+	taskCreate(&periodicTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(100);
+	check("taskDelayUntil keeps its period", numTimes == 3 && times[0] == start + 10 && times[1] == start + 20 && times[2] == start + 30);
+
+	numTimes = 0;
+	taskCreate(&priorityTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	taskCreate(&priorityTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_HIGHEST);
+	taskCreate(&priorityTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_LOWEST);
+	simRun(10);
+	check("higher priority tasks run first", numTimes == 3 && times[0] == TASK_PRIORITY_HIGHEST &&
+			times[1] == TASK_PRIORITY_DEFAULT && times[2] == TASK_PRIORITY_LOWEST);
+
+	char traceFile[] = "/tmp/checksim-XXXXXX";
+	close(mkstemp(traceFile));
+	simTraceOpen(traceFile, true);
+	start = millis();
+	numTimes = 0;
+	sharedMutex = mutexCreate();
+	taskCreate(&holdMutexTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	taskCreate(&takeMutexTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(100);
+	simTraceClose();
+	check("mutexTake times out", numTimes == 4 && !times[0] && times[1] == start + 20);
+	check("mutexTake waits for mutexGive", numTimes == 4 && times[2] && times[3] == start + 50);
+	mutexDelete(sharedMutex);
+	check("finished tasks are gone", taskGetCount() == 0);
+
+	// The taking task waits for the mutex from the start, and again after its 20 ms timeout
+	char trace[65536];
+	int fd = open(traceFile, O_RDONLY);
+	int length = read(fd, trace, sizeof(trace) - 1);
+	close(fd);
+	unlink(traceFile);
+	trace[MAX(length, 0)] = 0;
+	char waitStart[80], waitEnd[80], tick[80];
+	snprintf(waitStart, sizeof(waitStart), "{\"name\":\"mutex wait\",\"ph\":\"B\",\"pid\":1,\"tid\":2,\"ts\":%lu}",
+			start * 1000);
+	snprintf(waitEnd, sizeof(waitEnd), "{\"name\":\"ready\",\"ph\":\"B\",\"pid\":1,\"tid\":2,\"ts\":%lu}",
+			(start + 50) * 1000);
+	snprintf(tick, sizeof(tick), "{\"name\":\"tick\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":0,\"ts\":%lu}",
+			(start + 100) * 1000);
+	check("trace shows mutex waits and ticks", strstr(trace, waitStart) != NULL && strstr(trace, waitEnd) != NULL &&
+			strstr(trace, tick) != NULL && strstr(trace, "\"name\":\"delay\",\"ph\":\"B\",\"pid\":1,\"tid\":1,") != NULL &&
+			length > 0 && strcmp(trace + length - 3, "]}\n") == 0);
+}
+
+/**
+ * Reads what the robot has printed on the serial monitor
+ *
+ * @param fd The computer's end of the serial monitor
+ * @param text The buffer to read into
+ * @param size The size of the buffer
+ */
+static void readSerial(int fd, char* text, int size) {
+	int length = 0;
+	int result;
+	while (length < size - 1 && (result = read(fd, text + length, size - 1 - length)) > 0) {
+		length += result;
+	}
+	text[length] = 0;
+}
+
+/**
+ * Answers the robot when it asks for a file on the LCD: presses the right button (for 40 ms at a
+ * time) until lcdChoice is shown, then the center button, and holds lcdPress otherwise
+ */
+static void answerLcd() {
+	unsigned int buttons = lcdPress;
+	if (strcmp(simLcdLine(1), "Select file") == 0) {
+		if (lcdChoice[0] == 0 || strcmp(simLcdLine(2), lcdChoice) == 0) {
+			buttons = LCD_BTN_CENTER;
+		} else if ((millis() / 40) % 2 == 0) {
+			buttons = LCD_BTN_RIGHT;
+		}
+	}
+	simLcdSetButtons(buttons);
+}
+
+/**
+ * Records the forward speed halfway through each programming skills section while the robot plays back
+ */
+static void watchPlayback() {
+	if (autonPlaying) {
+		if (playbackTime % (AUTON_TIME * 1000) == AUTON_TIME * 500 && numTimes < 8) {
+			times[numTimes++] = simMotorGet(BACK_LEFT_MOTOR);
+		}
+		playbackTime++;
+	}
+}
+
+/**
+ * Downloads slot 3 from the serial monitor, as the LCD menu's "Download Auton" does
+ *
+ * @param parameters Unused task parameter
+ */
+static void lcdDownloadTask(void* parameters) {
+	serialLock();
+	downloadAutonFromComputer(3);
+	serialUnlock();
+}
+
+/**
+ * Takes the serial monitor and waits until it is deleted, as an LCD download does when the kernel
+ * ends operator control partway
+ *
+ * @param parameters Unused task parameter
+ */
+static void serialHolderTask(void* parameters) {
+	serialLock();
+	while (true) {
+		delay(1000);
+	}
+}
+
+/**
+ * Checks the whole robot program
+ */
+static void checkRobot() {
+	int serial[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, serial);
+	fcntl(serial[1], F_SETFL, O_NONBLOCK);
+	simSerialOpen(serial[0]);
+	simAddTickHook(&answerLcd);
+	uint8_t auton[AUTON_TIME * JOY_POLL_FREQ * 5] = { 0 };
+	simFlashWrite("a2", auton, sizeof(auton));
+
+	simStartRobot(false);
+	simRun(2000);
+	check("robot reaches operator control", strcmp(simLcdLine(1), "Select file") != 0);
+
+	simJoystickSetAnalog(1, 3, 100);
+	simRun(50);
+	check("joystick drives forward", simMotorGet(FRONT_LEFT_MOTOR) == -100 && simMotorGet(BACK_LEFT_MOTOR) == 100 &&
+			simMotorGet(FRONT_RIGHT_MOTOR) == 100 && simMotorGet(BACK_RIGHT_MOTOR) == -100);
+	simJoystickSetAnalog(1, 3, 0);
+	simJoystickSetDigital(1, 6, JOY_UP, true);
+	simRun(50);
+	check("lift button drives the lift", simMotorGet(LIFT_TOP_Y_MOTOR) == MOTOR_SPEED && simMotorGet(FRONT_LEFT_MOTOR) == 0);
+	simJoystickSetDigital(1, 6, JOY_UP, false);
+
+	char text[4096];
+	readSerial(serial[1], text, sizeof(text));
+	simSerialInput("list\n", 5);
+	simRun(200);
+	readSerial(serial[1], text, sizeof(text));
+	check("serial shell lists slots and the files missing beside them", strstr(text, "a1 empty\n") != NULL &&
+			strstr(text, "a2 3750 missing track voltage heights headings\n") != NULL);
+
+	// The menu sets both LCD lines every 20 ms in operator control
+	simRun(1000);
+	simSerialInput("uart\n", 5);
+	simRun(100);
+	readSerial(serial[1], text, sizeof(text));
+	check("uart counts the LCD lines of every menu update", uartStats[0].lastSecondBytes == 2 * 1000 / 20 &&
+			uartStats[0].peakQueued == 0 && strstr(text, "\nlcd lines ") != NULL);
+	check("uart counts the serial monitor bytes", uartStats[2].bytes > strlen(text) && strstr(text, "\nstdout ") != NULL);
+
+	// A file full of line ends, which the shell would take as command lines if it read any of them
+	uint8_t download[AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE];
+	for (int i = 0; i < (int) sizeof(download); i++) {
+		download[i] = (i % 3 == 0) ? '\n' : 'a' + i % 26;
+	}
+	// Below the shell's priority and with the file arriving a little at a time, the shell gets to
+	// read whenever the download waits, as it can between any two bytes on the Cortex
+	taskCreate(&lcdDownloadTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_LOWEST);
+	simRun(100);
+	for (int offset = 0; offset < (int) sizeof(download); offset += 50) {
+		simSerialInput(download + offset, MIN(50, (int) sizeof(download) - offset));
+		simRun(5);
+	}
+	simRun(500);
+	int downloadedSize = 0;
+	const uint8_t* downloaded = simFlashRead("a3", &downloadedSize);
+	check("LCD download gets every byte past the shell", downloaded != NULL && downloadedSize == sizeof(download) &&
+			memcmp(downloaded, download, sizeof(download)) == 0);
+	simSerialInput("list\n", 5);
+	simRun(200);
+	readSerial(serial[1], text, sizeof(text));
+	check("serial shell runs again after an LCD download", strstr(text, "a3 3750 ") != NULL &&
+			strstr(text, "ERR") == NULL);
+	TaskHandle holder = taskCreate(&serialHolderTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(100);
+	simSerialInput("list\n", 5);
+	simRun(200);
+	readSerial(serial[1], text, sizeof(text));
+	bool heldOff = strstr(text, "a3 3750 ") == NULL;
+	taskDelete(holder);
+	simRun(200);
+	readSerial(serial[1], text, sizeof(text));
+	check("serial shell takes the serial monitor back from a deleted task", heldOff && strstr(text, "a3 3750 ") != NULL);
+	// Loading prints every state, more than the serial monitor holds, so it is read as it comes
+	simSerialInput("load 3\n", 7);
+	bool reported = false;
+	for (int i = 0; i < 100 && !reported; i++) {
+		simRun(100);
+		readSerial(serial[1], text, sizeof(text));
+		reported = strstr(text, "Loaded without: track voltage heights headings\nOK\n") != NULL;
+	}
+	check("serial shell load names the files a downloaded slot plays without", reported);
+
+	// Programming skills, started from operator control, with each section driving forward at its own speed
+	simSerialOpen(-1);
+	for (int section = 0; section < PROGSKILL_TIME / AUTON_TIME; section++) {
+		char filename[AUTON_FILENAME_MAX_LENGTH];
+		snprintf(filename, sizeof(filename), "p%d", section);
+		for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+			auton[i * 5] = 20 * (section + 1);
+		}
+		simFlashWrite(filename, auton, sizeof(auton));
+	}
+	snprintf(lcdChoice, sizeof(lcdChoice), "Programming skills");
+	numTimes = 0;
+	simAddTickHook(&watchPlayback);
+	struct timespec hostStart, hostEnd;
+	clock_gettime(CLOCK_MONOTONIC, &hostStart);
+	simJoystickSetDigital(1, 7, JOY_LEFT, true);
+	simRun(100);
+	simJoystickSetDigital(1, 7, JOY_LEFT, false);
+	simRun((PROGSKILL_TIME + 30) * 1000);
+	clock_gettime(CLOCK_MONOTONIC, &hostEnd);
+	double hostTime = (hostEnd.tv_sec - hostStart.tv_sec) + (hostEnd.tv_nsec - hostStart.tv_nsec) / 1e9;
+	check("skills plays every section in order", numTimes == 4 && times[0] == 20 && times[1] == 40 &&
+			times[2] == 60 && times[3] == 80);
+	check("skills playback lasts 61 s of robot time", !autonPlaying && playbackTime == (PROGSKILL_TIME + 1) * 1000);
+	check("skills replay takes under a second", hostTime < 1.0);
+}
+
+/**
+ * Moves the lift model by a millisecond and sets the lift potentiometer: full power raises it at
+ * 1500 counts a second with no load, and gravity pulls it down with a fifth of full power
+ */
+static void stepLiftModel() {
+	double duty = fmax(-1.0, fmin(1.0, simMotorGet(LIFT_TOP_Y_MOTOR) / 90.0));
+	liftModelSpeed += 12000.0 * (duty - liftModelSpeed / 1500.0 - 0.2) * 0.001;
+	liftModelHeight += liftModelSpeed * 0.001;
+	if (liftModelHeight < 0.0 || liftModelHeight > LIFT_MODEL_TOP) {
+		liftModelHeight = fmax(0.0, fmin(LIFT_MODEL_TOP, liftModelHeight));
+		liftModelSpeed = 0.0;
+	}
+	simSetAnalog(LIFT_POT, LIFT_MODEL_BOTTOM + (int) lround(liftModelHeight));
+}
+
+/**
+ * Drives the drivetrain model for a second with each wheel's motor at a fixed command
+ *
+ * @param model The model, reset before driving
+ * @param frontLeft The command of the front left motor, positive to drive forward
+ * @param frontRight The command of the front right motor
+ * @param backLeft The command of the back left motor
+ * @param backRight The command of the back right motor
+ */
+static void driveModel(mecanum_model* model, int frontLeft, int frontRight, int backLeft, int backRight) {
+	mecanum_params params;
+	mecanumDefaults(&params);
+	mecanumReset(model, &params);
+	int commands[MECANUM_WHEELS];
+	commands[MECANUM_FRONT_LEFT] = frontLeft;
+	commands[MECANUM_FRONT_RIGHT] = frontRight;
+	commands[MECANUM_BACK_LEFT] = backLeft;
+	commands[MECANUM_BACK_RIGHT] = backRight;
+	mecanumStep(model, commands, 1.0);
+}
+
+/**
+ * Checks that the drivetrain model moves the way a mecanum robot does
+ */
+static void checkMecanum() {
+	mecanum_model model;
+	mecanum_params params;
+	mecanumDefaults(&params);
+	double freeVelocity = params.freeSpeed * params.wheelRadius * params.batteryVoltage / params.nominalVoltage;
+
+	driveModel(&model, 127, 127, 127, 127);
+	check("model drives straight forward", model.x > 0.5 && fabs(model.y) < 0.001 && fabs(model.heading) < 0.001);
+	check("model stays under free speed", model.vx > 0.5 * freeVelocity && model.vx < freeVelocity);
+	check("model battery sags under load", model.voltage < params.batteryVoltage);
+	driveModel(&model, 127, -127, -127, 127);
+	check("model strafes right", model.y < -0.3 && fabs(model.x) < 0.001 && fabs(model.heading) < 0.001);
+	driveModel(&model, 127, -127, 127, -127);
+	check("model turns clockwise in place", model.heading < -1.0 && hypot(model.x, model.y) < 0.001);
+	driveModel(&model, 60, 60, 60, 60);
+	double halfSpeed = model.vx;
+	driveModel(&model, 127, 127, 127, 127);
+	check("model motor saturates before 127", halfSpeed < model.vx && halfSpeed > 0.5 * model.vx);
+}
+
+/**
+ * Checks the fixed-point arithmetic and the input curves built with it
+ */
+static void checkFixed() {
+	char text[16];
+	check("fixed multiply rounds", fixedMul(fixedFromRatio(3, 2), fixedFromRatio(-5, 2)) == fixedFromRatio(-15, 4));
+	check("fixed divide rounds", fixedDiv(INT_TO_FIXED(1), INT_TO_FIXED(3)) == 21845);
+	check("fixed to int rounds halves away from zero", fixedToInt(fixedFromRatio(5, 2)) == 3 &&
+			fixedToInt(fixedFromRatio(-5, 2)) == -3);
+	check("fixed scale", fixedScale(127, fixedFromRatio(3, 4)) == 95);
+	check("fixed scale rounds halves away from zero", fixedScale(3, FIXED_ONE / 2) == 2 && fixedScale(-3, FIXED_ONE / 2) == -2 &&
+			fixedScale(-5, FIXED_ONE / 4) == -1 && fixedScale(-7, FIXED_ONE / 4) == -2);
+	check("integer divide rounds halves away from zero", roundDivide(-7, 2) == -4 && roundDivide(7, -2) == -4 &&
+			roundDivide(5, 3) == 2 && roundDivide64(-30000000000LL, 20000000000LL) == -2);
+	check("integer square root", intSqrt(0) == 0 && intSqrt(99) == 9 && intSqrt(100) == 10 &&
+			intSqrt(0xFFFFFFFFFFFFFFFFULL) == 0xFFFFFFFF);
+	formatDecimal(text, sizeof(text), 7840, 3);
+	check("decimal format", strcmp(text, "7.840") == 0);
+	formatDecimal(text, sizeof(text), -5, 2);
+	check("negative decimal format", strcmp(text, "-0.05") == 0);
+	fixedFormat(text, sizeof(text), fixedFromRatio(-7, 8), 2);
+	check("fixed format rounds", strcmp(text, "-0.88") == 0);
+	check("fixed sine of whole degrees comes from the table", fixedSin(30000) == FIXED_ONE / 2 &&
+			fixedSin(-90000) == -FIXED_ONE && fixedCos(180000) == -FIXED_ONE && fixedSin(720000) == 0);
+	check("fixed sine interpolates between degrees", abs(fixedSin(45500) - 46744) <= 2 &&
+			abs(fixedCos(-404500) - 46744) <= 2);
+
+	initInputCurves();
+	check("input curves are odd with a deadband", INPUT_SHAPE(speedCurve, 9) == 0 && INPUT_SHAPE(speedCurve, -10) == -10 &&
+			INPUT_SHAPE(horizontalCurve, 127) == 127 && INPUT_SHAPE(horizontalCurve, -100) == -48 &&
+			INPUT_SHAPE(horizontalCurve, 60) == 0);
+}
+
+/**
+ * Checks that the simulated flash keeps to the Cortex's limits on open files
+ */
+static void checkFlashLimits() {
+	simFlashWrite("f1", "x", 1);
+	FILE* files[SIM_MAX_FILES];
+	bool opened = true;
+	for (int i = 0; i < SIM_MAX_FILES; i++) {
+		files[i] = fopen("f1", "r");
+		opened &= files[i] != NULL;
+	}
+	FILE* extra = fopen("f1", "r");
+	check("flash opens at most four files at once", SIM_MAX_FILES == 4 && opened && extra == NULL);
+	for (int i = 0; i < SIM_MAX_FILES; i++) {
+		if (files[i] != NULL) {
+			fclose(files[i]);
+		}
+	}
+	FILE* writer = fopen("f2", "w");
+	FILE* second = fopen("f3", "w");
+	check("flash opens at most one file for writing", writer != NULL && second == NULL);
+	if (writer != NULL) {
+		fclose(writer);
+	}
+}
+
+/**
+ * Checks that the motor frame writes only the channels that changed
+ */
+static void checkMotorFrame() {
+	motorFrameInvalidate();
+	motorFrameStatsReset();
+	spd = 50;
+	horizontal = turn = sht = 0;
+	lift = 1;
+	moveRobot();
+	check("first motor frame writes every channel", motorFrameStats.writes == MOTOR_CHANNELS &&
+			simMotorGet(BACK_LEFT_MOTOR) == 50 && simMotorGet(LIFT_MIDDLE_LEFT_MOTOR) == MOTOR_SPEED);
+	sht = 40;
+	moveRobot();
+	check("motor frame skips unchanged channels", motorFrameStats.writes == MOTOR_CHANNELS + 1 &&
+			motorFrameStats.skipped == MOTOR_CHANNELS - 1 && simMotorGet(PINCER_Y_MOTOR) == 40);
+	spd = horizontal = 200;
+	moveRobot();
+	check("motor frame clamps", simMotorGet(FRONT_LEFT_MOTOR) == -127);
+	motorFrameStopAll();
+	spd = horizontal = lift = 0;
+	moveRobot();
+	check("motor frame writes after a stop", simMotorGet(PINCER_Y_MOTOR) == 40 && simMotorGet(BACK_LEFT_MOTOR) == 0);
+	motorSet(PINCER_Y_MOTOR, 0);
+	motorFrameInvalidate();
+	moveRobot();
+	check("invalid motor frame writes every channel", simMotorGet(PINCER_Y_MOTOR) == 40);
+	motorFrameStatsReset();
+	for (int i = 0; i < 2 * MOTOR_FRAME_REFRESH / CONTROL_PERIOD; i++) {
+		motorFrameCommit();
+	}
+	check("motor frame refreshes after a time, not a number of commits", motorFrameStats.writes == 0);
+	sht = 0;
+	motorFrameStopAll();
+	// A motor stopped behind the frame's back, with operator control committing the same frame
+	simRun(100);
+	motorSet(PINCER_Y_MOTOR, 99);
+	simRun(MOTOR_FRAME_REFRESH / 2);
+	bool skipped = simMotorGet(PINCER_Y_MOTOR) == 99;
+	simRun(MOTOR_FRAME_REFRESH);
+	check("motor frame writes every channel again after its refresh time", skipped && simMotorGet(PINCER_Y_MOTOR) == 0);
+}
+
+/**
+ * Checks that the drive mixing keeps the ratios between the wheels when it saturates
+ */
+static void checkDriveMix() {
+	int powers[DRIVE_WHEELS];
+	mixDrive(60, 30, 20, false, powers);
+	check("drive mix passes small commands through", powers[DRIVE_FRONT_LEFT] == -110 && powers[DRIVE_FRONT_RIGHT] == 10 &&
+			powers[DRIVE_BACK_LEFT] == 50 && powers[DRIVE_BACK_RIGHT] == -70);
+	mixDrive(127, 127, 0, false, powers);
+	check("drive mix uses the full range on a diagonal", powers[DRIVE_FRONT_LEFT] == -127 &&
+			powers[DRIVE_FRONT_RIGHT] == 0 && powers[DRIVE_BACK_LEFT] == 0 && powers[DRIVE_BACK_RIGHT] == -127);
+	driveMixStatsReset();
+	mixDrive(127, 0, 127, false, powers);
+	check("drive mix scales every wheel together", powers[DRIVE_FRONT_LEFT] == -127 && powers[DRIVE_FRONT_RIGHT] == 0 &&
+			powers[DRIVE_BACK_LEFT] == 127 && powers[DRIVE_BACK_RIGHT] == 0 && driveMixStats.saturated == 1);
+	mixDrive(100, 50, 60, false, powers);
+	check("drive mix keeps the ratios", powers[DRIVE_FRONT_LEFT] == -127 && powers[DRIVE_FRONT_RIGHT] == -6 &&
+			powers[DRIVE_BACK_LEFT] == 67 && powers[DRIVE_BACK_RIGHT] == -54);
+	mixDrive(127, 0, 100, true, powers);
+	check("drive mix with turn priority keeps the turn", powers[DRIVE_FRONT_LEFT] == -127 &&
+			powers[DRIVE_FRONT_RIGHT] == -73 && powers[DRIVE_BACK_LEFT] == 127 && powers[DRIVE_BACK_RIGHT] == 73);
+}
+
+/**
+ * Checks the PID controller used by closed-loop playback
+ */
+static void checkPid() {
+	pid_controller pid;
+	pidInit(&pid, INT_TO_FIXED(4), FIXED_ONE / 4, INT_TO_FIXED(2), 100);
+	check("pid skips the derivative on its first update", pidUpdate(&pid, 8) == 34);
+	check("pid adds proportional, integral and derivative terms", pidUpdate(&pid, 12) == 61);
+	check("pid clamps its integral", pidUpdate(&pid, 200) == 1201);
+	pidReset(&pid);
+	check("pid reset clears the integral and the last error", pidUpdate(&pid, 8) == 34);
+}
+
+/**
+ * Checks the battery compensation of played back commands (the robot's battery is at its default of 7.8 V)
+ */
+static void checkBattery() {
+	check("battery scale is the recorded over the filtered voltage", batteryScale(7020) == FIXED_ONE * 9 / 10 &&
+			batteryScale(7800) == FIXED_ONE);
+	check("battery scale is clamped", batteryScale(20000) == BATTERY_SCALE_MAX && batteryScale(1000) == BATTERY_SCALE_MIN);
+	check("battery scale is off without a recorded voltage", batteryScale(0) == FIXED_ONE);
+	check("battery scale leaves commands alone at one", batteryScaleCommand(127, FIXED_ONE) == 127 &&
+			batteryScaleCommand(-60, FIXED_ONE) == -60);
+	check("battery scale starts from a full command", batteryScaleCommand(127, FIXED_ONE * 9 / 10) == 81 &&
+			batteryScaleCommand(-40, FIXED_ONE * 11 / 10) == -44);
+}
+
+/**
+ * Presses LCD buttons for long enough that the menu sees them, and lets them go again
+ *
+ * @param buttons The LCD_BTN_* buttons to press
+ */
+static void pressLcd(unsigned int buttons) {
+	lcdPress = buttons;
+	simRun(60);
+	lcdPress = 0;
+	simRun(60);
+}
+
+/**
+ * Checks the lift controller on the lift model, with the robot in operator control
+ */
+static void checkLift() {
+	simSetAnalog(LIFT_POT, LIFT_MODEL_BOTTOM);
+	initLift();
+	simAddTickHook(&stepLiftModel);
+	check("lift potentiometer is found from its reading", liftPotFound && liftControlled());
+	simRun(500);
+	check("lift rests at the bottom with its motors off", liftModelHeight == 0.0 && simMotorGet(LIFT_TOP_Y_MOTOR) == 0);
+
+	simJoystickSetDigital(1, 6, JOY_UP, true);
+	simRun(400);
+	check("lift rises at full power while the button is held", simMotorGet(LIFT_TOP_Y_MOTOR) == MOTOR_SPEED &&
+			liftModelHeight > 200.0);
+	simJoystickSetDigital(1, 6, JOY_UP, false);
+	simRun(1000);
+	double held = liftModelHeight;
+	simRun(2000);
+	int power = simMotorGet(LIFT_TOP_Y_MOTOR);
+	check("lift holds its height after the button is let go", fabs(liftModelHeight - held) < 10.0 && power > 0 &&
+			power < LIFT_SAFE_POWER);
+
+	liftSetHeight(held + 400);
+	simRun(1500);
+	check("lift goes to a height setpoint", fabs(liftModelHeight - (held + 400)) < 20.0);
+
+	liftStatsReset();
+	liftSetHeight(LIFT_MODEL_TOP + 200);
+	simRun(4000);
+	power = simMotorGet(LIFT_TOP_Y_MOTOR);
+	check("lift cuts its power when held against a stop", liftStats.limited > 0 && power <= LIFT_SAFE_POWER / 2);
+
+	liftSetHeight(0);
+	simRun(3000);
+	check("lift sent to the bottom rests with its motors off", liftModelHeight == 0.0 &&
+			simMotorGet(LIFT_TOP_Y_MOTOR) == 0);
+
+	// The motor test of the LCD menu on a lift port, which the lift loop commits every period
+	for (int i = 0; i < 10 && strstr(simLcdLine(1), "Motor Testing") == NULL; i++) {
+		pressLcd(LCD_BTN_RIGHT);
+	}
+	pressLcd(LCD_BTN_CENTER);
+	for (int i = 0; i < 10 && strstr(simLcdLine(1), "Port 3") == NULL; i++) {
+		pressLcd(LCD_BTN_RIGHT);
+	}
+	pressLcd(LCD_BTN_CENTER);
+	simRun(1500);
+	check("motor test runs a lift port past the lift loop", simMotorGet(LIFT_TOP_Y_MOTOR) == 127 &&
+			!liftControlled() && liftModelHeight > 200.0);
+	pressLcd(LCD_BTN_CENTER);
+	simRun(2000);
+	check("lift holds its height again after the motor test", liftControlled() && simMotorGet(LIFT_TOP_Y_MOTOR) != 127 &&
+			fabs(liftModelHeight - liftSetpoint()) < 20.0);
+	pressLcd(LCD_BTN_LEFT);
+	liftSetHeight(0);
+	simRun(3000);
+}
+
+/**
+ * Checks the heading hold of playback on a simulated gyro, with the robot standing still
+ */
+static void checkHeading() {
+	simSetAnalog(GYRO_PORT, SIM_GYRO_REST);
+	simSetGyro(GYRO_PORT, 30);
+	initHeading();
+	simSetGyro(GYRO_PORT, 40);
+	check("gyro is found from its reading and zeroed when it starts", gyroFound && headingGet() == 10);
+	headingZero();
+	check("heading zero takes the heading now", headingGet() == 0);
+	check("heading hold turns counterclockwise toward a heading counterclockwise of the robot",
+			headingCorrection(5) == -15);
+	check("heading hold limits its correction", headingCorrection(-100) == HEADING_MAX_CORRECTION);
+	wheelTrack track = { { 10, 10, 10, 10 } };
+	int powers[DRIVE_WHEELS];
+	mixDrive(0, 0, 40, false, powers);
+	driveTrackAddTurn(&track, 40);
+	bool turned = true;
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		turned &= abs(powers[i]) == 40 && track.wheel[i] == 10 + powers[i] / DRIVE_TRACK_TURN_PER_COUNT;
+	}
+	check("a turn added to a track turns each wheel the way its motor turns", turned);
+	simSetAnalog(GYRO_PORT, 0);
+}
+
+/**
+ * Checks that interpolated playback starts each state halfway from the last one
+ */
+static void checkInterpolate() {
+	joyState slow = { 40, 0, 0, 0, 0 };
+	joyState fast = { 80, 0, 0, 0, 0 };
+	driveInterpolateStart();
+	controlLock();
+	driveInterpolateStep(&slow, &fast);
+	int first = simMotorGet(BACK_LEFT_MOTOR);
+	driveInterpolateStep(&fast, &fast);
+	int second = simMotorGet(BACK_LEFT_MOTOR);
+	bool updating = driveInterpolateUpdate();
+	controlUnlock();
+	check("interpolation starts a state halfway from the last one", first == 20 && second == 60 && updating);
+	driveInterpolateStop();
+	controlLock();
+	check("interpolation stops staging the drive", !driveInterpolateUpdate());
+	controlUnlock();
+	motorFrameStopAll();
+}
+
+/**
+ * Sets the drive IMEs to the counts of wheels that rolled forward by some counts
+ *
+ * @param forward The counts each wheel rolled forward
+ * @param turn The counts each wheel rolled to turn the robot counterclockwise
+ */
+static void rollWheels(int forward, int turn) {
+	// Signs from mixDrive(): the counts of the front left and back right IMEs fall as the robot drives forward
+	simSetIme(FRONT_LEFT_IME, -forward + turn, 0);
+	simSetIme(FRONT_RIGHT_IME, forward + turn, 0);
+	simSetIme(BACK_LEFT_IME, forward - turn, 0);
+	simSetIme(BACK_RIGHT_IME, -forward - turn, 0);
+}
+
+/**
+ * Checks the odometry task on the simulated IMEs, without the gyro
+ */
+static void checkOdometry() {
+	odometry_pose pose;
+	check("odometry is off without the drive IMEs", !odometryGetPose(&pose));
+	rollWheels(0, 0);
+	simSetImes(DRIVE_WHEELS);
+	initDriveEncoders();
+	initOdometry();
+	odometryGyro = false;
+	simRun(50);
+	odometryReset();
+	simRun(50);
+	// One revolution of a 4 inch wheel is 319.186 mm, and 685 counts on each wheel turn the robot 90.014 degrees
+	rollWheels(DRIVE_IME_COUNTS_PER_REV, 0);
+	simRun(50);
+	odometryGetPose(&pose);
+	check("odometry moves forward along x", labs(pose.x - 319186) < 100 && pose.y == 0 && pose.heading == 0);
+	rollWheels(DRIVE_IME_COUNTS_PER_REV, 685);
+	simRun(50);
+	odometryGetPose(&pose);
+	check("odometry turns in place", labs(pose.x - 319186) < 100 && labs(pose.y) < 100 && labs(pose.heading - 90014) < 10);
+	rollWheels(2 * DRIVE_IME_COUNTS_PER_REV, 685);
+	simRun(50);
+	odometryGetPose(&pose);
+	check("odometry moves forward along the heading", labs(pose.x - 319186) < 500 && labs(pose.y - 319186) < 500 &&
+			pose.forwardSpeed == 0 && odometryStats.readFailures == 0 && odometryStats.maxGap == ODOMETRY_PERIOD);
+	odometryGyro = true;
+}
+
+/**
+ * Plays back the loaded routine, as autonomous() does
+ *
+ * @param parameters Unused task parameter
+ */
+static void playbackTask(void* parameters) {
+	playbackAuton();
+}
+
+/**
+ * Runs operator control, as the firmware does when the robot enters it
+ *
+ * @param parameters Unused task parameter
+ */
+static void operatorTask(void* parameters) {
+	operatorControl();
+}
+
+/**
+ * Checks that operator control takes the motors back from a playback that the kernel killed partway
+ */
+static void checkKilledPlayback() {
+	uint8_t auton[AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE] = { 0 };
+	for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+		auton[i * AUTON_STATE_SIZE] = 60;
+	}
+	simFlashWrite("a1", auton, sizeof(auton));
+	loadAuton(1);
+	TaskHandle playback = taskCreate(&playbackTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(1000);
+	check("playback drives the robot", autonPlaying && simMotorGet(BACK_LEFT_MOTOR) == 60);
+	TaskHandle second = taskCreate(&playbackTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(100);
+	check("a second playback does nothing while one is running", taskGetState(second) == TASK_DEAD &&
+			taskGetState(playback) != TASK_DEAD && autonPlaying);
+	taskDelete(playback);
+	// The scale that a killed playback of a routine recorded on a fuller battery would leave behind
+	motorFrameSetScale(fixedFromRatio(1, 2));
+	TaskHandle operator = taskCreate(&operatorTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(200);
+	controlLock();
+	bool interpolating = driveInterpolateUpdate();
+	controlUnlock();
+	check("operator control stops a killed playback", !autonPlaying && !interpolating &&
+			simMotorGet(BACK_LEFT_MOTOR) == 0);
+	simJoystickSetAnalog(1, 3, 100);
+	simRun(100);
+	check("operator control drives unscaled after a killed playback", simMotorGet(BACK_LEFT_MOTOR) == 100);
+	simJoystickSetAnalog(1, 3, 0);
+	simRun(100);
+	taskDelete(operator);
+
+	playback = taskCreate(&playbackTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT);
+	simRun(500);
+	taskDelete(playback);
+	bool left = autonPlaying;
+	check("a killed playback does not keep the robot busy", left && !playbackActive() && !autonPlaying);
+	simRun(100);
+}
+
+/**
+ * Runs the benchmark case of playbackState(), as the benchmark of the LCD menu does in operator control
+ */
+static void runPlaybackBenchmark() {
+	for (int i = 0; i < BENCH_CASES; i++) {
+		if (strcmp(benchCases[i].name, "playbackState") == 0) {
+			benchCases[i].run();
+		}
+	}
+}
+
+/**
+ * Checks that the benchmark leaves operator control as it found it
+ */
+static void checkBenchmark() {
+	// A routine recorded on an emptier battery, which playback would scale every command down for
+	autonVoltage = 7020;
+	runPlaybackBenchmark();
+	autonVoltage = 0;
+	simJoystickSetAnalog(1, 3, 100);
+	simRun(100);
+	check("operator control drives unscaled after the playback benchmark", simMotorGet(BACK_LEFT_MOTOR) == 100);
+	simJoystickSetAnalog(1, 3, 0);
+	simRun(100);
+
+	// A routine with a lift height and a heading far from where the robot is
+	heights[0] = 100;
+	headings[0] = 90;
+	heightsLoaded = headingsLoaded = true;
+	int setpoint = liftSetpoint();
+	heading_stats stats = headingStats;
+	runPlaybackBenchmark();
+	simRun(100);
+	check("playback benchmark leaves the lift and the heading hold alone", liftSetpoint() == setpoint &&
+			memcmp(&stats, &headingStats, sizeof(stats)) == 0 && heightsLoaded && headingsLoaded &&
+			simMotorGet(BACK_LEFT_MOTOR) == 0);
+	heightsLoaded = headingsLoaded = false;
+	heights[0] = 0;
+	headings[0] = 0;
+}
+
+int main() {
+	checkTasks();
+	checkRobot();
+	checkMecanum();
+	checkFixed();
+	checkFlashLimits();
+	checkMotorFrame();
+	checkDriveMix();
+	checkPid();
+	checkBattery();
+	checkLift();
+	checkHeading();
+	checkInterpolate();
+	checkOdometry();
+	checkKilledPlayback();
+	checkBenchmark();
+	return failed ? 1 : 0;
+}
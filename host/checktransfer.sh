@@ -0,0 +1,111 @@
+#!/bin/sh
+# Tests autontool against the stand-in robot (robotsim) over a pseudo-terminal.
+# Usage: checktransfer.sh <build directory>
+
+BUILD=$(cd "${1:-build}" && pwd)
+WORK=$(mktemp -d)
+FAILED=0
+
+cleanup() {
+	[ -n "$ROBOT" ] && kill "$ROBOT" 2>/dev/null
+	rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+# Runs a check and reports whether it passed
+check() {
+	NAME="$1"
+	shift
+	if "$@" >"$WORK/output" 2>&1; then
+		echo "PASS $NAME"
+	else
+		echo "FAIL $NAME"
+		sed 's/^/    /' "$WORK/output"
+		FAILED=1
+	fi
+}
+
+# Runs a command that is expected to fail
+fails() {
+	! "$@"
+}
+
+tool() {
+	"$BUILD/autontool" -p "$WORK/tty" "$@"
+}
+
+# Makes a file of random bytes the size of an autonomous (750 states of 5 bytes)
+randomAuton() {
+	head -c 3750 /dev/urandom >"$1"
+}
+
+mkdir -p "$WORK/flash" "$WORK/local" "$WORK/mirror"
+# Files recorded beside the routines on the robot, which pushing or removing a slot must not leave behind
+head -c 3750 /dev/zero >"$WORK/flash/p2"
+for name in a3t a3g p1h a10v p2g; do
+	echo old >"$WORK/flash/$name"
+done
+"$BUILD/robotsim" -d "$WORK/flash" -l "$WORK/tty" 2>"$WORK/robot.log" &
+ROBOT=$!
+for i in 1 2 3 4 5 6 7 8 9 10; do
+	[ -e "$WORK/tty" ] && break
+	sleep 0.1
+done
+
+randomAuton "$WORK/r1"
+randomAuton "$WORK/r2"
+
+check "list on an empty slot" sh -c "$BUILD/autontool -p $WORK/tty list | grep -q '^a1 empty$'"
+check "binary push" tool push a3 "$WORK/r1"
+check "binary push stored file" cmp "$WORK/r1" "$WORK/flash/a3"
+check "binary push removed the old companions" test ! -e "$WORK/flash/a3t" -a ! -e "$WORK/flash/a3g"
+check "binary pull" tool pull 3 "$WORK/r1.pulled"
+check "binary pull matches" cmp "$WORK/r1" "$WORK/r1.pulled"
+check "text push" tool push p1 "$WORK/r2" text
+check "text push stored file" cmp "$WORK/r2" "$WORK/flash/p1"
+check "text push removed the old companions" test ! -e "$WORK/flash/p1h"
+check "text pull" tool pull p1 "$WORK/r2.pulled" text
+check "text pull matches" cmp "$WORK/r2" "$WORK/r2.pulled"
+check "list shows sizes" sh -c "$BUILD/autontool -p $WORK/tty list | grep -q '^a3 3750 missing track voltage heights headings$'"
+check "list names only the missing files" sh -c "$BUILD/autontool -p $WORK/tty list | grep -q '^p2 3750 missing track voltage heights$'"
+
+check "invalid slot is refused" fails tool push a11 "$WORK/r1"
+head -c 100 "$WORK/r1" >"$WORK/short"
+check "short file is refused" fails tool push a4 "$WORK/short"
+check "refused push left no file" test ! -e "$WORK/flash/a4"
+
+check "csv export" tool tocsv "$WORK/r1" "$WORK/r1.csv"
+check "csv has a row per state" test "$(wc -l <"$WORK/r1.csv")" -eq 751
+check "csv import" tool fromcsv "$WORK/r1.csv" "$WORK/r1.back"
+check "csv round trip" cmp "$WORK/r1" "$WORK/r1.back"
+printf 'state,spd,horizontal,turn,sht,lift\n0,127,-128,5,0,1\n' >"$WORK/short.csv"
+check "short csv is padded" sh -c "$BUILD/autontool fromcsv $WORK/short.csv $WORK/padded && test \$(wc -c <$WORK/padded) -eq 3750"
+printf 'state,spd,horizontal,turn,sht,lift\n0,200,0,0,0,0\n' >"$WORK/bad.csv"
+check "out of range csv is refused" fails tool fromcsv "$WORK/bad.csv" "$WORK/bad"
+
+randomAuton "$WORK/local/a1"
+randomAuton "$WORK/local/a10"
+randomAuton "$WORK/local/p3"
+mkdir -p "$WORK/badlocal"
+cp "$WORK/local/a1" "$WORK/badlocal/a1"
+cp "$WORK/short" "$WORK/badlocal/a2"
+check "sync push of a short file is refused" fails tool sync push "$WORK/badlocal"
+check "refused sync push left the robot as it was" test ! -e "$WORK/flash/a1" -a ! -e "$WORK/flash/a2" -a \
+	-e "$WORK/flash/a3" -a -e "$WORK/flash/p1" -a -e "$WORK/flash/p2"
+check "sync push" tool sync push "$WORK/local"
+check "sync push sent a1" cmp "$WORK/local/a1" "$WORK/flash/a1"
+check "sync push sent a10" cmp "$WORK/local/a10" "$WORK/flash/a10"
+check "sync push sent p3" cmp "$WORK/local/p3" "$WORK/flash/p3"
+check "sync push removed a3" test ! -e "$WORK/flash/a3"
+check "sync push removed p1" test ! -e "$WORK/flash/p1"
+check "sync push removed p2" test ! -e "$WORK/flash/p2"
+check "sync push removed the companions of replaced and removed slots" test ! -e "$WORK/flash/a10v" -a \
+	! -e "$WORK/flash/p2g"
+check "sync push again changes nothing" sh -c "$BUILD/autontool -p $WORK/tty sync push $WORK/local | grep -q 'Already in sync'"
+randomAuton "$WORK/a5"
+check "push for sync pull" tool push a5 "$WORK/a5"
+cp "$WORK/r2" "$WORK/mirror/a2"
+check "sync pull" tool sync pull "$WORK/mirror"
+check "sync pull matches robot" diff -r "$WORK/flash" "$WORK/mirror"
+
+exit $FAILED
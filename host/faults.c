@@ -0,0 +1,610 @@
+/** @file faults.c
+ * @brief File for measuring how the recorder recovers from flash and serial faults
+ *
+ * Runs the recorder's load, save and serial transfer paths, and programming skills playback (which
+ * reads each section while the one before it plays), on the simulated PROS API many times
+ * with faults injected by simSetFaults(): files that will not open, short flash reads and writes,
+ * slow flash, and serial bytes that are lost or damaged in either direction. After every run the
+ * result is checked: a load or skills playback that failed must leave nothing loaded, a save or download that failed
+ * must leave no file, and one that succeeded must leave exactly the right data. The report shows
+ * how often each path failed, how often it was left inconsistent, and how much robot time the
+ * faults cost: the extra robot time of the runs that recovered, against a run without faults,
+ * and the time that the runs that failed took to give up. The computer's end of the binary
+ * transfers answers like autontool, sending frames again after a NAK or a timeout.
+ *
+ * Usage: faults [-z] [-n runs]
+ * -z starts from free flash and serial instead of the Cortex estimates in simCortexIoCosts, and
+ * -n sets the number of runs of each path (each with its own seed).
+ * The exit status is 1 if a path that is meant to be safe was left inconsistent.
+ */
+
+#include "main.h"
+#include "frame.h"
+#include "serialTransfer.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Number of bytes in an autonomous file
+ */
+#define FAULTS_FILE_SIZE (AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE)
+
+/**
+ * Number of frames in a binary transfer of an autonomous file: BEGIN, the data blocks and END
+ */
+#define FAULTS_FRAMES ((FAULTS_FILE_SIZE + TRANSFER_BLOCK_SIZE - 1) / TRANSFER_BLOCK_SIZE + 2)
+
+/**
+ * A recorder path to run with faults
+ */
+typedef struct fault_scenario {
+	/**
+	 * The name printed in the report
+	 */
+	const char* name;
+
+	/**
+	 * The faults to inject (the seed is set for each run)
+	 */
+	sim_faults faults;
+
+	/**
+	 * Sets up the flash and the computer's end of the link before a run, without faults
+	 */
+	void (*prepare)();
+
+	/**
+	 * Runs the path
+	 *
+	 * @return true if the robot reported success, false otherwise
+	 */
+	bool (*run)();
+
+	/**
+	 * Checks what the path left behind
+	 *
+	 * @param success What run() returned
+	 *
+	 * @return true if the result is consistent, false otherwise
+	 */
+	bool (*check)(bool success);
+
+	/**
+	 * Whether or not the path is meant to stay consistent under these faults
+	 */
+	bool safe;
+} fault_scenario;
+
+/**
+ * The computer's end of the serial monitor
+ */
+static int peerFd = -1;
+
+/**
+ * Decoder for the frames the robot sends to the computer
+ */
+static frame_decoder peerDecoder;
+
+/**
+ * The file that the robot is given or is expected to end up with
+ */
+static uint8_t fileData[FAULTS_FILE_SIZE];
+
+/**
+ * The frames that the computer sends during a binary download
+ */
+static uint8_t peerFrames[FAULTS_FRAMES][FRAME_MAX_LENGTH];
+
+/**
+ * The number of bytes in each of peerFrames
+ */
+static size_t peerLengths[FAULTS_FRAMES];
+
+/**
+ * Whether or not the computer is sending peerFrames, and whether or not it is receiving an upload
+ */
+static bool peerSending = false;
+static bool peerReceiving = false;
+
+/**
+ * The first frame that has not been acknowledged and the next frame to send
+ */
+static int peerBase = 0;
+static int peerNext = 0;
+
+/**
+ * The time in milliseconds that a frame was last sent or acknowledged
+ */
+static unsigned long peerActiveAt = 0;
+
+/**
+ * The file received during an upload and the number of bytes in it
+ */
+static uint8_t received[FAULTS_FILE_SIZE];
+static int receivedLength = 0;
+
+/**
+ * The sequence number of the next frame expected during an upload
+ */
+static uint8_t peerExpected = 0;
+
+/**
+ * Whether or not a NAK has been sent for the frame expected
+ */
+static bool peerNakSent = false;
+
+/**
+ * Whether or not a whole upload arrived with the right size and CRC
+ */
+static bool peerDone = false;
+
+/**
+ * Prints a line of the report to standard output
+ *
+ * @param format The format string, as for printf
+ */
+static void report(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (write(STDOUT_FILENO, line, MIN(length, (int) sizeof(line) - 1)) < 0) {
+		exit(1);
+	}
+}
+
+/**
+ * Sends a control frame (ACK or NAK) with no payload to the robot
+ *
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ */
+static void peerControl(uint8_t type, uint8_t seq) {
+	uint8_t frame[FRAME_HEADER_LENGTH + FRAME_CRC_LENGTH];
+	simSerialInput(frame, frameEncode(frame, type, seq, NULL, 0));
+}
+
+/**
+ * Handles a frame from the robot while sending a download, as linkSendStream() does
+ */
+static void senderFrame() {
+	int seq = peerDecoder.seq;
+	if (peerDecoder.type == FRAME_ABORT) {
+		peerSending = false;
+	} else if (peerDecoder.type == FRAME_ACK && seq >= peerBase && seq < peerNext) {
+		peerBase = seq + 1;
+		peerActiveAt = millis();
+	} else if (peerDecoder.type == FRAME_NAK && seq >= peerBase && seq <= peerNext) {
+		peerBase = peerNext = seq;
+	}
+}
+
+/**
+ * Handles a frame from the robot while receiving an upload, as linkReceiveStream() does
+ *
+ * @param result The result of feeding the last byte to the decoder
+ */
+static void receiverFrame(int result) {
+	if (result == FRAME_CORRUPT) {
+		if (!peerNakSent) {
+			peerControl(FRAME_NAK, peerExpected);
+			peerNakSent = true;
+		}
+		return;
+	} else if (peerDecoder.type == FRAME_ABORT) {
+		peerReceiving = false;
+		return;
+	} else if (peerDecoder.type == FRAME_ACK || peerDecoder.type == FRAME_NAK) {
+		return;
+	} else if (peerDecoder.seq != peerExpected) {
+		if ((uint8_t) (peerDecoder.seq - peerExpected) < 128) {
+			if (!peerNakSent) {
+				peerControl(FRAME_NAK, peerExpected);
+				peerNakSent = true;
+			}
+		} else {
+			peerControl(FRAME_ACK, peerExpected - 1);
+		}
+		return;
+	}
+
+	if (peerDecoder.type == FRAME_BEGIN) {
+		receivedLength = 0;
+	} else if (peerDecoder.type == FRAME_DATA && receivedLength + peerDecoder.length <= FAULTS_FILE_SIZE) {
+		memcpy(received + receivedLength, peerDecoder.payload, peerDecoder.length);
+		receivedLength += peerDecoder.length;
+	} else if (peerDecoder.type == FRAME_END && peerDecoder.length >= 2) {
+		uint16_t crc = frameCrc16(0xFFFF, received, receivedLength);
+		peerDone = receivedLength == FAULTS_FILE_SIZE && (peerDecoder.payload[0] | (peerDecoder.payload[1] << 8)) == crc;
+	}
+	peerControl(FRAME_ACK, peerExpected);
+	peerExpected++;
+	peerNakSent = false;
+}
+
+/**
+ * Reads what the robot sent and answers it, then sends the next frames of a download
+ */
+static void answerRobot() {
+	uint8_t data[1024];
+	ssize_t length;
+	while ((length = read(peerFd, data, sizeof(data))) > 0) {
+		for (int i = 0; i < length; i++) {
+			int result = frameDecoderFeed(&peerDecoder, data[i]);
+			if (result == FRAME_INCOMPLETE) {
+				continue;
+			} else if (peerSending && result == FRAME_READY) {
+				senderFrame();
+			} else if (peerReceiving) {
+				receiverFrame(result);
+			}
+		}
+	}
+
+	if (peerSending && peerBase < FAULTS_FRAMES) {
+		// Nothing was acknowledged in time, so send the whole window again
+		if (millis() - peerActiveAt >= TRANSFER_ACK_TIMEOUT) {
+			peerNext = peerBase;
+		}
+		while (peerNext < FAULTS_FRAMES && peerNext - peerBase < TRANSFER_WINDOW) {
+			simSerialInput(peerFrames[peerNext], peerLengths[peerNext]);
+			peerNext++;
+			peerActiveAt = millis();
+		}
+	}
+}
+
+/**
+ * Fills fileData with a random autonomous file
+ */
+static void randomFile() {
+	for (int i = 0; i < FAULTS_FILE_SIZE; i++) {
+		fileData[i] = rand();
+	}
+}
+
+/**
+ * Checks that a file in flash holds fileData
+ *
+ * @param filename The name of the file
+ *
+ * @return true if the file exists and holds fileData, false otherwise
+ */
+static bool fileMatches(const char* filename) {
+	int size;
+	const uint8_t* data = simFlashRead(filename, &size);
+	return data != NULL && size == FAULTS_FILE_SIZE && memcmp(data, fileData, FAULTS_FILE_SIZE) == 0;
+}
+
+/**
+ * Checks whether a file is in flash
+ *
+ * @param filename The name of the file
+ *
+ * @return true if the file exists, false otherwise
+ */
+static bool fileExists(const char* filename) {
+	int size;
+	return simFlashRead(filename, &size) != NULL;
+}
+
+/**
+ * Checks that the states array holds the routine in fileData (saved as speed, horizontal, turn, dumper and lift)
+ *
+ * @return true if every state matches, false otherwise
+ */
+static bool statesMatch() {
+	const signed char* data = (const signed char*) fileData;
+	for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++, data += AUTON_STATE_SIZE) {
+		if (states[i].spd != data[0] || states[i].horizontal != data[1] || states[i].turn != data[2] ||
+				states[i].sht != data[3] || states[i].lift != data[4]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Stores a random routine in slot 1 with nothing loaded
+ */
+static void prepareLoad() {
+	randomFile();
+	simFlashWrite("a1", fileData, FAULTS_FILE_SIZE);
+	memset(states, 0, FAULTS_FILE_SIZE);
+	autonLoaded = 0;
+}
+
+/**
+ * Loads slot 1
+ */
+static bool runLoad() {
+	loadAuton(1);
+	return autonLoaded == 1;
+}
+
+/**
+ * A load must leave the whole routine loaded or nothing
+ */
+static bool checkLoad(bool success) {
+	return success ? statesMatch() : autonLoaded == 0;
+}
+
+/**
+ * Fills the states array with a random routine and removes slot 1
+ */
+static void prepareSave() {
+	randomFile();
+	const signed char* data = (const signed char*) fileData;
+	for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++, data += AUTON_STATE_SIZE) {
+		states[i] = (joyState) { .spd = data[0], .horizontal = data[1], .turn = data[2], .sht = data[3], .lift = data[4] };
+	}
+	fdelete("a1");
+}
+
+/**
+ * Saves the states array to slot 1
+ */
+static bool runSave() {
+	return saveAutonToSlot(1);
+}
+
+/**
+ * A save or a download must leave the whole file or none
+ */
+static bool checkSave(bool success) {
+	return success ? fileMatches("a1") : !fileExists("a1");
+}
+
+/**
+ * Makes a random routine to download into slot 2 and removes the slot
+ */
+static void prepareDownload() {
+	randomFile();
+	fdelete("a2");
+}
+
+/**
+ * Receives the routine into slot 2 as text
+ */
+static bool runTextDownload() {
+	simSerialInput(fileData, FAULTS_FILE_SIZE);
+	return downloadAutonFromComputer(2);
+}
+
+/**
+ * Makes the frames of a binary download of a random routine and removes slot 2
+ */
+static void prepareBinaryDownload() {
+	prepareDownload();
+	uint8_t header[2] = { FAULTS_FILE_SIZE & 0xFF, FAULTS_FILE_SIZE >> 8 };
+	peerLengths[0] = frameEncode(peerFrames[0], FRAME_BEGIN, 0, header, 2);
+	for (int i = 1; i < FAULTS_FRAMES - 1; i++) {
+		int offset = (i - 1) * TRANSFER_BLOCK_SIZE;
+		peerLengths[i] = frameEncode(peerFrames[i], FRAME_DATA, i, fileData + offset,
+				MIN(TRANSFER_BLOCK_SIZE, FAULTS_FILE_SIZE - offset));
+	}
+	uint16_t crc = frameCrc16(0xFFFF, fileData, FAULTS_FILE_SIZE);
+	uint8_t footer[2] = { crc & 0xFF, crc >> 8 };
+	peerLengths[FAULTS_FRAMES - 1] = frameEncode(peerFrames[FAULTS_FRAMES - 1], FRAME_END, FAULTS_FRAMES - 1, footer, 2);
+	peerBase = peerNext = 0;
+	peerActiveAt = millis();
+}
+
+/**
+ * Receives the routine into slot 2 as frames
+ */
+static bool runBinaryDownload() {
+	peerSending = true;
+	return downloadAutonBinary(2);
+}
+
+/**
+ * A download must leave the whole file or none
+ */
+static bool checkDownload(bool success) {
+	return success ? fileMatches("a2") : !fileExists("a2");
+}
+
+/**
+ * Stores a random routine in slot 1 for the computer to receive
+ */
+static void prepareUpload() {
+	randomFile();
+	simFlashWrite("a1", fileData, FAULTS_FILE_SIZE);
+	receivedLength = 0;
+	peerExpected = 0;
+	peerNakSent = false;
+	peerDone = false;
+}
+
+/**
+ * Sends slot 1 to the computer as frames
+ */
+static bool runUpload() {
+	peerReceiving = true;
+	return uploadAutonBinary(1);
+}
+
+/**
+ * An upload that the robot reports as sent must have reached the computer whole
+ */
+static bool checkUpload(bool success) {
+	return !success || (peerDone && memcmp(received, fileData, FAULTS_FILE_SIZE) == 0);
+}
+
+/**
+ * Stores random programming skills sections and loads them; fileData is left holding the last section
+ */
+static void prepareSkills() {
+	for (int i = 0; i < PROGSKILL_TIME / AUTON_TIME; i++) {
+		char filename[AUTON_FILENAME_MAX_LENGTH];
+		snprintf(filename, sizeof(filename), "p%d", i);
+		randomFile();
+		simFlashWrite(filename, fileData, FAULTS_FILE_SIZE);
+	}
+	autonLoaded = 0;
+	loadAuton(MAX_AUTON_SLOTS + 1);
+}
+
+/**
+ * Plays programming skills, which reads each section from flash while the one before it plays
+ */
+static bool runSkills() {
+	playbackAuton();
+	return autonLoaded == MAX_AUTON_SLOTS + 1;
+}
+
+/**
+ * Skills must play every section and end with the last one loaded, or stop leaving nothing loaded
+ */
+static bool checkSkills(bool success) {
+	if (success) {
+		return statesMatch();
+	}
+	for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+		if (states[i].spd != 0 || states[i].horizontal != 0 || states[i].turn != 0 || states[i].sht != 0 ||
+				states[i].lift != 0) {
+			return false;
+		}
+	}
+	return autonLoaded == 0;
+}
+
+/**
+ * Every path, with faults at rates that make some runs fail
+ * Loads and saves move one byte per flash call, so their short read and write rates are lower.
+ */
+static const fault_scenario scenarios[] = {
+	{ "load", { .shortRead = 0.0002, .slowFlash = 200 }, &prepareLoad, &runLoad, &checkLoad, true },
+	{ "load, no flash", { .openFailure = 1 }, &prepareLoad, &runLoad, &checkLoad, true },
+	{ "save", { .shortWrite = 0.0002, .slowFlash = 200 }, &prepareSave, &runSave, &checkSave, true },
+	{ "save, no flash", { .openFailure = 1 }, &prepareSave, &runSave, &checkSave, true },
+	{ "text download", { .serialDrop = 0.0002, .serialCorrupt = 0.0002 }, &prepareDownload, &runTextDownload,
+			&checkDownload, false },
+	{ "binary download", { .serialDrop = 0.001, .serialCorrupt = 0.001, .shortWrite = 0.01 }, &prepareBinaryDownload,
+			&runBinaryDownload, &checkDownload, true },
+	{ "binary upload", { .serialDrop = 0.001, .serialCorrupt = 0.001, .shortRead = 0.01 }, &prepareUpload, &runUpload,
+			&checkUpload, true },
+	{ "skills", { .shortRead = 0.0001, .slowFlash = 200 }, &prepareSkills, &runSkills, &checkSkills, true },
+	{ "skills, no flash", { .openFailure = 1 }, &prepareSkills, &runSkills, &checkSkills, true },
+};
+
+/**
+ * Runs a path once and stops the computer's end of the link afterwards
+ *
+ * @param scenario The path
+ * @param faults The faults to inject
+ * @param success Set to whether or not the robot reported success
+ * @param stats Set to the flash and serial figures of the run
+ *
+ * @return the robot time of the run in microseconds
+ */
+static uint64_t runOnce(const fault_scenario* scenario, const sim_faults* faults, bool* success, sim_io_stats* stats) {
+	static const sim_faults none;
+	simSetFaults(&none);
+	scenario->prepare();
+	simSetFaults(faults);
+	simResetIoStats();
+	uint64_t start = simMicros();
+	*success = scenario->run();
+	uint64_t time = simMicros() - start;
+	simGetIoStats(stats);
+	simSetFaults(&none);
+
+	// Let whatever is still on the link arrive, then throw it away before the next run
+	peerSending = peerReceiving = false;
+	delay(2 * TRANSFER_ACK_TIMEOUT);
+	while (fcount(stdin) > 0) {
+		fgetc(stdin);
+	}
+	frameDecoderReset(&peerDecoder);
+	return time;
+}
+
+/**
+ * Runs a path without faults and then with faults, and prints a row of the report
+ *
+ * @param scenario The path
+ * @param runs The number of runs with faults
+ *
+ * @return true if the path was consistent after every run or is not meant to be, false otherwise
+ */
+static bool measure(const fault_scenario* scenario, int runs) {
+	bool success;
+	sim_io_stats stats;
+	static const sim_faults none;
+	uint64_t baseline = runOnce(scenario, &none, &success, &stats);
+	if (!success || !scenario->check(success)) {
+		report("%-16s failed without faults\n", scenario->name);
+		return false;
+	}
+
+	int succeeded = 0, inconsistent = 0;
+	unsigned long faults = 0;
+	uint64_t okTime = 0, failTime = 0;
+	for (int i = 0; i < runs; i++) {
+		sim_faults settings = scenario->faults;
+		settings.seed = i + 1;
+		uint64_t time = runOnce(scenario, &settings, &success, &stats);
+		faults += stats.faults;
+		if (success) {
+			succeeded++;
+			okTime += time;
+		} else {
+			failTime += time;
+		}
+		if (!scenario->check(success)) {
+			inconsistent++;
+		}
+	}
+	// A run that succeeded shows what recovering cost; one that failed shows how long it took to find out
+	report("%-16s %5d %5d %5d %6d %7.1f %9.1f %9.1f %9.1f  %s\n", scenario->name, runs, succeeded, runs - succeeded,
+			inconsistent, (double) faults / runs, baseline / 1000.0,
+			succeeded > 0 ? okTime / 1000.0 / succeeded - baseline / 1000.0 : 0.0,
+			succeeded < runs ? failTime / 1000.0 / (runs - succeeded) : 0.0,
+			scenario->safe ? "safe" : "unsafe (no checksum)");
+	return !scenario->safe || inconsistent == 0;
+}
+
+int main(int argc, char** argv) {
+	sim_io_costs costs = simCortexIoCosts;
+	int runs = 20;
+	int option;
+	while ((option = getopt(argc, argv, "zn:")) != -1) {
+		if (option == 'z') {
+			memset(&costs, 0, sizeof(costs));
+		} else if (option == 'n') {
+			runs = MAX(1, atoi(optarg));
+		} else {
+			simLog("Usage: faults [-z] [-n runs]");
+			return 2;
+		}
+	}
+	simSetIoCosts(&costs);
+
+	int serial[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, serial);
+	peerFd = serial[1];
+	fcntl(peerFd, F_SETFL, O_NONBLOCK);
+	frameDecoderReset(&peerDecoder);
+	simSerialOpen(serial[0]);
+	simAddTickHook(&answerRobot);
+	srand(750);
+	initAutonRecorder();
+
+	report("%-16s %5s %5s %5s %6s %7s %9s %9s %9s\n", "path", "runs", "ok", "fail", "incons", "faults", "base ms",
+			"extra ms", "fail ms");
+	bool passed = true;
+	for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		passed = measure(&scenarios[i], runs) && passed;
+	}
+	return passed ? 0 : 1;
+}
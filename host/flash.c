@@ -0,0 +1,468 @@
+/** @file flash.c
+ * @brief File for the in-memory flash file system of the simulated PROS API
+ *
+ * Flash files are kept in memory so that reads and writes cost no real time and can be timed on
+ * the virtual clock, which is charged for each operation by iomodel.c. If a flash directory has been opened, every file is loaded from it at the
+ * start and each change (closing a written file or deleting a file) is written back to it.
+ *
+ * This file is compiled with prosnames.h like the robot code, so it must not include <stdio.h>.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include "flash.h"
+#include "iomodel.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Maximum length of a flash file name, including the terminating null character
+ */
+#define FLASH_NAME_LENGTH 16
+
+/**
+ * Maximum number of bytes in a flash file
+ */
+#define FLASH_MAX_FILE_SIZE 65536
+
+/**
+ * A file in the simulated flash
+ */
+typedef struct flash_file {
+	/**
+	 * Whether or not this entry holds a file
+	 */
+	bool used;
+
+	/**
+	 * The name of the file
+	 */
+	char name[FLASH_NAME_LENGTH];
+
+	/**
+	 * The contents of the file
+	 */
+	uint8_t* data;
+
+	/**
+	 * The number of bytes in the file
+	 */
+	int size;
+} flash_file;
+
+/**
+ * A flash file that has been opened
+ */
+typedef struct open_file {
+	/**
+	 * The file, or NULL if the handle is not in use
+	 */
+	flash_file* file;
+
+	/**
+	 * The position of the next byte to read or write
+	 */
+	int position;
+
+	/**
+	 * Whether or not the file was opened for writing
+	 */
+	bool writing;
+} open_file;
+
+/**
+ * Every file in the simulated flash
+ */
+static flash_file files[SIM_MAX_FLASH_FILES];
+
+/**
+ * Every open file handle
+ */
+static open_file handles[SIM_MAX_FILES];
+
+/**
+ * The directory that files are loaded from and saved to, or NULL if there is none
+ */
+static const char* flashDirectory = NULL;
+
+/**
+ * Finds a file by name
+ *
+ * @param name The name of the file
+ *
+ * @return the file, or NULL if there is no file with that name
+ */
+static flash_file* findFile(const char* name) {
+	for (int i = 0; i < SIM_MAX_FLASH_FILES; i++) {
+		if (files[i].used && strcmp(files[i].name, name) == 0) {
+			return &files[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Creates an empty file, or empties the existing file with the same name
+ *
+ * @param name The name of the file
+ *
+ * @return the file, or NULL if the name is too long or the flash is full
+ */
+static flash_file* createFile(const char* name) {
+	if (strlen(name) >= FLASH_NAME_LENGTH) {
+		return NULL;
+	}
+	flash_file* file = findFile(name);
+	for (int i = 0; file == NULL && i < SIM_MAX_FLASH_FILES; i++) {
+		if (!files[i].used) {
+			file = &files[i];
+			file->used = true;
+			strcpy(file->name, name);
+			file->data = malloc(FLASH_MAX_FILE_SIZE);
+		}
+	}
+	if (file != NULL) {
+		file->size = 0;
+	}
+	return file;
+}
+
+/**
+ * Gets the path of a file in the flash directory
+ *
+ * @param name The name of the file
+ * @param path The buffer to write the path into
+ * @param size The size of the buffer
+ */
+static void directoryPath(const char* name, char* path, int size) {
+	snprintf(path, size, "%s/%s", flashDirectory, name);
+}
+
+/**
+ * Writes a file to the flash directory, if there is one
+ *
+ * @param file The file
+ */
+static void saveFile(flash_file* file) {
+	if (flashDirectory == NULL) {
+		return;
+	}
+	char path[512];
+	directoryPath(file->name, path, sizeof(path));
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || write(fd, file->data, file->size) != file->size) {
+		simLog("flash: could not save %s", path);
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+/**
+ * Loads the simulated flash from a directory and writes every later change back to it
+ *
+ * @param directory The directory, which must already exist
+ *
+ * @return the number of files loaded, or -1 if the directory could not be read
+ */
+int simFlashOpen(const char* directory) {
+	DIR* dir = opendir(directory);
+	if (dir == NULL) {
+		return -1;
+	}
+	flashDirectory = directory;
+
+	int loaded = 0;
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		char path[512];
+		struct stat info;
+		directoryPath(entry->d_name, path, sizeof(path));
+		if (stat(path, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size > FLASH_MAX_FILE_SIZE) {
+			continue;
+		}
+
+		flash_file* file = createFile(entry->d_name);
+		int fd = open(path, O_RDONLY);
+		if (file == NULL || fd < 0) {
+			simLog("flash: could not load %s", path);
+		} else {
+			int size = read(fd, file->data, FLASH_MAX_FILE_SIZE);
+			file->size = MAX(0, size);
+			loaded++;
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	closedir(dir);
+	return loaded;
+}
+
+/**
+ * Stores a file in the simulated flash, replacing any file with the same name
+ *
+ * @param name The name of the file
+ * @param data The contents of the file
+ * @param size The number of bytes in the file
+ *
+ * @return true if the file was stored, false if the flash is full
+ */
+bool simFlashWrite(const char* name, const void* data, int size) {
+	flash_file* file = createFile(name);
+	if (file == NULL || size > FLASH_MAX_FILE_SIZE) {
+		return false;
+	}
+	memcpy(file->data, data, size);
+	file->size = size;
+	saveFile(file);
+	return true;
+}
+
+/**
+ * Gets the contents of a file in the simulated flash
+ *
+ * @param name The name of the file
+ * @param size Set to the number of bytes in the file
+ *
+ * @return the contents of the file, or NULL if it does not exist
+ */
+const uint8_t* simFlashRead(const char* name, int* size) {
+	flash_file* file = findFile(name);
+	if (file == NULL) {
+		return NULL;
+	}
+	*size = file->size;
+	return file->data;
+}
+
+/**
+ * Charges the time to erase the pages that hold a number of bytes
+ *
+ * @param size The number of bytes
+ */
+static void erasePages(int size) {
+	int pages = MAX(1, (size + SIM_FLASH_PAGE_SIZE - 1) / SIM_FLASH_PAGE_SIZE);
+	ioStats.flashPagesErased += pages;
+	ioChargeFlash("flash erase", (long) pages * SIM_FLASH_PAGE_SIZE, (uint64_t) pages * ioCosts.flashErase);
+}
+
+/**
+ * Gets an open file from its handle
+ *
+ * @param handle The handle
+ *
+ * @return the open file, or NULL if the handle is not open
+ */
+static open_file* getHandle(int handle) {
+	if (handle < 0 || handle >= SIM_MAX_FILES || handles[handle].file == NULL) {
+		return NULL;
+	}
+	return &handles[handle];
+}
+
+/**
+ * Opens a flash file
+ *
+ * @param name The name of the file
+ * @param mode "r" to read, "w" to replace the file, or "a" to add to the end of the file
+ *
+ * @return the handle of the open file, or -1 if the file does not exist (when reading), the flash
+ * is full, SIM_MAX_FILES files are open or another file is open for writing
+ */
+int flashOpen(const char* name, const char* mode) {
+	int handle = SIM_MAX_FILES;
+	for (int i = SIM_MAX_FILES - 1; i >= 0; i--) {
+		if (handles[i].file == NULL) {
+			handle = i;
+		} else if (handles[i].writing && mode[0] != 'r') {
+			simLog("flash: %s is already open for writing, so %s cannot be", handles[i].file->name, name);
+			return -1;
+		}
+	}
+	if (handle == SIM_MAX_FILES) {
+		simLog("flash: %d files are already open, so %s cannot be", SIM_MAX_FILES, name);
+		return -1;
+	}
+	ioStats.flashOpens++;
+	ioChargeFlash("flash open", 0, ioCosts.flashOpen);
+	if (ioFault(ioFaults.openFailure)) {
+		return -1;
+	}
+
+	flash_file* file;
+	if (mode[0] == 'w') {
+		file = createFile(name);
+	} else if (mode[0] == 'a') {
+		file = findFile(name);
+		file = (file == NULL) ? createFile(name) : file;
+	} else {
+		file = findFile(name);
+	}
+	if (file == NULL) {
+		return -1;
+	}
+
+	handles[handle].file = file;
+	handles[handle].position = (mode[0] == 'a') ? file->size : 0;
+	handles[handle].writing = mode[0] != 'r';
+	return handle;
+}
+
+/**
+ * Closes a flash file, saving it to the flash directory if it was written
+ *
+ * @param handle The handle of the open file
+ */
+void flashClose(int handle) {
+	open_file* open = getHandle(handle);
+	if (open != NULL) {
+		ioStats.flashCloses++;
+		ioChargeFlash("flash close", 0, ioCosts.flashClose);
+		if (open->writing) {
+			erasePages(open->file->size);
+			saveFile(open->file);
+		}
+		open->file = NULL;
+	}
+}
+
+/**
+ * Reads from a flash file
+ *
+ * @param handle The handle of the open file
+ * @param data The buffer to read into
+ * @param length The maximum number of bytes to read
+ *
+ * @return the number of bytes read
+ */
+int flashRead(int handle, void* data, int length) {
+	open_file* open = getHandle(handle);
+	if (open == NULL || open->writing) {
+		return 0;
+	}
+	length = MAX(0, MIN(length, open->file->size - open->position));
+	if (length > 0 && ioFault(ioFaults.shortRead)) {
+		length /= 2;
+	}
+	ioStats.flashReads++;
+	ioStats.flashBytesRead += length;
+	ioChargeFlash("flash read", length, ioCosts.flashCall + (uint64_t) length * ioCosts.flashReadByte);
+	memcpy(data, open->file->data + open->position, length);
+	open->position += length;
+	return length;
+}
+
+/**
+ * Writes to a flash file
+ *
+ * @param handle The handle of the open file
+ * @param data The bytes to write
+ * @param length The number of bytes to write
+ *
+ * @return the number of bytes written
+ */
+int flashWrite(int handle, const void* data, int length) {
+	open_file* open = getHandle(handle);
+	if (open == NULL || !open->writing) {
+		return 0;
+	}
+	length = MAX(0, MIN(length, FLASH_MAX_FILE_SIZE - open->position));
+	if (length > 0 && ioFault(ioFaults.shortWrite)) {
+		length /= 2;
+	}
+	ioStats.flashWrites++;
+	ioStats.flashBytesWritten += length;
+	ioChargeFlash("flash write", length, ioCosts.flashCall + (uint64_t) length * ioCosts.flashWriteByte);
+	memcpy(open->file->data + open->position, data, length);
+	open->position += length;
+	open->file->size = MAX(open->file->size, open->position);
+	return length;
+}
+
+/**
+ * Moves the position of a flash file
+ *
+ * @param handle The handle of the open file
+ * @param offset The new position, relative to the origin
+ * @param origin SEEK_SET, SEEK_CUR or SEEK_END
+ *
+ * @return 0 if the position was moved, -1 otherwise
+ */
+int flashSeek(int handle, long offset, int origin) {
+	open_file* open = getHandle(handle);
+	if (open == NULL) {
+		return -1;
+	}
+	ioStats.flashSeeks++;
+	ioChargeFlash("flash seek", 0, ioCosts.flashSeek);
+	long position = offset;
+	if (origin == SEEK_CUR) {
+		position += open->position;
+	} else if (origin == SEEK_END) {
+		position += open->file->size;
+	}
+	if (position < 0 || position > open->file->size) {
+		return -1;
+	}
+	open->position = position;
+	return 0;
+}
+
+/**
+ * Gets the position of a flash file
+ *
+ * @param handle The handle of the open file
+ *
+ * @return the position, or -1 if the handle is not open
+ */
+long flashTell(int handle) {
+	open_file* open = getHandle(handle);
+	return (open == NULL) ? -1 : open->position;
+}
+
+/**
+ * Gets the number of bytes left to read in a flash file
+ *
+ * @param handle The handle of the open file
+ *
+ * @return the number of bytes after the position
+ */
+int flashCount(int handle) {
+	open_file* open = getHandle(handle);
+	return (open == NULL) ? 0 : open->file->size - open->position;
+}
+
+/**
+ * Deletes a flash file
+ *
+ * @param name The name of the file
+ *
+ * @return 0 if the file was deleted, 1 otherwise
+ */
+int flashDelete(const char* name) {
+	flash_file* file = findFile(name);
+	if (file == NULL) {
+		return 1;
+	}
+	ioStats.flashDeletes++;
+	erasePages(file->size);
+	for (int i = 0; i < SIM_MAX_FILES; i++) {
+		if (handles[i].file == file) {
+			handles[i].file = NULL;
+		}
+	}
+	file->used = false;
+	free(file->data);
+	file->data = NULL;
+	if (flashDirectory != NULL) {
+		char path[512];
+		directoryPath(name, path, sizeof(path));
+		unlink(path);
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+/** @file flash.h
+ * @brief File for the in-memory flash file system of the simulated PROS API
+ *
+ * Files are referred to by handles from 0 to SIM_MAX_FILES - 1; pros.c turns them into the FILE
+ * pointers seen by the robot code.
+ */
+
+#ifndef FLASH_H
+
+// This prevents multiple inclusion
+#define FLASH_H
+
+#include <stdbool.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opens a flash file
+ *
+ * @param name The name of the file
+ * @param mode "r" to read, "w" to replace the file, or "a" to add to the end of the file
+ *
+ * @return the handle of the open file, or -1 if the file does not exist (when reading) or the flash is full
+ */
+int flashOpen(const char* name, const char* mode);
+
+/**
+ * Closes a flash file, saving it to the flash directory if it was written
+ *
+ * @param handle The handle of the open file
+ */
+void flashClose(int handle);
+
+/**
+ * Reads from a flash file
+ *
+ * @param handle The handle of the open file
+ * @param data The buffer to read into
+ * @param length The maximum number of bytes to read
+ *
+ * @return the number of bytes read
+ */
+int flashRead(int handle, void* data, int length);
+
+/**
+ * Writes to a flash file
+ *
+ * @param handle The handle of the open file
+ * @param data The bytes to write
+ * @param length The number of bytes to write
+ *
+ * @return the number of bytes written
+ */
+int flashWrite(int handle, const void* data, int length);
+
+/**
+ * Moves the position of a flash file
+ *
+ * @param handle The handle of the open file
+ * @param offset The new position, relative to the origin
+ * @param origin SEEK_SET, SEEK_CUR or SEEK_END
+ *
+ * @return 0 if the position was moved, -1 otherwise
+ */
+int flashSeek(int handle, long offset, int origin);
+
+/**
+ * Gets the position of a flash file
+ *
+ * @param handle The handle of the open file
+ *
+ * @return the position, or -1 if the handle is not open
+ */
+long flashTell(int handle);
+
+/**
+ * Gets the number of bytes left to read in a flash file
+ *
+ * @param handle The handle of the open file
+ *
+ * @return the number of bytes after the position
+ */
+int flashCount(int handle);
+
+/**
+ * Deletes a flash file
+ *
+ * @param name The name of the file
+ *
+ * @return 0 if the file was deleted, 1 otherwise
+ */
+int flashDelete(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,581 @@
+/** @file goldentrace.c
+ * @brief File for the golden motor trace checks of the robot code
+ *
+ * Plays the recordings in a directory (named a1 - a10 and p0 - p3, as autontool sync pull leaves
+ * them) through the robot code and compares what the motors received with the golden traces
+ * checked in beside them, so a change to recordJoyInfo(), moveRobot() or the playback loop can be
+ * shown to leave the motors alone. Each recording makes these cases:
+ *
+ * - aN: the robot boots in autonomous mode, slot N is picked on the LCD and autonomous() plays it.
+ * - aN.drive: the robot boots in operator control and the states of aN are fed in as joystick
+ *   moves and buttons, one every 1000 / JOY_POLL_FREQ milliseconds.
+ * - skills: like aN for the programming skills sections p0 - p3, if all four are there.
+ *
+ * Every case runs in its own process, so each starts from a freshly booted robot. The trace of a
+ * case (in <case>.trace) holds the value of all ten motors at every millisecond from the start
+ * of playback (or of the joystick moves) until the robot has stopped, written as the lines on
+ * which any motor changes. Several writes within a millisecond count as the last one, so writing
+ * a motor less often does not change the trace as long as it gets the same value.
+ *
+ * Usage: goldentrace [-u] [-t milliseconds] [-v value] directory
+ * -u writes the traces instead of checking them. -t lets each motor value be matched by the
+ * golden trace up to that many milliseconds earlier or later, and -v lets it differ by that much.
+ * A failed case leaves what the motors received in <case>.actual.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+// The C library's wait() is not used, but <sys/wait.h> declares it, and prosnames.h renames it
+#undef wait
+#include <sys/wait.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Number of motor channels
+ */
+#define GOLDEN_MOTORS 10
+
+/**
+ * Number of bytes in a recording
+ */
+#define GOLDEN_FILE_SIZE (AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE)
+
+/**
+ * Milliseconds that a drive case keeps tracing after the last state, with the joystick let go
+ */
+#define GOLDEN_DRIVE_TAIL 1000
+
+/**
+ * Maximum number of bytes in a trace file
+ */
+#define GOLDEN_MAX_TRACE_SIZE (4 * 1024 * 1024)
+
+/**
+ * The values of every motor at every millisecond of a case
+ */
+typedef struct golden_trace {
+	/**
+	 * The motor values, GOLDEN_MOTORS for each millisecond
+	 */
+	signed char* values;
+
+	/**
+	 * The number of milliseconds
+	 */
+	int length;
+
+	/**
+	 * The number of milliseconds that fit in values
+	 */
+	int capacity;
+} golden_trace;
+
+/**
+ * A case to run
+ */
+typedef struct golden_case {
+	/**
+	 * The name of the case, which is also the start of its file names
+	 */
+	char name[16];
+
+	/**
+	 * The slot to play (1 - MAX_AUTON_SLOTS, or MAX_AUTON_SLOTS + 1 for programming skills)
+	 */
+	int slot;
+
+	/**
+	 * Whether the states are fed in through the joystick instead of played back
+	 */
+	bool drive;
+} golden_case;
+
+/**
+ * The trace being captured by the tick hook
+ */
+static golden_trace captured = { NULL, 0, 0 };
+
+/**
+ * Whether or not the tick hook captures the motors
+ */
+static bool capturing = false;
+
+/**
+ * Whether or not the recording was playing at the last tick
+ */
+static bool wasPlaying = false;
+
+/**
+ * What the second LCD line shows when the recording to play is selected, or empty to pick none
+ */
+static char choice[SIM_LCD_LINE_LENGTH] = "";
+
+/**
+ * Prints a line of the report to standard output
+ *
+ * @param format The format string, as for printf
+ */
+static void report(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (write(STDOUT_FILENO, line, MIN(length, (int) sizeof(line) - 1)) < 0) {
+		exit(1);
+	}
+}
+
+/**
+ * Adds a millisecond to a trace
+ *
+ * @param trace The trace
+ *
+ * @return the GOLDEN_MOTORS values of the new millisecond, all zero
+ */
+static signed char* addMillisecond(golden_trace* trace) {
+	if (trace->length == trace->capacity) {
+		trace->capacity = MAX(1024, trace->capacity * 2);
+		trace->values = realloc(trace->values, trace->capacity * GOLDEN_MOTORS);
+	}
+	signed char* values = trace->values + trace->length++ * GOLDEN_MOTORS;
+	memset(values, 0, GOLDEN_MOTORS);
+	return values;
+}
+
+/**
+ * Adds the value of every motor to the captured trace
+ */
+static void captureMotors() {
+	signed char* values = addMillisecond(&captured);
+	for (int channel = 1; channel <= GOLDEN_MOTORS; channel++) {
+		values[channel - 1] = simMotorGet(channel);
+	}
+}
+
+/**
+ * Captures the motors while a recording plays back, and stops the simulation when it is done
+ */
+static void followPlayback() {
+	if (autonPlaying) {
+		captureMotors();
+	} else if (wasPlaying) {
+		simStop();
+	}
+	wasPlaying = autonPlaying;
+}
+
+/**
+ * Captures the motors while the joystick is being moved
+ */
+static void followDrive() {
+	if (capturing) {
+		captureMotors();
+	}
+}
+
+/**
+ * Answers the LCD prompt of initialize(): presses the right button (for 40 ms at a time) until
+ * the choice is shown, then the center button
+ */
+static void pickRecording() {
+	unsigned int buttons = 0;
+	if (strcmp(simLcdLine(1), "Select file") == 0) {
+		if (choice[0] == 0 || strcmp(simLcdLine(2), choice) == 0) {
+			buttons = LCD_BTN_CENTER;
+		} else if ((millis() / 40) % 2 == 0) {
+			buttons = LCD_BTN_RIGHT;
+		}
+	}
+	simLcdSetButtons(buttons);
+}
+
+/**
+ * Reads a whole file
+ *
+ * @param path The path of the file
+ * @param data The buffer to read into
+ * @param size The size of the buffer
+ *
+ * @return the number of bytes read, or -1 if the file could not be read
+ */
+static int readFile(const char* path, void* data, int size) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	int length = 0;
+	int result;
+	while (length < size && (result = read(fd, (char*) data + length, size - length)) > 0) {
+		length += result;
+	}
+	close(fd);
+	return length;
+}
+
+/**
+ * Loads every recording of a directory into the simulated flash
+ *
+ * @param directory The directory
+ */
+static void loadRecordings(const char* directory) {
+	uint8_t data[GOLDEN_FILE_SIZE + 1];
+	for (int slot = 1; slot <= MAX_AUTON_SLOTS + PROGSKILL_TIME / AUTON_TIME; slot++) {
+		char name[AUTON_FILENAME_MAX_LENGTH];
+		char path[256];
+		snprintf(name, sizeof(name), slot <= MAX_AUTON_SLOTS ? "a%d" : "p%d",
+				slot <= MAX_AUTON_SLOTS ? slot : slot - MAX_AUTON_SLOTS - 1);
+		snprintf(path, sizeof(path), "%s/%s", directory, name);
+		if (readFile(path, data, sizeof(data)) == GOLDEN_FILE_SIZE) {
+			simFlashWrite(name, data, GOLDEN_FILE_SIZE);
+		}
+	}
+}
+
+/**
+ * Holds the joystick the way a driver would to make a recorded state
+ *
+ * @param state The state
+ */
+static void holdJoystick(const signed char* state) {
+	simJoystickSetAnalog(1, 3, state[0]);
+	simJoystickSetAnalog(1, 4, state[1]);
+	simJoystickSetAnalog(1, 1, state[2]);
+	int pincer = state[3];
+	simJoystickSetDigital(1, 5, JOY_UP, pincer > 40);
+	simJoystickSetDigital(1, 5, JOY_DOWN, pincer < -40);
+	simJoystickSetDigital(1, 8, JOY_UP, pincer > 0 && pincer <= 40);
+	simJoystickSetDigital(1, 8, JOY_DOWN, pincer < 0 && pincer >= -40);
+	simJoystickSetDigital(1, 6, JOY_UP, state[4] < 0);
+	simJoystickSetDigital(1, 6, JOY_DOWN, state[4] > 0);
+}
+
+/**
+ * Runs a case and captures its trace
+ *
+ * @param directory The directory of the recordings
+ * @param run The case
+ */
+static void runCase(const char* directory, const golden_case* run) {
+	simSerialOpen(-1);
+	loadRecordings(directory);
+	simAddTickHook(&pickRecording);
+	if (run->drive) {
+		signed char states[GOLDEN_FILE_SIZE];
+		char path[256];
+		snprintf(path, sizeof(path), "%s/a%d", directory, run->slot);
+		readFile(path, states, sizeof(states));
+		simAddTickHook(&followDrive);
+		simStartRobot(false);
+		simRun(2000);
+		capturing = true;
+		for (int i = 0; i < GOLDEN_FILE_SIZE; i += AUTON_STATE_SIZE) {
+			holdJoystick(states + i);
+			simRun(1000 / JOY_POLL_FREQ);
+		}
+		signed char idle[AUTON_STATE_SIZE] = { 0 };
+		holdJoystick(idle);
+		simRun(GOLDEN_DRIVE_TAIL);
+	} else {
+		if (run->slot <= MAX_AUTON_SLOTS) {
+			snprintf(choice, sizeof(choice), "Slot: %d", run->slot);
+		} else {
+			snprintf(choice, sizeof(choice), "Programming skills");
+		}
+		simAddTickHook(&followPlayback);
+		simStartRobot(true);
+		simRun((PROGSKILL_TIME + 60) * 1000UL);
+	}
+}
+
+/**
+ * Writes a trace as text: a line with the time in milliseconds and the value of every motor for
+ * the first millisecond and each one on which a motor changes, then a line with the length
+ *
+ * @param fd Where to write the trace
+ * @param name The name of the case
+ * @param trace The trace
+ *
+ * @return true if the trace was written
+ */
+static bool writeTrace(int fd, const char* name, const golden_trace* trace) {
+	char line[128];
+	int length = snprintf(line, sizeof(line), "# Motor trace of %s\n# ms, then motors 1 - %d\n", name, GOLDEN_MOTORS);
+	bool written = write(fd, line, length) == length;
+	for (int ms = 0; written && ms < trace->length; ms++) {
+		const signed char* values = trace->values + ms * GOLDEN_MOTORS;
+		if (ms > 0 && memcmp(values, values - GOLDEN_MOTORS, GOLDEN_MOTORS) == 0) {
+			continue;
+		}
+		length = snprintf(line, sizeof(line), "%d", ms);
+		for (int i = 0; i < GOLDEN_MOTORS; i++) {
+			length += snprintf(line + length, sizeof(line) - length, " %d", values[i]);
+		}
+		line[length++] = '\n';
+		written = write(fd, line, length) == length;
+	}
+	if (written) {
+		length = snprintf(line, sizeof(line), "end %d\n", trace->length);
+		written = write(fd, line, length) == length;
+	}
+	return written;
+}
+
+/**
+ * Parses a trace written by writeTrace()
+ *
+ * @param text The text of the trace, terminated by a null character
+ * @param trace Set to the trace
+ *
+ * @return true if the text was a whole trace
+ */
+static bool parseTrace(const char* text, golden_trace* trace) {
+	trace->length = 0;
+	signed char last[GOLDEN_MOTORS] = { 0 };
+	while (*text != 0) {
+		char* next;
+		if (*text == '#') {
+			// Comment
+		} else if (strncmp(text, "end ", 4) == 0) {
+			int end = strtol(text + 4, NULL, 10);
+			while (trace->length < end) {
+				memcpy(addMillisecond(trace), last, GOLDEN_MOTORS);
+			}
+			return trace->length > 0;
+		} else {
+			int ms = strtol(text, &next, 10);
+			if (next == text || ms < trace->length) {
+				return false;
+			}
+			while (trace->length < ms) {
+				memcpy(addMillisecond(trace), last, GOLDEN_MOTORS);
+			}
+			for (int i = 0; i < GOLDEN_MOTORS; i++) {
+				last[i] = strtol(next, &next, 10);
+			}
+			memcpy(addMillisecond(trace), last, GOLDEN_MOTORS);
+		}
+		const char* newline = strchr(text, '\n');
+		if (newline == NULL) {
+			break;
+		}
+		text = newline + 1;
+	}
+	return false;
+}
+
+/**
+ * Compares a trace with its golden trace and prints the first difference
+ *
+ * @param name The name of the case
+ * @param actual The trace of the case
+ * @param golden The golden trace
+ * @param timeTolerance How many milliseconds earlier or later a value may be matched
+ * @param valueTolerance How far a value may be from the one it is matched with
+ *
+ * @return true if every value matched
+ */
+static bool compareTraces(const char* name, const golden_trace* actual, const golden_trace* golden,
+		int timeTolerance, int valueTolerance) {
+	if (abs(actual->length - golden->length) > timeTolerance) {
+		report("FAIL %s: lasts %d ms instead of %d ms\n", name, actual->length, golden->length);
+		return false;
+	}
+	int mismatches = 0;
+	int firstMs = -1, firstMotor = 0;
+	for (int ms = 0; ms < actual->length; ms++) {
+		for (int i = 0; i < GOLDEN_MOTORS; i++) {
+			int value = actual->values[ms * GOLDEN_MOTORS + i];
+			bool matched = false;
+			for (int near = MAX(0, ms - timeTolerance); !matched && near <= MIN(golden->length - 1, ms + timeTolerance); near++) {
+				matched = abs(value - golden->values[near * GOLDEN_MOTORS + i]) <= valueTolerance;
+			}
+			if (!matched) {
+				if (mismatches++ == 0) {
+					firstMs = ms;
+					firstMotor = i;
+				}
+			}
+		}
+	}
+	if (mismatches > 0) {
+		int expected = golden->values[MIN(firstMs, golden->length - 1) * GOLDEN_MOTORS + firstMotor];
+		report("FAIL %s: %d values differ, first at %d ms: motor %d got %d, golden %d\n", name, mismatches, firstMs,
+				firstMotor + 1, actual->values[firstMs * GOLDEN_MOTORS + firstMotor], expected);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Runs a case in a child process and gets the text of its trace
+ *
+ * @param directory The directory of the recordings
+ * @param run The case
+ * @param text Set to the text of the trace, terminated by a null character
+ * @param size The size of the text buffer
+ *
+ * @return true if the case ran
+ */
+static bool traceCase(const char* directory, const golden_case* run, char* text, int size) {
+	int pipeFds[2];
+	if (pipe(pipeFds) != 0) {
+		return false;
+	}
+	pid_t child = fork();
+	if (child == 0) {
+		close(pipeFds[0]);
+		runCase(directory, run);
+		_exit(captured.length > 0 && writeTrace(pipeFds[1], run->name, &captured) ? 0 : 1);
+	}
+	close(pipeFds[1]);
+	int length = 0;
+	int result;
+	while (length < size - 1 && (result = read(pipeFds[0], text + length, size - 1 - length)) > 0) {
+		length += result;
+	}
+	text[length] = 0;
+	close(pipeFds[0]);
+	int status;
+	return child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * Writes text to a file
+ *
+ * @param path The path of the file
+ * @param text The text, terminated by a null character
+ *
+ * @return true if the file was written
+ */
+static bool writeText(const char* path, const char* text) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	int length = strlen(text);
+	bool written = write(fd, text, length) == length;
+	close(fd);
+	return written;
+}
+
+/**
+ * Runs a case and checks or writes its golden trace
+ *
+ * @param directory The directory of the recordings and traces
+ * @param run The case
+ * @param update Whether to write the golden trace instead of checking it
+ * @param timeTolerance How many milliseconds earlier or later a value may be matched
+ * @param valueTolerance How far a value may be from the one it is matched with
+ *
+ * @return true if the case passed or its trace was written
+ */
+static bool goldenCase(const char* directory, const golden_case* run, bool update, int timeTolerance, int valueTolerance) {
+	static char text[GOLDEN_MAX_TRACE_SIZE];
+	static char goldenText[GOLDEN_MAX_TRACE_SIZE];
+	char path[256];
+	if (!traceCase(directory, run, text, sizeof(text))) {
+		report("FAIL %s: the case did not run\n", run->name);
+		return false;
+	}
+	snprintf(path, sizeof(path), "%s/%s.trace", directory, run->name);
+	if (update) {
+		bool written = writeText(path, text);
+		report("%s %s\n", written ? "WROTE" : "FAIL", path);
+		return written;
+	}
+	int length = readFile(path, goldenText, sizeof(goldenText) - 1);
+	if (length < 0) {
+		report("FAIL %s: no golden trace in %s\n", run->name, path);
+		return false;
+	}
+	goldenText[length] = 0;
+
+	golden_trace actual = { NULL, 0, 0 };
+	golden_trace golden = { NULL, 0, 0 };
+	bool passed;
+	if (!parseTrace(goldenText, &golden)) {
+		report("FAIL %s: %s is not a trace\n", run->name, path);
+		passed = false;
+	} else {
+		parseTrace(text, &actual);
+		passed = compareTraces(run->name, &actual, &golden, timeTolerance, valueTolerance);
+	}
+	snprintf(path, sizeof(path), "%s/%s.actual", directory, run->name);
+	if (passed) {
+		report("PASS %s\n", run->name);
+		unlink(path);
+	} else {
+		writeText(path, text);
+	}
+	free(actual.values);
+	free(golden.values);
+	return passed;
+}
+
+int main(int argc, char** argv) {
+	bool update = false;
+	int timeTolerance = 0;
+	int valueTolerance = 0;
+	int option;
+	while ((option = getopt(argc, argv, "ut:v:")) != -1) {
+		if (option == 'u') {
+			update = true;
+		} else if (option == 't') {
+			timeTolerance = atoi(optarg);
+		} else if (option == 'v') {
+			valueTolerance = atoi(optarg);
+		} else {
+			optind = argc;
+		}
+	}
+	if (optind != argc - 1) {
+		simLog("Usage: goldentrace [-u] [-t milliseconds] [-v value] directory");
+		return 2;
+	}
+	const char* directory = argv[optind];
+
+	golden_case cases[2 * MAX_AUTON_SLOTS + 1];
+	int numCases = 0;
+	uint8_t data[GOLDEN_FILE_SIZE + 1];
+	char path[256];
+	for (int slot = 1; slot <= MAX_AUTON_SLOTS; slot++) {
+		snprintf(path, sizeof(path), "%s/a%d", directory, slot);
+		if (readFile(path, data, sizeof(data)) == GOLDEN_FILE_SIZE) {
+			for (int drive = 0; drive < 2; drive++) {
+				golden_case* run = &cases[numCases++];
+				snprintf(run->name, sizeof(run->name), drive ? "a%d.drive" : "a%d", slot);
+				run->slot = slot;
+				run->drive = drive;
+			}
+		}
+	}
+	int sections = 0;
+	for (int section = 0; section < PROGSKILL_TIME / AUTON_TIME; section++) {
+		snprintf(path, sizeof(path), "%s/p%d", directory, section);
+		sections += readFile(path, data, sizeof(data)) == GOLDEN_FILE_SIZE;
+	}
+	if (sections == PROGSKILL_TIME / AUTON_TIME) {
+		golden_case* run = &cases[numCases++];
+		snprintf(run->name, sizeof(run->name), "skills");
+		run->slot = MAX_AUTON_SLOTS + 1;
+		run->drive = false;
+	}
+	if (numCases == 0) {
+		simLog("No recordings in %s", directory);
+		return 1;
+	}
+
+	bool passed = true;
+	for (int i = 0; i < numCases; i++) {
+		passed &= goldenCase(directory, &cases[i], update, timeTolerance, valueTolerance);
+	}
+	return passed ? 0 : 1;
+}
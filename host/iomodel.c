@@ -0,0 +1,149 @@
+/** @file iomodel.c
+ * @brief File for charging the costs of flash and serial operations in the simulated PROS API
+ *
+ * Costs are kept in nanoseconds so that cheap per-byte costs add up correctly; the virtual clock
+ * only moves in whole microseconds, so the remainder is carried over to the next charge.
+ *
+ * This file is compiled with prosnames.h like the robot code, so it must not include <stdio.h>.
+ */
+
+#include "main.h"
+#include "iomodel.h"
+#include "trace.h"
+#include <string.h>
+
+const sim_io_costs simCortexIoCosts = {
+	.flashOpen = 50000,
+	.flashClose = 10000,
+	.flashErase = 20000000,
+	.flashSeek = 3000,
+	.flashCall = 2000,
+	.flashReadByte = 100,
+	.flashWriteByte = 26000,
+	.serialCall = 20000,
+	.serialByte = 86806,
+};
+
+/**
+ * The costs of each operation
+ */
+sim_io_costs ioCosts;
+
+/**
+ * The counts of each operation
+ */
+sim_io_stats ioStats;
+
+/**
+ * The faults to inject
+ */
+sim_faults ioFaults;
+
+/**
+ * The state of the random number generator that picks the faults
+ */
+static uint32_t faultState = 1;
+
+/**
+ * Nanoseconds charged but not yet spent, because the clock moves in whole microseconds
+ */
+static uint64_t owedTime = 0;
+
+/**
+ * Spends virtual time, carrying over any part of a microsecond
+ *
+ * @param time The number of nanoseconds to spend
+ *
+ * @return the number of whole microseconds spent
+ */
+static uint64_t spend(uint64_t time) {
+	owedTime += time;
+	uint64_t micros = owedTime / 1000;
+	owedTime %= 1000;
+	if (micros > 0) {
+		simSpend(micros);
+	}
+	return micros;
+}
+
+/**
+ * Spends virtual time on a flash operation, and shows it in the trace
+ *
+ * @param operation The name of the operation in the trace
+ * @param bytes The number of bytes the operation moved
+ * @param time The number of nanoseconds to spend
+ */
+void ioChargeFlash(const char* operation, long bytes, uint64_t time) {
+	uint64_t start = simMicros();
+	ioStats.flashTime += spend(time + ioFaults.slowFlash * 1000ULL);
+	traceSpan(operation, start, bytes);
+}
+
+/**
+ * Spends virtual time on serial output, and shows it in the trace
+ *
+ * @param bytes The number of bytes written
+ * @param time The number of nanoseconds to spend
+ */
+void ioChargeSerial(long bytes, uint64_t time) {
+	uint64_t start = simMicros();
+	ioStats.serialTime += spend(time);
+	traceSpan("serial write", start, bytes);
+}
+
+/**
+ * Decides whether to inject a fault, counting it if so
+ *
+ * @param chance The chance of a fault, from 0 to 1
+ *
+ * @return true if the operation should fail
+ */
+bool ioFault(double chance) {
+	if (chance <= 0) {
+		return false;
+	}
+	// xorshift32
+	faultState ^= faultState << 13;
+	faultState ^= faultState >> 17;
+	faultState ^= faultState << 5;
+	if (faultState >= chance * UINT32_MAX) {
+		return false;
+	}
+	ioStats.faults++;
+	return true;
+}
+
+/**
+ * Sets the virtual time charged for flash and serial operations (all zero, the default, makes them free)
+ *
+ * @param costs The costs, which are copied
+ */
+void simSetIoCosts(const sim_io_costs* costs) {
+	ioCosts = *costs;
+}
+
+/**
+ * Gets the counts of flash and serial operations since simResetIoStats()
+ *
+ * @param stats Set to the counts
+ */
+void simGetIoStats(sim_io_stats* stats) {
+	*stats = ioStats;
+}
+
+/**
+ * Sets the counts of flash and serial operations back to zero
+ */
+void simResetIoStats() {
+	memset(&ioStats, 0, sizeof(ioStats));
+}
+
+/**
+ * Starts injecting faults into the flash and serial operations (all zero, the default, injects none)
+ *
+ * @param newFaults The faults, which are copied
+ */
+void simSetFaults(const sim_faults* newFaults) {
+	ioFaults = *newFaults;
+	faultState = (ioFaults.seed == 0) ? 1 : ioFaults.seed;
+}
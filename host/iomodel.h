@@ -0,0 +1,64 @@
+/** @file iomodel.h
+ * @brief File for charging the costs of flash and serial operations in the simulated PROS API
+ *
+ * Used by flash.c and pros.c; test programs use simSetIoCosts() and simGetIoStats() in sim.h.
+ */
+
+#ifndef IOMODEL_H
+
+// This prevents multiple inclusion
+#define IOMODEL_H
+
+#include "sim.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The costs of each operation
+ */
+extern sim_io_costs ioCosts;
+
+/**
+ * The counts of each operation
+ */
+extern sim_io_stats ioStats;
+
+/**
+ * The faults to inject
+ */
+extern sim_faults ioFaults;
+
+/**
+ * Decides whether to inject a fault, counting it if so
+ *
+ * @param chance The chance of a fault, from 0 to 1
+ *
+ * @return true if the operation should fail
+ */
+bool ioFault(double chance);
+
+/**
+ * Spends virtual time on a flash operation, and shows it in the trace
+ *
+ * @param operation The name of the operation in the trace
+ * @param bytes The number of bytes the operation moved
+ * @param time The number of nanoseconds to spend
+ */
+void ioChargeFlash(const char* operation, long bytes, uint64_t time);
+
+/**
+ * Spends virtual time on serial output, and shows it in the trace
+ *
+ * @param bytes The number of bytes written
+ * @param time The number of nanoseconds to spend
+ */
+void ioChargeSerial(long bytes, uint64_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,443 @@
+/** @file link.c
+ * @brief File for the computer's end of the serial link to the robot
+ *
+ * The go-back-N window here mirrors sendStream() and receiveStream() in serialTransfer.c.
+ * Every byte that arrives passes through a frame decoder; bytes that are not part of a frame are
+ * the robot's printed text and are kept in a buffer until they are read as lines.
+ */
+
+#include "link.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Number of bytes of printed text that are kept while frames are being received
+ */
+#define LINK_TEXT_BUFFER_SIZE 8192
+
+/**
+ * Result of linkNext(): a byte of text is in nextText
+ */
+#define LINK_TEXT 3
+
+/**
+ * Result of linkNext(): nothing arrived in time
+ */
+#define LINK_TIMEOUT 4
+
+/**
+ * Whether or not every line of text from the robot is echoed to standard error
+ */
+bool linkVerbose = false;
+
+/**
+ * File descriptor of the serial port
+ */
+static int linkFd = -1;
+
+/**
+ * Bytes read from the serial port that have not been looked at yet
+ */
+static uint8_t inBuffer[1024];
+
+/**
+ * Index of the next byte to look at in inBuffer
+ */
+static int inPosition = 0;
+
+/**
+ * Number of bytes in inBuffer
+ */
+static int inLength = 0;
+
+/**
+ * Text that arrived while frames were being received
+ */
+static char textBuffer[LINK_TEXT_BUFFER_SIZE];
+
+/**
+ * Number of bytes in textBuffer
+ */
+static int textLength = 0;
+
+/**
+ * Index of the next byte to read from textBuffer
+ */
+static int textPosition = 0;
+
+/**
+ * The text byte returned by the last call to linkNext()
+ */
+static char nextText;
+
+/**
+ * Decoder for frames received from the robot
+ */
+static frame_decoder decoder;
+
+/**
+ * Sequence number of the last frame of the last stream received, or -1 if there is none
+ * The robot sends this frame again if its acknowledgement is lost, so it is acknowledged again.
+ */
+static int lastReceivedSeq = -1;
+
+/**
+ * Gets the time since an arbitrary point in the past
+ *
+ * @return the time in milliseconds
+ */
+static long linkMillis() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000L + now.tv_nsec / 1000000;
+}
+
+/**
+ * Opens the robot's serial port and throws away anything the robot printed before
+ *
+ * @param path The path of the serial port (or pseudo-terminal)
+ *
+ * @return true if the port was opened, false otherwise
+ */
+bool linkOpen(const char* path) {
+	linkFd = open(path, O_RDWR | O_NOCTTY);
+	if (linkFd < 0) {
+		perror(path);
+		return false;
+	}
+
+	struct termios settings;
+	if (tcgetattr(linkFd, &settings) == 0) {
+		cfmakeraw(&settings);
+		cfsetispeed(&settings, B115200);
+		cfsetospeed(&settings, B115200);
+		tcsetattr(linkFd, TCSANOW, &settings);
+		tcflush(linkFd, TCIFLUSH);
+	}
+	inPosition = inLength = 0;
+	textPosition = textLength = 0;
+	frameDecoderReset(&decoder);
+	return true;
+}
+
+/**
+ * Closes the robot's serial port
+ */
+void linkClose() {
+	if (linkFd >= 0) {
+		close(linkFd);
+		linkFd = -1;
+	}
+}
+
+/**
+ * Writes bytes to the robot
+ *
+ * @param data The bytes to write
+ * @param length The number of bytes
+ */
+void linkWrite(const void* data, size_t length) {
+	size_t written = 0;
+	while (written < length) {
+		ssize_t result = write(linkFd, (const uint8_t*) data + written, length - written);
+		if (result <= 0) {
+			perror("write");
+			return;
+		}
+		written += result;
+	}
+}
+
+/**
+ * Sends a shell command line to the robot
+ *
+ * @param line The command line, without a newline
+ */
+void linkCommand(const char* line) {
+	linkWrite(line, strlen(line));
+	linkWrite("\n", 1);
+}
+
+/**
+ * Reads a single raw byte from the robot, ignoring frames
+ *
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return the byte (0 - 255), or -1 if the time ran out
+ */
+int linkReadByte(int timeout) {
+	if (inPosition < inLength) {
+		return inBuffer[inPosition++];
+	}
+
+	struct pollfd request = { .fd = linkFd, .events = POLLIN };
+	if (poll(&request, 1, timeout) <= 0) {
+		return -1;
+	}
+	ssize_t result = read(linkFd, inBuffer, sizeof(inBuffer));
+	if (result <= 0) {
+		return -1;
+	}
+	inLength = result;
+	inPosition = 1;
+	return inBuffer[0];
+}
+
+/**
+ * Sends a control frame (ACK, NAK or ABORT) with no payload to the robot
+ *
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ */
+static void sendControlFrame(uint8_t type, uint8_t seq) {
+	uint8_t frame[FRAME_HEADER_LENGTH + FRAME_CRC_LENGTH];
+	linkWrite(frame, frameEncode(frame, type, seq, NULL, 0));
+}
+
+/**
+ * Waits for the next frame or byte of text from the robot
+ *
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return FRAME_READY or FRAME_CORRUPT if a frame arrived, LINK_TEXT if a byte of text arrived, or LINK_TIMEOUT
+ */
+static int linkNext(int timeout) {
+	long deadline = linkMillis() + timeout;
+	while (true) {
+		long remaining = deadline - linkMillis();
+		int c = linkReadByte(remaining > 0 ? remaining : 0);
+		if (c < 0) {
+			return LINK_TIMEOUT;
+		}
+		bool inFrame = decoder.position > 0;
+		int result = frameDecoderFeed(&decoder, c);
+		if (result != FRAME_INCOMPLETE) {
+			return result;
+		} else if (!inFrame && decoder.position == 0) {
+			nextText = c;
+			return LINK_TEXT;
+		}
+	}
+}
+
+/**
+ * Waits for the next frame from the robot, keeping any text that arrives first
+ *
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return FRAME_READY or FRAME_CORRUPT if a frame arrived, or LINK_TIMEOUT
+ */
+static int receiveFrame(int timeout) {
+	long deadline = linkMillis() + timeout;
+	while (true) {
+		long remaining = deadline - linkMillis();
+		int result = linkNext(remaining > 0 ? remaining : 0);
+		if (result != LINK_TEXT) {
+			return result;
+		} else if (textLength < LINK_TEXT_BUFFER_SIZE) {
+			textBuffer[textLength++] = nextText;
+		}
+	}
+}
+
+/**
+ * Reads a line of text from the robot
+ *
+ * @param line The buffer to read the line into, without the newline (LINK_LINE_MAX_LENGTH bytes)
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return true if a line was read, false if the time ran out
+ */
+bool linkReadLine(char* line, int timeout) {
+	long deadline = linkMillis() + timeout;
+	int length = 0;
+	while (true) {
+		char c;
+		if (textPosition < textLength) {
+			c = textBuffer[textPosition++];
+		} else {
+			textPosition = textLength = 0;
+			long remaining = deadline - linkMillis();
+			int result = linkNext(remaining > 0 ? remaining : 0);
+			if (result == LINK_TIMEOUT) {
+				line[length] = 0;
+				return false;
+			} else if (result != LINK_TEXT) {
+				// The robot did not hear the acknowledgement of the end of its last stream
+				if (result == FRAME_READY && lastReceivedSeq >= 0 && decoder.type != FRAME_ACK) {
+					sendControlFrame(FRAME_ACK, lastReceivedSeq);
+				}
+				continue;
+			}
+			c = nextText;
+		}
+
+		if (c == '\n') {
+			line[length] = 0;
+			if (linkVerbose) {
+				fprintf(stderr, "robot: %s\n", line);
+			}
+			return true;
+		} else if (c != '\r' && length < LINK_LINE_MAX_LENGTH - 1) {
+			line[length++] = c;
+		}
+	}
+}
+
+/**
+ * Reads lines from the robot until the shell reports that the command has finished
+ *
+ * @param print Whether or not to print the lines to standard output
+ *
+ * @return true if the command printed OK, false if it printed ERR or did not finish in time
+ */
+bool linkFinish(bool print) {
+	char line[LINK_LINE_MAX_LENGTH];
+	while (linkReadLine(line, LINK_COMMAND_TIMEOUT)) {
+		if (strcmp(line, "OK") == 0) {
+			return true;
+		} else if (strncmp(line, "ERR", 3) == 0) {
+			fprintf(stderr, "robot: %s\n", line);
+			return false;
+		} else if (print) {
+			printf("%s\n", line);
+		}
+	}
+	fprintf(stderr, "Timed out waiting for the robot.\n");
+	return false;
+}
+
+/**
+ * Sends a stream of frames to the robot, keeping up to TRANSFER_WINDOW of them in flight
+ *
+ * @param source The function that builds each frame of the stream
+ *
+ * @return true if every frame was acknowledged, false otherwise
+ */
+bool linkSendStream(link_source source) {
+	static uint8_t windowFrames[TRANSFER_WINDOW][FRAME_MAX_LENGTH];
+	static size_t windowLengths[TRANSFER_WINDOW];
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	uint8_t base = 0;
+	uint8_t next = 0;
+	bool ended = false;
+	int retries = 0;
+
+	while (true) {
+		while (!ended && (uint8_t) (next - base) < TRANSFER_WINDOW) {
+			uint8_t type;
+			uint16_t length;
+			int built = source(&type, payload, &length);
+			if (built < 0) {
+				sendControlFrame(FRAME_ABORT, next);
+				return false;
+			} else if (built == 0) {
+				ended = true;
+				break;
+			}
+			int index = next % TRANSFER_WINDOW;
+			windowLengths[index] = frameEncode(windowFrames[index], type, next, payload, length);
+			linkWrite(windowFrames[index], windowLengths[index]);
+			next++;
+		}
+		if (ended && base == next) {
+			return true;
+		}
+
+		int result = receiveFrame(TRANSFER_ACK_TIMEOUT);
+		if (result == FRAME_READY && decoder.type == FRAME_ABORT) {
+			fprintf(stderr, "Transfer aborted by robot.\n");
+			return false;
+		} else if (result == FRAME_READY && decoder.type == FRAME_ACK) {
+			if ((uint8_t) (decoder.seq - base) < (uint8_t) (next - base)) {
+				base = decoder.seq + 1;
+				retries = 0;
+			}
+			continue;
+		} else if (result == FRAME_READY && decoder.type == FRAME_NAK) {
+			if ((uint8_t) (decoder.seq - base) <= (uint8_t) (next - base)) {
+				base = decoder.seq;
+			}
+		} else if (result == FRAME_READY) {
+			// The robot is still sending the end of the last stream because its acknowledgement was lost
+			if (lastReceivedSeq >= 0) {
+				sendControlFrame(FRAME_ACK, lastReceivedSeq);
+			}
+			continue;
+		} else if (result == FRAME_CORRUPT) {
+			continue;
+		}
+
+		if (++retries > TRANSFER_MAX_RETRIES) {
+			fprintf(stderr, "The robot stopped responding.\n");
+			sendControlFrame(FRAME_ABORT, next);
+			return false;
+		}
+		for (uint8_t seq = base; seq != next; seq++) {
+			linkWrite(windowFrames[seq % TRANSFER_WINDOW], windowLengths[seq % TRANSFER_WINDOW]);
+		}
+	}
+}
+
+/**
+ * Receives a stream of frames from the robot, handing each one to the sink in order
+ *
+ * @param sink The function that handles each frame
+ * @param timeout The number of milliseconds to wait for the first frame
+ *
+ * @return true if the sink accepted the whole stream, false otherwise
+ */
+bool linkReceiveStream(link_sink sink, int timeout) {
+	uint8_t expected = 0;
+	bool nakSent = false;
+
+	lastReceivedSeq = -1;
+	while (true) {
+		int result = receiveFrame(timeout);
+		if (result == LINK_TIMEOUT) {
+			fprintf(stderr, "Timed out waiting for frame %d.\n", expected);
+			return false;
+		} else if (result == FRAME_CORRUPT) {
+			if (!nakSent) {
+				sendControlFrame(FRAME_NAK, expected);
+				nakSent = true;
+			}
+			continue;
+		} else if (decoder.type == FRAME_ABORT) {
+			fprintf(stderr, "Transfer aborted by robot.\n");
+			return false;
+		} else if (decoder.type == FRAME_ACK || decoder.type == FRAME_NAK) {
+			continue;
+		} else if (decoder.seq != expected) {
+			if ((uint8_t) (decoder.seq - expected) < 128) {
+				if (!nakSent) {
+					sendControlFrame(FRAME_NAK, expected);
+					nakSent = true;
+				}
+			} else {
+				sendControlFrame(FRAME_ACK, expected - 1);
+			}
+			continue;
+		}
+
+		int handled = sink(&decoder);
+		if (handled < 0) {
+			sendControlFrame(FRAME_ABORT, expected);
+			return false;
+		}
+		sendControlFrame(FRAME_ACK, expected);
+		expected++;
+		nakSent = false;
+		timeout = TRANSFER_ACK_TIMEOUT * (TRANSFER_MAX_RETRIES + 1);
+
+		if (handled == 0) {
+			lastReceivedSeq = expected - 1;
+			return true;
+		}
+	}
+}
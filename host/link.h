@@ -0,0 +1,136 @@
+/** @file link.h
+ * @brief File for the computer's end of the serial link to the robot
+ *
+ * Opens the robot's serial port, runs shell commands and sends and receives frame streams with
+ * the same window, acknowledgements and timeouts as serialTransfer.c on the robot.
+ * Text printed by the robot between frames is kept so that it can be read as lines afterwards.
+ */
+
+#ifndef LINK_H
+
+// This prevents multiple inclusion
+#define LINK_H
+
+#include "frame.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maximum length of a line of text read from the robot, including the terminating null character
+ */
+#define LINK_LINE_MAX_LENGTH 256
+
+/**
+ * Number of milliseconds to wait for a shell command to finish
+ */
+#define LINK_COMMAND_TIMEOUT 30000
+
+/**
+ * Function that builds the next frame of an outgoing stream
+ *
+ * @param type Set to the type of the frame
+ * @param payload The buffer to build the payload in (FRAME_MAX_PAYLOAD bytes)
+ * @param length Set to the number of bytes in the payload
+ *
+ * @return 1 if a frame was built, 0 if the stream has ended, or -1 if the stream must be aborted
+ */
+typedef int (*link_source)(uint8_t* type, uint8_t* payload, uint16_t* length);
+
+/**
+ * Function that handles the next frame of an incoming stream
+ *
+ * @param frame The decoder holding the frame
+ *
+ * @return 1 to keep receiving, 0 if this was the last frame of the stream, or -1 if the stream must be aborted
+ */
+typedef int (*link_sink)(const frame_decoder* frame);
+
+/**
+ * Whether or not every line of text from the robot is echoed to standard error
+ */
+extern bool linkVerbose;
+
+/**
+ * Opens the robot's serial port and throws away anything the robot printed before
+ *
+ * @param path The path of the serial port (or pseudo-terminal)
+ *
+ * @return true if the port was opened, false otherwise
+ */
+bool linkOpen(const char* path);
+
+/**
+ * Closes the robot's serial port
+ */
+void linkClose();
+
+/**
+ * Writes bytes to the robot
+ *
+ * @param data The bytes to write
+ * @param length The number of bytes
+ */
+void linkWrite(const void* data, size_t length);
+
+/**
+ * Sends a shell command line to the robot
+ *
+ * @param line The command line, without a newline
+ */
+void linkCommand(const char* line);
+
+/**
+ * Reads a line of text from the robot
+ *
+ * @param line The buffer to read the line into, without the newline (LINK_LINE_MAX_LENGTH bytes)
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return true if a line was read, false if the time ran out
+ */
+bool linkReadLine(char* line, int timeout);
+
+/**
+ * Reads lines from the robot until the shell reports that the command has finished
+ *
+ * @param print Whether or not to print the lines to standard output
+ *
+ * @return true if the command printed OK, false if it printed ERR or did not finish in time
+ */
+bool linkFinish(bool print);
+
+/**
+ * Reads a single raw byte from the robot, ignoring frames
+ *
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return the byte (0 - 255), or -1 if the time ran out
+ */
+int linkReadByte(int timeout);
+
+/**
+ * Sends a stream of frames to the robot, keeping up to TRANSFER_WINDOW of them in flight
+ *
+ * @param source The function that builds each frame of the stream
+ *
+ * @return true if every frame was acknowledged, false otherwise
+ */
+bool linkSendStream(link_source source);
+
+/**
+ * Receives a stream of frames from the robot, handing each one to the sink in order
+ *
+ * @param sink The function that handles each frame
+ * @param timeout The number of milliseconds to wait for the first frame
+ *
+ * @return true if the sink accepted the whole stream, false otherwise
+ */
+bool linkReceiveStream(link_sink sink, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
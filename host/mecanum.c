@@ -0,0 +1,180 @@
+/** @file mecanum.c
+ * @brief File for the physics model of the mecanum drivetrain
+ *
+ * Each wheel at (x, y) from the center has rollers that roll freely along one diagonal, so it can
+ * only push the robot along the other one, u = (1, s) / sqrt(2), where s is -1 for the front left
+ * and back right wheels and 1 for the others. Rolling without slip would need the wheel's rim
+ * speed to equal vx + s * vy at the wheel; the difference is the slip, which gives a force along u
+ * that turns back the wheel and moves the robot. The motor torque is (V - ke * w) * kt / R, with
+ * the constants chosen to match the stall torque, free speed and stall current.
+ */
+
+#include "mecanum.h"
+#include <math.h>
+
+/**
+ * Acceleration due to gravity in m/s^2
+ */
+#define MECANUM_GRAVITY 9.81
+
+/**
+ * Which way the free diagonal of each wheel's rollers points
+ */
+static const int rollerSign[MECANUM_WHEELS] = { -1, 1, 1, -1 };
+
+/**
+ * Whether each wheel is on the front (1) or back (-1) of the robot
+ */
+static const int wheelFront[MECANUM_WHEELS] = { 1, 1, -1, -1 };
+
+/**
+ * Whether each wheel is on the left (1) or right (-1) of the robot
+ */
+static const int wheelLeft[MECANUM_WHEELS] = { 1, -1, 1, -1 };
+
+/**
+ * Gets the properties of the Starstruck robot: about 7 kg on 4 inch wheels, each driven by a
+ * high speed 393 motor, on a 7.8 V battery
+ *
+ * @param params Set to the properties
+ */
+void mecanumDefaults(mecanum_params* params) {
+	params->mass = 7.0;
+	params->inertia = 0.15;
+	params->halfLength = 0.165;
+	params->halfWidth = 0.19;
+	params->wheelRadius = 0.0508;
+	params->wheelInertia = 0.003;
+	params->stallTorque = 1.04;
+	params->freeSpeed = 160.0 * 2.0 * M_PI / 60.0;
+	params->stallCurrent = 4.8;
+	params->nominalVoltage = 7.2;
+	params->deadband = 0;
+	params->saturation = 90;
+	params->friction = 0.6;
+	params->slipStiffness = 300.0;
+	params->drag = 2.0;
+	params->batteryVoltage = 7.8;
+	params->batteryResistance = 0.08;
+}
+
+/**
+ * Puts a robot at rest at the origin, facing along x, with a full battery
+ *
+ * @param model The robot
+ * @param params The physical properties of the robot, which are copied
+ */
+void mecanumReset(mecanum_model* model, const mecanum_params* params) {
+	model->params = *params;
+	model->x = 0.0;
+	model->y = 0.0;
+	model->heading = 0.0;
+	model->vx = 0.0;
+	model->vy = 0.0;
+	model->omega = 0.0;
+	for (int i = 0; i < MECANUM_WHEELS; i++) {
+		model->wheelSpeed[i] = 0.0;
+		model->wheelAngle[i] = 0.0;
+	}
+	model->voltage = params->batteryVoltage;
+	model->current = 0.0;
+}
+
+/**
+ * Gets the fraction of the battery voltage that a motor controller gives for a command
+ *
+ * @param params The properties of the robot
+ * @param command The motor command (-127 to 127)
+ *
+ * @return the duty cycle (-1 to 1)
+ */
+static double motorDuty(const mecanum_params* params, int command) {
+	int magnitude = command < 0 ? -command : command;
+	if (magnitude <= params->deadband) {
+		return 0.0;
+	}
+	double duty = (double) (magnitude - params->deadband) / (params->saturation - params->deadband);
+	if (duty > 1.0) {
+		duty = 1.0;
+	}
+	return command < 0 ? -duty : duty;
+}
+
+/**
+ * Moves a robot forward by one short step
+ *
+ * @param model The robot
+ * @param duties The duty cycle of each wheel's motor
+ * @param dt The step in seconds, at most MECANUM_MAX_STEP
+ */
+static void step(mecanum_model* model, const double duties[MECANUM_WHEELS], double dt) {
+	const mecanum_params* params = &model->params;
+	double resistance = params->nominalVoltage / params->stallCurrent;
+	double ke = params->nominalVoltage / params->freeSpeed;
+	double kt = params->stallTorque / params->stallCurrent;
+	double maxForce = params->friction * params->mass * MECANUM_GRAVITY / MECANUM_WHEELS;
+	double cosine = cos(model->heading);
+	double sine = sin(model->heading);
+	// Velocity in the robot's own frame
+	double forward = model->vx * cosine + model->vy * sine;
+	double left = -model->vx * sine + model->vy * cosine;
+
+	double forceForward = -params->drag * forward;
+	double forceLeft = -params->drag * left;
+	double torque = -params->drag * model->omega * params->halfLength * params->halfWidth;
+	double current = 0.0;
+	for (int i = 0; i < MECANUM_WHEELS; i++) {
+		double wheelX = wheelFront[i] * params->halfLength;
+		double wheelY = wheelLeft[i] * params->halfWidth;
+		double groundForward = forward - model->omega * wheelY;
+		double groundLeft = left + model->omega * wheelX;
+		double slip = (model->wheelSpeed[i] * params->wheelRadius - groundForward - rollerSign[i] * groundLeft) / M_SQRT2;
+		double force = params->slipStiffness * slip;
+		if (force > maxForce) {
+			force = maxForce;
+		} else if (force < -maxForce) {
+			force = -maxForce;
+		}
+		double pushForward = force / M_SQRT2;
+		double pushLeft = rollerSign[i] * force / M_SQRT2;
+		forceForward += pushForward;
+		forceLeft += pushLeft;
+		torque += wheelX * pushLeft - wheelY * pushForward;
+
+		double motorCurrent = (duties[i] * model->voltage - ke * model->wheelSpeed[i]) / resistance;
+		current += fabs(duties[i] * motorCurrent);
+		double wheelTorque = kt * motorCurrent - force * params->wheelRadius / M_SQRT2;
+		model->wheelSpeed[i] += wheelTorque / params->wheelInertia * dt;
+		model->wheelAngle[i] += model->wheelSpeed[i] * dt;
+	}
+
+	model->vx += (forceForward * cosine - forceLeft * sine) / params->mass * dt;
+	model->vy += (forceForward * sine + forceLeft * cosine) / params->mass * dt;
+	model->omega += torque / params->inertia * dt;
+	model->x += model->vx * dt;
+	model->y += model->vy * dt;
+	model->heading += model->omega * dt;
+	model->current = current;
+	model->voltage = params->batteryVoltage - params->batteryResistance * current;
+	if (model->voltage < 0.0) {
+		model->voltage = 0.0;
+	}
+}
+
+/**
+ * Moves a robot forward in time with its motors held at the given commands
+ *
+ * @param model The robot
+ * @param commands The command of each wheel's motor (-127 to 127), positive to drive the robot forward
+ * @param time The time to move forward in seconds
+ */
+void mecanumStep(mecanum_model* model, const int commands[MECANUM_WHEELS], double time) {
+	double duties[MECANUM_WHEELS];
+	for (int i = 0; i < MECANUM_WHEELS; i++) {
+		duties[i] = motorDuty(&model->params, commands[i]);
+	}
+	int steps = (int) ceil(time / MECANUM_MAX_STEP);
+	for (int i = 0; i < steps; i++) {
+		step(model, duties, time / steps);
+	}
+}
@@ -0,0 +1,212 @@
+/** @file mecanum.h
+ * @brief File for the physics model of the mecanum drivetrain
+ *
+ * A 2D rigid body on four mecanum wheels with 45 degree rollers, each turned by a 393 motor. Each
+ * motor follows a linear torque-speed curve fed by a PWM duty from its motor command and by the
+ * battery, whose voltage sags with the total current. Each wheel pushes the robot along the
+ * direction its rollers cannot roll, with a force that grows with slip until friction runs out.
+ *
+ * The model has no global state, so any number of robots can be simulated at once.
+ */
+
+#ifndef MECANUM_H
+
+// This prevents multiple inclusion
+#define MECANUM_H
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Index of each wheel in the arrays of the model
+ */
+#define MECANUM_FRONT_LEFT 0
+#define MECANUM_FRONT_RIGHT 1
+#define MECANUM_BACK_LEFT 2
+#define MECANUM_BACK_RIGHT 3
+
+/**
+ * Number of wheels
+ */
+#define MECANUM_WHEELS 4
+
+/**
+ * Longest time step in seconds; longer steps are split so that the wheel contact stays stable
+ */
+#define MECANUM_MAX_STEP 0.0005
+
+/**
+ * The physical properties of the robot
+ */
+typedef struct mecanum_params {
+	/**
+	 * Mass of the robot in kilograms
+	 */
+	double mass;
+
+	/**
+	 * Moment of inertia of the robot about its vertical axis in kg m^2
+	 */
+	double inertia;
+
+	/**
+	 * Distance from the center to the front and back axles in meters
+	 */
+	double halfLength;
+
+	/**
+	 * Distance from the center to the left and right wheels in meters
+	 */
+	double halfWidth;
+
+	/**
+	 * Radius of the wheels in meters
+	 */
+	double wheelRadius;
+
+	/**
+	 * Moment of inertia of a wheel with its gears and motor, seen at the wheel, in kg m^2
+	 */
+	double wheelInertia;
+
+	/**
+	 * Torque at the wheel of a stalled motor at the nominal voltage in N m
+	 */
+	double stallTorque;
+
+	/**
+	 * Speed of the wheel of a free-running motor at the nominal voltage in radians per second
+	 */
+	double freeSpeed;
+
+	/**
+	 * Current drawn by a stalled motor at the nominal voltage in amperes
+	 */
+	double stallCurrent;
+
+	/**
+	 * Voltage at which the stall torque, free speed and stall current were measured
+	 */
+	double nominalVoltage;
+
+	/**
+	 * Motor commands from -deadband to deadband do not turn the motor
+	 */
+	int deadband;
+
+	/**
+	 * Motor command (and above) that gives the full battery voltage; the motor controllers reach
+	 * nearly full speed well before 127
+	 */
+	int saturation;
+
+	/**
+	 * Friction coefficient between the rollers and the floor
+	 */
+	double friction;
+
+	/**
+	 * Force from each wheel per meter per second of slip, until friction runs out, in N s/m
+	 */
+	double slipStiffness;
+
+	/**
+	 * Force against the motion of the robot per meter per second of speed (rolling resistance), in N s/m
+	 */
+	double drag;
+
+	/**
+	 * Voltage of the battery with no load
+	 */
+	double batteryVoltage;
+
+	/**
+	 * Resistance of the battery, wiring and breakers in ohms
+	 */
+	double batteryResistance;
+} mecanum_params;
+
+/**
+ * The state of a simulated robot
+ */
+typedef struct mecanum_model {
+	/**
+	 * The physical properties of the robot
+	 */
+	mecanum_params params;
+
+	/**
+	 * Position of the center of the robot in meters; x is forward and y is left at the start
+	 */
+	double x;
+	double y;
+
+	/**
+	 * Heading of the robot in radians, counterclockwise from the start
+	 */
+	double heading;
+
+	/**
+	 * Velocity of the robot in meters per second, in the same frame as the position
+	 */
+	double vx;
+	double vy;
+
+	/**
+	 * Rate of turn of the robot in radians per second, counterclockwise
+	 */
+	double omega;
+
+	/**
+	 * Speed of each wheel in radians per second, positive when it would drive the robot forward
+	 */
+	double wheelSpeed[MECANUM_WHEELS];
+
+	/**
+	 * Angle each wheel has turned since the reset in radians, positive the way it would drive the robot forward
+	 */
+	double wheelAngle[MECANUM_WHEELS];
+
+	/**
+	 * Voltage at the battery terminals, after the sag from the last step's current
+	 */
+	double voltage;
+
+	/**
+	 * Total current drawn from the battery in the last step in amperes
+	 */
+	double current;
+} mecanum_model;
+
+/**
+ * Gets the properties of the Starstruck robot: about 7 kg on 4 inch wheels, each driven by a
+ * high speed 393 motor, on a 7.8 V battery
+ *
+ * @param params Set to the properties
+ */
+void mecanumDefaults(mecanum_params* params);
+
+/**
+ * Puts a robot at rest at the origin, facing along x, with a full battery
+ *
+ * @param model The robot
+ * @param params The physical properties of the robot, which are copied
+ */
+void mecanumReset(mecanum_model* model, const mecanum_params* params);
+
+/**
+ * Moves a robot forward in time with its motors held at the given commands
+ *
+ * @param model The robot
+ * @param commands The command of each wheel's motor (-127 to 127), positive to drive the robot forward
+ * @param time The time to move forward in seconds
+ */
+void mecanumStep(mecanum_model* model, const int commands[MECANUM_WHEELS], double time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,761 @@
+/** @file pros.c
+ * @brief File for the devices of the simulated PROS API used when the robot code runs on a computer
+ *
+ * Implements the stdio, LCD, motor, joystick, sensor and competition parts of API.h. Flash
+ * files are passed on to flash.c and the serial monitor (stdin and stdout) is a buffer filled
+ * from a file descriptor once per tick or by simSerialInput(). Tasks and time are in sim.c.
+ *
+ * This file is compiled with prosnames.h like the robot code, so it must not include <stdio.h>.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include "flash.h"
+#include "iomodel.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Number of the first FILE handle used for flash files (1 - 3 are the serial ports)
+ */
+#define SIM_FIRST_FILE 4
+
+/**
+ * Largest line that the printf functions can print at once
+ */
+#define SIM_PRINT_MAX_LENGTH 512
+
+/**
+ * Number of real milliseconds to wait for the serial monitor to accept output before throwing it away
+ */
+#define SIM_SERIAL_WRITE_TIMEOUT 1000
+
+/**
+ * File descriptor of the serial monitor
+ */
+static int serialFd = -1;
+
+/**
+ * Serial input that has not been read yet
+ */
+static uint8_t serialBuffer[SIM_SERIAL_BUFFER_SIZE];
+
+/**
+ * Index in serialBuffer of the next byte to read
+ */
+static int serialStart = 0;
+
+/**
+ * Number of bytes in serialBuffer
+ */
+static int serialCount = 0;
+
+/**
+ * Text on the LCD
+ */
+static char lcdLines[2][SIM_LCD_LINE_LENGTH];
+
+/**
+ * LCD buttons held down
+ */
+static unsigned int lcdButtons = 0;
+
+/**
+ * Values last sent to each motor
+ */
+static int motorValues[10];
+
+/**
+ * Analog axes of each joystick (axes 1 - 4, ACCEL_X and ACCEL_Y)
+ */
+static int joystickAxes[2][6];
+
+/**
+ * Buttons held down on each joystick, as JOY_ bits for button groups 5 - 8
+ */
+static unsigned int joystickButtons[2][4];
+
+/**
+ * Values read from the analog inputs
+ */
+static int analogValues[8];
+
+/**
+ * Values found by analogCalibrate() on the analog inputs
+ */
+static int analogCalibrations[8];
+
+/**
+ * Values read from the digital pins (pulled up, so true when nothing is connected)
+ */
+static bool digitalValues[12] = { true, true, true, true, true, true, true, true, true, true, true, true };
+
+/**
+ * Voltage of the main battery in millivolts
+ */
+static unsigned int batteryMillivolts = 7800;
+
+/**
+ * Number of IMEs connected to the robot
+ */
+static int imesConnected = 0;
+
+/**
+ * Whether or not imeInitializeAll() has found the IMEs since they were last shut down
+ */
+static bool imesInitialized = false;
+
+/**
+ * Counts each IME has turned since the robot started, and the counts at its last reset
+ */
+static int imeCounts[SIM_MAX_IMES];
+static int imeResetCounts[SIM_MAX_IMES];
+
+/**
+ * Velocity of each IME (RPM of the encoder wheel)
+ */
+static int imeVelocities[SIM_MAX_IMES];
+
+/**
+ * Degrees each analog port's gyro has turned since the robot started, and the degrees at its last reset
+ */
+static int gyroDegrees[8];
+static int gyroResetDegrees[8];
+
+/**
+ * The gyro of each analog port, while it is initialized; a Gyro points to its port's entry
+ */
+static unsigned char gyroPorts[8];
+static bool gyrosInitialized[8];
+
+/**
+ * Whether or not the robot is connected to a field controller
+ */
+static bool competitionOnline = false;
+
+/**
+ * Whether or not the robot is enabled
+ */
+static bool competitionEnabled = true;
+
+/**
+ * Whether or not the robot is in autonomous mode
+ */
+static bool competitionAutonomous = false;
+
+/**
+ * Adds bytes to the serial input, as if they had been typed into the serial monitor
+ * Bytes that do not fit in the buffer are lost, as they would be on the robot.
+ *
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+void simSerialInput(const void* data, int length) {
+	ioStats.serialBytesIn += length;
+	for (int i = 0; i < length && serialCount < SIM_SERIAL_BUFFER_SIZE; i++) {
+		if (ioFault(ioFaults.serialDrop)) {
+			continue;
+		}
+		uint8_t c = ((const uint8_t*) data)[i];
+		if (ioFault(ioFaults.serialCorrupt)) {
+			c ^= 1 << (i % 8);
+		}
+		serialBuffer[(serialStart + serialCount) % SIM_SERIAL_BUFFER_SIZE] = c;
+		serialCount++;
+	}
+}
+
+/**
+ * Moves bytes that have arrived on the serial file descriptor into the serial input
+ */
+static void pollSerial() {
+	uint8_t data[256];
+	int space = MIN((int) sizeof(data), SIM_SERIAL_BUFFER_SIZE - serialCount);
+	ssize_t length = (serialFd >= 0 && space > 0) ? read(serialFd, data, space) : 0;
+	if (length > 0) {
+		simSerialInput(data, length);
+	}
+}
+
+/**
+ * Sets the file descriptor that the serial monitor (stdin and stdout) reads from and writes to
+ * Input is read without blocking once per millisecond of virtual time.
+ *
+ * @param fd The file descriptor, or -1 to throw away output and only receive input from simSerialInput()
+ */
+void simSerialOpen(int fd) {
+	if (serialFd < 0 && fd >= 0) {
+		simAddTickHook(&pollSerial);
+	}
+	serialFd = fd;
+	if (fd >= 0) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	}
+}
+
+/**
+ * Gets a line of the simulated LCD
+ *
+ * @param line The line number (1 or 2)
+ *
+ * @return the text on the line
+ */
+const char* simLcdLine(int line) {
+	return lcdLines[(line == 2) ? 1 : 0];
+}
+
+/**
+ * Sets which LCD buttons are held down
+ *
+ * @param buttons The LCD_BTN_LEFT, LCD_BTN_CENTER and LCD_BTN_RIGHT bits of the held buttons
+ */
+void simLcdSetButtons(unsigned int buttons) {
+	lcdButtons = buttons;
+}
+
+/**
+ * Gets the value last sent to a motor
+ *
+ * @param channel The motor channel (1 - 10)
+ *
+ * @return the motor value (-127 to 127)
+ */
+int simMotorGet(int channel) {
+	return (channel >= 1 && channel <= 10) ? motorValues[channel - 1] : 0;
+}
+
+/**
+ * Sets an analog axis of a joystick
+ *
+ * @param joystick The joystick (1 or 2)
+ * @param axis The axis (1 - 4, ACCEL_X or ACCEL_Y)
+ * @param value The value of the axis (-127 to 127)
+ */
+void simJoystickSetAnalog(int joystick, int axis, int value) {
+	if (joystick >= 1 && joystick <= 2 && axis >= 1 && axis <= 6) {
+		joystickAxes[joystick - 1][axis - 1] = MAX(-127, MIN(127, value));
+	}
+}
+
+/**
+ * Sets whether a joystick button is held down
+ *
+ * @param joystick The joystick (1 or 2)
+ * @param buttonGroup The button group (5 - 8)
+ * @param button JOY_UP, JOY_DOWN, JOY_LEFT or JOY_RIGHT
+ * @param pressed Whether or not the button is held down
+ */
+void simJoystickSetDigital(int joystick, int buttonGroup, int button, bool pressed) {
+	if (joystick >= 1 && joystick <= 2 && buttonGroup >= 5 && buttonGroup <= 8) {
+		unsigned int* buttons = &joystickButtons[joystick - 1][buttonGroup - 5];
+		*buttons = pressed ? (*buttons | button) : (*buttons & ~button);
+	}
+}
+
+/**
+ * Sets the value read from an analog input
+ *
+ * @param channel The analog channel (1 - 8)
+ * @param value The value (0 - 4095)
+ */
+void simSetAnalog(int channel, int value) {
+	if (channel >= 1 && channel <= 8) {
+		analogValues[channel - 1] = MAX(0, MIN(4095, value));
+	}
+}
+
+/**
+ * Sets the value read from a digital input
+ *
+ * @param pin The digital pin (1 - 12)
+ * @param value The value
+ */
+void simSetDigital(int pin, bool value) {
+	if (pin >= 1 && pin <= 12) {
+		digitalValues[pin - 1] = value;
+	}
+}
+
+/**
+ * Sets the voltage of the main battery
+ *
+ * @param millivolts The voltage in millivolts
+ */
+void simSetBattery(unsigned int millivolts) {
+	batteryMillivolts = millivolts;
+}
+
+/**
+ * Connects integrated motor encoders (IMEs) to the robot; imeInitializeAll() finds this many
+ *
+ * @param count The number of IMEs, at addresses 0 to count - 1 (at most SIM_MAX_IMES)
+ */
+void simSetImes(int count) {
+	imesConnected = MAX(0, MIN(SIM_MAX_IMES, count));
+}
+
+/**
+ * Sets what an integrated motor encoder measures
+ *
+ * @param address The address of the IME
+ * @param counts The counts it has turned since the robot started; imeGet() reads them less those at its last reset
+ * @param velocity The velocity that imeGetVelocity() reads (RPM of the encoder wheel)
+ */
+void simSetIme(int address, int counts, int velocity) {
+	if (address >= 0 && address < SIM_MAX_IMES) {
+		imeCounts[address] = counts;
+		imeVelocities[address] = velocity;
+	}
+}
+
+/**
+ * Sets what a gyro measures; gyroInit() and gyroReset() take the heading then as zero
+ *
+ * @param channel The analog port of the gyro, from 1 to 8
+ * @param degrees The degrees it has turned counterclockwise since the robot started
+ */
+void simSetGyro(int channel, int degrees) {
+	if (channel >= 1 && channel <= 8) {
+		gyroDegrees[channel - 1] = degrees;
+	}
+}
+
+/**
+ * Sets the competition state reported to the robot code
+ *
+ * @param online Whether or not the robot is connected to a field controller
+ * @param enabled Whether or not the robot is enabled
+ * @param autonomous Whether or not the robot is in autonomous mode
+ */
+void simSetCompetition(bool online, bool enabled, bool autonomous) {
+	competitionOnline = online;
+	competitionEnabled = enabled;
+	competitionAutonomous = autonomous;
+}
+
+/**
+ * Writes all of a buffer to a file descriptor, waiting a limited time for it to accept the bytes
+ *
+ * @param fd The file descriptor
+ * @param data The bytes to write
+ * @param length The number of bytes to write
+ *
+ * @return the number of bytes written
+ */
+static size_t writeAll(int fd, const void* data, size_t length) {
+	size_t written = 0;
+	while (fd >= 0 && written < length) {
+		ssize_t result = write(fd, (const char*) data + written, length - written);
+		if (result > 0) {
+			written += result;
+			continue;
+		}
+		struct pollfd ready = { .fd = fd, .events = POLLOUT };
+		if (result < 0 && errno == EAGAIN && poll(&ready, 1, SIM_SERIAL_WRITE_TIMEOUT) > 0) {
+			continue;
+		}
+		break;
+	}
+	return written;
+}
+
+/**
+ * Writes serial output to a file descriptor, losing or damaging bytes as simSetFaults() asks
+ *
+ * @param fd The file descriptor
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+static void writeFaulty(int fd, const void* data, size_t length) {
+	uint8_t sent[256];
+	size_t count = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (ioFault(ioFaults.serialDrop)) {
+			continue;
+		}
+		sent[count] = ((const uint8_t*) data)[i];
+		if (ioFault(ioFaults.serialCorrupt)) {
+			sent[count] ^= 1 << (i % 8);
+		}
+		if (++count == sizeof(sent)) {
+			writeAll(fd, sent, count);
+			count = 0;
+		}
+	}
+	writeAll(fd, sent, count);
+}
+
+/**
+ * Prints a message to the standard error of the computer, adding a newline
+ *
+ * @param format The format string, as for printf
+ */
+void simLog(const char* format, ...) {
+	char line[SIM_PRINT_MAX_LENGTH];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line) - 1, format, args);
+	va_end(args);
+	length = MIN(length, (int) sizeof(line) - 2);
+	line[length++] = '\n';
+	writeAll(STDERR_FILENO, line, length);
+}
+
+/**
+ * Gets the flash file handle behind a PROS stream
+ *
+ * @param stream The stream
+ *
+ * @return the flash.c handle, or -1 if the stream is not a flash file
+ */
+static int flashHandle(FILE* stream) {
+	intptr_t handle = (intptr_t) stream;
+	return (handle >= SIM_FIRST_FILE && handle < SIM_FIRST_FILE + SIM_MAX_FILES) ? handle - SIM_FIRST_FILE : -1;
+}
+
+/**
+ * Checks whether serial input is waiting to be read
+ *
+ * @param argument Unused
+ *
+ * @return true if there is at least one byte of serial input
+ */
+static bool serialAvailable(void* argument) {
+	return serialCount > 0;
+}
+
+FILE* fopen(const char* file, const char* mode) {
+	int handle = flashOpen(file, mode);
+	return (handle < 0) ? NULL : (FILE*) (intptr_t) (SIM_FIRST_FILE + handle);
+}
+
+void fclose(FILE* stream) {
+	flashClose(flashHandle(stream));
+}
+
+int fdelete(const char* file) {
+	return flashDelete(file);
+}
+
+int fcount(FILE* stream) {
+	return (stream == stdin) ? serialCount : flashCount(flashHandle(stream));
+}
+
+int feof(FILE* stream) {
+	return stream != stdin && fcount(stream) <= 0;
+}
+
+int fflush(FILE* stream) {
+	return 0;
+}
+
+int fgetc(FILE* stream) {
+	if (stream == stdin) {
+		simWait(&serialAvailable, NULL, (unsigned long) -1);
+		int c = serialBuffer[serialStart];
+		serialStart = (serialStart + 1) % SIM_SERIAL_BUFFER_SIZE;
+		serialCount--;
+		return c;
+	}
+	unsigned char c;
+	return (flashRead(flashHandle(stream), &c, 1) == 1) ? c : EOF;
+}
+
+char* fgets(char* str, int num, FILE* stream) {
+	int i = 0;
+	while (i < num - 1) {
+		int c = fgetc(stream);
+		if (c == EOF) {
+			break;
+		}
+		str[i++] = c;
+		if (c == '\n') {
+			break;
+		}
+	}
+	str[i] = 0;
+	return (i == 0) ? NULL : str;
+}
+
+size_t fread(void* ptr, size_t size, size_t count, FILE* stream) {
+	if (size == 0) {
+		return 0;
+	} else if (stream == stdin) {
+		for (size_t i = 0; i < size * count; i++) {
+			((uint8_t*) ptr)[i] = fgetc(stdin);
+		}
+		return count;
+	}
+	return flashRead(flashHandle(stream), ptr, size * count) / size;
+}
+
+size_t fwrite(const void* ptr, size_t size, size_t count, FILE* stream) {
+	if (size == 0) {
+		return 0;
+	}
+	uartCount(stream, size * count);
+	if (stream == stdout) {
+		ioStats.serialWrites++;
+		ioStats.serialBytesOut += size * count;
+		ioChargeSerial(size * count, ioCosts.serialCall + (uint64_t) (size * count) * ioCosts.serialByte);
+		if (serialFd >= 0 && (ioFaults.serialDrop > 0 || ioFaults.serialCorrupt > 0)) {
+			writeFaulty(serialFd, ptr, size * count);
+		} else if (serialFd >= 0) {
+			writeAll(serialFd, ptr, size * count);
+		}
+		return count;
+	}
+	return flashWrite(flashHandle(stream), ptr, size * count) / size;
+}
+
+int fseek(FILE* stream, long int offset, int origin) {
+	return flashSeek(flashHandle(stream), offset, origin);
+}
+
+long int ftell(FILE* stream) {
+	return flashTell(flashHandle(stream));
+}
+
+int fputc(int value, FILE* stream) {
+	unsigned char c = value;
+	return fwrite(&c, 1, 1, stream) == 1 ? c : EOF;
+}
+
+int fputs(const char* string, FILE* stream) {
+	return fwrite(string, 1, strlen(string), stream);
+}
+
+void fprint(const char* string, FILE* stream) {
+	fputs(string, stream);
+}
+
+int getchar() {
+	return fgetc(stdin);
+}
+
+int putchar(int value) {
+	return fputc(value, stdout);
+}
+
+int puts(const char* string) {
+	fputs(string, stdout);
+	return fputc('\n', stdout);
+}
+
+void print(const char* string) {
+	fputs(string, stdout);
+}
+
+int fprintf(FILE* stream, const char* formatString, ...) {
+	char line[SIM_PRINT_MAX_LENGTH];
+	va_list args;
+	va_start(args, formatString);
+	int length = vsnprintf(line, sizeof(line), formatString, args);
+	va_end(args);
+	return fwrite(line, 1, MIN(length, (int) sizeof(line) - 1), stream);
+}
+
+int printf(const char* formatString, ...) {
+	char line[SIM_PRINT_MAX_LENGTH];
+	va_list args;
+	va_start(args, formatString);
+	int length = vsnprintf(line, sizeof(line), formatString, args);
+	va_end(args);
+	return fwrite(line, 1, MIN(length, (int) sizeof(line) - 1), stdout);
+}
+
+void lcdInit(FILE* lcdPort) {
+}
+
+void lcdShutdown(FILE* lcdPort) {
+}
+
+void lcdClear(FILE* lcdPort) {
+	lcdSetText(lcdPort, 1, "");
+	lcdSetText(lcdPort, 2, "");
+}
+
+void lcdSetText(FILE* lcdPort, unsigned char line, const char* buffer) {
+	uartCount(lcdPort, 1);
+	if (line == 1 || line == 2) {
+		snprintf(lcdLines[line - 1], SIM_LCD_LINE_LENGTH, "%s", buffer);
+	}
+}
+
+void lcdPrint(FILE* lcdPort, unsigned char line, const char* formatString, ...) {
+	char text[SIM_PRINT_MAX_LENGTH];
+	va_list args;
+	va_start(args, formatString);
+	vsnprintf(text, sizeof(text), formatString, args);
+	va_end(args);
+	lcdSetText(lcdPort, line, text);
+}
+
+void lcdSetBacklight(FILE* lcdPort, bool backlight) {
+}
+
+unsigned int lcdReadButtons(FILE* lcdPort) {
+	return lcdButtons;
+}
+
+void motorSet(unsigned char channel, int speed) {
+	if (channel >= 1 && channel <= 10) {
+		motorValues[channel - 1] = MAX(-127, MIN(127, speed));
+	}
+}
+
+int motorGet(unsigned char channel) {
+	return simMotorGet(channel);
+}
+
+void motorStop(unsigned char channel) {
+	motorSet(channel, 0);
+}
+
+void motorStopAll() {
+	for (int channel = 1; channel <= 10; channel++) {
+		motorSet(channel, 0);
+	}
+}
+
+int joystickGetAnalog(unsigned char joystick, unsigned char axis) {
+	return (joystick >= 1 && joystick <= 2 && axis >= 1 && axis <= 6) ? joystickAxes[joystick - 1][axis - 1] : 0;
+}
+
+bool joystickGetDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char button) {
+	if (joystick < 1 || joystick > 2 || buttonGroup < 5 || buttonGroup > 8) {
+		return false;
+	}
+	return (joystickButtons[joystick - 1][buttonGroup - 5] & button) != 0;
+}
+
+bool isAutonomous() {
+	return competitionAutonomous;
+}
+
+bool isEnabled() {
+	return competitionEnabled;
+}
+
+bool isJoystickConnected(unsigned char joystick) {
+	return joystick == 1 || joystick == 2;
+}
+
+bool isOnline() {
+	return competitionOnline;
+}
+
+unsigned int powerLevelMain() {
+	return batteryMillivolts;
+}
+
+unsigned int powerLevelBackup() {
+	return 9000;
+}
+
+int analogRead(unsigned char channel) {
+	return (channel >= 1 && channel <= 8) ? analogValues[channel - 1] : 0;
+}
+
+int analogCalibrate(unsigned char channel) {
+	// The simulated inputs only change when they are set, so one reading is the average, and no time passes
+	if (channel < 1 || channel > 8) {
+		return 0;
+	}
+	analogCalibrations[channel - 1] = analogValues[channel - 1];
+	return analogCalibrations[channel - 1];
+}
+
+int analogReadCalibrated(unsigned char channel) {
+	return (channel >= 1 && channel <= 8) ? analogValues[channel - 1] - analogCalibrations[channel - 1] : 0;
+}
+
+bool digitalRead(unsigned char pin) {
+	return (pin >= 1 && pin <= 12) ? digitalValues[pin - 1] : true;
+}
+
+void digitalWrite(unsigned char pin, bool value) {
+	simSetDigital(pin, value);
+}
+
+void pinMode(unsigned char pin, unsigned char mode) {
+}
+
+/**
+ * Checks whether an IME answers
+ *
+ * @param address The address of the IME
+ *
+ * @return true if it is connected and has been initialized
+ */
+static bool imeAnswers(unsigned char address) {
+	return imesInitialized && address < imesConnected;
+}
+
+unsigned int imeInitializeAll() {
+	imesInitialized = true;
+	for (int i = 0; i < imesConnected; i++) {
+		imeResetCounts[i] = imeCounts[i];
+	}
+	return imesConnected;
+}
+
+bool imeGet(unsigned char address, int* value) {
+	if (!imeAnswers(address)) {
+		return false;
+	}
+	*value = imeCounts[address] - imeResetCounts[address];
+	return true;
+}
+
+bool imeGetVelocity(unsigned char address, int* value) {
+	if (!imeAnswers(address)) {
+		return false;
+	}
+	*value = imeVelocities[address];
+	return true;
+}
+
+bool imeReset(unsigned char address) {
+	if (!imeAnswers(address)) {
+		return false;
+	}
+	imeResetCounts[address] = imeCounts[address];
+	return true;
+}
+
+void imeShutdown() {
+	imesInitialized = false;
+}
+
+Gyro gyroInit(unsigned char port, unsigned short multiplier) {
+	if (port < 1 || port > 8 || gyrosInitialized[port - 1]) {
+		return NULL;
+	}
+	// The simulated robot stands still while the gyro calibrates, so no time passes
+	gyrosInitialized[port - 1] = true;
+	gyroPorts[port - 1] = port;
+	gyroResetDegrees[port - 1] = gyroDegrees[port - 1];
+	return &gyroPorts[port - 1];
+}
+
+int gyroGet(Gyro gyro) {
+	unsigned char port = *(unsigned char*) gyro;
+	return gyroDegrees[port - 1] - gyroResetDegrees[port - 1];
+}
+
+void gyroReset(Gyro gyro) {
+	unsigned char port = *(unsigned char*) gyro;
+	gyroResetDegrees[port - 1] = gyroDegrees[port - 1];
+}
+
+void gyroShutdown(Gyro gyro) {
+	gyrosInitialized[*(unsigned char*) gyro - 1] = false;
+}
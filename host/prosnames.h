@@ -0,0 +1,35 @@
+/** @file prosnames.h
+ * @brief File that renames the PROS functions which clash with the C library of the computer
+ *
+ * The robot code is compiled for the computer with this file included before everything else
+ * (gcc -include). API.h declares its own FILE and stdio functions, so they are renamed here to the
+ * sim versions in pros.c and sim.c before API.h is seen. Files compiled this way must not include <stdio.h>.
+ */
+
+#ifndef PROS_NAMES_H
+
+// This prevents multiple inclusion
+#define PROS_NAMES_H
+
+#define fclose(...) simFclose(__VA_ARGS__)
+#define feof(...) simFeof(__VA_ARGS__)
+#define fflush(...) simFflush(__VA_ARGS__)
+#define fgetc(...) simFgetc(__VA_ARGS__)
+#define fgets(...) simFgets(__VA_ARGS__)
+#define fopen(...) simFopen(__VA_ARGS__)
+#define fprint(...) simFprint(__VA_ARGS__)
+#define fprintf(...) simFprintf(__VA_ARGS__)
+#define fputc(...) simFputc(__VA_ARGS__)
+#define fputs(...) simFputs(__VA_ARGS__)
+#define fread(...) simFread(__VA_ARGS__)
+#define fseek(...) simFseek(__VA_ARGS__)
+#define ftell(...) simFtell(__VA_ARGS__)
+#define fwrite(...) simFwrite(__VA_ARGS__)
+#define getchar(...) simGetchar(__VA_ARGS__)
+#define print(...) simPrint(__VA_ARGS__)
+#define printf(...) simPrintf(__VA_ARGS__)
+#define putchar(...) simPutchar(__VA_ARGS__)
+#define puts(...) simPuts(__VA_ARGS__)
+#define wait(...) simWaitTime(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,313 @@
+/** @file replay.c
+ * @brief File for replaying recorded autonomous routines on a simulated robot
+ *
+ * The model follows the motors from a tick hook, so the playback run sees the same motor values
+ * at the same ticks as the robot would. The reference run calls the same step function directly.
+ */
+
+#include "main.h"
+#include "frame.h"
+#include "replay.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Revolutions of the encoder wheel in a 393 IME per revolution of the motor in high speed mode (see imeGetVelocity())
+ */
+#define REPLAY_IME_GEARING 24.5
+
+/**
+ * The IME of each wheel of the model
+ */
+static const int wheelImes[MECANUM_WHEELS] = { FRONT_LEFT_IME, FRONT_RIGHT_IME, BACK_LEFT_IME, BACK_RIGHT_IME };
+
+/**
+ * Which way each wheel's IME counts as the wheel drives the robot forward: the way its motor turns,
+ * with the signs of stepRobot()
+ */
+static const int imeSigns[MECANUM_WHEELS] = { -1, 1, 1, -1 };
+
+/**
+ * The simulated robot
+ */
+static mecanum_model robot;
+
+/**
+ * The command of each wheel's motor at the last step of the robot, with the signs of stepRobot()
+ */
+static int lastCommands[MECANUM_WHEELS];
+
+/**
+ * The path of the playback run, which the tick hook adds to while the recording plays
+ */
+static replay_path* followed = NULL;
+
+/**
+ * Whether or not the recording was playing at the last tick
+ */
+static bool wasPlaying = false;
+
+/**
+ * What the second LCD line shows when the recording to play is selected
+ */
+static char choice[SIM_LCD_LINE_LENGTH];
+
+/**
+ * Gets the count of a wheel's IME
+ *
+ * @param wheel The wheel
+ *
+ * @return the counts the wheel has turned since the model was reset, the way its motor turns
+ */
+static int imeCount(int wheel) {
+	return (int) lround(imeSigns[wheel] * robot.wheelAngle[wheel] / (2 * M_PI) * DRIVE_IME_COUNTS_PER_REV);
+}
+
+/**
+ * Gets the heading of the robot's gyro
+ *
+ * @return the degrees the robot has turned counterclockwise since the model was reset
+ */
+static int gyroDegrees() {
+	return (int) lround(robot.heading * 180 / M_PI);
+}
+
+/**
+ * Sets the simulated battery, IMEs and gyro from the robot
+ */
+static void setSensors() {
+	simSetBattery((unsigned int) (robot.voltage * 1000));
+	for (int i = 0; i < MECANUM_WHEELS; i++) {
+		double rpm = robot.wheelSpeed[i] * 60 / (2 * M_PI);
+		simSetIme(wheelImes[i], imeCount(i), (int) lround(imeSigns[i] * rpm * REPLAY_IME_GEARING));
+	}
+	simSetGyro(GYRO_PORT, gyroDegrees());
+}
+
+/**
+ * Moves the robot forward one millisecond with the simulated drive motors and adds its pose to a path
+ *
+ * @param path The path
+ */
+static void stepRobot(replay_path* path) {
+	// Signs from mixDrive() in driveMix.c, so that a positive command drives the robot forward
+	int commands[MECANUM_WHEELS];
+	commands[MECANUM_FRONT_LEFT] = -simMotorGet(FRONT_LEFT_MOTOR);
+	commands[MECANUM_FRONT_RIGHT] = simMotorGet(FRONT_RIGHT_MOTOR);
+	commands[MECANUM_BACK_LEFT] = simMotorGet(BACK_LEFT_MOTOR);
+	commands[MECANUM_BACK_RIGHT] = -simMotorGet(BACK_RIGHT_MOTOR);
+	mecanumStep(&robot, commands, 0.001);
+	setSensors();
+	for (int i = 0; i < MECANUM_WHEELS; i++) {
+		if (path->length > 0) {
+			path->largestStep = MAX(path->largestStep, abs(commands[i] - lastCommands[i]));
+		}
+		lastCommands[i] = commands[i];
+	}
+
+	if (path->length == path->capacity) {
+		path->capacity = MAX(1024, path->capacity * 2);
+		path->poses = realloc(path->poses, path->capacity * sizeof(replay_pose));
+	}
+	if (path->length == 0 || robot.voltage < path->lowestVoltage) {
+		path->lowestVoltage = robot.voltage;
+	}
+	replay_pose* pose = &path->poses[path->length++];
+	pose->x = robot.x;
+	pose->y = robot.y;
+	pose->heading = robot.heading;
+}
+
+/**
+ * Follows the robot while the recording plays, and stops the simulation when it is done
+ */
+static void followRobot() {
+	if (autonPlaying) {
+		stepRobot(followed);
+	} else if (wasPlaying) {
+		simStop();
+	}
+	wasPlaying = autonPlaying;
+}
+
+/**
+ * Answers the LCD prompt of initialize(): presses the right button (for 40 ms at a time, as the
+ * menu only checks the buttons every 20 ms) until the recording is shown, then the center button
+ */
+static void pickRecording() {
+	unsigned int buttons = 0;
+	if (strcmp(simLcdLine(1), "Select file") == 0) {
+		if (strcmp(simLcdLine(2), choice) == 0) {
+			buttons = LCD_BTN_CENTER;
+		} else if ((millis() / 40) % 2 == 0) {
+			buttons = LCD_BTN_RIGHT;
+		}
+	}
+	simLcdSetButtons(buttons);
+}
+
+/**
+ * Reads a recording
+ *
+ * @param filename The name of the file
+ * @param data The buffer to read into, REPLAY_FILE_SIZE bytes long
+ *
+ * @return true if the file was read, false if it could not be read or is not REPLAY_FILE_SIZE bytes long
+ */
+bool replayReadRecording(const char* filename, uint8_t* data) {
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	int length = 0;
+	int result;
+	while (length <= REPLAY_FILE_SIZE && (result = read(fd, data + length, REPLAY_FILE_SIZE + 1 - length)) > 0) {
+		length += result;
+	}
+	close(fd);
+	return length == REPLAY_FILE_SIZE;
+}
+
+/**
+ * Writes the header that recordAuton() puts on the track, voltage and headings files of a recording
+ *
+ * @param recording The recording
+ * @param header The buffer to write the AUTON_TRACK_HEADER_SIZE bytes into
+ */
+static void writeHeader(const uint8_t* recording, uint8_t* header) {
+	uint32_t crc = frameCrc32(0, recording, REPLAY_FILE_SIZE);
+	for (int j = 0; j < AUTON_TRACK_HEADER_SIZE; j++) {
+		header[j] = crc >> (8 * j);
+	}
+}
+
+void replayReference(const mecanum_params* params, const uint8_t* recordings, uint8_t* tracks, uint8_t* voltages,
+		uint8_t* headings, int sections, replay_path* path) {
+	mecanumReset(&robot, params);
+	unsigned long voltageSum = 0;
+	for (int i = 0; i < sections * REPLAY_STATES; i++) {
+		const signed char* state = (const signed char*) recordings + i * AUTON_STATE_SIZE;
+		// recordAuton() reads the battery once per state, just before applying it
+		voltageSum += (unsigned int) (robot.voltage * 1000);
+		int counts[MECANUM_WHEELS];
+		for (int wheel = 0; wheel < MECANUM_WHEELS; wheel++) {
+			counts[wheel] = imeCount(wheel);
+		}
+		setDriveMotors(state[0], state[1], state[2]);
+		motorFrameCommit();
+		for (int ms = 0; ms < 1000 / JOY_POLL_FREQ; ms++) {
+			stepRobot(path);
+		}
+
+		// As recordAuton() records it: a header with the CRC of the recording, then the counts each wheel turned
+		if (tracks != NULL) {
+			uint8_t* track = tracks + (i / REPLAY_STATES) * REPLAY_TRACK_SIZE;
+			if (i % REPLAY_STATES == 0) {
+				writeHeader(recordings + (i / REPLAY_STATES) * REPLAY_FILE_SIZE, track);
+			}
+			for (int wheel = 0; wheel < MECANUM_WHEELS; wheel++) {
+				track[AUTON_TRACK_HEADER_SIZE + (i % REPLAY_STATES) * AUTON_TRACK_SIZE + wheel] =
+						(int8_t) CLAMP(imeCount(wheel) - counts[wheel], -127, 127);
+			}
+		}
+		if (voltages != NULL && i % REPLAY_STATES == REPLAY_STATES - 1) {
+			uint8_t* voltage = voltages + (i / REPLAY_STATES) * AUTON_VOLTAGE_FILE_SIZE;
+			unsigned int millivolts = voltageSum / REPLAY_STATES;
+			writeHeader(recordings + (i / REPLAY_STATES) * REPLAY_FILE_SIZE, voltage);
+			voltage[AUTON_TRACK_HEADER_SIZE] = millivolts;
+			voltage[AUTON_TRACK_HEADER_SIZE + 1] = millivolts >> 8;
+			voltageSum = 0;
+		}
+		// The gyro is zeroed once, at the start of the first section, and read at the end of each state
+		if (headings != NULL) {
+			uint8_t* heading = headings + (i / REPLAY_STATES) * REPLAY_HEADINGS_SIZE;
+			if (i % REPLAY_STATES == 0) {
+				writeHeader(recordings + (i / REPLAY_STATES) * REPLAY_FILE_SIZE, heading);
+			}
+			int16_t degrees = gyroDegrees();
+			heading[AUTON_TRACK_HEADER_SIZE + (i % REPLAY_STATES) * AUTON_HEADING_SIZE] = degrees;
+			heading[AUTON_TRACK_HEADER_SIZE + (i % REPLAY_STATES) * AUTON_HEADING_SIZE + 1] = degrees >> 8;
+		}
+	}
+	motorFrameStopAll();
+	for (int ms = 0; ms < REPLAY_SETTLE_TIME; ms++) {
+		stepRobot(path);
+	}
+}
+
+void replayPlayback(const mecanum_params* params, const uint8_t* recordings, const uint8_t* tracks,
+		const uint8_t* voltages, const uint8_t* headings, int sections, replay_path* path) {
+	for (int i = 0; i < sections; i++) {
+		char filename[AUTON_FILENAME_MAX_LENGTH];
+		snprintf(filename, sizeof(filename), sections == 1 ? "a%d" : "p%d", sections == 1 ? 1 : i);
+		simFlashWrite(filename, recordings + i * REPLAY_FILE_SIZE, REPLAY_FILE_SIZE);
+		if (tracks != NULL) {
+			getTrackFilename(sections == 1 ? 1 : -i - 1, filename, sizeof(filename));
+			simFlashWrite(filename, tracks + i * REPLAY_TRACK_SIZE, REPLAY_TRACK_SIZE);
+		}
+		if (voltages != NULL) {
+			getVoltageFilename(sections == 1 ? 1 : -i - 1, filename, sizeof(filename));
+			simFlashWrite(filename, voltages + i * AUTON_VOLTAGE_FILE_SIZE, AUTON_VOLTAGE_FILE_SIZE);
+		}
+		if (headings != NULL) {
+			getHeadingsFilename(sections == 1 ? 1 : -i - 1, filename, sizeof(filename));
+			simFlashWrite(filename, headings + i * REPLAY_HEADINGS_SIZE, REPLAY_HEADINGS_SIZE);
+		}
+	}
+	// The LCD line holds SIM_LCD_LINE_LENGTH - 1 characters, which cuts "Programming skills" short
+	snprintf(choice, sizeof(choice), sections == 1 ? "Slot: 1" : "Programming skills");
+	mecanumReset(&robot, params);
+	setSensors();
+	simSetImes(DRIVE_WHEELS);
+	if (headings != NULL) {
+		simSetAnalog(GYRO_PORT, SIM_GYRO_REST);
+	}
+	followed = path;
+	simAddTickHook(&pickRecording);
+	simAddTickHook(&followRobot);
+	simStartRobot(true);
+	simRun((REPLAY_SECTIONS * AUTON_TIME + 60) * 1000UL);
+	// Playback takes the robot's place as the origin when it starts, as the model's path does
+	odometry_pose pose;
+	if (odometryGetPose(&pose)) {
+		path->odometry.x = pose.x / 1e6;
+		path->odometry.y = pose.y / 1e6;
+		path->odometry.heading = pose.heading / 1000.0 * M_PI / 180;
+	}
+}
+
+/**
+ * Measures how far a run strayed from another, comparing them at the same time since the start
+ * (the shorter run holds its last pose)
+ *
+ * @param reference The path of the run to compare with
+ * @param path The path of the run
+ * @param error Set to the differences
+ */
+void replayCompare(const replay_path* reference, const replay_path* path, replay_error* error) {
+	int length = MAX(reference->length, path->length);
+	double sum = 0, squares = 0;
+	error->maxDistance = 0;
+	error->maxTime = 0;
+	for (int i = 0; i < length; i++) {
+		const replay_pose* a = &reference->poses[MIN(i, reference->length - 1)];
+		const replay_pose* b = &path->poses[MIN(i, path->length - 1)];
+		double distance = hypot(a->x - b->x, a->y - b->y);
+		sum += distance;
+		squares += distance * distance;
+		if (distance > error->maxDistance) {
+			error->maxDistance = distance;
+			error->maxTime = i;
+		}
+	}
+	const replay_pose* a = &reference->poses[reference->length - 1];
+	const replay_pose* b = &path->poses[path->length - 1];
+	error->finalDistance = hypot(a->x - b->x, a->y - b->y);
+	error->finalHeading = (b->heading - a->heading) * 180 / M_PI;
+	error->meanDistance = sum / length;
+	error->rmsDistance = sqrt(squares / length);
+}
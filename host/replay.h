@@ -0,0 +1,202 @@
+/** @file replay.h
+ * @brief File for replaying recorded autonomous routines on a simulated robot
+ *
+ * A recording is driven into the mecanum model (mecanum.h) in two ways. The reference run applies
+ * each state for exactly 1000 / JOY_POLL_FREQ milliseconds, as it was recorded, and can record
+ * the wheel track that the robot's drive IMEs would have recorded with it and the battery voltage
+ * that recordAuton() would have averaged, and the headings that its gyro would have read. The playback run
+ * loads the recording into the simulated flash and starts the robot program in autonomous mode:
+ * initialize() runs with its LCD menu and serial shell tasks, the recording is picked on the LCD,
+ * and autonomous() plays it on the robot's task, with the model following the simulated drive
+ * motors every millisecond and setting the IMEs from its wheels. Given the wheel tracks, the
+ * robot plays closed loop (driveTrack.h); given the voltages, it compensates for its battery
+ * (battery.h); given the headings, it has a gyro and holds them (headingHold.h). Comparing the two paths shows how the playback engine's
+ * timing and the robot's battery and floor change where the robot ends up.
+ *
+ * The playback run boots the simulated robot, so it can only be made once per process.
+ */
+
+#ifndef REPLAY_H
+
+// This prevents multiple inclusion
+#define REPLAY_H
+
+#include "mecanum.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of states in a recording
+ */
+#define REPLAY_STATES (AUTON_TIME * JOY_POLL_FREQ)
+
+/**
+ * Number of bytes in a recording
+ */
+#define REPLAY_FILE_SIZE (REPLAY_STATES * AUTON_STATE_SIZE)
+
+/**
+ * Number of bytes in the wheel track of a recording
+ */
+#define REPLAY_TRACK_SIZE (AUTON_TRACK_HEADER_SIZE + REPLAY_STATES * AUTON_TRACK_SIZE)
+
+/**
+ * Number of bytes in the headings file of a recording
+ */
+#define REPLAY_HEADINGS_SIZE (AUTON_TRACK_HEADER_SIZE + REPLAY_STATES * AUTON_HEADING_SIZE)
+
+/**
+ * Number of recordings in programming skills
+ */
+#define REPLAY_SECTIONS (PROGSKILL_TIME / AUTON_TIME)
+
+/**
+ * Milliseconds that playbackAuton() waits with the motors stopped after the last state
+ */
+#define REPLAY_SETTLE_TIME 1000
+
+/**
+ * A pose of the robot
+ */
+typedef struct replay_pose {
+	/**
+	 * Position in meters
+	 */
+	double x;
+	double y;
+
+	/**
+	 * Heading in radians, counterclockwise
+	 */
+	double heading;
+} replay_pose;
+
+/**
+ * The pose of the robot every millisecond of a run
+ */
+typedef struct replay_path {
+	/**
+	 * The poses, one per millisecond
+	 */
+	replay_pose* poses;
+
+	/**
+	 * The number of poses
+	 */
+	int length;
+
+	/**
+	 * The number of poses that fit in the buffer
+	 */
+	int capacity;
+
+	/**
+	 * The lowest battery voltage during the run
+	 */
+	double lowestVoltage;
+
+	/**
+	 * The largest change of a drive motor's command from one millisecond to the next
+	 */
+	int largestStep;
+
+	/**
+	 * Where the robot's odometry put it at the end of the run, in the frame of the poses (zero
+	 * without odometry, or for a reference run)
+	 */
+	replay_pose odometry;
+} replay_path;
+
+/**
+ * How far a run strayed from another
+ */
+typedef struct replay_error {
+	/**
+	 * Distance between the final positions in meters
+	 */
+	double finalDistance;
+
+	/**
+	 * Difference between the final headings in degrees
+	 */
+	double finalHeading;
+
+	/**
+	 * Mean, root mean square and largest distance between the runs at the same time since the start, in meters
+	 */
+	double meanDistance;
+	double rmsDistance;
+	double maxDistance;
+
+	/**
+	 * Time of the largest distance in milliseconds since the start
+	 */
+	int maxTime;
+} replay_error;
+
+/**
+ * Reads a recording
+ *
+ * @param filename The name of the file
+ * @param data The buffer to read into, REPLAY_FILE_SIZE bytes long
+ *
+ * @return true if the file was read, false if it could not be read or is not REPLAY_FILE_SIZE bytes long
+ */
+bool replayReadRecording(const char* filename, uint8_t* data);
+
+/**
+ * Drives the robot with each state for exactly the time between two states, then lets it settle
+ * for REPLAY_SETTLE_TIME
+ *
+ * @param params The physical properties of the robot
+ * @param recordings The recordings, one after another
+ * @param tracks Set to the wheel track of each recording (REPLAY_TRACK_SIZE bytes each) as the robot would
+ * record it, or NULL
+ * @param voltages Set to the voltage file of each recording (AUTON_VOLTAGE_FILE_SIZE bytes each) as the robot
+ * would record it, or NULL
+ * @param headings Set to the headings file of each recording (REPLAY_HEADINGS_SIZE bytes each) as the robot's
+ * gyro would record it, or NULL
+ * @param sections The number of recordings
+ * @param path Set to the path of the robot; must start empty
+ */
+void replayReference(const mecanum_params* params, const uint8_t* recordings, uint8_t* tracks, uint8_t* voltages,
+		uint8_t* headings, int sections, replay_path* path);
+
+/**
+ * Loads the recordings into the simulated flash and runs the robot program in autonomous mode
+ * until it has played them back
+ *
+ * @param params The physical properties of the robot
+ * @param recordings The recordings, one after another
+ * @param tracks The wheel tracks to load beside the recordings, so that the robot plays closed loop, or NULL
+ * @param voltages The voltage files to load beside the recordings, so that the robot compensates for its
+ * battery, or NULL
+ * @param headings The headings files to load beside the recordings, with a gyro on the robot so that it holds
+ * them, or NULL
+ * @param sections The number of recordings (1 or REPLAY_SECTIONS)
+ * @param path Set to the path of the robot from the start of playback, and to where its odometry put it
+ * at the end; must start empty
+ */
+void replayPlayback(const mecanum_params* params, const uint8_t* recordings, const uint8_t* tracks,
+		const uint8_t* voltages, const uint8_t* headings, int sections, replay_path* path);
+
+/**
+ * Measures how far a run strayed from another, comparing them at the same time since the start
+ * (the shorter run holds its last pose)
+ *
+ * @param reference The path of the run to compare with
+ * @param path The path of the run
+ * @param error Set to the differences
+ */
+void replayCompare(const replay_path* reference, const replay_path* path, replay_error* error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,240 @@
+/** @file replaytool.c
+ * @brief File for the tool that replays a recorded autonomous on a simulated robot
+ *
+ * Plays a recording with the reference and playback runs of replay.h and reports both final
+ * poses, how far the playback strayed from the reference along the way and how far the robot's
+ * odometry (odometry.h) was off at the end, so the effect of
+ * timing changes in the playback engine (wake-up jitter, time spent logging and reading flash) on
+ * where the robot ends up can be measured. The virtual clock skips every sleep, so even
+ * programming skills plays in a fraction of a second.
+ *
+ * Usage: replay [-j microseconds] [-s seed] [-c] [-e] [-v] [-g] [-p] [-b volts] [-o path.csv] [-t trace.json]
+ *               recording [section2 section3 section4]
+ * One recording is played as slot 1; four are played as the programming skills sections p0 - p3.
+ * -j makes every delay in the playback up to that much longer at random (seeded by -s), -c
+ * charges the Cortex estimates for flash and serial operations, -e plays closed loop, following
+ * the wheel track that the reference run records, -v compensates for the battery, scaling the
+ * commands by the voltage that the reference run records over the playback's, -g gives the robot
+ * a gyro and holds the headings that the reference run records, -p plays the drive commands in
+ * steps as they were recorded instead of interpolating them (see driveInterpolate.h), -b gives the playback robot a battery of that
+ * voltage (with no load) instead of the reference's, -o writes both paths to a CSV file, and -t
+ * writes a timeline of the playback run's tasks and flash operations (see simTraceOpen()).
+ */
+
+#include "main.h"
+#include "replay.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Prints a line of the report to standard output
+ *
+ * @param format The format string, as for printf
+ */
+static void report(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (write(STDOUT_FILENO, line, MIN(length, (int) sizeof(line) - 1)) < 0) {
+		exit(1);
+	}
+}
+
+/**
+ * Prints a pose of the report
+ *
+ * @param name The name of the run
+ * @param path The path of the run
+ */
+static void reportPose(const char* name, const replay_path* path) {
+	const replay_pose* pose = &path->poses[path->length - 1];
+	report("%-10s %8.3f %8.3f %8.1f %8.2f\n", name, pose->x, pose->y, pose->heading * 180 / M_PI, path->length / 1000.0);
+}
+
+/**
+ * Prints how far the playback strayed from the reference
+ *
+ * @param reference The path of the reference run
+ * @param playback The path of the playback run
+ */
+static void reportError(const replay_path* reference, const replay_path* playback) {
+	replay_error error;
+	replayCompare(reference, playback, &error);
+	report("Final error: %.3f m, %.1f degrees\n", error.finalDistance, error.finalHeading);
+	report("Path error: mean %.3f m, RMS %.3f m, max %.3f m at %.2f s\n", error.meanDistance, error.rmsDistance,
+			error.maxDistance, error.maxTime / 1000.0);
+}
+
+/**
+ * Writes both paths to a CSV file, one row per millisecond
+ *
+ * @param filename The name of the file
+ * @param reference The path of the reference run
+ * @param playback The path of the playback run
+ *
+ * @return true if the file was written
+ */
+static bool writePaths(const char* filename, const replay_path* reference, const replay_path* playback) {
+	int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	char line[160];
+	int length = snprintf(line, sizeof(line), "time,reference x,reference y,reference heading,playback x,playback y,playback heading\n");
+	bool written = write(fd, line, length) == length;
+	for (int i = 0; written && i < MAX(reference->length, playback->length); i++) {
+		const replay_pose* a = &reference->poses[MIN(i, reference->length - 1)];
+		const replay_pose* b = &playback->poses[MIN(i, playback->length - 1)];
+		length = snprintf(line, sizeof(line), "%.3f,%.4f,%.4f,%.2f,%.4f,%.4f,%.2f\n", i / 1000.0, a->x, a->y,
+				a->heading * 180 / M_PI, b->x, b->y, b->heading * 180 / M_PI);
+		written = write(fd, line, length) == length;
+	}
+	close(fd);
+	return written;
+}
+
+int main(int argc, char** argv) {
+	unsigned long jitter = 0;
+	unsigned int seed = 1;
+	bool costs = false;
+	bool closedLoop = false;
+	bool compensate = false;
+	bool gyro = false;
+	bool steps = false;
+	double battery = 0;
+	const char* csv = NULL;
+	const char* trace = NULL;
+	int option;
+	while ((option = getopt(argc, argv, "j:s:cevgpb:o:t:")) != -1) {
+		if (option == 'j') {
+			jitter = strtoul(optarg, NULL, 10);
+		} else if (option == 's') {
+			seed = strtoul(optarg, NULL, 10);
+		} else if (option == 'c') {
+			costs = true;
+		} else if (option == 'e') {
+			closedLoop = true;
+		} else if (option == 'v') {
+			compensate = true;
+		} else if (option == 'g') {
+			gyro = true;
+		} else if (option == 'p') {
+			steps = true;
+		} else if (option == 'b') {
+			battery = strtod(optarg, NULL);
+		} else if (option == 'o') {
+			csv = optarg;
+		} else if (option == 't') {
+			trace = optarg;
+		} else {
+			optind = argc + 1;
+		}
+	}
+	int sections = argc - optind;
+	if (sections != 1 && sections != REPLAY_SECTIONS) {
+		simLog("Usage: replay [-j microseconds] [-s seed] [-c] [-e] [-v] [-g] [-p] [-b volts] [-o path.csv] "
+				"[-t trace.json] recording [section2 section3 section4]");
+		return 2;
+	}
+	uint8_t* recordings = malloc(sections * REPLAY_FILE_SIZE);
+	for (int i = 0; i < sections; i++) {
+		if (!replayReadRecording(argv[optind + i], recordings + i * REPLAY_FILE_SIZE)) {
+			simLog("%s is not a %d byte recording", argv[optind + i], REPLAY_FILE_SIZE);
+			return 1;
+		}
+	}
+
+	mecanum_params params;
+	mecanumDefaults(&params);
+	replay_path reference = { NULL, 0, 0, 0, 0, { 0, 0, 0 } };
+	replay_path playback = { NULL, 0, 0, 0, 0, { 0, 0, 0 } };
+	uint8_t* tracks = closedLoop ? malloc(sections * REPLAY_TRACK_SIZE) : NULL;
+	uint8_t* voltages = compensate ? malloc(sections * AUTON_VOLTAGE_FILE_SIZE) : NULL;
+	uint8_t* headings = gyro ? malloc(sections * REPLAY_HEADINGS_SIZE) : NULL;
+	replayReference(&params, recordings, tracks, voltages, headings, sections, &reference);
+	if (battery > 0) {
+		params.batteryVoltage = battery;
+	}
+
+	if (costs) {
+		simSetIoCosts(&simCortexIoCosts);
+	}
+	simSetJitter(jitter, seed);
+	simSerialOpen(-1);
+	if (trace != NULL && !simTraceOpen(trace, false)) {
+		simLog("Could not write %s", trace);
+		return 1;
+	}
+	struct timespec hostStart, hostEnd;
+	clock_gettime(CLOCK_MONOTONIC, &hostStart);
+	motorFrameStatsReset();
+	driveMixStatsReset();
+	driveTrackStatsReset();
+	headingStatsReset();
+	odometryStatsReset();
+	driveInterpolation = !steps;
+	replayPlayback(&params, recordings, tracks, voltages, headings, sections, &playback);
+	clock_gettime(CLOCK_MONOTONIC, &hostEnd);
+	simTraceClose();
+	if (playback.length == 0) {
+		simLog("The robot did not play the recording");
+		return 1;
+	}
+
+	report("%d section%s, jitter up to %lu us (seed %u), %s flash and serial, %s at %.2f V%s%s\n", sections,
+			sections == 1 ? "" : "s", jitter, seed, costs ? "Cortex estimates for" : "free",
+			closedLoop ? "closed loop" : "open loop", params.batteryVoltage, compensate ? " compensated" : "",
+			gyro ? " holding headings" : "");
+	report("%-10s %8s %8s %8s %8s\n", "run", "x (m)", "y (m)", "heading", "time (s)");
+	reportPose("reference", &reference);
+	reportPose("playback", &playback);
+	reportError(&reference, &playback);
+	report("Lowest battery voltage in playback: %.2f V\n", playback.lowestVoltage);
+	report("Largest step of a drive motor command in one millisecond: %d in the reference, %d in playback\n",
+			reference.largestStep, playback.largestStep);
+	for (int i = 0; i < UART_PORTS; i++) {
+		const uart_stats* stats = &uartStats[i];
+		if (stats->baud == 0) {
+			report("Serial link %-9s %7lu set, busiest second %5lu\n", stats->name, stats->bytes, stats->peakSecondBytes);
+			continue;
+		}
+		report("Serial link %-9s %7lu bytes, busiest second %5lu of %5u bytes, deepest queue %4lu bytes\n", stats->name,
+				stats->bytes, stats->peakSecondBytes, stats->baud / 10, stats->peakQueued);
+	}
+	report("Motor writes %lu of %lu channels in %lu frames, %lu unchanged ones skipped\n", motorFrameStats.writes,
+			motorFrameStats.writes + motorFrameStats.skipped, motorFrameStats.commits, motorFrameStats.skipped);
+	report("Drive commands saturated a wheel in %lu of %lu ticks and were scaled down\n", driveMixStats.saturated,
+			driveMixStats.mixes);
+	if (closedLoop) {
+		unsigned long samples = (driveTrackStats.updates - driveTrackStats.readFailures) * DRIVE_WHEELS;
+		report("Wheels followed their tracks for %lu control periods, mean error %.1f counts, max %d counts\n",
+				driveTrackStats.updates, (double) driveTrackStats.errorSum / MAX(1, samples), driveTrackStats.maxError);
+	}
+	if (gyro) {
+		report("Heading held for %lu states, mean error %.1f degrees, max %d degrees\n", headingStats.updates,
+				(double) headingStats.errorSum / MAX(1, headingStats.updates), headingStats.maxError);
+	}
+	const replay_pose* end = &playback.poses[playback.length - 1];
+	report("Odometry ends at %.3f m, %.3f m, %.1f degrees, %.3f m and %.1f degrees off the robot, in %lu readings "
+			"(mean %lu us, max gap %lu ms)\n", playback.odometry.x, playback.odometry.y,
+			playback.odometry.heading * 180 / M_PI, hypot(playback.odometry.x - end->x, playback.odometry.y - end->y),
+			(playback.odometry.heading - end->heading) * 180 / M_PI, odometryStats.updates,
+			odometryStats.busySum / MAX(1, odometryStats.updates), odometryStats.maxGap);
+	report("Robot time %.2f s (boot and playback) took %.1f ms on this computer\n", millis() / 1000.0,
+			(hostEnd.tv_sec - hostStart.tv_sec) * 1e3 + (hostEnd.tv_nsec - hostStart.tv_nsec) / 1e6);
+	if (csv != NULL && !writePaths(csv, &reference, &playback)) {
+		simLog("Could not write %s", csv);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,125 @@
+/** @file robotsim.c
+ * @brief File for the stand-in robot used to test the transfer tools without a Cortex
+ *
+ * Runs the whole robot program from src/ (initialize() then operatorControl()) on the simulated
+ * PROS API at real-time speed, with flash files kept in a directory and the serial monitor on a
+ * pseudo-terminal. autontool (or a terminal program) can open the pseudo-terminal exactly as it
+ * would open the robot's USB serial port. Nobody is there to pick a file on the LCD, so the
+ * center button is pressed for the robot whenever it asks, which loads no autonomous.
+ *
+ * Usage: robotsim [-d flash directory] [-l link path]
+ * The path of the pseudo-terminal is printed to standard error, and if -l is given a symbolic
+ * link to it is made at the link path so that scripts know where to find it.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * Number of milliseconds of virtual time given to initialize() before the serial port is opened
+ */
+#define ROBOTSIM_BOOT_TIME 2000
+
+/**
+ * Path of the symbolic link to the pseudo-terminal, or NULL if there is none
+ */
+static const char* linkPath = NULL;
+
+/**
+ * Removes the symbolic link and exits when the program is stopped
+ *
+ * @param signal The signal that stopped the program
+ */
+static void stopSimulator(int signal) {
+	if (linkPath != NULL) {
+		unlink(linkPath);
+	}
+	_exit(0);
+}
+
+/**
+ * Creates the pseudo-terminal that stands in for the robot's serial port
+ *
+ * @return the file descriptor of the robot's end of the pseudo-terminal, or -1 if it could not be created
+ */
+static int openSerialPort() {
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+		return -1;
+	}
+	const char* slavePath = ptsname(master);
+
+	// Keep the computer's end open and raw so that bytes pass through unchanged (no echo, no
+	// newline translation) and so that the robot's end stays usable between connections
+	int slave = open(slavePath, O_RDWR | O_NOCTTY);
+	if (slave < 0) {
+		return -1;
+	}
+	struct termios settings;
+	tcgetattr(slave, &settings);
+	cfmakeraw(&settings);
+	tcsetattr(slave, TCSANOW, &settings);
+
+	simLog("robotsim: serial port is %s", slavePath);
+	if (linkPath != NULL) {
+		unlink(linkPath);
+		if (symlink(slavePath, linkPath) != 0) {
+			simLog("robotsim: could not link %s", linkPath);
+			return -1;
+		}
+	}
+	return master;
+}
+
+/**
+ * Presses the LCD center button while the robot is asking for a file and releases it otherwise
+ */
+static void answerLcd() {
+	simLcdSetButtons(strcmp(simLcdLine(1), "Select file") == 0 ? LCD_BTN_CENTER : 0);
+}
+
+int main(int argc, char** argv) {
+	const char* flashDirectory = ".";
+	int option;
+	while ((option = getopt(argc, argv, "d:l:")) != -1) {
+		if (option == 'd') {
+			flashDirectory = optarg;
+		} else if (option == 'l') {
+			linkPath = optarg;
+		} else {
+			simLog("Usage: robotsim [-d flash directory] [-l link path]");
+			return 2;
+		}
+	}
+
+	signal(SIGINT, &stopSimulator);
+	signal(SIGTERM, &stopSimulator);
+
+	if (simFlashOpen(flashDirectory) < 0) {
+		simLog("robotsim: could not read %s", flashDirectory);
+		return 1;
+	}
+
+	// Get through initialize() as fast as possible before the serial port appears, so that its
+	// messages cannot land in the middle of a transfer
+	simAddTickHook(&answerLcd);
+	simStartRobot(false);
+	simRun(ROBOTSIM_BOOT_TIME);
+
+	int serial = openSerialPort();
+	if (serial < 0) {
+		simLog("robotsim: could not create a pseudo-terminal");
+		return 1;
+	}
+	simSerialOpen(serial);
+	simSetSpeed(1);
+	while (true) {
+		simRun(1000);
+	}
+}
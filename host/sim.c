@@ -0,0 +1,744 @@
+/** @file sim.c
+ * @brief File for the tasks and virtual clock of the simulated PROS API
+ *
+ * Every task has its own stack and is switched to with swapcontext(), so only one task runs at a
+ * time and every switch happens at a known point. Together with the virtual clock this makes a
+ * run repeat exactly, whatever the speed of the computer.
+ *
+ * This file is compiled with prosnames.h like the robot code, so it must not include <stdio.h>.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+/**
+ * Maximum number of tick hooks
+ */
+#define SIM_MAX_TICK_HOOKS 8
+
+/**
+ * Wake time of a task that waits forever
+ */
+#define SIM_FOREVER UINT64_MAX
+
+/**
+ * A task of the simulated robot
+ */
+typedef struct sim_task {
+	/**
+	 * The state of the task (TASK_DEAD, TASK_RUNNABLE, TASK_SLEEPING or TASK_SUSPENDED)
+	 */
+	unsigned int state;
+
+	/**
+	 * The saved registers of the task while it is not running
+	 */
+	ucontext_t context;
+
+	/**
+	 * The stack of the task
+	 */
+	void* stack;
+
+	/**
+	 * The function that the task runs
+	 */
+	TaskCode taskCode;
+
+	/**
+	 * The parameter passed to the function
+	 */
+	void* parameters;
+
+	/**
+	 * The priority of the task
+	 */
+	unsigned int priority;
+
+	/**
+	 * The virtual time in microseconds at which a sleeping task wakes up
+	 */
+	uint64_t wakeTime;
+
+	/**
+	 * The condition that a sleeping task is waiting for, or NULL if it is only waiting for time to pass
+	 */
+	sim_condition condition;
+
+	/**
+	 * The argument passed to the condition
+	 */
+	void* argument;
+
+	/**
+	 * Whether or not the task woke up because its wait timed out
+	 */
+	bool timedOut;
+
+	/**
+	 * When the task last became ready; tasks of equal priority run in this order
+	 */
+	unsigned long readyOrder;
+} sim_task;
+
+/**
+ * A mutex or semaphore of the simulated robot
+ */
+typedef struct sim_lock {
+	/**
+	 * The task holding a mutex
+	 */
+	sim_task* owner;
+
+	/**
+	 * Whether or not the lock can be taken
+	 */
+	bool available;
+} sim_lock;
+
+/**
+ * Every task of the simulated robot
+ */
+static sim_task tasks[SIM_MAX_TASKS];
+
+/**
+ * The task that is running, or NULL if the scheduler is running
+ */
+static sim_task* currentTask = NULL;
+
+/**
+ * The saved registers of the scheduler while a task is running
+ */
+static ucontext_t schedulerContext;
+
+/**
+ * The virtual time in microseconds
+ */
+static uint64_t clockMicros = 0;
+
+/**
+ * The virtual time in microseconds of the next tick
+ */
+static uint64_t nextTick = 1000;
+
+/**
+ * The number of times a task has become ready
+ */
+static unsigned long readyCount = 0;
+
+/**
+ * The number of taskSuspendAll() calls not yet matched by taskResumeAll()
+ */
+static int suspendAllDepth = 0;
+
+/**
+ * Whether or not simStop() has been called
+ */
+static bool stopRequested = false;
+
+/**
+ * How fast the virtual clock runs compared to the real clock, or 0 for as fast as possible
+ */
+static double clockSpeed = 0;
+
+/**
+ * The real time in microseconds at which the virtual clock read 0, when running at a set speed
+ */
+static double paceOrigin = 0;
+
+/**
+ * The longest extra time in microseconds added to each sleep by simSetJitter()
+ */
+static unsigned long maxJitter = 0;
+
+/**
+ * The state of the random number generator that picks the jitter
+ */
+static uint32_t jitterState = 1;
+
+/**
+ * The functions called every tick
+ */
+static sim_tick_hook tickHooks[SIM_MAX_TICK_HOOKS];
+
+/**
+ * The number of functions in tickHooks
+ */
+static int numTickHooks = 0;
+
+/**
+ * Gets the real time
+ *
+ * @return the number of microseconds since an arbitrary point in the past
+ */
+static double realMicros() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+/**
+ * Waits until the real clock catches up with the virtual clock, if a speed is set
+ */
+static void paceClock() {
+	if (clockSpeed <= 0) {
+		return;
+	}
+	double ahead = paceOrigin + clockMicros / clockSpeed - realMicros();
+	if (ahead > 0) {
+		struct timespec duration = { .tv_sec = (time_t) (ahead / 1e6), .tv_nsec = (long) (ahead * 1000) % 1000000000 };
+		nanosleep(&duration, NULL);
+	} else if (ahead < -100000) {
+		// Running too slowly to keep up; do not rush to catch up afterwards
+		paceOrigin -= ahead;
+	}
+}
+
+/**
+ * Moves the virtual clock forward, running the tick hooks for every tick that passes
+ *
+ * @param time The virtual time in microseconds to move to
+ */
+static void advanceClock(uint64_t time) {
+	while (nextTick <= time) {
+		clockMicros = nextTick;
+		nextTick += 1000;
+		traceTick();
+		for (int i = 0; i < numTickHooks; i++) {
+			tickHooks[i]();
+		}
+		paceClock();
+	}
+	if (time > clockMicros) {
+		clockMicros = time;
+	}
+}
+
+/**
+ * Marks a task as ready to run
+ *
+ * @param task The task
+ */
+static void makeReady(sim_task* task) {
+	task->state = TASK_RUNNABLE;
+	task->condition = NULL;
+	task->readyOrder = ++readyCount;
+	traceState(task - tasks + 1, "ready");
+}
+
+static bool lockAvailable(void* lock);
+
+/**
+ * Gets what a task that is not running is doing, as shown in the trace
+ *
+ * @param task The task
+ *
+ * @return the name of the task's state, or NULL if the task is dead
+ */
+static const char* stateName(sim_task* task) {
+	switch (task->state) {
+	case TASK_RUNNABLE:
+		return "ready";
+	case TASK_SUSPENDED:
+		return "suspended";
+	case TASK_SLEEPING:
+		if (task->condition == NULL) {
+			return "delay";
+		}
+		return (task->condition == &lockAvailable) ? "mutex wait" : "wait";
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * Wakes up every sleeping task whose condition is true or whose time has come
+ */
+static void wakeTasks() {
+	for (int i = 0; i < SIM_MAX_TASKS; i++) {
+		sim_task* task = &tasks[i];
+		if (task->state != TASK_SLEEPING) {
+			continue;
+		} else if (task->condition != NULL && task->condition(task->argument)) {
+			task->timedOut = false;
+			makeReady(task);
+		} else if (task->wakeTime <= clockMicros) {
+			task->timedOut = task->condition != NULL;
+			makeReady(task);
+		}
+	}
+}
+
+/**
+ * Finds the task that should run next
+ *
+ * @return the ready task with the highest priority (the one that has been ready longest among
+ * equals), or NULL if no task is ready
+ */
+static sim_task* nextTask() {
+	wakeTasks();
+	sim_task* best = NULL;
+	for (int i = 0; i < SIM_MAX_TASKS; i++) {
+		sim_task* task = &tasks[i];
+		if (task->state == TASK_RUNNABLE && (best == NULL || task->priority > best->priority ||
+				(task->priority == best->priority && task->readyOrder < best->readyOrder))) {
+			best = task;
+		}
+	}
+	return best;
+}
+
+/**
+ * Switches from the running task back to the scheduler until the task is chosen to run again
+ */
+static void blockTask() {
+	sim_task* task = currentTask;
+	if (suspendAllDepth > 0) {
+		// The Cortex would switch tasks with the scheduler suspended, so this is a bug in the robot code
+		simLog("Task %d waited with the scheduler suspended", (int) (task - tasks));
+		abort();
+	}
+	swapcontext(&task->context, &schedulerContext);
+}
+
+/**
+ * Puts the running task to sleep until the given virtual time
+ *
+ * @param wakeTime The virtual time in microseconds to wake up at
+ */
+static void sleepUntil(uint64_t wakeTime) {
+	if (maxJitter > 0) {
+		// xorshift32
+		jitterState ^= jitterState << 13;
+		jitterState ^= jitterState >> 17;
+		jitterState ^= jitterState << 5;
+		wakeTime += jitterState % (maxJitter + 1);
+	}
+	if (currentTask == NULL) {
+		advanceClock(wakeTime);
+		return;
+	}
+	currentTask->state = TASK_SLEEPING;
+	currentTask->wakeTime = wakeTime;
+	currentTask->condition = NULL;
+	blockTask();
+}
+
+/**
+ * Gets the virtual time at which a wait of the given length ends
+ *
+ * @param timeout The length of the wait in milliseconds
+ *
+ * @return the virtual time in microseconds, or SIM_FOREVER if the wait has no end
+ */
+static uint64_t timeoutToWakeTime(unsigned long timeout) {
+	return (timeout >= (SIM_FOREVER - clockMicros) / 1000) ? SIM_FOREVER : clockMicros + timeout * 1000ULL;
+}
+
+/**
+ * Blocks the calling task until a condition is true or a timeout passes
+ * The condition is checked whenever the scheduler looks for a task to run. If this is called
+ * outside of a task, the clock moves forward until the condition is true instead.
+ *
+ * @param condition The condition to wait for
+ * @param argument The argument to pass to the condition
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return true if the condition became true, false if the timeout passed
+ */
+bool simWait(sim_condition condition, void* argument, unsigned long timeout) {
+	uint64_t wakeTime = timeoutToWakeTime(timeout);
+	if (condition(argument)) {
+		return true;
+	} else if (currentTask == NULL) {
+		while (!condition(argument)) {
+			if (clockMicros >= wakeTime || stopRequested) {
+				return false;
+			}
+			advanceClock(nextTick);
+		}
+		return true;
+	}
+	currentTask->state = TASK_SLEEPING;
+	currentTask->wakeTime = wakeTime;
+	currentTask->condition = condition;
+	currentTask->argument = argument;
+	blockTask();
+	return !currentTask->timedOut;
+}
+
+/**
+ * Runs the scheduler until the virtual clock has moved forward by the given time or simStop() is called
+ *
+ * @param time The number of milliseconds of virtual time to run for
+ */
+void simRun(unsigned long time) {
+	uint64_t end = clockMicros + time * 1000ULL;
+	stopRequested = false;
+	while (!stopRequested && clockMicros < end) {
+		sim_task* task = nextTask();
+		if (task == NULL) {
+			advanceClock(MIN(nextTick, end));
+			continue;
+		}
+
+		currentTask = task;
+		traceState(task - tasks + 1, "running");
+		swapcontext(&schedulerContext, &task->context);
+		currentTask = NULL;
+		traceState(task - tasks + 1, stateName(task));
+		if (task->state == TASK_DEAD && task->stack != NULL) {
+			free(task->stack);
+			task->stack = NULL;
+		}
+	}
+}
+
+/**
+ * Makes simRun() return as soon as the task or hook that called this blocks or returns
+ */
+void simStop() {
+	stopRequested = true;
+}
+
+/**
+ * Sets how fast the virtual clock runs compared to the real clock
+ *
+ * @param speed 1 for real time, 2 for twice as fast, and so on, or 0 to run as fast as possible
+ */
+void simSetSpeed(double speed) {
+	clockSpeed = speed;
+	if (speed > 0) {
+		paceOrigin = realMicros() - clockMicros / speed;
+	}
+}
+
+/**
+ * Makes every sleep (delay(), taskDelayUntil() and the like) last a random extra time, as if
+ * other work held up the task when it should have woken
+ * A task wakes on the first tick at or after its wake time, so only whole milliseconds of jitter
+ * show in tasks; calls outside of a task wake at the exact microsecond.
+ *
+ * @param maxDelay The longest extra time in microseconds, or 0 to turn jitter off
+ * @param seed The seed of the random extra times, so that a run can be repeated
+ */
+void simSetJitter(unsigned long maxDelay, unsigned int seed) {
+	maxJitter = maxDelay;
+	jitterState = seed != 0 ? seed : 1;
+}
+
+/**
+ * Gets the virtual time
+ *
+ * @return the number of microseconds since the simulation started
+ */
+uint64_t simMicros() {
+	return clockMicros;
+}
+
+/**
+ * Moves the virtual clock forward while the calling task keeps running, as if it were busy
+ * (tick hooks still run for every millisecond that passes)
+ *
+ * @param time The number of microseconds to spend
+ */
+void simSpend(unsigned long time) {
+	advanceClock(clockMicros + time);
+}
+
+/**
+ * Adds a function to be called every millisecond of virtual time
+ *
+ * @param hook The function to call
+ */
+void simAddTickHook(sim_tick_hook hook) {
+	if (numTickHooks < SIM_MAX_TICK_HOOKS) {
+		tickHooks[numTickHooks++] = hook;
+	}
+}
+
+/**
+ * Runs the robot program the way the firmware's main task does
+ *
+ * @param parameters Non-zero to run autonomous() after initialization
+ */
+static void robotMain(void* parameters) {
+	initializeIO();
+	initialize();
+	if (parameters != NULL) {
+		autonomous();
+	} else {
+		operatorControl();
+	}
+}
+
+/**
+ * Starts the robot program the way the firmware does: initializeIO() and initialize(), then
+ * autonomous() or operatorControl(), on a task of default priority
+ *
+ * @param autonomous true to run autonomous() after initialization, false to run operatorControl()
+ */
+void simStartRobot(bool autonomous) {
+	taskCreate(&robotMain, TASK_DEFAULT_STACK_SIZE, autonomous ? (void*) 1 : NULL, TASK_PRIORITY_DEFAULT);
+}
+
+/**
+ * Runs a task's function and marks the task dead when the function returns
+ *
+ * @param index The index of the task in the tasks array
+ */
+static void taskEntry(int index) {
+	sim_task* task = &tasks[index];
+	task->taskCode(task->parameters);
+	task->state = TASK_DEAD;
+}
+
+TaskHandle taskCreate(TaskCode taskCode, const unsigned int stackDepth, void* parameters, const unsigned int priority) {
+	for (int i = 0; i < SIM_MAX_TASKS; i++) {
+		sim_task* task = &tasks[i];
+		if (task->state != TASK_DEAD || task->stack != NULL) {
+			continue;
+		}
+		task->stack = malloc(SIM_TASK_STACK_SIZE);
+		if (task->stack == NULL) {
+			return NULL;
+		}
+		task->taskCode = taskCode;
+		task->parameters = parameters;
+		task->priority = MIN(priority, TASK_PRIORITY_HIGHEST);
+		getcontext(&task->context);
+		task->context.uc_stack.ss_sp = task->stack;
+		task->context.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+		task->context.uc_link = &schedulerContext;
+		makecontext(&task->context, (void (*)()) &taskEntry, 1, i);
+		char name[32];
+		if (taskCode == &robotMain) {
+			snprintf(name, sizeof(name), "robot (task %d)", i);
+		} else {
+			snprintf(name, sizeof(name), "task %d, priority %u", i, task->priority);
+		}
+		traceName(i + 1, name);
+		makeReady(task);
+		return task;
+	}
+	return NULL;
+}
+
+void taskDelete(TaskHandle taskToDelete) {
+	sim_task* task = (taskToDelete == NULL) ? currentTask : taskToDelete;
+	if (task == NULL) {
+		return;
+	}
+	task->state = TASK_DEAD;
+	if (task == currentTask) {
+		blockTask();
+	} else if (task->stack != NULL) {
+		free(task->stack);
+		task->stack = NULL;
+	}
+}
+
+unsigned int taskGetCount() {
+	unsigned int count = 0;
+	for (int i = 0; i < SIM_MAX_TASKS; i++) {
+		if (tasks[i].state != TASK_DEAD) {
+			count++;
+		}
+	}
+	return count;
+}
+
+unsigned int taskGetState(TaskHandle task) {
+	if (task == NULL) {
+		return TASK_DEAD;
+	}
+	return (task == currentTask) ? TASK_RUNNING : ((sim_task*) task)->state;
+}
+
+unsigned int taskPriorityGet(const TaskHandle task) {
+	return ((sim_task*) ((task == NULL) ? currentTask : task))->priority;
+}
+
+void taskPrioritySet(TaskHandle task, const unsigned int newPriority) {
+	((sim_task*) ((task == NULL) ? currentTask : task))->priority = MIN(newPriority, TASK_PRIORITY_HIGHEST);
+}
+
+void taskSuspend(TaskHandle taskToSuspend) {
+	sim_task* task = (taskToSuspend == NULL) ? currentTask : taskToSuspend;
+	if (task != NULL && task->state != TASK_DEAD) {
+		task->state = TASK_SUSPENDED;
+		if (task == currentTask) {
+			blockTask();
+		}
+	}
+}
+
+void taskResume(TaskHandle taskToResume) {
+	sim_task* task = taskToResume;
+	if (task != NULL && task->state == TASK_SUSPENDED) {
+		makeReady(task);
+	}
+}
+
+void taskSuspendAll() {
+	// Tasks only switch when the running one waits, so there is nothing more to stop
+	suspendAllDepth++;
+}
+
+void taskResumeAll() {
+	if (suspendAllDepth > 0) {
+		suspendAllDepth--;
+	}
+}
+
+TaskHandle taskGetCurrent() {
+	return currentTask;
+}
+
+/**
+ * The function and period of a task started with taskRunLoop()
+ */
+typedef struct sim_loop {
+	void (*fn)(void);
+	unsigned long increment;
+} sim_loop;
+
+/**
+ * Calls a function at a fixed period
+ *
+ * @param loop The sim_loop describing the function and period
+ */
+static void runLoop(void* loop) {
+	sim_loop* settings = loop;
+	unsigned long wakeTime = millis();
+	while (true) {
+		settings->fn();
+		taskDelayUntil(&wakeTime, settings->increment);
+	}
+}
+
+TaskHandle taskRunLoop(void (*fn)(void), const unsigned long increment) {
+	sim_loop* loop = malloc(sizeof(sim_loop));
+	loop->fn = fn;
+	loop->increment = increment;
+	sim_task* task = taskCreate(&runLoop, TASK_DEFAULT_STACK_SIZE, loop, TASK_PRIORITY_DEFAULT + 1);
+	if (task != NULL) {
+		char name[32];
+		snprintf(name, sizeof(name), "loop (task %d), every %lu ms", (int) (task - tasks), increment);
+		traceName(task - tasks + 1, name);
+	}
+	return task;
+}
+
+unsigned long micros() {
+	return clockMicros;
+}
+
+unsigned long millis() {
+	return clockMicros / 1000;
+}
+
+void delayMicroseconds(const unsigned long us) {
+	simSpend(us);
+}
+
+void delay(const unsigned long time) {
+	sleepUntil(clockMicros + time * 1000ULL);
+}
+
+void wait(const unsigned long time) {
+	delay(time);
+}
+
+void taskDelay(const unsigned long msToDelay) {
+	delay(msToDelay);
+}
+
+void taskDelayUntil(unsigned long* previousWakeTime, const unsigned long cycleTime) {
+	*previousWakeTime += cycleTime;
+	if (*previousWakeTime * 1000ULL > clockMicros) {
+		sleepUntil(*previousWakeTime * 1000ULL);
+	}
+}
+
+void waitUntil(unsigned long* previousWakeTime, const unsigned long time) {
+	taskDelayUntil(previousWakeTime, time);
+}
+
+/**
+ * Checks whether a mutex or semaphore can be taken
+ *
+ * @param lock The sim_lock
+ *
+ * @return true if the lock is available
+ */
+static bool lockAvailable(void* lock) {
+	return ((sim_lock*) lock)->available;
+}
+
+/**
+ * Takes a mutex or semaphore, waiting for it to become available
+ *
+ * @param lock The lock
+ * @param blockTime The maximum number of milliseconds to wait
+ *
+ * @return true if the lock was taken
+ */
+static bool takeLock(sim_lock* lock, unsigned long blockTime) {
+	if (lock == NULL || !simWait(&lockAvailable, lock, blockTime)) {
+		return false;
+	}
+	lock->available = false;
+	lock->owner = currentTask;
+	return true;
+}
+
+Mutex mutexCreate() {
+	sim_lock* lock = calloc(1, sizeof(sim_lock));
+	lock->available = true;
+	return lock;
+}
+
+bool mutexTake(Mutex mutex, const unsigned long blockTime) {
+	return takeLock(mutex, blockTime);
+}
+
+bool mutexGive(Mutex mutex) {
+	sim_lock* lock = mutex;
+	if (lock == NULL || lock->available || lock->owner != currentTask) {
+		return false;
+	}
+	lock->available = true;
+	lock->owner = NULL;
+	return true;
+}
+
+void mutexDelete(Mutex mutex) {
+	free(mutex);
+}
+
+Semaphore semaphoreCreate() {
+	return mutexCreate();
+}
+
+bool semaphoreTake(Semaphore semaphore, const unsigned long blockTime) {
+	return takeLock(semaphore, blockTime);
+}
+
+bool semaphoreGive(Semaphore semaphore) {
+	sim_lock* lock = semaphore;
+	if (lock == NULL || lock->available) {
+		return false;
+	}
+	lock->available = true;
+	return true;
+}
+
+void semaphoreDelete(Semaphore semaphore) {
+	free(semaphore);
+}
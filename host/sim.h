@@ -0,0 +1,540 @@
+/** @file sim.h
+ * @brief File for controlling the simulated PROS API used when the robot code runs on a computer
+ *
+ * The files in host/ implement the API.h surface on Linux so that the code in src/ can run
+ * without a Cortex:
+ *
+ * - sim.c runs tasks one at a time on a virtual clock. A task runs until it calls a function that
+ *   blocks (delay(), mutexTake(), reading serial input that has not arrived...), then the highest
+ *   priority task that is ready runs next. When every task is blocked the clock moves forward one
+ *   millisecond, tick hooks run and sleeping tasks whose time has come wake up. The clock only
+ *   follows the real clock if a speed is set, so a run is repeatable and as fast as the computer.
+ * - flash.c keeps flash files in memory, optionally loaded from and written back to a directory.
+ * - pros.c holds the motors, joysticks, LCD, sensors and the serial monitor.
+ * - iomodel.c charges virtual time for flash and serial operations and counts them.
+ *
+ * A task that loops without ever blocking never gives the other tasks a turn, just as a task that
+ * never delays would starve lower priority tasks on the robot.
+ */
+
+#ifndef SIM_H
+
+// This prevents multiple inclusion
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of bytes in a line of the simulated LCD, including the terminating null character
+ */
+#define SIM_LCD_LINE_LENGTH 17
+
+/**
+ * Maximum number of flash files that can be open at once, as on the Cortex (at most one of them writing)
+ */
+#define SIM_MAX_FILES 4
+
+/**
+ * Maximum number of files in the simulated flash
+ */
+#define SIM_MAX_FLASH_FILES 32
+
+/**
+ * Maximum number of tasks that can exist at once
+ */
+#define SIM_MAX_TASKS 16
+
+/**
+ * Number of bytes of stack given to each task (much more than on the robot, since the computer's
+ * C library uses more stack)
+ */
+#define SIM_TASK_STACK_SIZE (256 * 1024)
+
+/**
+ * Number of bytes of serial input that can wait to be read
+ */
+#define SIM_SERIAL_BUFFER_SIZE 4096
+
+/**
+ * Number of bytes erased at once in the Cortex's flash (STM32F103 page)
+ */
+#define SIM_FLASH_PAGE_SIZE 1024
+
+/**
+ * Number of integrated motor encoders (IMEs) that can be connected to the simulated robot
+ */
+#define SIM_MAX_IMES 10
+
+/**
+ * Analog reading of a gyro at rest, which its rate output sits at (about 1.5 V)
+ */
+#define SIM_GYRO_REST 1860
+
+/**
+ * Virtual time charged for each flash and serial operation, in nanoseconds
+ * The time passes with simSpend(), so the calling task stays busy for it as it would on the robot.
+ */
+typedef struct sim_io_costs {
+	/**
+	 * Opening a flash file
+	 */
+	unsigned long flashOpen;
+
+	/**
+	 * Closing a flash file
+	 */
+	unsigned long flashClose;
+
+	/**
+	 * Erasing a page, charged for each SIM_FLASH_PAGE_SIZE bytes (or part) of a file written and closed, or deleted
+	 */
+	unsigned long flashErase;
+
+	/**
+	 * Moving the position of a flash file
+	 */
+	unsigned long flashSeek;
+
+	/**
+	 * Each call that reads or writes a flash file, whatever its length
+	 */
+	unsigned long flashCall;
+
+	/**
+	 * Each byte read from a flash file
+	 */
+	unsigned long flashReadByte;
+
+	/**
+	 * Each byte written to a flash file
+	 */
+	unsigned long flashWriteByte;
+
+	/**
+	 * Each call that writes to the serial monitor, whatever its length
+	 */
+	unsigned long serialCall;
+
+	/**
+	 * Each byte written to the serial monitor
+	 */
+	unsigned long serialByte;
+} sim_io_costs;
+
+/**
+ * Counts of the flash and serial operations since simResetIoStats()
+ */
+typedef struct sim_io_stats {
+	/**
+	 * Flash files opened
+	 */
+	unsigned long flashOpens;
+
+	/**
+	 * Flash files closed
+	 */
+	unsigned long flashCloses;
+
+	/**
+	 * Calls that moved the position of a flash file
+	 */
+	unsigned long flashSeeks;
+
+	/**
+	 * Calls that read a flash file
+	 */
+	unsigned long flashReads;
+
+	/**
+	 * Calls that wrote a flash file
+	 */
+	unsigned long flashWrites;
+
+	/**
+	 * Flash files deleted
+	 */
+	unsigned long flashDeletes;
+
+	/**
+	 * Bytes read from flash
+	 */
+	unsigned long flashBytesRead;
+
+	/**
+	 * Bytes written to flash
+	 */
+	unsigned long flashBytesWritten;
+
+	/**
+	 * Flash pages erased
+	 */
+	unsigned long flashPagesErased;
+
+	/**
+	 * Calls that wrote to the serial monitor
+	 */
+	unsigned long serialWrites;
+
+	/**
+	 * Bytes written to the serial monitor
+	 */
+	unsigned long serialBytesOut;
+
+	/**
+	 * Bytes received from the serial monitor
+	 */
+	unsigned long serialBytesIn;
+
+	/**
+	 * Virtual time charged for flash operations in microseconds
+	 */
+	uint64_t flashTime;
+
+	/**
+	 * Virtual time charged for serial output in microseconds
+	 */
+	uint64_t serialTime;
+
+	/**
+	 * Faults injected by simSetFaults()
+	 */
+	unsigned long faults;
+} sim_io_stats;
+
+/**
+ * Faults to inject into the simulated flash and serial monitor, as a chance from 0 to 1 of each
+ * operation or byte going wrong
+ */
+typedef struct sim_faults {
+	/**
+	 * Opening a flash file fails
+	 */
+	double openFailure;
+
+	/**
+	 * A flash read or write moves only half of its bytes (none, for a single byte)
+	 */
+	double shortRead;
+	double shortWrite;
+
+	/**
+	 * A byte sent over the serial monitor, in either direction, is lost or has one bit flipped
+	 */
+	double serialDrop;
+	double serialCorrupt;
+
+	/**
+	 * Extra virtual time in microseconds spent by every flash operation, as on a worn or busy flash
+	 */
+	unsigned long slowFlash;
+
+	/**
+	 * The seed of the random choices, so that a run can be repeated
+	 */
+	unsigned int seed;
+} sim_faults;
+
+/**
+ * Estimated costs on a Cortex: STM32F103 flash timings (20 ms page erase, about 26 us per byte
+ * programmed, memory-mapped reads) plus PROS file system overhead, and 115200 baud serial output
+ * (10 bits per byte). Replace them with numbers measured on the robot where they are known.
+ */
+extern const sim_io_costs simCortexIoCosts;
+
+/**
+ * Function called once per millisecond of virtual time, after the clock has moved forward
+ */
+typedef void (*sim_tick_hook)();
+
+/**
+ * Function that tells a waiting task whether the thing it is waiting for has happened
+ *
+ * @param argument The argument given to simWait()
+ *
+ * @return true if the task can stop waiting
+ */
+typedef bool (*sim_condition)(void* argument);
+
+/**
+ * Runs the scheduler until the virtual clock has moved forward by the given time or simStop() is called
+ *
+ * @param time The number of milliseconds of virtual time to run for
+ */
+void simRun(unsigned long time);
+
+/**
+ * Makes simRun() return as soon as the task or hook that called this blocks or returns
+ */
+void simStop();
+
+/**
+ * Sets how fast the virtual clock runs compared to the real clock
+ *
+ * @param speed 1 for real time, 2 for twice as fast, and so on, or 0 to run as fast as possible
+ */
+void simSetSpeed(double speed);
+
+/**
+ * Makes every sleep (delay(), taskDelayUntil() and the like) last a random extra time, as if
+ * other work held up the task when it should have woken
+ * A task wakes on the first tick at or after its wake time, so only whole milliseconds of jitter
+ * show in tasks; calls outside of a task wake at the exact microsecond.
+ *
+ * @param maxDelay The longest extra time in microseconds, or 0 to turn jitter off
+ * @param seed The seed of the random extra times, so that a run can be repeated
+ */
+void simSetJitter(unsigned long maxDelay, unsigned int seed);
+
+/**
+ * Starts recording a timeline of the simulated robot in the Chrome trace event format, for
+ * chrome://tracing or https://ui.perfetto.dev
+ * Each task gets a track showing when it runs, waits to run, sleeps in a delay or waits for a
+ * mutex, with the flash operations and serial writes it makes; all times are virtual.
+ *
+ * @param filename The name of the file to write
+ * @param ticks Whether to also mark every millisecond tick of the virtual clock
+ *
+ * @return true if the file could be opened
+ */
+bool simTraceOpen(const char* filename, bool ticks);
+
+/**
+ * Stops recording the timeline started by simTraceOpen() and finishes the file
+ */
+void simTraceClose();
+
+/**
+ * Gets the virtual time
+ *
+ * @return the number of microseconds since the simulation started
+ */
+uint64_t simMicros();
+
+/**
+ * Moves the virtual clock forward while the calling task keeps running, as if it were busy
+ * (tick hooks still run for every millisecond that passes)
+ *
+ * @param time The number of microseconds to spend
+ */
+void simSpend(unsigned long time);
+
+/**
+ * Blocks the calling task until a condition is true or a timeout passes
+ * The condition is checked whenever the scheduler looks for a task to run. If this is called
+ * outside of a task, the clock moves forward until the condition is true instead.
+ *
+ * @param condition The condition to wait for
+ * @param argument The argument to pass to the condition
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return true if the condition became true, false if the timeout passed
+ */
+bool simWait(sim_condition condition, void* argument, unsigned long timeout);
+
+/**
+ * Adds a function to be called every millisecond of virtual time
+ *
+ * @param hook The function to call
+ */
+void simAddTickHook(sim_tick_hook hook);
+
+/**
+ * Starts the robot program the way the firmware does: initializeIO() and initialize(), then
+ * autonomous() or operatorControl(), on a task of default priority
+ *
+ * @param autonomous true to run autonomous() after initialization, false to run operatorControl()
+ */
+void simStartRobot(bool autonomous);
+
+/**
+ * Loads the simulated flash from a directory and writes every later change back to it
+ *
+ * @param directory The directory, which must already exist
+ *
+ * @return the number of files loaded, or -1 if the directory could not be read
+ */
+int simFlashOpen(const char* directory);
+
+/**
+ * Stores a file in the simulated flash, replacing any file with the same name
+ *
+ * @param name The name of the file
+ * @param data The contents of the file
+ * @param size The number of bytes in the file
+ *
+ * @return true if the file was stored, false if the flash is full
+ */
+bool simFlashWrite(const char* name, const void* data, int size);
+
+/**
+ * Gets the contents of a file in the simulated flash
+ *
+ * @param name The name of the file
+ * @param size Set to the number of bytes in the file
+ *
+ * @return the contents of the file, or NULL if it does not exist
+ */
+const uint8_t* simFlashRead(const char* name, int* size);
+
+/**
+ * Sets the virtual time charged for flash and serial operations (all zero, the default, makes them free)
+ *
+ * @param costs The costs, which are copied
+ */
+void simSetIoCosts(const sim_io_costs* costs);
+
+/**
+ * Gets the counts of flash and serial operations since simResetIoStats()
+ *
+ * @param stats Set to the counts
+ */
+void simGetIoStats(sim_io_stats* stats);
+
+/**
+ * Sets the counts of flash and serial operations back to zero
+ */
+void simResetIoStats();
+
+/**
+ * Starts injecting faults into the flash and serial operations (all zero, the default, injects none)
+ * Serial faults apply to the bytes given to simSerialInput() or read from the serial file
+ * descriptor, and to the bytes the robot writes to it.
+ *
+ * @param faults The faults, which are copied
+ */
+void simSetFaults(const sim_faults* faults);
+
+/**
+ * Sets the file descriptor that the serial monitor (stdin and stdout) reads from and writes to
+ * Input is read without blocking once per millisecond of virtual time.
+ *
+ * @param fd The file descriptor, or -1 to throw away output and only receive input from simSerialInput()
+ */
+void simSerialOpen(int fd);
+
+/**
+ * Adds bytes to the serial input, as if they had been typed into the serial monitor
+ *
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+void simSerialInput(const void* data, int length);
+
+/**
+ * Gets a line of the simulated LCD
+ *
+ * @param line The line number (1 or 2)
+ *
+ * @return the text on the line
+ */
+const char* simLcdLine(int line);
+
+/**
+ * Sets which LCD buttons are held down
+ *
+ * @param buttons The LCD_BTN_LEFT, LCD_BTN_CENTER and LCD_BTN_RIGHT bits of the held buttons
+ */
+void simLcdSetButtons(unsigned int buttons);
+
+/**
+ * Gets the value last sent to a motor
+ *
+ * @param channel The motor channel (1 - 10)
+ *
+ * @return the motor value (-127 to 127)
+ */
+int simMotorGet(int channel);
+
+/**
+ * Sets an analog axis of a joystick
+ *
+ * @param joystick The joystick (1 or 2)
+ * @param axis The axis (1 - 4, ACCEL_X or ACCEL_Y)
+ * @param value The value of the axis (-127 to 127)
+ */
+void simJoystickSetAnalog(int joystick, int axis, int value);
+
+/**
+ * Sets whether a joystick button is held down
+ *
+ * @param joystick The joystick (1 or 2)
+ * @param buttonGroup The button group (5 - 8)
+ * @param button JOY_UP, JOY_DOWN, JOY_LEFT or JOY_RIGHT
+ * @param pressed Whether or not the button is held down
+ */
+void simJoystickSetDigital(int joystick, int buttonGroup, int button, bool pressed);
+
+/**
+ * Sets the value read from an analog input
+ *
+ * @param channel The analog channel (1 - 8)
+ * @param value The value (0 - 4095)
+ */
+void simSetAnalog(int channel, int value);
+
+/**
+ * Sets the value read from a digital input
+ *
+ * @param pin The digital pin (1 - 12)
+ * @param value The value
+ */
+void simSetDigital(int pin, bool value);
+
+/**
+ * Sets the voltage of the main battery
+ *
+ * @param millivolts The voltage in millivolts
+ */
+void simSetBattery(unsigned int millivolts);
+
+/**
+ * Connects integrated motor encoders (IMEs) to the robot; imeInitializeAll() finds this many
+ *
+ * @param count The number of IMEs, at addresses 0 to count - 1 (at most SIM_MAX_IMES)
+ */
+void simSetImes(int count);
+
+/**
+ * Sets what an integrated motor encoder measures
+ *
+ * @param address The address of the IME
+ * @param counts The counts it has turned since the robot started; imeGet() reads them less those at its last reset
+ * @param velocity The velocity that imeGetVelocity() reads (RPM of the encoder wheel)
+ */
+void simSetIme(int address, int counts, int velocity);
+
+/**
+ * Sets what a gyro measures; gyroInit() and gyroReset() take the heading then as zero
+ *
+ * @param channel The analog port of the gyro, from 1 to 8
+ * @param degrees The degrees it has turned counterclockwise since the robot started
+ */
+void simSetGyro(int channel, int degrees);
+
+/**
+ * Sets the competition state reported to the robot code
+ *
+ * @param online Whether or not the robot is connected to a field controller
+ * @param enabled Whether or not the robot is enabled
+ * @param autonomous Whether or not the robot is in autonomous mode
+ */
+void simSetCompetition(bool online, bool enabled, bool autonomous);
+
+/**
+ * Prints a message to the standard error of the computer, adding a newline
+ *
+ * @param format The format string, as for printf
+ */
+void simLog(const char* format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,431 @@
+/** @file sweep.c
+ * @brief File for the Monte Carlo sweep of how robust a recording's playback is
+ *
+ * Plays a recording many times with the battery voltage, the wheel friction and the wake-up
+ * jitter of the playback chosen at random for each trial, and reports the distribution of how
+ * far each playback ends from the reference run (replay.h) made with the nominal robot.
+ *
+ * The simulated robot and the robot code keep their state in globals, so trials cannot share a
+ * process. Instead the sweep keeps one child process per CPU busy: each trial forks from the
+ * parent after the reference run, plays once on its own copy of the simulator and sends its
+ * result back through a pipe, so no mutable state is shared. A trial's parameters come from the
+ * seed and its number only, so the results do not depend on the number of workers.
+ *
+ * Usage: sweep [-n trials] [-w workers] [-s seed] [-b volts:volts] [-f friction:friction]
+ *              [-j microseconds] [-c] [-e] [-v] [-g] [-p] recording [section2 section3 section4]
+ * -b and -f give the ranges of battery voltage (with no load) and friction, -j the largest jitter
+ * (each trial picks its own largest extra delay up to this), -c charges the Cortex estimates
+ * for flash and serial operations, -e plays closed loop, following the wheel track that the
+ * reference run records, -v compensates for the battery with the voltage that the reference
+ * run records, -g gives the robot a gyro and holds the headings that the reference run records, and
+ * -p plays the drive commands in steps as they were recorded instead of interpolating them.
+ */
+
+#include "main.h"
+#include "replay.h"
+#include "sim.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+// The C library's wait() is not used, but <sys/wait.h> declares it, and prosnames.h renames it
+#undef wait
+#include <sys/wait.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * The random parameters of a trial
+ */
+typedef struct sweep_trial {
+	/**
+	 * Voltage of the battery with no load
+	 */
+	double battery;
+
+	/**
+	 * Friction coefficient between the rollers and the floor
+	 */
+	double friction;
+
+	/**
+	 * Longest extra time in microseconds added to each sleep
+	 */
+	unsigned long jitter;
+
+	/**
+	 * Seed of the extra times
+	 */
+	unsigned int seed;
+} sweep_trial;
+
+/**
+ * What a trial sends back to the parent
+ */
+typedef struct sweep_result {
+	/**
+	 * The number of the trial
+	 */
+	int index;
+
+	/**
+	 * How far the playback strayed from the reference
+	 */
+	replay_error error;
+
+	/**
+	 * The lowest battery voltage during the playback
+	 */
+	double lowestVoltage;
+
+	/**
+	 * How far the robot's odometry put it from where it ended the playback
+	 */
+	double odometryError;
+} sweep_result;
+
+/**
+ * A range of values to pick from
+ */
+typedef struct sweep_range {
+	/**
+	 * The lowest and highest values
+	 */
+	double low;
+	double high;
+} sweep_range;
+
+/**
+ * Prints a line of the report to standard output
+ *
+ * @param format The format string, as for printf
+ */
+static void report(const char* format, ...) {
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (write(STDOUT_FILENO, line, MIN(length, (int) sizeof(line) - 1)) < 0) {
+		exit(1);
+	}
+}
+
+/**
+ * Gets a random number from a seed (splitmix64), so that any trial's numbers can be made alone
+ *
+ * @param state The seed, moved on to the next number
+ *
+ * @return a number from 0 to 1
+ */
+static double randomUnit(uint64_t* state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return (z >> 11) / 9007199254740992.0;
+}
+
+/**
+ * Picks the parameters of a trial
+ *
+ * @param seed The seed of the sweep
+ * @param index The number of the trial
+ * @param battery The range of battery voltages
+ * @param friction The range of friction coefficients
+ * @param jitter The largest jitter in microseconds
+ * @param trial Set to the parameters
+ */
+static void pickTrial(unsigned int seed, int index, const sweep_range* battery, const sweep_range* friction,
+		unsigned long jitter, sweep_trial* trial) {
+	uint64_t state = ((uint64_t) seed << 32) ^ (uint64_t) index;
+	trial->battery = battery->low + (battery->high - battery->low) * randomUnit(&state);
+	trial->friction = friction->low + (friction->high - friction->low) * randomUnit(&state);
+	trial->jitter = (unsigned long) (jitter * randomUnit(&state));
+	trial->seed = (unsigned int) (randomUnit(&state) * 4294967295.0) | 1;
+}
+
+/**
+ * Runs a trial in a child process, which sends its result through a pipe and exits
+ *
+ * @param index The number of the trial
+ * @param trial The parameters of the trial
+ * @param recordings The recordings, one after another
+ * @param tracks The wheel tracks of the recordings, or NULL to play open loop
+ * @param voltages The voltage files of the recordings, or NULL to play without battery compensation
+ * @param headings The headings files of the recordings, or NULL to play without a gyro
+ * @param sections The number of recordings
+ * @param reference The path of the reference run
+ * @param costs Whether to charge the Cortex estimates for flash and serial operations
+ * @param resultFd The end of the pipe to write the result to
+ */
+static void runTrial(int index, const sweep_trial* trial, const uint8_t* recordings, const uint8_t* tracks,
+		const uint8_t* voltages, const uint8_t* headings, int sections, const replay_path* reference, bool costs,
+		int resultFd) {
+	mecanum_params params;
+	mecanumDefaults(&params);
+	params.batteryVoltage = trial->battery;
+	params.friction = trial->friction;
+	if (costs) {
+		simSetIoCosts(&simCortexIoCosts);
+	}
+	simSetJitter(trial->jitter, trial->seed);
+	simSerialOpen(-1);
+	replay_path playback = { NULL, 0, 0, 0, 0, { 0, 0, 0 } };
+	replayPlayback(&params, recordings, tracks, voltages, headings, sections, &playback);
+	if (playback.length == 0) {
+		_exit(1);
+	}
+	sweep_result result;
+	result.index = index;
+	replayCompare(reference, &playback, &result.error);
+	result.lowestVoltage = playback.lowestVoltage;
+	const replay_pose* end = &playback.poses[playback.length - 1];
+	result.odometryError = hypot(playback.odometry.x - end->x, playback.odometry.y - end->y);
+	// Writes of up to PIPE_BUF bytes are never mixed with other children's
+	_exit(write(resultFd, &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+}
+
+/**
+ * Compares two numbers for qsort()
+ *
+ * @param a The first number
+ * @param b The second number
+ *
+ * @return negative, zero or positive as a is less than, equal to or greater than b
+ */
+static int compareDoubles(const void* a, const void* b) {
+	double difference = *(const double*) a - *(const double*) b;
+	return (difference > 0) - (difference < 0);
+}
+
+/**
+ * Prints the distribution of a measure over the trials
+ *
+ * @param name The name of the measure
+ * @param values The measure of each trial, which are sorted
+ * @param count The number of trials
+ */
+static void reportDistribution(const char* name, double* values, int count) {
+	qsort(values, count, sizeof(double), &compareDoubles);
+	double sum = 0;
+	for (int i = 0; i < count; i++) {
+		sum += values[i];
+	}
+	report("%-20s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", name, sum / count, values[count / 2],
+			values[count * 90 / 100], values[count * 95 / 100], values[count * 99 / 100], values[count - 1]);
+}
+
+/**
+ * Gets the correlation between two measures over the trials
+ *
+ * @param x The first measure of each trial
+ * @param y The second measure of each trial
+ * @param count The number of trials
+ *
+ * @return the Pearson correlation coefficient, or 0 if either measure does not vary
+ */
+static double correlation(const double* x, const double* y, int count) {
+	double sumX = 0, sumY = 0, sumXX = 0, sumYY = 0, sumXY = 0;
+	for (int i = 0; i < count; i++) {
+		sumX += x[i];
+		sumY += y[i];
+		sumXX += x[i] * x[i];
+		sumYY += y[i] * y[i];
+		sumXY += x[i] * y[i];
+	}
+	double varianceX = count * sumXX - sumX * sumX;
+	double varianceY = count * sumYY - sumY * sumY;
+	return (varianceX > 0 && varianceY > 0) ? (count * sumXY - sumX * sumY) / sqrt(varianceX * varianceY) : 0;
+}
+
+/**
+ * Parses a range written as "low:high"
+ *
+ * @param text The text
+ * @param range Set to the range
+ *
+ * @return true if the text was a range
+ */
+static bool parseRange(const char* text, sweep_range* range) {
+	char* end;
+	range->low = strtod(text, &end);
+	if (*end != ':') {
+		return false;
+	}
+	range->high = strtod(end + 1, &end);
+	return *end == 0 && range->high >= range->low;
+}
+
+int main(int argc, char** argv) {
+	int trials = 1000;
+	int workers = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int seed = 1;
+	sweep_range battery = { 7.0, 8.4 };
+	sweep_range friction = { 0.45, 0.75 };
+	unsigned long jitter = 3000;
+	bool costs = false;
+	bool closedLoop = false;
+	bool compensate = false;
+	bool gyro = false;
+	bool steps = false;
+	bool usage = false;
+	int option;
+	while ((option = getopt(argc, argv, "n:w:s:b:f:j:cevgp")) != -1) {
+		if (option == 'n') {
+			trials = atoi(optarg);
+		} else if (option == 'w') {
+			workers = atoi(optarg);
+		} else if (option == 's') {
+			seed = strtoul(optarg, NULL, 10);
+		} else if (option == 'b') {
+			usage |= !parseRange(optarg, &battery);
+		} else if (option == 'f') {
+			usage |= !parseRange(optarg, &friction);
+		} else if (option == 'j') {
+			jitter = strtoul(optarg, NULL, 10);
+		} else if (option == 'c') {
+			costs = true;
+		} else if (option == 'e') {
+			closedLoop = true;
+		} else if (option == 'v') {
+			compensate = true;
+		} else if (option == 'g') {
+			gyro = true;
+		} else if (option == 'p') {
+			steps = true;
+		} else {
+			usage = true;
+		}
+	}
+	int sections = argc - optind;
+	if (usage || trials < 1 || workers < 1 || (sections != 1 && sections != REPLAY_SECTIONS)) {
+		simLog("Usage: sweep [-n trials] [-w workers] [-s seed] [-b volts:volts] [-f friction:friction] "
+				"[-j microseconds] [-c] [-e] [-v] [-g] [-p] recording [section2 section3 section4]");
+		return 2;
+	}
+	uint8_t* recordings = malloc(sections * REPLAY_FILE_SIZE);
+	for (int i = 0; i < sections; i++) {
+		if (!replayReadRecording(argv[optind + i], recordings + i * REPLAY_FILE_SIZE)) {
+			simLog("%s is not a %d byte recording", argv[optind + i], REPLAY_FILE_SIZE);
+			return 1;
+		}
+	}
+
+	mecanum_params params;
+	mecanumDefaults(&params);
+	replay_path reference = { NULL, 0, 0, 0, 0, { 0, 0, 0 } };
+	uint8_t* tracks = closedLoop ? malloc(sections * REPLAY_TRACK_SIZE) : NULL;
+	uint8_t* voltages = compensate ? malloc(sections * AUTON_VOLTAGE_FILE_SIZE) : NULL;
+	uint8_t* headings = gyro ? malloc(sections * REPLAY_HEADINGS_SIZE) : NULL;
+	replayReference(&params, recordings, tracks, voltages, headings, sections, &reference);
+	// Every worker forked from here on plays with the same setting
+	driveInterpolation = !steps;
+
+	int resultPipe[2];
+	if (pipe(resultPipe) != 0) {
+		simLog("Could not make a pipe");
+		return 1;
+	}
+	fcntl(resultPipe[0], F_SETFL, O_NONBLOCK);
+	sweep_trial* trialParams = malloc(trials * sizeof(sweep_trial));
+	sweep_result* results = calloc(trials, sizeof(sweep_result));
+	bool* done = calloc(trials, sizeof(bool));
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int started = 0, running = 0, failures = 0;
+	while (started < trials || running > 0) {
+		while (running < workers && started < trials) {
+			pickTrial(seed, started, &battery, &friction, jitter, &trialParams[started]);
+			pid_t child = fork();
+			if (child == 0) {
+				close(resultPipe[0]);
+				runTrial(started, &trialParams[started], recordings, tracks, voltages, headings, sections, &reference, costs,
+						resultPipe[1]);
+			} else if (child < 0) {
+				simLog("Could not start a trial: %s", strerror(errno));
+				return 1;
+			}
+			started++;
+			running++;
+		}
+		int status;
+		if (waitpid(-1, &status, 0) > 0) {
+			running--;
+			failures += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+		}
+		sweep_result result;
+		while (read(resultPipe[0], &result, sizeof(result)) == sizeof(result)) {
+			results[result.index] = result;
+			done[result.index] = true;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double wallTime = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	struct rusage usageTimes;
+	getrusage(RUSAGE_CHILDREN, &usageTimes);
+	double cpuTime = usageTimes.ru_utime.tv_sec + usageTimes.ru_utime.tv_usec / 1e6 +
+			usageTimes.ru_stime.tv_sec + usageTimes.ru_stime.tv_usec / 1e6;
+
+	int count = 0;
+	double* finalDistance = malloc(trials * sizeof(double));
+	double* finalHeading = malloc(trials * sizeof(double));
+	double* rmsDistance = malloc(trials * sizeof(double));
+	double* lowestVoltage = malloc(trials * sizeof(double));
+	double* odometryError = malloc(trials * sizeof(double));
+	double* batteries = malloc(trials * sizeof(double));
+	double* frictions = malloc(trials * sizeof(double));
+	double* jitters = malloc(trials * sizeof(double));
+	int worst = -1;
+	for (int i = 0; i < trials; i++) {
+		if (!done[i]) {
+			continue;
+		}
+		finalDistance[count] = results[i].error.finalDistance;
+		finalHeading[count] = fabs(results[i].error.finalHeading);
+		rmsDistance[count] = results[i].error.rmsDistance;
+		lowestVoltage[count] = results[i].lowestVoltage;
+		odometryError[count] = results[i].odometryError;
+		batteries[count] = trialParams[i].battery;
+		frictions[count] = trialParams[i].friction;
+		jitters[count] = trialParams[i].jitter;
+		if (worst < 0 || results[i].error.finalDistance > results[worst].error.finalDistance) {
+			worst = i;
+		}
+		count++;
+	}
+	report("%d replays of %d section%s on %d workers in %.2f s (%.2f s of CPU, %.1f ms per replay)\n", count,
+			sections, sections == 1 ? "" : "s", workers, wallTime, cpuTime, cpuTime * 1000 / MAX(1, count));
+	report("Battery %.2f - %.2f V, friction %.2f - %.2f, jitter up to 0 - %lu us, %s flash and serial, %s%s%s\n",
+			battery.low, battery.high, friction.low, friction.high, jitter, costs ? "Cortex estimates for" : "free",
+			closedLoop ? "closed loop" : "open loop", compensate ? ", battery compensated" : "",
+			gyro ? ", holding headings" : "");
+	if (failures > 0 || count < trials) {
+		report("%d trials failed\n", trials - count);
+	}
+	if (count == 0) {
+		return 1;
+	}
+	// Correlations first, as reportDistribution() sorts the measures
+	double batteryCorrelation = correlation(batteries, finalDistance, count);
+	double frictionCorrelation = correlation(frictions, finalDistance, count);
+	double jitterCorrelation = correlation(jitters, finalDistance, count);
+	report("%-20s %8s %8s %8s %8s %8s %8s\n", "", "mean", "p50", "p90", "p95", "p99", "max");
+	reportDistribution("final error (m)", finalDistance, count);
+	reportDistribution("heading error (deg)", finalHeading, count);
+	reportDistribution("path RMS error (m)", rmsDistance, count);
+	reportDistribution("lowest battery (V)", lowestVoltage, count);
+	reportDistribution("odometry error (m)", odometryError, count);
+	report("Correlation with final error: battery %.2f, friction %.2f, jitter %.2f\n", batteryCorrelation,
+			frictionCorrelation, jitterCorrelation);
+	report("Worst: trial %d (battery %.2f V, friction %.2f, jitter up to %lu us) ends %.3f m and %.1f degrees off\n",
+			worst, trialParams[worst].battery, trialParams[worst].friction, trialParams[worst].jitter,
+			results[worst].error.finalDistance, results[worst].error.finalHeading);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/** @file trace.c
+ * @brief File for recording a timeline of the simulated robot
+ *
+ * The timeline is written as it happens in the Chrome trace event format (a JSON object with a
+ * traceEvents array), which chrome://tracing and https://ui.perfetto.dev open directly. Each task
+ * has a track showing the state it is in (running, ready, delay, mutex wait...) as a slice, with
+ * the flash and serial operations it made inside its running slices; times are virtual.
+ *
+ * This file is compiled with prosnames.h like the robot code, so it must not include <stdio.h>.
+ */
+
+#include "main.h"
+#include "trace.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Number of tracks: the code outside of tasks, then one per task
+ */
+#define TRACE_TRACKS (SIM_MAX_TASKS + 1)
+
+/**
+ * Number of bytes of trace buffered before they are written out
+ */
+#define TRACE_BUFFER_SIZE 65536
+
+/**
+ * Number of bytes in a track name, including the terminating null character
+ */
+#define TRACE_NAME_LENGTH 32
+
+/**
+ * The file the trace is written to, or -1 if the timeline is not being recorded
+ */
+static int traceFd = -1;
+
+/**
+ * Whether or not every tick is shown
+ */
+static bool traceTicks = false;
+
+/**
+ * Trace text not yet written to the file
+ */
+static char buffer[TRACE_BUFFER_SIZE];
+
+/**
+ * The number of bytes in buffer
+ */
+static int buffered = 0;
+
+/**
+ * The name of each track
+ */
+static char trackNames[TRACE_TRACKS][TRACE_NAME_LENGTH];
+
+/**
+ * Whether or not each track's name has been written to the trace
+ */
+static bool trackNamed[TRACE_TRACKS];
+
+/**
+ * Whether or not each track has a state slice that has not ended
+ */
+static bool stateOpen[TRACE_TRACKS];
+
+/**
+ * The track of the running task, or 0 if no task is running
+ */
+static int runningTrack = 0;
+
+/**
+ * Writes the buffered trace text to the file
+ */
+static void flush() {
+	if (buffered > 0 && write(traceFd, buffer, buffered) != buffered) {
+		simLog("Could not write the trace; it stops here");
+		close(traceFd);
+		traceFd = -1;
+	}
+	buffered = 0;
+}
+
+/**
+ * Adds an event to the trace, naming its track first if the track has not been named yet
+ *
+ * @param track The track of the event
+ * @param format The format string of the event's JSON, as for printf
+ */
+static void event(int track, const char* format, ...) {
+	if (!trackNamed[track]) {
+		trackNamed[track] = true;
+		event(track, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				track, trackNames[track][0] != 0 ? trackNames[track] : (track == 0 ? "main" : "task"));
+	}
+	if (buffered > TRACE_BUFFER_SIZE - 256) {
+		flush();
+	}
+	va_list args;
+	va_start(args, format);
+	buffered += vsnprintf(buffer + buffered, TRACE_BUFFER_SIZE - buffered, format, args);
+	va_end(args);
+	buffered += snprintf(buffer + buffered, TRACE_BUFFER_SIZE - buffered, ",\n");
+}
+
+/**
+ * Starts recording a timeline of the simulated robot to a file
+ *
+ * @param filename The name of the file
+ * @param ticks Whether to show every tick of the virtual clock (about 60 bytes per millisecond)
+ *
+ * @return true if the file was opened
+ */
+bool simTraceOpen(const char* filename, bool ticks) {
+	simTraceClose();
+	traceFd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (traceFd < 0) {
+		return false;
+	}
+	traceTicks = ticks;
+	memset(trackNamed, 0, sizeof(trackNamed));
+	memset(stateOpen, 0, sizeof(stateOpen));
+	buffered = snprintf(buffer, TRACE_BUFFER_SIZE, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	event(0, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"robot\"}}");
+	return true;
+}
+
+/**
+ * Ends every slice and finishes the file started by simTraceOpen()
+ */
+void simTraceClose() {
+	if (traceFd < 0) {
+		return;
+	}
+	for (int track = 0; track < TRACE_TRACKS; track++) {
+		if (stateOpen[track]) {
+			event(track, "{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%llu}", track, (unsigned long long) simMicros());
+		}
+	}
+	// The last event ends with a comma, so finish with an event that needs none
+	buffered += snprintf(buffer + buffered, TRACE_BUFFER_SIZE - buffered,
+			"{\"name\":\"end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%llu}\n]}\n", (unsigned long long) simMicros());
+	flush();
+	if (traceFd >= 0) {
+		close(traceFd);
+	}
+	traceFd = -1;
+}
+
+/**
+ * Names a track, which is shown once the track is first used in a trace
+ *
+ * @param track The track
+ * @param name The name, which is copied
+ */
+void traceName(int track, const char* name) {
+	if (track >= 0 && track < TRACE_TRACKS) {
+		snprintf(trackNames[track], TRACE_NAME_LENGTH, "%s", name);
+		trackNamed[track] = false;
+	}
+}
+
+/**
+ * Ends the state that a task's track is showing and starts another
+ * "running" also makes the track the one that traceSpan() adds to, until the task leaves that state.
+ *
+ * @param track The task's track
+ * @param state The new state, or NULL when the task has ended
+ */
+void traceState(int track, const char* state) {
+	if (track < 0 || track >= TRACE_TRACKS) {
+		return;
+	}
+	if (state != NULL && strcmp(state, "running") == 0) {
+		runningTrack = track;
+	} else if (runningTrack == track) {
+		runningTrack = 0;
+	}
+	if (traceFd < 0) {
+		return;
+	}
+	unsigned long long now = simMicros();
+	if (stateOpen[track]) {
+		event(track, "{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%llu}", track, now);
+	}
+	stateOpen[track] = state != NULL;
+	if (state != NULL) {
+		event(track, "{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%llu}", state, track, now);
+	}
+}
+
+/**
+ * Shows an operation that started earlier and has just ended on the track of the running task
+ *
+ * @param name The name of the operation
+ * @param start The virtual time in microseconds at which the operation started
+ * @param bytes The number of bytes the operation moved
+ */
+void traceSpan(const char* name, uint64_t start, long bytes) {
+	if (traceFd >= 0) {
+		event(runningTrack, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu,\"args\":{\"bytes\":%ld}}",
+				name, runningTrack, (unsigned long long) start, (unsigned long long) (simMicros() - start), bytes);
+	}
+}
+
+/**
+ * Shows the virtual clock moving to the next millisecond, if simTraceOpen() asked for ticks
+ */
+void traceTick() {
+	if (traceFd >= 0 && traceTicks) {
+		event(0, "{\"name\":\"tick\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":0,\"ts\":%llu}", (unsigned long long) simMicros());
+	}
+}
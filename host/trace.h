@@ -0,0 +1,56 @@
+/** @file trace.h
+ * @brief File for recording a timeline of the simulated robot
+ *
+ * Used by sim.c, flash.c, pros.c and iomodel.c; test programs use simTraceOpen() and
+ * simTraceClose() in sim.h. Track 0 is the code that runs outside of any task (test programs and
+ * tick hooks); task n of sim.c has track n + 1.
+ */
+
+#ifndef TRACE_H
+
+// This prevents multiple inclusion
+#define TRACE_H
+
+#include "sim.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Names a track, which is shown once the track is first used in a trace
+ *
+ * @param track The track
+ * @param name The name, which is copied
+ */
+void traceName(int track, const char* name);
+
+/**
+ * Ends the state that a task's track is showing and starts another
+ * "running" also makes the track the one that traceSpan() adds to, until the task leaves that state.
+ *
+ * @param track The task's track
+ * @param state The new state, or NULL when the task has ended
+ */
+void traceState(int track, const char* state);
+
+/**
+ * Shows an operation that started earlier and has just ended on the track of the running task
+ *
+ * @param name The name of the operation
+ * @param start The virtual time in microseconds at which the operation started
+ * @param bytes The number of bytes the operation moved
+ */
+void traceSpan(const char* name, uint64_t start, long bytes);
+
+/**
+ * Shows the virtual clock moving to the next millisecond, if simTraceOpen() asked for ticks
+ */
+void traceTick();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
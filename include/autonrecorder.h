@@ -11,6 +11,8 @@
 #ifndef AUTONRECORDER_H
 #define AUTONRECORDER_H
 
+#include "driveMix.h"
+
 /**
  * Number of seconds the autonomous period lasts.
  */
@@ -33,6 +35,40 @@
  */
 #define MAX_AUTON_SLOTS 10
 
+/**
+ * Number of bytes each joystick state takes up in an autonomous file.
+ */
+#define AUTON_STATE_SIZE 5
+
+/**
+ * Number of bytes each wheel track entry takes up in a track file.
+ */
+#define AUTON_TRACK_SIZE DRIVE_WHEELS
+
+/**
+ * Number of bytes before the entries of a track file: the CRC-32 (frameCrc32()) of the autonomous
+ * file it was recorded with, least significant byte first.
+ * A track whose autonomous file has since been replaced no longer matches, and is not followed.
+ */
+#define AUTON_TRACK_HEADER_SIZE 4
+
+/**
+ * Number of bytes in a voltage file: the same header as a track file, then the average main
+ * battery voltage in millivolts while the autonomous file was recorded, least significant byte first.
+ */
+#define AUTON_VOLTAGE_FILE_SIZE (AUTON_TRACK_HEADER_SIZE + 2)
+
+/**
+ * Number of bytes each lift height takes up in a heights file, after the same header as a track file.
+ */
+#define AUTON_HEIGHT_SIZE 1
+
+/**
+ * Number of bytes each heading takes up in a headings file, after the same header as a track file:
+ * degrees counterclockwise, least significant byte first.
+ */
+#define AUTON_HEADING_SIZE 2
+
 /**
  * Maximum file name length of autonomous routine files.
  */
@@ -88,12 +124,64 @@ typedef struct joyState {
     signed char lift;
 } joyState;
 
+/**
+ * @brief How far each drive wheel turned while a joystick state was applied.
+ *
+ * Recorded from the drive IMEs alongside each state and saved to the track file of the slot
+ * (getTrackFilename()). Closed-loop playback (driveTrack.h) makes the wheels follow these positions.
+ */
+typedef struct wheelTrack {
+    /**
+    * Encoder counts each wheel turned, in the order of mixDrive(), positive the way its motor turns for a positive power.
+    */
+    signed char wheel[DRIVE_WHEELS];
+} wheelTrack;
+
 /**
  * Stores the joystick state variables for moving the robot.
  * Used for recording and playing back autonomous routines.
  */
 extern joyState states[AUTON_TIME*JOY_POLL_FREQ];
 
+/**
+ * Stores how far each wheel turned during each state of the states array.
+ * Only valid while trackLoaded is set.
+ */
+extern wheelTrack tracks[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether or not tracks holds the wheel track of the loaded autonomous routine.
+ */
+extern bool trackLoaded;
+
+/**
+ * Average main battery voltage in millivolts while the loaded autonomous routine was recorded, or 0 if it is not known.
+ */
+extern unsigned int autonVoltage;
+
+/**
+ * Stores the height to hold the lift at by the end of each state of the states array, in units of LIFT_HEIGHT_STEP.
+ * Only valid while heightsLoaded is set.
+ */
+extern unsigned char heights[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether or not heights holds the lift heights of the loaded autonomous routine.
+ */
+extern bool heightsLoaded;
+
+/**
+ * Stores the gyro heading of the robot at the end of each state of the states array, in degrees counterclockwise
+ * since the routine started (headingHold.h).
+ * Only valid while headingsLoaded is set.
+ */
+extern int16_t headings[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether or not headings holds the headings of the loaded autonomous routine.
+ */
+extern bool headingsLoaded;
+
 /**
  * Slot number of currently loaded autonomous routine.
  */
@@ -110,6 +198,12 @@ extern int autonFlipped;
  */
 extern int progSkills;
 
+/**
+ * Whether or not an autonomous routine is currently being played back.
+ * Operator control does not drive the motors while this is set.
+ */
+extern volatile bool autonPlaying;
+
 /**
  * Initializes autonomous recorder by setting joystick states array to zero.
  */
@@ -122,17 +216,23 @@ void recordAuton();
 
 /**
  * Downloads a 15 second autonomous portion from the computer through the serial monitor
+ * The file is written to flash as the input arrives; the loaded autonomous is not changed, and the
+ * slot's track, voltage, heights and headings files are deleted (see deleteAutonCompanions()).
  *
  * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if a full autonomous was received and saved, false otherwise
  */
-void downloadAutonFromComputer(int slot);
+bool downloadAutonFromComputer(int slot);
 
 /**
  * Uploads a 15 second autonomous portion to the computer through the serial monitor
  *
  * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if the autonomous was sent, false otherwise
  */
-void uploadAutonToComputer(int slot);
+bool uploadAutonToComputer(int slot);
 
 /**
  * Gets the autonomous selection from the LCD buttons
@@ -143,21 +243,123 @@ void uploadAutonToComputer(int slot);
  */
 int selectAuton(int allowProgSkillSection);
 
+/**
+ * Gets the name of the file in flash memory that backs an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getAutonFilename(int slot, char* filename, int size);
+
+/**
+ * Gets the name of the file in flash memory that holds the wheel track of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getTrackFilename(int slot, char* filename, int size);
+
+/**
+ * Gets the name of the file in flash memory that holds the recorded battery voltage of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getVoltageFilename(int slot, char* filename, int size);
+
+/**
+ * Gets the name of the file in flash memory that holds the lift heights of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getHeightsFilename(int slot, char* filename, int size);
+
+/**
+ * Gets the name of the file in flash memory that holds the gyro headings of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getHeadingsFilename(int slot, char* filename, int size);
+
+/**
+ * Deletes the files beside an autonomous slot (its wheel track, recorded voltage, lift heights and gyro headings)
+ * Called when the slot's file is replaced or removed from the computer, which only sends the autonomous file, so
+ * that nothing recorded with the old routine is left beside the new one.
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ */
+void deleteAutonCompanions(int slot);
+
 /**
  * Saves contents of the states array to a file in flash memory for later playback.
  */
 void saveAuton();
 
+/**
+ * Saves contents of the states array to the given slot without prompting for a selection
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if the states were saved, false otherwise
+ */
+bool saveAutonToSlot(int slot);
+
 /**
  * Loads autonomous file contents into states array for playback.
  */
 void loadAuton(int autonFile);
 
+/**
+ * Drives the robot with one state of the states array, as playback does for each state.
+ *
+ * @param i The index of the state
+ */
+void playbackState(int i);
+
+/**
+ * Checks whether an autonomous routine is being played back. A playback whose task was deleted or
+ * whose robot was disabled is stopped first, so it does not keep the robot busy.
+ *
+ * @return true if a live task is playing back
+ */
+bool playbackActive();
+
 /**
  * Replays autonomous based on loaded values in states array.
+ * Does nothing while another task is playing back.
  *
  * @param flipped -1 if the autonomous should be flipped over the y axis (for the opposite starting tile), 1 otherwise
  */
 void playbackAuton();
 
+/**
+ * Ends any playback: stops the drive controllers, takes the battery scale off the motors and
+ * clears autonPlaying. The kernel kills autonomous() at the end of its period wherever it is, so
+ * operatorControl() calls this before taking over the motors; a playback still running in
+ * another task stops at its next state.
+ */
+void stopPlayback();
+
+/**
+ * Prints information about the loaded autonomous routine to the serial monitor
+ */
+void printAutonStats();
+
 #endif
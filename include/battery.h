@@ -0,0 +1,91 @@
+/** @file battery.h
+ * @brief File for battery-voltage compensation of played back motor commands
+ *
+ * A motor gets its command's share of the battery voltage, so the same recording drives the
+ * robot further on a full battery than on a flat one. recordAuton() stores the average main
+ * battery voltage seen while recording (autonVoltage in autonrecorder.h), and playback has the
+ * motor frame (motorFrame.h) scale every command by the recorded voltage over the voltage now.
+ * The voltage now is sampled by the control task and filtered, so that the scale follows the
+ * battery without jumping with the noise of each reading.
+ */
+
+#ifndef BATTERY_H
+
+// This prevents multiple inclusion
+#define BATTERY_H
+
+#include <API.h>
+#include "fixed.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of samples the filtered voltage averages over; with one sample per CONTROL_PERIOD this
+ * makes it settle within about a quarter of a second
+ */
+#define BATTERY_FILTER_SAMPLES 32
+
+/**
+ * Smallest and largest scale that playback applies to the recorded commands, so a bad reading
+ * (or a routine recorded on a nearly flat battery) cannot make the robot crawl or lunge
+ */
+#define BATTERY_SCALE_MIN (FIXED_ONE * 4 / 5)
+#define BATTERY_SCALE_MAX (FIXED_ONE * 5 / 4)
+
+/**
+ * Command at which a motor controller already gives the motor the whole battery voltage; the
+ * MC29 gives no more between about 90 and 127, so a command is scaled from at most this
+ */
+#define BATTERY_FULL_COMMAND 90
+
+/**
+ * Whether or not playback scales the commands of a routine that has a recorded voltage (on by default)
+ */
+extern bool batteryCompensation;
+
+/**
+ * Adds a reading of the main battery to the filtered voltage
+ * Run by the control task every CONTROL_PERIOD milliseconds.
+ */
+void batteryUpdate();
+
+/**
+ * Gets the filtered voltage of the main battery
+ *
+ * @return the voltage in millivolts, or the last reading if the control task has not sampled it yet
+ */
+unsigned int batteryVoltage();
+
+/**
+ * Gets the scale that makes the motors see the voltage that they saw while a routine was recorded
+ *
+ * @param recordedMillivolts The average voltage while the routine was recorded, or 0 if it is not known
+ *
+ * @return the recorded voltage over the filtered voltage, clamped to BATTERY_SCALE_MIN - BATTERY_SCALE_MAX,
+ * or FIXED_ONE if compensation is off or either voltage is not known
+ */
+fixed batteryScale(unsigned int recordedMillivolts);
+
+/**
+ * Scales a motor command for the battery, so that the motor gets the share of the voltage it was recorded with
+ *
+ * @param command The command, from -127 to 127
+ * @param scale The scale from batteryScale()
+ *
+ * @return the scaled command, or the command itself if scale is FIXED_ONE
+ */
+int batteryScaleCommand(int command, fixed scale);
+
+/**
+ * Prints whether compensation is on, the filtered voltage and the scale for the loaded routine
+ */
+void printBatteryStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/** @file benchmark.h
+ * @brief File for timing the functions that run every tick of the robot program
+ *
+ * The same list of functions is timed on the Cortex from the LCD menu ("Benchmark", with micros())
+ * and on a computer by host/benchtick against the simulated PROS API (with the computer's clock).
+ * Every function runs in rounds of many calls, and the time per call of each round is averaged,
+ * so that the variance between rounds shows how far the result can be trusted.
+ */
+
+#ifndef BENCHMARK_H
+
+// This prevents multiple inclusion
+#define BENCHMARK_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of rounds each function is timed for
+ */
+#define BENCH_ROUNDS 10
+
+/**
+ * Number of functions in benchCases
+ */
+#define BENCH_CASES 8
+
+/**
+ * A function to time
+ */
+typedef struct bench_case {
+	/**
+	 * The name of the function (the LCD shows the first LCD_MESSAGE_MAX_LENGTH characters)
+	 */
+	const char* name;
+
+	/**
+	 * Calls the function once
+	 */
+	void (*run)();
+
+	/**
+	 * The number of calls per round on the Cortex, so that a round takes about a tenth of a second
+	 */
+	unsigned int targetCalls;
+} bench_case;
+
+/**
+ * The time per call of a function over all rounds, in tenths of a nanosecond
+ */
+typedef struct bench_result {
+	/**
+	 * Mean of the rounds
+	 */
+	uint32_t mean;
+
+	/**
+	 * Standard deviation of the rounds
+	 */
+	uint32_t deviation;
+
+	/**
+	 * Fastest and slowest round
+	 */
+	uint32_t min;
+	uint32_t max;
+} bench_result;
+
+/**
+ * The functions to time: recordJoyInfo() with its parts (one joystickGetAnalog() call and the
+ * input curve), the motor outputs, the LCD menu and one state of playback
+ */
+extern const bench_case benchCases[BENCH_CASES];
+
+/**
+ * Times a function
+ *
+ * @param benchCase The function
+ * @param calls The number of calls per round
+ * @param clock Gets the current time in nanoseconds
+ * @param result Set to the time per call
+ */
+void benchMeasure(const bench_case* benchCase, unsigned int calls, uint64_t (*clock)(), bench_result* result);
+
+/**
+ * Times every function in benchCases on the Cortex, showing each result on the LCD and printing
+ * them all to the serial monitor, then waits for an LCD button
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void runBenchmarks(int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
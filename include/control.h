@@ -0,0 +1,76 @@
+/** @file control.h
+ * @brief File for the control task, which runs the feedback loops of the robot at a fixed rate
+ *
+ * The task is started by initialize() and keeps running in every mode; a loop made with
+ * taskRunLoop() would stop when the mode changes. Every CONTROL_PERIOD milliseconds it runs each
+ * controller while holding the control lock. Other tasks hold the lock while they change what a
+ * controller follows, so the task never sees half of a change.
+ *
+ * The lock suspends the scheduler instead of taking a mutex: the kernel deletes operatorControl()
+ * and autonomous() whenever the mode changes, and a mutex held by a deleted task would never be
+ * given back, stopping the control task for good. A task holding the lock cannot be switched out,
+ * so it cannot be deleted with it; it must only hold it for a few staged values and never block.
+ */
+
+#ifndef CONTROL_H
+
+// This prevents multiple inclusion
+#define CONTROL_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of milliseconds between runs of the controllers
+ */
+#define CONTROL_PERIOD 5
+
+/**
+ * Priority of the control task (above operator control and autonomous, so that it keeps its period)
+ */
+#define CONTROL_TASK_PRIORITY (TASK_PRIORITY_DEFAULT + 1)
+
+/**
+ * Finds the sensors of the controllers and starts the control task
+ */
+void initControl();
+
+/**
+ * Stops the scheduler from switching tasks until taskResumeAll(); calls can be nested
+ * This and the two functions below are in the PROS kernel but not declared in API.h.
+ */
+void taskSuspendAll();
+
+/**
+ * Lets the scheduler switch tasks again once every taskSuspendAll() has been matched
+ */
+void taskResumeAll();
+
+/**
+ * Gets the task that is running
+ *
+ * @return the handle of the calling task
+ */
+TaskHandle taskGetCurrent();
+
+/**
+ * Keeps the control task (and every other task) from running until controlUnlock(); the control
+ * task never stops partway through a run, so it sees all of a change or none of it
+ * Calls can be nested. Nothing that waits (delay(), mutexes, file or serial input) may be called in between.
+ */
+void controlLock();
+
+/**
+ * Lets the control task run again
+ */
+void controlUnlock();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
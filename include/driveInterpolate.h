@@ -0,0 +1,66 @@
+/** @file driveInterpolate.h
+ * @brief File for the interpolated drive output of open-loop playback
+ *
+ * Recordings hold one joystick state every 1000 / JOY_POLL_FREQ milliseconds, and sending each
+ * state to the drive motors as it comes makes the wheel powers jump every 20 ms. Instead the
+ * control task moves the forward, strafing and turning commands in a straight line between the
+ * states, every CONTROL_PERIOD milliseconds: each state's command is reached halfway through its
+ * period, and the line runs from the middle of one period to the middle of the next. The average
+ * command over a period is then still about the recorded one, so the robot covers the recorded
+ * distance, but the wheels ramp instead of jerking. The lift and pincer commands are button
+ * presses, so they still change in steps as each state is played.
+ */
+
+#ifndef DRIVE_INTERPOLATE_H
+
+// This prevents multiple inclusion
+#define DRIVE_INTERPOLATE_H
+
+#include <API.h>
+#include "autonrecorder.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Whether or not open-loop playback interpolates the drive commands between states (on by default)
+ */
+extern bool driveInterpolation;
+
+/**
+ * Starts interpolating from a stopped drive, as playback does before its first state
+ */
+void driveInterpolateStart();
+
+/**
+ * Moves on to the next state: over the next 1000 / JOY_POLL_FREQ milliseconds the drive commands
+ * move from halfway between the last state and this one, to this one, to halfway between this one
+ * and the next. The drive motors are staged for the start of the state and the motor frame is
+ * committed straight away, so motors staged by the caller change at the same time. The caller
+ * holds the control lock.
+ *
+ * @param state The joystick state to play now
+ * @param next The joystick state that will be played after it
+ */
+void driveInterpolateStep(const joyState* state, const joyState* next);
+
+/**
+ * Stops interpolating; the drive motors keep their last values until something else sets them
+ */
+void driveInterpolateStop();
+
+/**
+ * Stages the drive motors with the interpolated commands for the time now, if playback is interpolating
+ * Run by the control task every CONTROL_PERIOD milliseconds while it holds the control lock.
+ *
+ * @return true if the drive motors were staged, false otherwise
+ */
+bool driveInterpolateUpdate();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
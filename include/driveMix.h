@@ -0,0 +1,91 @@
+/** @file driveMix.h
+ * @brief File for mixing the drive commands into mecanum wheel powers
+ *
+ * Forward, horizontal and turning commands of up to 127 each can add up to 381 on a wheel. Clipping
+ * each wheel on its own changes the ratios between the wheels, so a combined strafe and turn
+ * drives in a different direction than was asked for. mixDrive() scales all four wheels together
+ * instead, keeping the direction and using the full motor range. Optionally the turn is kept
+ * whole and only the translation is scaled, so the robot always turns as fast as asked.
+ */
+
+#ifndef DRIVE_MIX_H
+
+// This prevents multiple inclusion
+#define DRIVE_MIX_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of wheels mixed
+ */
+#define DRIVE_WHEELS 4
+
+/**
+ * Indices of the wheels in the mixed powers
+ */
+#define DRIVE_FRONT_LEFT 0
+#define DRIVE_FRONT_RIGHT 1
+#define DRIVE_BACK_LEFT 2
+#define DRIVE_BACK_RIGHT 3
+
+/**
+ * Largest power that a motor takes
+ */
+#define DRIVE_MAX_POWER 127
+
+/**
+ * Whether or not setDriveMotors() keeps the turn whole when the wheels saturate, scaling only the translation
+ */
+#define DRIVE_TURN_PRIORITY false
+
+/**
+ * Counters of how often the drive commands saturated the wheels
+ */
+typedef struct drive_mix_stats {
+	/**
+	 * The number of commands mixed
+	 */
+	unsigned long mixes;
+
+	/**
+	 * The number of commands that asked a wheel for more than DRIVE_MAX_POWER and were scaled down
+	 */
+	unsigned long saturated;
+} drive_mix_stats;
+
+/**
+ * The counters since the robot started or driveMixStatsReset() was called
+ */
+extern drive_mix_stats driveMixStats;
+
+/**
+ * Mixes the drive commands into the power of each drive motor, with the motor directions of the robot applied
+ *
+ * @param forward The forward command
+ * @param horizontal The strafing command, positive to the right
+ * @param turn The turning command, positive clockwise
+ * @param turnPriority true to scale only the translation when a wheel saturates, false to scale everything
+ * @param powers Set to the power of each motor, indexed by DRIVE_FRONT_LEFT and the others, each within DRIVE_MAX_POWER
+ */
+void mixDrive(int forward, int horizontal, int turn, bool turnPriority, int powers[DRIVE_WHEELS]);
+
+/**
+ * Sets the counters back to zero
+ */
+void driveMixStatsReset();
+
+/**
+ * Prints the counters to the serial monitor
+ */
+void printDriveMixStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
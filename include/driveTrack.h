@@ -0,0 +1,158 @@
+/** @file driveTrack.h
+ * @brief File for closed-loop playback, which makes the drive wheels follow their recorded positions
+ *
+ * Open-loop playback sends the recorded joystick values to the motors, so how far the robot goes
+ * depends on the battery and the floor. When the four drive motors have IMEs, recordAuton() also
+ * stores how far each wheel turned during every state (wheelTrack in autonrecorder.h), and
+ * playback can follow those positions instead: the control task runs a PID loop on each wheel,
+ * with the recorded joystick values, mixed as setDriveMotors() mixes them and scaled for the
+ * battery (battery.h), as the feedforward.
+ * Within a state the position to follow moves evenly from where the wheel was recorded at the
+ * start of the state to where it was at the end, so the loops are not kicked every 20 ms.
+ */
+
+#ifndef DRIVE_TRACK_H
+
+// This prevents multiple inclusion
+#define DRIVE_TRACK_H
+
+#include <API.h>
+#include "autonrecorder.h"
+#include "pid.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Gains of the loop on each wheel: power per count behind, per count of summed error and per
+ * count of change in error over a control period. The feedforward already gives most of the
+ * power, so the loop needs no derivative; tuned with sweep -e (host/).
+ */
+#define DRIVE_TRACK_KP INT_TO_FIXED(4)
+#define DRIVE_TRACK_KI (FIXED_ONE / 32)
+#define DRIVE_TRACK_KD INT_TO_FIXED(0)
+
+/**
+ * Largest sum of errors of a wheel's loop in counts, so the integral gives at most about a quarter of full power
+ */
+#define DRIVE_TRACK_INTEGRAL_LIMIT 1000
+
+/**
+ * Turn command per count that driveTrackAddTurn() adds to each wheel's track. A wheel turns about
+ * one count a state per 5 of command, but moved targets add up state after state, so a gentler
+ * conversion keeps the wheels from overshooting; tuned with sweep -e -g (host/).
+ */
+#define DRIVE_TRACK_TURN_PER_COUNT 20
+
+/**
+ * How closely the wheels followed their tracks
+ */
+typedef struct drive_track_stats {
+	/**
+	 * The number of control periods that drove the wheels from a track
+	 */
+	unsigned long updates;
+
+	/**
+	 * The number of those in which an encoder could not be read, so the wheels got the feedforward alone
+	 */
+	unsigned long readFailures;
+
+	/**
+	 * The sum over those periods and the four wheels of how many counts each wheel was off its track
+	 */
+	unsigned long errorSum;
+
+	/**
+	 * The most counts that a wheel has been off its track
+	 */
+	int maxError;
+} drive_track_stats;
+
+/**
+ * How closely the wheels have followed their tracks since the counters were reset
+ */
+extern drive_track_stats driveTrackStats;
+
+/**
+ * Whether or not all four drive IMEs answered when the robot started; without them nothing is recorded or followed
+ */
+extern bool driveEncoders;
+
+/**
+ * Whether or not playback follows the wheel track of a routine that has one (on by default)
+ */
+extern bool closedLoopPlayback;
+
+/**
+ * Starts the IMEs and checks that the four drive IMEs answer
+ * Called by initControl().
+ */
+void initDriveEncoders();
+
+/**
+ * Reads the four drive IMEs
+ *
+ * @param counts Set to the count of each wheel, in the order of mixDrive()
+ *
+ * @return true if every IME was read, false otherwise
+ */
+bool readDriveEncoders(int counts[DRIVE_WHEELS]);
+
+/**
+ * Starts following a track from where the wheels are now
+ *
+ * @return true if the wheels are being followed, false if the IMEs could not be read
+ */
+bool driveTrackStart();
+
+/**
+ * Moves on to the next state of the track: the wheels are to turn by the recorded amounts over
+ * the next 1000 / JOY_POLL_FREQ milliseconds, with the state's joystick values as the feedforward.
+ * The wheels are driven and the motor frame committed straight away, so motors staged by the
+ * caller (the lift and pincer) change at the same time. The caller holds the control lock.
+ *
+ * @param state The joystick state
+ * @param track How far each wheel turned while the state was recorded
+ */
+void driveTrackStep(const joyState* state, const wheelTrack* track);
+
+/**
+ * Adds a turn to a state of a track, so that following it turns the robot as the turn command would
+ * (headingHold.h steers the robot this way when it has slipped off its recorded heading)
+ *
+ * @param track The state of the track
+ * @param turn The turn command to add, positive clockwise
+ */
+void driveTrackAddTurn(wheelTrack* track, int turn);
+
+/**
+ * Stops following the track; the drive motors keep their last values until something else sets them
+ */
+void driveTrackStop();
+
+/**
+ * Drives the wheels toward their tracks if one is being followed, staging the drive motors
+ * Run by the control task every CONTROL_PERIOD milliseconds while it holds the control lock.
+ *
+ * @return true if the drive motors were staged, false otherwise
+ */
+bool driveTrackUpdate();
+
+/**
+ * Sets every counter back to zero
+ */
+void driveTrackStatsReset();
+
+/**
+ * Prints whether closed-loop playback is on and how closely the wheels have followed their tracks
+ */
+void printDriveTrackStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
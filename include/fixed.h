@@ -0,0 +1,172 @@
+/** @file fixed.h
+ * @brief File for fixed-point arithmetic
+ *
+ * The Cortex-M3 has no floating point unit, so every float or double operation is a call into
+ * the soft-float library. The control and display code works in integers instead: a fixed value
+ * is a Q16.16 number (16 integer bits and 16 fraction bits in an int32_t), and decimals are
+ * printed from integers, so the robot program links without -lm.
+ */
+
+#ifndef FIXED_H
+
+// This prevents multiple inclusion
+#define FIXED_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of fraction bits in a fixed value
+ */
+#define FIXED_SHIFT 16
+
+/**
+ * The fixed value of 1
+ */
+#define FIXED_ONE (1 << FIXED_SHIFT)
+
+/**
+ * Converts an integer to a fixed value
+ */
+#define INT_TO_FIXED(V) ((fixed) ((V) * FIXED_ONE))
+
+/**
+ * Limits a value to a range
+ */
+#define CLAMP(V, LOW, HIGH) (((V) < (LOW)) ? (LOW) : (((V) > (HIGH)) ? (HIGH) : (V)))
+
+/**
+ * A Q16.16 fixed-point number, from -32768 to just under 32768 in steps of 1/65536
+ */
+typedef int32_t fixed;
+
+/**
+ * Divides two integers, rounding to the nearest integer (halves away from zero)
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, which must not be zero
+ *
+ * @return the rounded quotient
+ */
+long roundDivide(long numerator, long denominator);
+
+/**
+ * Divides two 64-bit integers as roundDivide() does, for numerators that do not fit in 32 bits
+ * This is a call into the runtime library on the Cortex-M3, tens of cycles long.
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, which must not be zero
+ *
+ * @return the rounded quotient
+ */
+int64_t roundDivide64(int64_t numerator, int64_t denominator);
+
+/**
+ * Multiplies two fixed values, rounding to the nearest step
+ *
+ * @param a The first value
+ * @param b The second value
+ *
+ * @return the product
+ */
+fixed fixedMul(fixed a, fixed b);
+
+/**
+ * Divides two fixed values, rounding to the nearest step
+ *
+ * @param a The dividend
+ * @param b The divisor, which must not be zero
+ *
+ * @return the quotient
+ */
+fixed fixedDiv(fixed a, fixed b);
+
+/**
+ * Makes a fixed value from a ratio of integers, such as millivolts over 1000
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, which must not be zero
+ *
+ * @return the ratio, rounded to the nearest step
+ */
+fixed fixedFromRatio(long numerator, long denominator);
+
+/**
+ * Rounds a fixed value to the nearest integer (halves away from zero)
+ *
+ * @param value The fixed value
+ *
+ * @return the integer
+ */
+int fixedToInt(fixed value);
+
+/**
+ * Multiplies an integer by a fixed value, such as a motor power by a gain
+ *
+ * @param value The integer
+ * @param scale The fixed value
+ *
+ * @return the product, rounded to the nearest integer
+ */
+int fixedScale(int value, fixed scale);
+
+/**
+ * Gets the integer square root of a number
+ *
+ * @param value The number
+ *
+ * @return the largest integer whose square is not more than the number
+ */
+uint32_t intSqrt(uint64_t value);
+
+/**
+ * Gets the sine of an angle, from a table of whole degrees with the degrees between interpolated
+ *
+ * @param millidegrees The angle in thousandths of a degree, counterclockwise
+ *
+ * @return the sine, as a fixed value from -1 to 1
+ */
+fixed fixedSin(long millidegrees);
+
+/**
+ * Gets the cosine of an angle
+ *
+ * @param millidegrees The angle in thousandths of a degree, counterclockwise
+ *
+ * @return the cosine, as a fixed value from -1 to 1
+ */
+fixed fixedCos(long millidegrees);
+
+/**
+ * Prints an integer that counts in units of 10 ^ -decimals as a decimal number, such as 7840 with 3 decimals as "7.840"
+ *
+ * @param buffer The buffer to print to, which is always null terminated
+ * @param size The size of the buffer
+ * @param value The integer
+ * @param decimals The number of digits after the decimal point, from 0 to 9
+ *
+ * @return the number of characters printed
+ */
+int formatDecimal(char* buffer, size_t size, long value, int decimals);
+
+/**
+ * Prints a fixed value as a decimal number, rounded to the nearest last digit
+ *
+ * @param buffer The buffer to print to, which is always null terminated
+ * @param size The size of the buffer
+ * @param value The fixed value
+ * @param decimals The number of digits after the decimal point, from 0 to 4
+ *
+ * @return the number of characters printed
+ */
+int fixedFormat(char* buffer, size_t size, fixed value, int decimals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,264 @@
+/** @file frame.h
+ * @brief File for the binary serial frame format
+ *
+ * Frames carry autonomous files over the serial monitor without being confused with the text
+ * printed by the rest of the program. Every frame looks like:
+ *
+ *     0xA5 0x5A | type | sequence | length (2 bytes, little endian) | payload | CRC (2 bytes, little endian)
+ *
+ * The CRC is CRC-16/CCITT-FALSE over the type, sequence, length and payload bytes.
+ *
+ * This file does not depend on the PROS API so that programs on the computer can use the same
+ * encoder, decoder and protocol constants as the robot.
+ */
+
+#ifndef FRAME_H
+
+// This prevents multiple inclusion
+#define FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * First byte of every frame
+ */
+#define FRAME_SYNC_1 0xA5
+
+/**
+ * Second byte of every frame
+ */
+#define FRAME_SYNC_2 0x5A
+
+/**
+ * Number of bytes before the payload of a frame
+ */
+#define FRAME_HEADER_LENGTH 6
+
+/**
+ * Number of bytes after the payload of a frame
+ */
+#define FRAME_CRC_LENGTH 2
+
+/**
+ * Largest payload that a frame can carry
+ */
+#define FRAME_MAX_PAYLOAD 256
+
+/**
+ * Largest number of bytes in an encoded frame
+ */
+#define FRAME_MAX_LENGTH (FRAME_HEADER_LENGTH + FRAME_MAX_PAYLOAD + FRAME_CRC_LENGTH)
+
+/**
+ * Starts a transfer; the payload is the file size (2 bytes, little endian) followed by the file name
+ */
+#define FRAME_BEGIN 'B'
+
+/**
+ * Carries the next block of the file being transferred
+ */
+#define FRAME_DATA 'D'
+
+/**
+ * Ends a transfer; the payload is the CRC of the whole file (2 bytes, little endian)
+ */
+#define FRAME_END 'E'
+
+/**
+ * Lists the autonomous slots on the robot at the start of a sync session
+ * The payload is one entry of SYNC_ENTRY_SIZE bytes per slot.
+ */
+#define FRAME_MANIFEST 'M'
+
+/**
+ * Tells the robot which slots to send, receive or remove during a sync session
+ * The payload is one entry of SYNC_ENTRY_SIZE bytes per slot.
+ */
+#define FRAME_PLAN 'P'
+
+/**
+ * Acknowledges every frame up to and including the one with the same sequence number
+ */
+#define FRAME_ACK 'A'
+
+/**
+ * Asks for every frame from the one with the same sequence number onwards to be sent again
+ */
+#define FRAME_NAK 'N'
+
+/**
+ * Cancels the transfer
+ */
+#define FRAME_ABORT 'X'
+
+/**
+ * Number of file bytes sent in each data frame (50 joystick states)
+ */
+#define TRANSFER_BLOCK_SIZE 250
+
+/**
+ * Number of frames that can be sent before the first of them has been acknowledged
+ */
+#define TRANSFER_WINDOW 4
+
+/**
+ * Number of milliseconds to wait for a frame to be acknowledged before sending it again
+ */
+#define TRANSFER_ACK_TIMEOUT 250
+
+/**
+ * Number of times a frame is sent again before the transfer is given up
+ */
+#define TRANSFER_MAX_RETRIES 8
+
+/**
+ * Number of bytes in each manifest or plan entry of a sync session:
+ * slot index, action, file size (2 bytes) and CRC-32 of the file (4 bytes), little endian
+ */
+#define SYNC_ENTRY_SIZE 8
+
+/**
+ * Manifest action: the slot is empty on the robot
+ */
+#define SYNC_EMPTY 0
+
+/**
+ * Manifest action: the slot holds a file on the robot
+ */
+#define SYNC_PRESENT 1
+
+/**
+ * Plan action: the robot sends the slot to the computer
+ */
+#define SYNC_SEND 'U'
+
+/**
+ * Plan action: the robot receives the slot from the computer
+ */
+#define SYNC_RECEIVE 'D'
+
+/**
+ * Plan action: the robot removes the slot
+ */
+#define SYNC_REMOVE 'R'
+
+/**
+ * Number of bytes before the file data in a sync data frame: slot index and file offset (2 bytes)
+ */
+#define SYNC_DATA_HEADER 3
+
+/**
+ * Result of feeding a byte to the decoder: no complete frame yet
+ */
+#define FRAME_INCOMPLETE 0
+
+/**
+ * Result of feeding a byte to the decoder: a valid frame is ready
+ */
+#define FRAME_READY 1
+
+/**
+ * Result of feeding a byte to the decoder: a frame was received with a bad CRC or length
+ */
+#define FRAME_CORRUPT 2
+
+/**
+ * A struct that holds the state of a frame being received
+ */
+typedef struct frame_decoder {
+	/**
+	 * The index of the next byte expected in the frame
+	 */
+	int position;
+
+	/**
+	 * The type of the frame
+	 */
+	uint8_t type;
+
+	/**
+	 * The sequence number of the frame
+	 */
+	uint8_t seq;
+
+	/**
+	 * The number of bytes in the payload
+	 */
+	uint16_t length;
+
+	/**
+	 * The CRC sent with the frame
+	 */
+	uint16_t crc;
+
+	/**
+	 * The payload of the frame
+	 */
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+} frame_decoder;
+
+/**
+ * Updates a CRC-16/CCITT-FALSE with more data
+ *
+ * @param crc The CRC of the data so far, or 0xFFFF to start a new CRC
+ * @param data The data to add to the CRC
+ * @param length The number of bytes of data
+ *
+ * @return the updated CRC
+ */
+uint16_t frameCrc16(uint16_t crc, const uint8_t* data, size_t length);
+
+/**
+ * Updates a CRC-32 (as used by zip files) with more data
+ *
+ * @param crc The CRC of the data so far, or 0 to start a new CRC
+ * @param data The data to add to the CRC
+ * @param length The number of bytes of data
+ *
+ * @return the updated CRC
+ */
+uint32_t frameCrc32(uint32_t crc, const uint8_t* data, size_t length);
+
+/**
+ * Encodes a frame into a buffer
+ *
+ * @param out The buffer to write to, which must hold at least FRAME_MAX_LENGTH bytes
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ * @param payload The payload of the frame
+ * @param length The number of bytes in the payload, at most FRAME_MAX_PAYLOAD
+ *
+ * @return the number of bytes written to out
+ */
+size_t frameEncode(uint8_t* out, uint8_t type, uint8_t seq, const uint8_t* payload, uint16_t length);
+
+/**
+ * Prepares a decoder to look for the start of a new frame
+ *
+ * @param decoder The decoder to reset
+ */
+void frameDecoderReset(frame_decoder* decoder);
+
+/**
+ * Feeds the next received byte to a decoder
+ * Bytes outside of a frame (such as printed text) are skipped.
+ *
+ * @param decoder The decoder to feed
+ * @param byte The received byte
+ *
+ * @return FRAME_READY if a valid frame has been received, FRAME_CORRUPT if a damaged frame was received, or FRAME_INCOMPLETE otherwise
+ */
+int frameDecoderFeed(frame_decoder* decoder, uint8_t byte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
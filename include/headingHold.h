@@ -0,0 +1,130 @@
+/** @file headingHold.h
+ * @brief File for the heading hold of playback, which turns the robot toward its recorded heading
+ *
+ * Open-loop playback sends the recorded turn to the motors blindly, so a few degrees lost early in
+ * a routine point every later move the wrong way. With a gyro on GYRO_PORT, recordAuton() also
+ * stores the gyro's heading at the end of every state (saved beside the recording, see
+ * getHeadingsFilename() in autonrecorder.h), and playback adds a correction to each state's turn
+ * that steers the robot back to the heading it had when the state was recorded. Closed-loop
+ * playback (driveTrack.h) also adds the correction to the wheel track, or the wheel loops would
+ * undo it. The heading is zeroed once at the start of
+ * a routine, not at each programming skills section, so a later section also makes up for what an
+ * earlier one got wrong.
+ */
+
+#ifndef HEADING_HOLD_H
+
+// This prevents multiple inclusion
+#define HEADING_HOLD_H
+
+#include <API.h>
+#include "pid.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Gains of the heading loop: turn command per degree off the recorded heading, per degree of
+ * summed error and per degree of change in error over a state. Tuned with sweep -g and sweep -e -g (host/).
+ */
+#define HEADING_KP INT_TO_FIXED(3)
+#define HEADING_KI 0
+#define HEADING_KD INT_TO_FIXED(4)
+
+/**
+ * Largest sum of errors of the heading loop in degrees (unused while HEADING_KI is 0)
+ */
+#define HEADING_INTEGRAL_LIMIT 0
+
+/**
+ * Largest turn command that the heading loop adds to a state's turn, so that a bumped robot does
+ * not spin around at full power in the middle of a routine
+ */
+#define HEADING_MAX_CORRECTION 40
+
+/**
+ * Range of analog readings, with the robot standing still when it starts, in which the gyro counts
+ * as plugged in; an empty port reads near one end
+ */
+#define GYRO_REST_MIN 1000
+#define GYRO_REST_MAX 3000
+
+/**
+ * How the heading has been held
+ */
+typedef struct heading_stats {
+	/**
+	 * The number of states whose turn was corrected
+	 */
+	unsigned long updates;
+
+	/**
+	 * The sum over those states of how many degrees the robot was off its recorded heading
+	 */
+	unsigned long errorSum;
+
+	/**
+	 * The most degrees that the robot has been off its recorded heading
+	 */
+	int maxError;
+} heading_stats;
+
+/**
+ * How the heading has been held since the counters were reset
+ */
+extern heading_stats headingStats;
+
+/**
+ * Whether or not the gyro was found when the robot started; without it no heading is recorded or held
+ */
+extern bool gyroFound;
+
+/**
+ * Whether or not playback holds the recorded heading of a routine that has one (on by default)
+ */
+extern bool headingHoldEnabled;
+
+/**
+ * Checks that the gyro is plugged in and starts it; the robot must stand still
+ * Called by initControl().
+ */
+void initHeading();
+
+/**
+ * Gets the heading of the robot
+ *
+ * @return the degrees the robot has turned counterclockwise since headingZero(), or 0 without a gyro
+ */
+int headingGet();
+
+/**
+ * Takes the heading now as zero, as recording and playback do at the start of a routine
+ */
+void headingZero();
+
+/**
+ * Gets the turn that steers the robot toward a recorded heading, as playback adds to each state's turn
+ *
+ * @param recorded The heading the robot had when the state started to be recorded, in degrees
+ *
+ * @return the turn command to add, positive clockwise like the turn of a joystick state
+ */
+int headingCorrection(int recorded);
+
+/**
+ * Sets every counter back to zero
+ */
+void headingStatsReset();
+
+/**
+ * Prints whether the heading is held, the heading now and how closely it has been held
+ */
+void printHeadingStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
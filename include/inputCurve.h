@@ -0,0 +1,87 @@
+/** @file inputCurve.h
+ * @brief File for shaping the joystick axes with lookup tables
+ *
+ * Every axis has a table with an output for each of the 256 values a joystick axis can read,
+ * built once by initInputCurves() from a power curve and a deadband. Shaping an axis in
+ * recordJoyInfo() is then a single table read with no floating point, and a different feel only
+ * needs a different table.
+ */
+
+#ifndef INPUT_CURVE_H
+
+// This prevents multiple inclusion
+#define INPUT_CURVE_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of entries in an input curve, one for every joystick value from -128 to 127
+ */
+#define INPUT_CURVE_SIZE 256
+
+/**
+ * Outputs closer to zero than this are set to zero, so that a stick resting off center does not move the robot
+ */
+#define INPUT_DEADBAND 10
+
+/**
+ * Exponents of the curves of the forward, horizontal and turning axes
+ * The horizontal axis is a fourth power so that strafing is gentle until the stick is pushed far.
+ */
+#define SPEED_CURVE_EXPONENT 1
+#define HORIZONTAL_CURVE_EXPONENT 4
+#define TURN_CURVE_EXPONENT 1
+
+/**
+ * Shapes a joystick value with an input curve
+ *
+ * @param curve The input curve
+ * @param value The joystick value, from -128 to 127
+ *
+ * @return the shaped value
+ */
+#define INPUT_SHAPE(curve, value) ((curve).table[((value) + 128) & 0xFF])
+
+/**
+ * A table that shapes a joystick axis
+ */
+typedef struct input_curve {
+	/**
+	 * The output for each joystick value, at the index value + 128
+	 */
+	signed char table[INPUT_CURVE_SIZE];
+} input_curve;
+
+/**
+ * The curves of the forward, horizontal and turning axes
+ */
+extern input_curve speedCurve;
+extern input_curve horizontalCurve;
+extern input_curve turnCurve;
+
+/**
+ * Builds an input curve that raises the joystick value to a power, keeping its sign
+ * The output is |value| ^ exponent / 127 ^ (exponent - 1), rounded toward zero, so that full
+ * stick is still full speed; outputs inside the deadband are zero.
+ *
+ * @param curve The input curve to build
+ * @param exponent The power, from 1 (linear) to 4
+ * @param deadband Outputs closer to zero than this are set to zero
+ */
+void buildInputCurve(input_curve* curve, int exponent, int deadband);
+
+/**
+ * Builds the curves of every axis; must be called before recordJoyInfo()
+ */
+void initInputCurves();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/** @file liftControl.h
+ * @brief File for the lift controller, which holds the lift at a height read from its potentiometer
+ *
+ * Without a potentiometer the lift buttons drive the five lift motors at full power and the lift
+ * coasts and droops when they are let go. With one on LIFT_POT, the control task runs a PID loop
+ * on the lift's height with a gravity feedforward: while a lift button is held the lift still
+ * moves at full power, and when it is let go the lift holds the height it was at. Recordings
+ * store the height to hold at the end of each state (saved beside the recording, see
+ * getHeightsFilename() in autonrecorder.h), so playback puts the lift at the recorded heights
+ * instead of repeating the button presses.
+ *
+ * Five motors holding a lift against a load heat up, so the controller keeps a rough heat
+ * count: power above LIFT_SAFE_POWER adds to it and power below takes from it, and past
+ * LIFT_HEAT_LIMIT the power is cut to half of LIFT_SAFE_POWER until the motors have cooled.
+ * A lift resting at the bottom gets no power at all.
+ */
+
+#ifndef LIFT_CONTROL_H
+
+// This prevents multiple inclusion
+#define LIFT_CONTROL_H
+
+#include <API.h>
+#include "pid.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Gains of the lift loop: power per count below the setpoint, per count of summed error and per
+ * count of change in error over a control period. The lift swings on its own, so the derivative
+ * does most of the work of settling it; tuned on the lift model of checksim (host/).
+ */
+#define LIFT_KP INT_TO_FIXED(2)
+#define LIFT_KI (FIXED_ONE / 32)
+#define LIFT_KD INT_TO_FIXED(20)
+
+/**
+ * Largest sum of errors of the lift loop in counts, so the integral gives at most about 30 power
+ * on top of the gravity feedforward
+ */
+#define LIFT_INTEGRAL_LIMIT 1000
+
+/**
+ * Power that holds the lift up against gravity, added to the loop's output everywhere but at the bottom
+ */
+#define LIFT_GRAVITY_POWER 20
+
+/**
+ * Height in counts above the bottom below which a lift sent to the bottom rests there with its motors off
+ */
+#define LIFT_REST_HEIGHT 40
+
+/**
+ * Counts of height per unit of a recorded height, so that heights up to 4080 fit in a byte
+ */
+#define LIFT_HEIGHT_STEP 16
+
+/**
+ * Power that the lift motors can keep up without overheating
+ */
+#define LIFT_SAFE_POWER 60
+
+/**
+ * Heat count past which the lift power is cut, about three seconds of full power at a stall
+ */
+#define LIFT_HEAT_LIMIT 40000
+
+/**
+ * Range of potentiometer readings, with the lift at the bottom when the robot starts, in which the
+ * potentiometer counts as plugged in; an empty port reads near one end
+ */
+#define LIFT_POT_MIN 50
+#define LIFT_POT_MAX 4045
+
+/**
+ * How the lift has been controlled
+ */
+typedef struct lift_stats {
+	/**
+	 * The number of control periods in which the loop held the lift at a setpoint
+	 */
+	unsigned long updates;
+
+	/**
+	 * The number of control periods in which the power was cut to let the motors cool
+	 */
+	unsigned long limited;
+
+	/**
+	 * The sum over the held periods of how many counts the lift was off its setpoint
+	 */
+	unsigned long errorSum;
+
+	/**
+	 * The most counts that the lift has been off its setpoint while held
+	 */
+	int maxError;
+} lift_stats;
+
+/**
+ * How the lift has been controlled since the counters were reset
+ */
+extern lift_stats liftStats;
+
+/**
+ * Whether or not the lift potentiometer was found when the robot started; without it the lift is driven open loop
+ */
+extern bool liftPotFound;
+
+/**
+ * Whether or not the lift holds its height when the buttons are let go (on by default)
+ */
+extern bool liftHoldEnabled;
+
+/**
+ * Calibrates the lift potentiometer, which must be at the bottom, and checks that it is plugged in
+ * Called by initControl().
+ */
+void initLift();
+
+/**
+ * Gets the height of the lift
+ *
+ * @return the height in potentiometer counts above the bottom
+ */
+int liftHeight();
+
+/**
+ * Whether or not the lift is being driven by the controller
+ *
+ * @return true if the potentiometer was found and holding is on, false if the lift is driven open loop
+ */
+bool liftControlled();
+
+/**
+ * Drives the lift from a button command, as operator control and open-loop playback do
+ * Without the controller this stages the lift motors as setLiftMotors() does. With it, a command
+ * drives the lift at full power, and the height at which the command goes back to 0 is held.
+ *
+ * @param command -1 to raise the lift, 1 to lower it, 0 to hold it
+ */
+void liftDrive(int command);
+
+/**
+ * Sends the lift to a height, as playback of a recording with heights does
+ *
+ * @param height The height in counts above the bottom
+ */
+void liftSetHeight(int height);
+
+/**
+ * Gets the height that the lift is being held at
+ *
+ * @return the setpoint in counts above the bottom, or the height now while a button drives the lift
+ */
+int liftSetpoint();
+
+/**
+ * Drives the lift toward its setpoint if the controller is on, staging the lift motors
+ * Run by the control task every CONTROL_PERIOD milliseconds while it holds the control lock.
+ *
+ * @return true if the lift motors were staged, false otherwise
+ */
+bool liftUpdate();
+
+/**
+ * Sets every counter back to zero
+ */
+void liftStatsReset();
+
+/**
+ * Prints whether the lift is held, its height and setpoint, and how closely it has been held
+ */
+void printLiftStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
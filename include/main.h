@@ -45,8 +45,24 @@
 
 #include <API.h>
 #include "autonrecorder.h"
+#include "battery.h"
+#include "benchmark.h"
+#include "control.h"
+#include "driveInterpolate.h"
+#include "driveMix.h"
+#include "driveTrack.h"
+#include "fixed.h"
+#include "headingHold.h"
+#include "inputCurve.h"
+#include "liftControl.h"
+#include "motorFrame.h"
+#include "odometry.h"
+#include "pid.h"
 #include "robot.h"
 #include "lcdDisplay.h"
+#include "serialShell.h"
+#include "serialTransfer.h"
+#include "uartStats.h"
 
 // Allow usage of this file in C++ programs
 #ifdef __cplusplus
@@ -0,0 +1,114 @@
+/** @file motorFrame.h
+ * @brief File for writing the motors once per tick, skipping the ones that have not changed
+ *
+ * The motion functions in robot.h stage the value of every motor in a frame, and moveRobot()
+ * commits the frame once per tick: only the channels whose value differs from the last committed
+ * frame are passed to motorSet(). Every MOTOR_FRAME_REFRESH milliseconds, and after anything else has
+ * set the motors (motorFrameInvalidate()), every channel is written again, so a motor stopped
+ * behind the frame's back (for example by the Cortex when the robot is disabled) does not stay stopped.
+ * While a routine plays back, the frame also scales every value for the battery (battery.h).
+ */
+
+#ifndef MOTOR_FRAME_H
+
+// This prevents multiple inclusion
+#define MOTOR_FRAME_H
+
+#include <API.h>
+#include "fixed.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of motor channels in a frame (ports 1 - 10)
+ */
+#define MOTOR_CHANNELS 10
+
+/**
+ * Milliseconds after which the next commit writes every channel again, even if unchanged
+ * The control task commits every CONTROL_PERIOD, so this is kept in time rather than in commits.
+ */
+#define MOTOR_FRAME_REFRESH 1000
+
+/**
+ * Counters of the motor writes made and skipped by motorFrameCommit()
+ */
+typedef struct motor_frame_stats {
+	/**
+	 * The number of frames committed
+	 */
+	unsigned long commits;
+
+	/**
+	 * The number of channels passed to motorSet()
+	 */
+	unsigned long writes;
+
+	/**
+	 * The number of channels left alone because they had not changed
+	 */
+	unsigned long skipped;
+} motor_frame_stats;
+
+/**
+ * The counters since the robot started or motorFrameStatsReset() was called
+ */
+extern motor_frame_stats motorFrameStats;
+
+/**
+ * Stages the value of a motor for the next commit
+ *
+ * @param channel The motor channel, from 1 to MOTOR_CHANNELS
+ * @param speed The new signed speed; values outside -127 to 127 are clamped
+ */
+void motorFrameSet(unsigned char channel, int speed);
+
+/**
+ * Stages the value of a motor for the next commit without the battery scale, for a controller
+ * that already corrects for the battery
+ *
+ * @param channel The motor channel, from 1 to MOTOR_CHANNELS
+ * @param speed The new signed speed; values outside -127 to 127 are clamped
+ */
+void motorFrameSetExact(unsigned char channel, int speed);
+
+/**
+ * Sets the battery scale that motorFrameSet() applies from now on (see batteryScaleCommand())
+ *
+ * @param scale The scale from batteryScale(), or FIXED_ONE to stage values as they are given
+ */
+void motorFrameSetScale(fixed scale);
+
+/**
+ * Writes every staged value that differs from the last committed frame to the motors
+ */
+void motorFrameCommit();
+
+/**
+ * Makes the next commit write every channel, after the motors were set without the frame
+ */
+void motorFrameInvalidate();
+
+/**
+ * Stops every motor at once and stages and commits a stopped frame
+ */
+void motorFrameStopAll();
+
+/**
+ * Sets the counters back to zero
+ */
+void motorFrameStatsReset();
+
+/**
+ * Prints the counters to the serial monitor
+ */
+void printMotorFrameStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
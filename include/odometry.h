@@ -0,0 +1,151 @@
+/** @file odometry.h
+ * @brief File for the odometry task, which keeps track of where the robot is from its drive encoders
+ *
+ * Every ODOMETRY_PERIOD milliseconds the task reads the four drive IMEs and works out how far the
+ * robot moved forward, moved left and turned since the last reading (mecanum forward kinematics:
+ * the mean of the four wheels gives the forward motion, and the differences between the diagonals
+ * and between the sides give the strafing and the turn). The motion is turned by the heading into
+ * a position on the field, which starts at the origin, facing along x, when odometryReset() is
+ * called. With a gyro (headingHold.h), the heading also closes a share of its gap to the gyro's
+ * at every reading, as mecanum wheels slip most when turning and the gyro does not drift far in a
+ * routine. Other tasks read the pose with odometryGetPose(), which copies it under the control lock
+ * (control.h), so a pose is never half of one reading and half of the next; recording and playback
+ * call it from tasks that the kernel deletes on a mode change, so a mutex could be left taken.
+ */
+
+#ifndef ODOMETRY_H
+
+// This prevents multiple inclusion
+#define ODOMETRY_H
+
+#include <API.h>
+#include "fixed.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of milliseconds between readings of the drive IMEs
+ */
+#define ODOMETRY_PERIOD 10
+
+/**
+ * Priority of the odometry task (that of the control task, so that it keeps its period)
+ */
+#define ODOMETRY_TASK_PRIORITY (TASK_PRIORITY_DEFAULT + 1)
+
+/**
+ * Share of the gap between the heading and the gyro's closed at every reading; the encoders give
+ * the turn from one reading to the next, and the gyro keeps them from drifting over a routine
+ */
+#define ODOMETRY_GYRO_WEIGHT (FIXED_ONE / 8)
+
+/**
+ * Where the robot is
+ */
+typedef struct odometry_pose {
+	/**
+	 * Micrometers the robot has moved along the way it faced at odometryReset()
+	 */
+	long x;
+
+	/**
+	 * Micrometers the robot has moved to the left of the way it faced at odometryReset()
+	 */
+	long y;
+
+	/**
+	 * Thousandths of a degree the robot has turned counterclockwise since odometryReset()
+	 */
+	long heading;
+
+	/**
+	 * Speed of the robot forward and to its left, in millimeters per second, over the last ODOMETRY_PERIOD
+	 */
+	int forwardSpeed;
+	int leftSpeed;
+
+	/**
+	 * The time in milliseconds at which the IMEs were read
+	 */
+	unsigned long time;
+} odometry_pose;
+
+/**
+ * How the odometry task has kept up
+ */
+typedef struct odometry_stats {
+	/**
+	 * The number of readings of every IME
+	 */
+	unsigned long updates;
+
+	/**
+	 * The number of readings in which an IME could not be read, so the pose waited for the next one
+	 */
+	unsigned long readFailures;
+
+	/**
+	 * The sum over every reading of the microseconds it took to read the IMEs and move the pose
+	 */
+	unsigned long busySum;
+
+	/**
+	 * The most microseconds that a reading has taken
+	 */
+	unsigned long maxBusy;
+
+	/**
+	 * The most milliseconds between the starts of two readings (ODOMETRY_PERIOD when the task keeps its period)
+	 */
+	unsigned long maxGap;
+} odometry_stats;
+
+/**
+ * How the odometry task has kept up since the counters were reset
+ */
+extern odometry_stats odometryStats;
+
+/**
+ * Whether or not the heading is steered toward the gyro's when the robot has one (on by default)
+ */
+extern bool odometryGyro;
+
+/**
+ * Starts the odometry task if the four drive IMEs answer, with the robot at the origin
+ * Called by initControl() after initDriveEncoders() and initHeading().
+ */
+void initOdometry();
+
+/**
+ * Gets where the robot is
+ *
+ * @param pose Set to the pose at the last reading
+ *
+ * @return true if the pose is kept, false if the robot has no drive IMEs
+ */
+bool odometryGetPose(odometry_pose* pose);
+
+/**
+ * Takes where the robot is now as the origin, facing along x, as recording and playback do at the
+ * start of a routine; called after headingZero(), so the gyro is zeroed at the same time
+ */
+void odometryReset();
+
+/**
+ * Sets every counter back to zero
+ */
+void odometryStatsReset();
+
+/**
+ * Prints the pose and how the odometry task has kept up
+ */
+void printOdometryStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
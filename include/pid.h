@@ -0,0 +1,95 @@
+/** @file pid.h
+ * @brief File for the PID controllers of the control task
+ *
+ * A controller turns the error between where something should be and where it is into a motor
+ * power. It is called once per CONTROL_PERIOD (control.h), so the integral is a sum of errors and
+ * the derivative is the change in error since the last call, with the period folded into the
+ * gains. The gains are fixed-point (fixed.h), so a controller needs no floating point.
+ */
+
+#ifndef PID_H
+
+// This prevents multiple inclusion
+#define PID_H
+
+#include <API.h>
+#include "fixed.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A PID controller and its gains
+ */
+typedef struct pid_controller {
+	/**
+	 * Power per unit of error
+	 */
+	fixed kp;
+
+	/**
+	 * Power per unit of the sum of errors
+	 */
+	fixed ki;
+
+	/**
+	 * Power per unit of change in error since the last call
+	 */
+	fixed kd;
+
+	/**
+	 * Largest magnitude of the sum of errors, so that a long stall cannot wind it up
+	 */
+	long integralLimit;
+
+	/**
+	 * The sum of the errors since the controller was reset
+	 */
+	long integral;
+
+	/**
+	 * The error at the last call
+	 */
+	int lastError;
+
+	/**
+	 * Whether or not lastError holds an error yet
+	 */
+	bool started;
+} pid_controller;
+
+/**
+ * Sets the gains of a controller and resets it
+ *
+ * @param pid The controller
+ * @param kp The proportional gain
+ * @param ki The integral gain
+ * @param kd The derivative gain
+ * @param integralLimit The largest magnitude of the sum of errors
+ */
+void pidInit(pid_controller* pid, fixed kp, fixed ki, fixed kd, long integralLimit);
+
+/**
+ * Forgets the errors that a controller has seen, keeping its gains
+ *
+ * @param pid The controller
+ */
+void pidReset(pid_controller* pid);
+
+/**
+ * Adds an error to a controller and gets the power that corrects it
+ *
+ * @param pid The controller
+ * @param error Where the controlled thing should be, less where it is
+ *
+ * @return the correcting power (not clamped; add the feedforward and clamp the sum)
+ */
+int pidUpdate(pid_controller* pid, int error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,7 +8,9 @@
 #define ROBOT_H_
 
 #include <API.h>
-#include <math.h>
+#include "fixed.h"
+#include "driveMix.h"
+#include "motorFrame.h"
 
 // Allow usage of this file in C++ programs
 #ifdef __cplusplus
@@ -35,6 +37,27 @@ extern "C" {
  * Definition for the back right drive motor
  */
 #define BACK_RIGHT_MOTOR 2
+/**
+ * Addresses of the integrated motor encoders (IMEs) on the drive motors, in the order they are chained
+ * from the Cortex. Each counts positive when its motor turns for a positive power.
+ */
+#define FRONT_LEFT_IME 0
+#define FRONT_RIGHT_IME 1
+#define BACK_LEFT_IME 2
+#define BACK_RIGHT_IME 3
+/**
+ * Counts per revolution of a 393 IME with the motor in high speed mode
+ */
+#define DRIVE_IME_COUNTS_PER_REV 392
+/**
+ * Radius of the drive wheels (4 inch mecanum wheels) in micrometers
+ */
+#define DRIVE_WHEEL_RADIUS 50800
+/**
+ * Half the distance between the front and back axles plus half the distance between the left and
+ * right wheels, in micrometers: how far a wheel rolls per radian of turn in place
+ */
+#define DRIVE_WHEEL_SPAN 355000
 /**
 * Definition for the right top lift motor
 */
@@ -55,6 +78,14 @@ extern "C" {
 * Definition for the right bottom lift motor
 */
 #define LIFT_BOTTOM_RIGHT_MOTOR 5
+/**
+ * Analog port of the potentiometer that turns with the lift (see liftControl.h)
+ */
+#define LIFT_POT 2
+/**
+ * Analog port of the gyro that playback holds the recorded heading with (see headingHold.h)
+ */
+#define GYRO_PORT 3
 /**
  * Definition for the pincer Y cable motor port
  */
@@ -63,16 +94,21 @@ extern "C" {
 #define LCD_PORT uart1
 
 /**
- * Sets the drive motors for the tank drive based on left and right sides
+ * Sets the drive motors from the forward, strafing and turning commands, scaling all four wheels
+ * together when one would go past full power (see driveMix.h)
+ * Like the other motion functions, this stages the values; motorFrameCommit() writes them.
  *
- * @param left sets the power to the left motors
- * @param right sets the power to the right motors
+ * @param forward The forward command
+ * @param horizontal The strafing command, positive to the right
+ * @param turn The turning command, positive clockwise
  */
 inline void setDriveMotors(int forward, int horizontal, int turn) {
-	motorSet(FRONT_LEFT_MOTOR, -(forward + horizontal + turn));
-	motorSet(FRONT_RIGHT_MOTOR, -(-forward + horizontal + turn));
-	motorSet(BACK_LEFT_MOTOR, forward - horizontal + turn);
-	motorSet(BACK_RIGHT_MOTOR, -forward - horizontal + turn);
+	int powers[DRIVE_WHEELS];
+	mixDrive(forward, horizontal, turn, DRIVE_TURN_PRIORITY, powers);
+	motorFrameSet(FRONT_LEFT_MOTOR, powers[DRIVE_FRONT_LEFT]);
+	motorFrameSet(FRONT_RIGHT_MOTOR, powers[DRIVE_FRONT_RIGHT]);
+	motorFrameSet(BACK_LEFT_MOTOR, powers[DRIVE_BACK_LEFT]);
+	motorFrameSet(BACK_RIGHT_MOTOR, powers[DRIVE_BACK_RIGHT]);
 }
 
 /**
@@ -81,7 +117,20 @@ inline void setDriveMotors(int forward, int horizontal, int turn) {
  * @param pincer sets the power to the pincer motors
  */
 inline void setPincerMotors(int pincer){
-  motorSet(PINCER_Y_MOTOR, pincer);
+  motorFrameSet(PINCER_Y_MOTOR, pincer);
+}
+
+/**
+ * Sets the power of the lift motors such that they rotate to move the lift in the same direction
+ *
+ * @param power The power, positive to raise the lift as the up button (6U) does
+ */
+inline void setLiftPower(int power) {
+	motorFrameSet(LIFT_TOP_Y_MOTOR, power);
+	motorFrameSet(LIFT_MIDDLE_LEFT_MOTOR, -power);
+	motorFrameSet(LIFT_MIDDLE_RIGHT_MOTOR, power);
+	motorFrameSet(LIFT_BOTTOM_LEFT_MOTOR, -power);
+	motorFrameSet(LIFT_BOTTOM_RIGHT_MOTOR, power);
 }
 
 /**
@@ -90,11 +139,7 @@ inline void setPincerMotors(int pincer){
  * @param spd sets the power to the lift motors on a continuum from -1 to 1
  */
 inline void setLiftMotors(int spd) {
-	motorSet(LIFT_TOP_Y_MOTOR, -spd * MOTOR_SPEED);
-	motorSet(LIFT_MIDDLE_LEFT_MOTOR, spd * MOTOR_SPEED);
-	motorSet(LIFT_MIDDLE_RIGHT_MOTOR, -spd * MOTOR_SPEED);
- 	motorSet(LIFT_BOTTOM_LEFT_MOTOR, spd * MOTOR_SPEED);
-	motorSet(LIFT_BOTTOM_RIGHT_MOTOR, -spd * MOTOR_SPEED);
+	setLiftPower(-CLAMP(spd, -1, 1) * MOTOR_SPEED);
 }
 
 #ifdef __cplusplus
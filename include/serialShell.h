@@ -0,0 +1,104 @@
+/** @file serialShell.h
+ * @brief File for the serial command shell functions and constants
+ *
+ * The serial shell lets the autonomous recorder be managed from a computer connected over the
+ * serial monitor. Commands are read a line at a time by a low priority task that never blocks
+ * waiting for input, so the robot keeps running while the shell is idle.
+ */
+
+#ifndef SERIAL_SHELL_H
+
+// This prevents multiple inclusion
+#define SERIAL_SHELL_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Maximum length of a command line, including the terminating null character
+ */
+#define SHELL_LINE_MAX_LENGTH 64
+
+/**
+ * Maximum number of words (command name and arguments) in a command line
+ */
+#define SHELL_MAX_ARGS 4
+
+/**
+ * Number of milliseconds the shell task sleeps when no input is waiting
+ */
+#define SHELL_POLL_TIME 20
+
+/**
+ * Priority of the shell task (below operator control and autonomous)
+ */
+#define SHELL_TASK_PRIORITY (TASK_PRIORITY_DEFAULT - 1)
+
+/**
+ * A struct that defines a command understood by the serial shell
+ */
+typedef struct shell_command {
+	/**
+	 * The word typed to run the command
+	 */
+	char* name;
+
+	/**
+	 * A short description of the arguments of the command
+	 */
+	char* usage;
+
+	/**
+	 * A function that runs the command
+	 *
+	 * @param int The number of words in the command line, including the command name
+	 * @param char** The words in the command line, starting with the command name
+	 *
+	 * @return true if the command succeeded, false otherwise
+	 */
+	bool (*runFunction)(int, char**);
+} shell_command;
+
+/**
+ * Starts the task that services the serial shell
+ */
+void initSerialShell();
+
+/**
+ * Waits until the shell is between command lines and keeps it from reading the serial monitor
+ * until serialUnlock(), so that a transfer started from another task gets every byte that arrives
+ * Shell commands already own the serial monitor and must not call this. If the calling task is
+ * deleted before serialUnlock(), the shell takes the serial monitor back.
+ */
+void serialLock();
+
+/**
+ * Lets the shell read the serial monitor again
+ */
+void serialUnlock();
+
+/**
+ * Runs a single command line through the shell
+ *
+ * @param line The command line to run; it is split into words in place
+ */
+void runShellCommand(char* line);
+
+/**
+ * Parses an autonomous slot typed into the shell
+ *
+ * @param text Either a slot number, a file name (a1 - a10 or p0 - p3), or "skills"
+ *
+ * @return the slot number in the format used by the recorder, or 0 if the text is not a valid slot
+ */
+int parseShellSlot(const char* text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
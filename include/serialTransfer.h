@@ -0,0 +1,98 @@
+/** @file serialTransfer.h
+ * @brief File for binary transfers of autonomous files over the serial monitor
+ *
+ * These functions move autonomous files to and from the computer in framed blocks (see frame.h).
+ * Up to TRANSFER_WINDOW blocks are sent before waiting for an acknowledgement, and blocks that are
+ * damaged or lost are sent again, so transfers run as fast as the serial link allows instead of
+ * being paced by delays.
+ * The text transfers in autonrecorder.h are kept as a fallback for use with a plain terminal.
+ */
+
+#ifndef SERIAL_TRANSFER_H
+
+// This prevents multiple inclusion
+#define SERIAL_TRANSFER_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of milliseconds to wait for the computer to start a transfer
+ */
+#define TRANSFER_START_TIMEOUT 10000
+
+/**
+ * Number of file bytes buffered before each write to flash during a text transfer
+ */
+#define TRANSFER_TEXT_BLOCK_SIZE 50
+
+/**
+ * Number of milliseconds to wait for each byte after the first during a text transfer
+ */
+#define TRANSFER_BYTE_TIMEOUT 2000
+
+/**
+ * Number of autonomous slots that are exchanged in a sync session (a1 - a10 and p0 - p3)
+ */
+#define SYNC_NUM_SLOTS (MAX_AUTON_SLOTS + PROGSKILL_TIME / AUTON_TIME)
+
+/**
+ * Reads a byte from the serial monitor, waiting at most the given time
+ *
+ * @param timeout The maximum number of milliseconds to wait for a byte
+ *
+ * @return the byte read (0 - 255), or -1 if no byte arrived in time
+ */
+int serialReadByte(unsigned long timeout);
+
+/**
+ * Sends an autonomous slot to the computer as binary frames
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if every frame was acknowledged by the computer, false otherwise
+ */
+bool uploadAutonBinary(int slot);
+
+/**
+ * Receives an autonomous slot from the computer as binary frames
+ * The file is written to flash as each block arrives; the loaded autonomous is not changed, and the
+ * slot's track, voltage, heights and headings files are deleted (see deleteAutonCompanions()).
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if a full autonomous was received and saved, false otherwise
+ */
+bool downloadAutonBinary(int slot);
+
+/**
+ * Gets the recorder slot number of a slot index used in a sync session
+ *
+ * @param index A slot index from 0 to SYNC_NUM_SLOTS - 1
+ *
+ * @return the slot number (1 - 10 for a1 - a10, -1 to -4 for p0 - p3)
+ */
+int syncIndexToSlot(int index);
+
+/**
+ * Runs a sync session with the computer
+ * The robot sends a manifest of every slot with its size and CRC, the computer answers with a plan
+ * followed by the slots it is sending, and the robot then sends the slots the computer asked for.
+ * Only slots that differ need to appear in the plan, and each direction is a single pipelined stream.
+ * Only the autonomous files are exchanged: a slot that is received or removed loses its track,
+ * voltage, heights and headings files (the shell's list and load report them missing), and a
+ * plan to receive a file of the wrong size is refused.
+ *
+ * @return true if every planned slot was transferred, false otherwise
+ */
+bool syncAutonSlots();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
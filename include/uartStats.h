@@ -0,0 +1,104 @@
+/** @file uartStats.h
+ * @brief File for counting the bytes sent over each serial link
+ *
+ * Every byte written to the telemetry port (uart2) and the serial monitor (stdout) is counted,
+ * with the busiest second and how deep the transmit queue would get if the link sends at its line
+ * rate. On the Cortex the writes are caught by linker wrappers (uartWrap.c); the simulator counts
+ * them in its PROS functions. A link whose busiest second comes near its capacity, or whose queue
+ * keeps growing, is about to delay the task that writes.
+ *
+ * The LCD (uart1) is counted in lines set instead of bytes: PROS keeps the text of each line and
+ * sends the frames to the LCD itself from the kernel, however often the lines are set, so the
+ * requests show how busy the code keeps the LCD but not how loaded its link is.
+ */
+
+#ifndef UART_STATS_H
+
+// This prevents multiple inclusion
+#define UART_STATS_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of serial links counted
+ */
+#define UART_PORTS 3
+
+/**
+ * The bytes sent over a serial link
+ */
+typedef struct uart_stats {
+	/**
+	 * The name of the link
+	 */
+	const char* name;
+
+	/**
+	 * The line rate of the link in bits per second (10 bits per byte), or 0 for the LCD, whose
+	 * counts are lines set and whose queue is not modelled
+	 */
+	unsigned int baud;
+
+	/**
+	 * The number of bytes sent since the counters were reset
+	 */
+	unsigned long bytes;
+
+	/**
+	 * The second (since the Cortex started) that secondBytes counts
+	 */
+	unsigned long second;
+
+	/**
+	 * The number of bytes sent in the current second, in the last full second, and in the busiest second
+	 */
+	unsigned long secondBytes;
+	unsigned long lastSecondBytes;
+	unsigned long peakSecondBytes;
+
+	/**
+	 * The number of bytes that would be waiting to be sent at the line rate, and the most there have been
+	 */
+	unsigned long queued;
+	unsigned long peakQueued;
+
+	/**
+	 * The time in microseconds up to which the queue has been drained
+	 */
+	unsigned long drainedAt;
+} uart_stats;
+
+/**
+ * The counters of the LCD, the telemetry port and the serial monitor, in that order
+ */
+extern uart_stats uartStats[UART_PORTS];
+
+/**
+ * Counts bytes written to a serial link
+ *
+ * @param port uart1, uart2 or stdout; other streams (flash files) are ignored
+ * @param bytes The number of bytes written, or of lines set for the LCD
+ */
+void uartCount(FILE* port, unsigned int bytes);
+
+/**
+ * Sets every counter back to zero
+ */
+void uartStatsReset();
+
+/**
+ * Prints the bytes, throughput, busiest second and deepest queue of each link to the serial monitor,
+ * and the lines set on the LCD
+ */
+void printUartStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
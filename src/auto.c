@@ -27,5 +27,6 @@
  * so, the robot will await a switch to another mode or disable/enable cycle.
  */
 void autonomous() {
+    motorFrameInvalidate();
     playbackAuton();
 }
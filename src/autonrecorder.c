@@ -11,6 +11,7 @@
  */
 
 #include "main.h"
+#include "frame.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -20,6 +21,41 @@
  */
 joyState states[AUTON_TIME*JOY_POLL_FREQ];
 
+/**
+ * Stores how far each wheel turned during each state of the states array.
+ */
+wheelTrack tracks[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether or not tracks holds the wheel track of the loaded autonomous routine.
+ */
+bool trackLoaded = false;
+
+/**
+ * Average main battery voltage in millivolts while the loaded autonomous routine was recorded, or 0 if it is not known.
+ */
+unsigned int autonVoltage = 0;
+
+/**
+ * Stores the height to hold the lift at by the end of each state of the states array, in units of LIFT_HEIGHT_STEP.
+ */
+unsigned char heights[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether or not heights holds the lift heights of the loaded autonomous routine.
+ */
+bool heightsLoaded = false;
+
+/**
+ * Stores the gyro heading of the robot at the end of each state of the states array, in degrees counterclockwise.
+ */
+int16_t headings[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether or not headings holds the headings of the loaded autonomous routine.
+ */
+bool headingsLoaded = false;
+
 /**
  * Slot number of currently loaded autonomous routine.
  */
@@ -35,6 +71,32 @@ int autonFlipped = 1;
  */
 int progSkills;
 
+/**
+ * Whether or not an autonomous routine is currently being played back.
+ */
+volatile bool autonPlaying = false;
+
+/**
+ * The task playing back while autonPlaying is set.
+ */
+static TaskHandle playbackOwner = NULL;
+
+/**
+ * Whether or not the drive is following the wheel track during the current playback.
+ */
+static bool playbackFollowing = false;
+
+/**
+ * Whether or not the drive commands are interpolated between states during the current playback.
+ */
+static bool playbackInterpolating = false;
+
+/**
+ * The heading that the robot had when the next state to play back started to be recorded: the
+ * heading at the end of the state before it, kept here as the skills sections replace the headings array.
+ */
+static int headingTarget = 0;
+
 /**
  * Initializes autonomous recorder by setting states array to zero.
  */
@@ -44,6 +106,13 @@ void initAutonRecorder() {
     lcdSetText(LCD_PORT, 1, "Init recorder...");
     lcdSetText(LCD_PORT, 2, "");
     memset(states, 0, sizeof(*states));
+    memset(tracks, 0, sizeof(tracks));
+    trackLoaded = false;
+    autonVoltage = 0;
+    memset(heights, 0, sizeof(heights));
+    heightsLoaded = false;
+    memset(headings, 0, sizeof(headings));
+    headingsLoaded = false;
     printf("Completed initialization of autonomous recorder.\n");
     lcdSetText(LCD_PORT, 1, "Init-ed recorder!");
     lcdSetText(LCD_PORT, 2, "");
@@ -67,11 +136,27 @@ void recordAuton() {
     lcdSetText(LCD_PORT, 1, "Recording auton...");
     lcdSetText(LCD_PORT, 2, "");
     bool lightState = false;
+    // Each state's track is how far the wheels turned between its sample and the next one
+    int lastCounts[DRIVE_WHEELS];
+    int counts[DRIVE_WHEELS];
+    bool trackRecorded = readDriveEncoders(lastCounts);
+    unsigned long voltageSum = 0;
+    int voltageSamples = 0;
+    bool heightsRecorded = liftControlled();
+    bool headingsRecorded = gyroFound;
+    // The sections of programming skills share the heading of the first, so each can make up for the last
+    if (progSkills == 0) {
+        headingZero();
+        odometryReset();
+    }
     for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+        int state = i;
         printf("Recording state %d...\n", i);
         lcdSetBacklight(LCD_PORT, lightState);
         lightState = !lightState;
         recordJoyInfo();
+        voltageSum += powerLevelMain();
+        voltageSamples++;
         states[i].spd = spd;
         states[i].horizontal = horizontal;
         states[i].turn = turn;
@@ -83,22 +168,339 @@ void recordAuton() {
             lcdSetText(LCD_PORT, 1, "Cancelled record.");
             lcdSetText(LCD_PORT, 2, "");
             memset(states + i + 1, 0, sizeof(joyState) * (AUTON_TIME * JOY_POLL_FREQ - i - 1));
+            memset(tracks + i + 1, 0, sizeof(wheelTrack) * (AUTON_TIME * JOY_POLL_FREQ - i - 1));
             i = AUTON_TIME * JOY_POLL_FREQ;
         }
         moveRobot();
         delay(1000 / JOY_POLL_FREQ);
+        if (trackRecorded && readDriveEncoders(counts)) {
+            for (int j = 0; j < DRIVE_WHEELS; j++) {
+                tracks[state].wheel[j] = CLAMP(counts[j] - lastCounts[j], -127, 127);
+                lastCounts[j] = counts[j];
+            }
+        } else {
+            trackRecorded = false;
+        }
+        // Each state's height is where the lift is to be by the time the next state starts
+        heightsRecorded = heightsRecorded && liftControlled();
+        if (heightsRecorded) {
+            heights[state] = CLAMP(roundDivide(liftSetpoint(), LIFT_HEIGHT_STEP), 0, 255);
+            if (i == AUTON_TIME * JOY_POLL_FREQ) {
+                // A cancelled recording holds the lift where it was for the rest of the states
+                memset(heights + state + 1, heights[state], AUTON_TIME * JOY_POLL_FREQ - state - 1);
+            }
+        }
+        if (headingsRecorded) {
+            headings[state] = headingGet();
+            if (i == AUTON_TIME * JOY_POLL_FREQ) {
+                // A cancelled recording keeps the heading it ended with for the rest of the states
+                for (int j = state + 1; j < AUTON_TIME * JOY_POLL_FREQ; j++) {
+                    headings[j] = headings[state];
+                }
+            }
+        }
     }
+    trackLoaded = trackRecorded;
+    heightsLoaded = heightsRecorded;
+    headingsLoaded = headingsRecorded;
+    autonVoltage = voltageSum / voltageSamples;
     lcdSetBacklight(LCD_PORT, true);
 
     printf("Completed autonomous recording.\n");
     lcdSetText(LCD_PORT, 1, "Recorded auton!");
     lcdSetText(LCD_PORT, 2, "");
-    motorStopAll();
+    motorFrameStopAll();
     delay(1000);
     autonLoaded = 0;
 
 }
 
+/**
+ * Gets the name of the file in flash memory that backs an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getAutonFilename(int slot, char* filename, int size) {
+    if (slot >= 1 && slot <= MAX_AUTON_SLOTS) {
+        snprintf(filename, size, "a%d", slot);
+    } else if (slot <= -1 && slot >= -(PROGSKILL_TIME / AUTON_TIME)) {
+        snprintf(filename, size, "p%d", -slot - 1);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Gets the name of a file that goes with an autonomous file
+ *
+ * @param autonFilename The name of the autonomous file
+ * @param kind The letter added to the name: 't' for the wheel track, 'v' for the recorded voltage, 'h' for the lift
+ * heights, 'g' for the gyro headings
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ */
+static void companionFilename(const char* autonFilename, char kind, char* filename, int size) {
+    snprintf(filename, size, "%s%c", autonFilename, kind);
+}
+
+/**
+ * Gets the name of a file that goes with the autonomous file of a slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param kind The letter added to the name (see companionFilename())
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+static bool companionSlotFilename(int slot, char kind, char* filename, int size) {
+    char autonFilename[AUTON_FILENAME_MAX_LENGTH + 1];
+    if (!getAutonFilename(slot, autonFilename, sizeof(autonFilename))) {
+        return false;
+    }
+    companionFilename(autonFilename, kind, filename, size);
+    return true;
+}
+
+/**
+ * Gets the name of the file in flash memory that holds the wheel track of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getTrackFilename(int slot, char* filename, int size) {
+    return companionSlotFilename(slot, 't', filename, size);
+}
+
+/**
+ * Gets the name of the file in flash memory that holds the recorded battery voltage of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getVoltageFilename(int slot, char* filename, int size) {
+    return companionSlotFilename(slot, 'v', filename, size);
+}
+
+/**
+ * Gets the name of the file in flash memory that holds the lift heights of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getHeightsFilename(int slot, char* filename, int size) {
+    return companionSlotFilename(slot, 'h', filename, size);
+}
+
+/**
+ * Gets the name of the file in flash memory that holds the gyro headings of an autonomous slot
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param filename The buffer to write the file name into
+ * @param size The size of the filename buffer
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+bool getHeadingsFilename(int slot, char* filename, int size) {
+    return companionSlotFilename(slot, 'g', filename, size);
+}
+
+/**
+ * Deletes the files beside an autonomous slot (its wheel track, recorded voltage, lift heights and gyro headings)
+ * Called when the slot's file is replaced or removed from the computer, which only sends the autonomous file, so
+ * that nothing recorded with the old routine is left beside the new one.
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ */
+void deleteAutonCompanions(int slot) {
+    static const char kinds[] = { 't', 'v', 'h', 'g' };
+    for (int i = 0; i < (int) sizeof(kinds); i++) {
+        char filename[AUTON_FILENAME_MAX_LENGTH + 2];
+        if (companionSlotFilename(slot, kinds[i], filename, sizeof(filename))) {
+            fdelete(filename);
+        }
+    }
+}
+
+/**
+ * Adds a state, as it is stored in an autonomous file, to a CRC-32
+ *
+ * @param crc The CRC so far, or 0 to start a new CRC
+ * @param state The state
+ *
+ * @return the updated CRC
+ */
+static uint32_t stateCrc(uint32_t crc, const joyState* state) {
+    signed char bytes[AUTON_STATE_SIZE] = { state->spd, state->horizontal, state->turn, state->sht, state->lift };
+    return frameCrc32(crc, (const uint8_t*) bytes, AUTON_STATE_SIZE);
+}
+
+/**
+ * Saves a file beside an autonomous file that was just saved from the states array: a header
+ * with the CRC-32 of the autonomous file, then the data. If there is nothing to save, the old
+ * file is removed; a file that cannot be saved is removed too, so it is never half written.
+ *
+ * @param autonFilename The name of the autonomous file
+ * @param kind The letter added to the name (see companionFilename())
+ * @param name What the file holds, for logging
+ * @param recorded Whether or not there is anything to save
+ * @param data The data to save after the header
+ * @param size The number of bytes of data
+ */
+static void saveCompanion(const char* autonFilename, char kind, const char* name, bool recorded, const void* data, int size) {
+    char filename[AUTON_FILENAME_MAX_LENGTH + 2];
+    companionFilename(autonFilename, kind, filename, sizeof(filename));
+    if (!recorded) {
+        fdelete(filename);
+        return;
+    }
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        printf("Error saving %s in file %s!\n", name, filename);
+        return;
+    }
+    uint32_t crc = 0;
+    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+        crc = stateCrc(crc, &states[i]);
+    }
+    uint8_t header[AUTON_TRACK_HEADER_SIZE] = { crc, crc >> 8, crc >> 16, crc >> 24 };
+    bool written = fwrite(header, 1, AUTON_TRACK_HEADER_SIZE, file) == AUTON_TRACK_HEADER_SIZE &&
+            fwrite(data, 1, size, file) == (size_t) size;
+    fclose(file);
+    if (!written) {
+        printf("Writing %s to file %s failed!\n", name, filename);
+        fdelete(filename);
+        return;
+    }
+    printf("Saved %s to file %s.\n", name, filename);
+}
+
+/**
+ * Saves the tracks, voltage, heights and headings of the states array beside an autonomous file that was just saved from it.
+ * Any of them that cannot be saved is left out, and the routine plays back without it.
+ *
+ * @param autonFilename The name of the autonomous file
+ */
+static void saveCompanions(const char* autonFilename) {
+    saveCompanion(autonFilename, 't', "wheel track", trackLoaded, tracks, sizeof(tracks));
+    uint8_t voltage[AUTON_VOLTAGE_FILE_SIZE - AUTON_TRACK_HEADER_SIZE] = { autonVoltage, autonVoltage >> 8 };
+    saveCompanion(autonFilename, 'v', "battery voltage", autonVoltage != 0, voltage, sizeof(voltage));
+    saveCompanion(autonFilename, 'h', "lift heights", heightsLoaded, heights, sizeof(heights));
+    // The Cortex stores the headings least significant byte first, as the file does
+    saveCompanion(autonFilename, 'g', "gyro headings", headingsLoaded, headings, sizeof(headings));
+}
+
+/**
+ * Opens a file beside an autonomous file and reads its header
+ *
+ * @param autonFilename The name of the autonomous file
+ * @param kind The letter added to the name (see companionFilename())
+ * @param crc Set to the CRC-32 of the autonomous file that the file was recorded with
+ *
+ * @return the file, positioned after its header, or NULL if there is no complete header
+ */
+static FILE* openCompanion(const char* autonFilename, char kind, uint32_t* crc) {
+    char filename[AUTON_FILENAME_MAX_LENGTH + 2];
+    companionFilename(autonFilename, kind, filename, sizeof(filename));
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+    uint8_t header[AUTON_TRACK_HEADER_SIZE];
+    if (fread(header, 1, AUTON_TRACK_HEADER_SIZE, file) != AUTON_TRACK_HEADER_SIZE) {
+        fclose(file);
+        return NULL;
+    }
+    *crc = header[0] | (header[1] << 8) | ((uint32_t) header[2] << 16) | ((uint32_t) header[3] << 24);
+    return file;
+}
+
+/**
+ * Loads the data of a file beside an autonomous file
+ *
+ * @param autonFilename The name of the autonomous file
+ * @param kind The letter added to the name (see companionFilename())
+ * @param name What the file holds, for logging
+ * @param crc The CRC-32 of the autonomous file, which the file must have been recorded with
+ * @param data The buffer to read the data into, which may be partly overwritten if the file is incomplete
+ * @param size The number of bytes of data
+ *
+ * @return true if the data was loaded, false if there is no file or it belongs to an older routine
+ */
+static bool loadCompanion(const char* autonFilename, char kind, const char* name, uint32_t crc, void* data, int size) {
+    uint32_t recordedCrc;
+    FILE* file = openCompanion(autonFilename, kind, &recordedCrc);
+    if (file == NULL) {
+        return false;
+    }
+    bool loaded = recordedCrc == crc && fread(data, 1, size, file) == (size_t) size;
+    fclose(file);
+    if (!loaded) {
+        printf("The %s of file %s is for another recording or incomplete, playing back without it.\n", name, autonFilename);
+    }
+    return loaded;
+}
+
+/**
+ * Reads the voltage file beside an autonomous file
+ *
+ * @param autonFilename The name of the autonomous file
+ * @param crc The CRC-32 of the autonomous file, which the voltage must have been recorded with
+ *
+ * @return the recorded voltage in millivolts, or 0 if there is none or it belongs to an older routine
+ */
+static unsigned int loadVoltage(const char* autonFilename, uint32_t crc) {
+    uint8_t voltage[AUTON_VOLTAGE_FILE_SIZE - AUTON_TRACK_HEADER_SIZE];
+    if (!loadCompanion(autonFilename, 'v', "battery voltage", crc, voltage, sizeof(voltage))) {
+        return 0;
+    }
+    return voltage[0] | (voltage[1] << 8);
+}
+
+/**
+ * Writes the contents of the states array to an open autonomous file.
+ *
+ * @param autonFile The file to write to
+ * @param filename The name of the file, used for logging
+ *
+ * @return true if every byte was written, false if the flash did not take one
+ */
+static bool writeStates(FILE* autonFile, const char* filename) {
+    signed char write[5];
+    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+        printf("Recording state %d to file %s...\n", i, filename);
+        write[0] = states[i].spd;
+        write[1] = states[i].horizontal;
+        write[2] = states[i].turn;
+        write[3] = states[i].sht;
+        write[4] = states[i].lift;
+
+        printf("Save State %d, Speed: %d %d %d %d %d\n", i, write[0], write[1], write[2], write[3], write[4]);
+        for (int j = 0; j < 5; j++) {
+            if (fwrite(write + j, sizeof(char), sizeof(char), autonFile) != 1) {
+                printf("Writing state %d to file %s failed!\n", i, filename);
+                return false;
+            }
+        }
+        delay(10);
+    }
+    return true;
+}
+
 /**
  * Saves contents of the states array to a file in flash memory.
  */
@@ -151,22 +553,16 @@ void saveAuton() {
         delay(1000);
         return;
     }
-    signed char write[5];
-    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-        printf("Recording state %d to file %s...\n", i, filename);
-        write[0] = states[i].spd;
-        write[1] = states[i].horizontal;
-        write[2] = states[i].turn;
-        write[3] = states[i].sht;
-        write[4] = states[i].lift;
-
-        printf("Save State %d, Speed: %d %d %d %d %d\n", i, write[0], write[1], write[2], write[3], write[4]);
-        for (int j = 0; j < 5; j++) {
-            fwrite(write + j, sizeof(char), sizeof(char), autonFile);
-        }
-        delay(10);
+    if (!writeStates(autonFile, filename)) {
+        // A truncated file would play back as a truncated routine, so do not leave one behind
+        fclose(autonFile);
+        fdelete(filename);
+        lcdSetText(LCD_PORT, 1, "Error saving!");
+        delay(1000);
+        return;
     }
     fclose(autonFile);
+    saveCompanions(filename);
     printf("Completed saving autonomous to file %s.\n", filename);
     lcdSetText(LCD_PORT, 1, "Saved auton!");
     if(autonSlot != MAX_AUTON_SLOTS + 1) {
@@ -187,88 +583,123 @@ void saveAuton() {
     autonLoaded = autonSlot;
 }
 
+/**
+ * Saves contents of the states array to the given slot without prompting for a selection
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if the states were saved, false otherwise
+ */
+bool saveAutonToSlot(int slot) {
+    char filename[AUTON_FILENAME_MAX_LENGTH + 1];
+    if (!getAutonFilename(slot, filename, sizeof(filename))) {
+        printf("Invalid autonomous selection.\n");
+        return false;
+    }
+    printf("Saving to file %s...\n", filename);
+    FILE* autonFile = fopen(filename, "w");
+    if (autonFile == NULL) {
+        printf("Error saving autonomous in file %s!\n", filename);
+        return false;
+    }
+    if (!writeStates(autonFile, filename)) {
+        fclose(autonFile);
+        fdelete(filename);
+        return false;
+    }
+    fclose(autonFile);
+    saveCompanions(filename);
+    printf("Completed saving autonomous to file %s.\n", filename);
+    if (slot > 0) {
+        autonLoaded = slot;
+    }
+    return true;
+}
+
 /**
  * Downloads a 15 second autonomous portion from the computer through the serial monitor
  *
  * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if a full autonomous was received and saved, false otherwise
  */
-void downloadAutonFromComputer(int slot) {
-    motorStopAll();
+bool downloadAutonFromComputer(int slot) {
+    motorFrameStopAll();
 
     char filename[AUTON_FILENAME_MAX_LENGTH + 1];
-    if (slot >= 1 && slot <= 10) {
-        snprintf(filename, sizeof(filename), "a%d", slot);
-    } else if (slot <= -1 && slot >= -4) {
-        snprintf(filename, sizeof(filename), "p%d", -slot - 1);
+    if (!getAutonFilename(slot, filename, sizeof(filename))) {
+        printf("Invalid autonomous selection.\n");
+        lcdSetText(LCD_PORT, 1, "Invalid slot!");
+        return false;
     }
 
     FILE* autonFile = fopen(filename, "w");
     if (autonFile == NULL) {
         printf("Writing to autonomous file failed. \n");
         lcdSetText(LCD_PORT, 1, "Failed to open!");
-        return;
-    } else {
-        printf("Please input the autonomous file fully in the serial input \n");
-        lcdSetText(LCD_PORT, 1, "Waiting for input...");
+        return false;
+    }
+    deleteAutonCompanions(slot);
+    printf("Please input the autonomous file fully in the serial input \n");
+    lcdSetText(LCD_PORT, 1, "Waiting for input...");
 
-        signed char read[5] = {0, 0, 0, 0, 0};
-        for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            lcdPrint(LCD_PORT, 2, "Pull state %d", i);
-            for (int j = 0; j < 5; j++) {
-                read[j] = getchar();
-                if (read[j] == -1) {//(fread(read + j, sizeof(char), sizeof(char), stdin) == 0) {
-                    printf("Not enough input for a full autonomous file, ending at state %d", i);
-                    fclose(autonFile);
-                    return;
-                }
+    // Bytes go straight from the serial buffer to flash one block at a time, so the loaded routine is untouched
+    char block[TRANSFER_TEXT_BLOCK_SIZE];
+    int size = AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE;
+    unsigned long timeout = TRANSFER_START_TIMEOUT;
+    for (int offset = 0; offset < size; offset += TRANSFER_TEXT_BLOCK_SIZE) {
+        int length = MIN(TRANSFER_TEXT_BLOCK_SIZE, size - offset);
+        for (int j = 0; j < length; j++) {
+            int c = serialReadByte(timeout);
+            if (c < 0) {
+                printf("Not enough input for a full autonomous file, ending at state %d\n", (offset + j) / AUTON_STATE_SIZE);
+                lcdSetText(LCD_PORT, 1, "Input ended!");
+                fclose(autonFile);
+                fdelete(filename);
+                return false;
             }
-            states[i].spd = (signed char) read[0];
-            states[i].horizontal = (signed char) read[1];
-            states[i].turn = (signed char) read[2];
-            states[i].sht = (signed char) read[3];
-            states[i].lift = (signed char) read[4];
-            delay(20);
+            block[j] = c;
+            timeout = TRANSFER_BYTE_TIMEOUT;
         }
-
-        lcdPrint(LCD_PORT, 1, "Writing to file...");
-        lcdSetText(LCD_PORT, 2, "");
-
-        signed char write[5];
-        for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            printf("Recording state %d to file %s...\n", i, filename);
-            write[0] = states[i].spd;
-            write[1] = states[i].horizontal;
-            write[2] = states[i].turn;
-            write[3] = states[i].sht;
-            write[4] = states[i].lift;
-
-            printf("Save State %d, Speed: %d %d %d %d %d\n", i, write[0], write[1], write[2], write[3], write[4]);
-            for (int j = 0; j < 5; j++) {
-                fwrite(write + j, sizeof(char), sizeof(char), autonFile);
-            }
-            delay(10);
+        if (fwrite(block, 1, length, autonFile) != length) {
+            printf("Writing to autonomous file failed. \n");
+            lcdSetText(LCD_PORT, 1, "Error saving!");
+            fclose(autonFile);
+            fdelete(filename);
+            return false;
         }
+        lcdPrint(LCD_PORT, 2, "Pull state %d", (offset + length) / AUTON_STATE_SIZE);
+    }
+    fclose(autonFile);
+
+    printf("Completed saving autonomous to file %s.\n", filename);
+    lcdSetText(LCD_PORT, 1, "Downloaded!");
+    if (slot == autonLoaded) {
+        printf("Slot %d is loaded; load it again to use the new file.\n", slot);
     }
+    return true;
 }
 
 /**
  * Uploads a 15 second autonomous portion to the computer through the serial monitor
  *
  * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if the autonomous was sent, false otherwise
  */
-void uploadAutonToComputer(int slot) {
+bool uploadAutonToComputer(int slot) {
     char filename[AUTON_FILENAME_MAX_LENGTH + 1];
-    if (slot >= 1 && slot <= 10) {
-        snprintf(filename, sizeof(filename), "a%d", slot);
-    } else if (slot <= -1 && slot >= -4) {
-        snprintf(filename, sizeof(filename), "p%d", -slot - 1);
+    if (!getAutonFilename(slot, filename, sizeof(filename))) {
+        printf("Invalid autonomous selection.\n");
+        lcdSetText(LCD_PORT, 1, "Invalid slot!");
+        return false;
     }
 
     FILE* autonFile = fopen(filename, "r");
     if (autonFile == NULL) {
         printf("Reading from autonomous file failed. \n");
         lcdSetText(LCD_PORT, 1, "Failed to open!");
-        return;
+        return false;
     } else {
         lcdSetText(LCD_PORT, 1, "Uploading...");
         lcdSetText(LCD_PORT, 2, "");
@@ -287,6 +718,7 @@ void uploadAutonToComputer(int slot) {
         printf("File ended.\n");
         fclose(autonFile);
     }
+    return true;
 }
 
 /**
@@ -426,27 +858,47 @@ void loadAuton(int autonSlot) {
         } else {
             printf("Doing programming skills, no auton in section 0!\n");
             lcdSetText(LCD_PORT, 1, "No skills saved!");
+            // Skills was marked as loaded above, but the states are still those of the last routine
+            autonLoaded = 0;
         }
         return;
     }
 
     fseek(autonFile, 0, SEEK_SET);
     signed char read[5];
+    uint32_t crc = 0;
     for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
         printf("Loading state %d from file %s...\n", i, filename);
         for (int j = 0; j < 5; j++) {
             fseek(autonFile, 5 * i + j, SEEK_SET);
-            fread(read + j, sizeof(char), sizeof(char), autonFile);
+            if (fread(read + j, sizeof(char), sizeof(char), autonFile) != 1) {
+                // A half loaded routine would play the rest of an older one, so load nothing instead
+                printf("Reading state %d from file %s failed!\n", i, filename);
+                lcdSetText(LCD_PORT, 1, "Load failed!");
+                fclose(autonFile);
+                memset(states, 0, sizeof(joyState) * AUTON_TIME * JOY_POLL_FREQ);
+                autonLoaded = 0;
+                trackLoaded = false;
+                autonVoltage = 0;
+                heightsLoaded = false;
+                headingsLoaded = false;
+                return;
+            }
         }
         states[i].spd = (signed char) read[0];
         states[i].horizontal = (signed char) read[1];
         states[i].turn = (signed char) read[2];
         states[i].sht = (signed char) read[3];
         states[i].lift = (signed char) read[4];
+        crc = frameCrc32(crc, (const uint8_t*) read, AUTON_STATE_SIZE);
         printf("Load State %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
         delay(10);
     }
     fclose(autonFile);
+    trackLoaded = loadCompanion(filename, 't', "wheel track", crc, tracks, sizeof(tracks));
+    autonVoltage = loadVoltage(filename, crc);
+    heightsLoaded = loadCompanion(filename, 'h', "lift heights", crc, heights, sizeof(heights));
+    headingsLoaded = loadCompanion(filename, 'g', "gyro headings", crc, headings, sizeof(headings));
     printf("Completed loading autonomous from file %s.\n", filename);
     lcdSetText(LCD_PORT, 1, "Loaded auton!");
     if(autonSlot != MAX_AUTON_SLOTS + 1){
@@ -459,6 +911,112 @@ void loadAuton(int autonSlot) {
     autonLoaded = autonSlot;
 }
 
+/**
+ * Drives the robot with one state of the states array, as playback does for each state.
+ *
+ * @param i The index of the state
+ */
+void playbackState(int i) {
+    // Give the motors the voltage they had while recording, whatever the battery has now
+    motorFrameSetScale(batteryScale(autonVoltage));
+    spd = states[i].spd;
+    horizontal = states[i].horizontal;
+    turn = states[i].turn;
+    sht = states[i].sht;
+    lift = states[i].lift;
+    printf("Playback State: %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
+    // As moveRobot(), but the lift can go to its recorded height, the drive can follow its track and
+    // the turn can be steered toward the recorded heading
+    joyState state = states[i];
+    // The last state of a section ramps toward itself, as the next section's first state is not known yet
+    joyState next = states[MIN(i + 1, AUTON_TIME * JOY_POLL_FREQ - 1)];
+    wheelTrack track = tracks[i];
+    if (headingsLoaded && headingHoldEnabled && gyroFound) {
+        int correction = headingCorrection(headingTarget);
+        int corrected = state.turn + correction;
+        state.turn = CLAMP(corrected, -127, 127);
+        corrected = next.turn + correction;
+        next.turn = CLAMP(corrected, -127, 127);
+        // The wheels that follow a track must be asked to turn further, or their loops undo the correction
+        driveTrackAddTurn(&track, correction);
+    }
+    if (headingsLoaded) {
+        headingTarget = headings[i];
+    }
+    controlLock();
+    // Without the lift loop a height setpoint would be ignored, so the recorded buttons drive the lift
+    if (heightsLoaded && liftControlled()) {
+        liftSetHeight(heights[i] * LIFT_HEIGHT_STEP);
+    } else {
+        liftDrive(lift);
+    }
+    setPincerMotors(sht);
+    if (playbackFollowing) {
+        driveTrackStep(&state, &track);
+    } else if (playbackInterpolating) {
+        driveInterpolateStep(&state, &next);
+    } else {
+        setDriveMotors(state.spd, state.horizontal, state.turn);
+        motorFrameCommit();
+    }
+    controlUnlock();
+}
+
+/**
+ * Starts or stops following the wheel track as playback moves on to a section of the routine.
+ *
+ * @param tracked Whether or not the tracks array holds the track of the section
+ */
+static void followSection(bool tracked) {
+    bool follow = tracked && closedLoopPlayback;
+    if (follow && !playbackFollowing) {
+        playbackFollowing = driveTrackStart();
+    } else if (!follow && playbackFollowing) {
+        driveTrackStop();
+        playbackFollowing = false;
+    }
+}
+
+/**
+ * Starts or stops interpolating the drive commands as playback moves on to a section of the routine or ends.
+ *
+ * @param interpolate Whether or not the section is to be played with interpolated drive commands
+ */
+static void interpolateSection(bool interpolate) {
+    if (interpolate && !playbackInterpolating) {
+        driveInterpolateStart();
+        playbackInterpolating = true;
+    } else if (!interpolate && playbackInterpolating) {
+        driveInterpolateStop();
+        playbackInterpolating = false;
+    }
+}
+
+/**
+ * Stops a playback that was left behind: its task was deleted, as the kernel deletes autonomous()
+ * at the end of its period, or the robot was disabled under it.
+ * The caller holds the control lock.
+ */
+static void clearStalePlayback() {
+    if (autonPlaying && playbackOwner != taskGetCurrent() &&
+            (!isEnabled() || taskGetState(playbackOwner) == TASK_DEAD)) {
+        stopPlayback();
+    }
+}
+
+/**
+ * Checks whether an autonomous routine is being played back, after stopping one that was left behind.
+ *
+ * @return true if a live task is playing back
+ */
+bool playbackActive() {
+    controlLock();
+    clearStalePlayback();
+    bool active = autonPlaying;
+    controlUnlock();
+    return active;
+}
+
 /**
  * Replays autonomous based on loaded values in states array.
  *
@@ -469,27 +1027,58 @@ void playbackAuton(int flipped) { //must load autonomous first!
         printf("autonLoaded = 0, doing nothing.\n");
         return;
     }
+    // Two playbacks would stream into the same states and controllers
+    controlLock();
+    clearStalePlayback();
+    bool busy = autonPlaying;
+    if (!busy) {
+        autonPlaying = true;
+        playbackOwner = taskGetCurrent();
+    }
+    controlUnlock();
+    if (busy) {
+        printf("Already playing back, doing nothing.\n");
+        return;
+    }
     printf("Beginning playback...\n");
     lcdSetText(LCD_PORT, 1, "Playing back...");
     lcdSetText(LCD_PORT, 2, "");
     lcdSetBacklight(LCD_PORT, true);
     int file = 0;
+    bool sectionTracked = trackLoaded;
+    // Every section is steered toward headings taken from where the routine started
+    headingZero();
+    odometryReset();
+    headingTarget = 0;
     do{
         FILE* nextFile = NULL;
+        FILE* nextTrack = NULL;
+        FILE* nextHeights = NULL;
+        FILE* nextHeadings = NULL;
+        uint32_t nextCrc = 0;
+        uint32_t nextTrackCrc = 0;
+        uint32_t nextHeightsCrc = 0;
+        uint32_t nextHeadingsCrc = 0;
         lcdPrint(LCD_PORT, 2, "File: %d", file+1);
         char filename[AUTON_FILENAME_MAX_LENGTH];
-        if(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1){
+        bool nextLoading = autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1;
+        if(nextLoading){
             printf("Next section: %d\n", file+1);
             snprintf(filename, sizeof(filename)/sizeof(char), "p%d", file+1);
             nextFile = fopen(filename, "r");
+            if (nextFile == NULL) {
+                printf("No autonomous was saved in file %s!\n", filename);
+            }
+            nextTrack = openCompanion(filename, 't', &nextTrackCrc);
+            nextHeights = openCompanion(filename, 'h', &nextHeightsCrc);
+            nextHeadings = openCompanion(filename, 'g', &nextHeadingsCrc);
         }
+        followSection(sectionTracked);
+        // A followed track already moves the wheels smoothly, so only open-loop sections are interpolated
+        interpolateSection(!playbackFollowing && driveInterpolation);
+        printf("Playing back section %d %s.\n", file+1, playbackFollowing ? "closed loop" : "open loop");
         for(int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            spd = states[i].spd;
-            horizontal = states[i].horizontal;
-            turn = states[i].turn;
-            sht = states[i].sht;
-            lift = states[i].lift;
-            printf("Playback State: %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
+            playbackState(i);
             if (joystickGetDigital(1, 7, JOY_UP) && !isOnline()) {
                 printf("Playback manually cancelled.\n");
                 lcdSetText(LCD_PORT, 1, "Cancelled playback.");
@@ -497,33 +1086,134 @@ void playbackAuton(int flipped) { //must load autonomous first!
                 i = AUTON_TIME * JOY_POLL_FREQ;
                 file = PROGSKILL_TIME/AUTON_TIME;
             }
-            moveRobot();
-            if(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1){
+            // stopPlayback() was called by another task, which has the motors now
+            if (!autonPlaying) {
+                printf("Playback stopped.\n");
+                i = AUTON_TIME * JOY_POLL_FREQ;
+                file = PROGSKILL_TIME/AUTON_TIME;
+            }
+            // A cancelled playback has moved i past the last state
+            if (nextFile != NULL && i < AUTON_TIME * JOY_POLL_FREQ) {
                 printf("Loading state %d from file %s...\n", i, filename);
 
                 char read[5] = {0, 0, 0, 0, 0};
-                for (int j = 0; j < 5; j++) {
+                bool stateRead = true;
+                for (int j = 0; j < 5 && stateRead; j++) {
                     fseek(nextFile, 5 * i + j, SEEK_SET);
-                    fread(read + j, sizeof(char), sizeof(char), nextFile);
+                    stateRead = fread(read + j, sizeof(char), sizeof(char), nextFile) == 1;
+                }
+                if (!stateRead) {
+                    printf("Reading state %d from file %s failed!\n", i, filename);
+                    fclose(nextFile);
+                    nextFile = NULL;
+                } else {
+                    states[i].spd = (signed char) read[0];
+                    states[i].horizontal = (signed char) read[1];
+                    states[i].turn = (signed char) read[2];
+                    states[i].sht = (signed char) read[3];
+                    states[i].lift = (signed char) read[4];
+                    nextCrc = frameCrc32(nextCrc, (const uint8_t*) read, AUTON_STATE_SIZE);
+                    printf("Load State %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
+                    // The track of this state has been handed to the control task, so it can be replaced too
+                    if (nextTrack != NULL && fread(tracks[i].wheel, 1, AUTON_TRACK_SIZE, nextTrack) != AUTON_TRACK_SIZE) {
+                        fclose(nextTrack);
+                        nextTrack = NULL;
+                    }
+                    if (nextHeights != NULL && fread(&heights[i], 1, AUTON_HEIGHT_SIZE, nextHeights) != AUTON_HEIGHT_SIZE) {
+                        fclose(nextHeights);
+                        nextHeights = NULL;
+                    }
+                    if (nextHeadings != NULL && fread(&headings[i], 1, AUTON_HEADING_SIZE, nextHeadings) != AUTON_HEADING_SIZE) {
+                        fclose(nextHeadings);
+                        nextHeadings = NULL;
+                    }
                 }
-                states[i].spd = (signed char) read[0];
-                states[i].horizontal = (signed char) read[1];
-                states[i].turn = (signed char) read[2];
-                states[i].sht = (signed char) read[3];
-                states[i].lift = (signed char) read[4];
-                printf("Load State %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
             }
             delay(1000 / JOY_POLL_FREQ);
         }
-        if(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1){
+        if (nextLoading && nextFile == NULL) {
+            // The next section could not be read whole, and part of it may be in the states array, so the
+            // routine stops here and nothing is left loaded, as when loadAuton() fails
+            printf("Could not load section %d, stopping.\n", file+2);
+            memset(states, 0, sizeof(joyState) * AUTON_TIME * JOY_POLL_FREQ);
+            autonLoaded = 0;
+            trackLoaded = false;
+            autonVoltage = 0;
+            heightsLoaded = false;
+            headingsLoaded = false;
+        } else if (nextLoading) {
             printf("Finished with section %d, closing file.\n", file+1);
             fclose(nextFile);
+            // Only now has the whole next section been read, so only now can its track be checked
+            sectionTracked = nextTrack != NULL && nextCrc == nextTrackCrc;
+            trackLoaded = sectionTracked;
+            autonVoltage = loadVoltage(filename, nextCrc);
+            heightsLoaded = nextHeights != NULL && nextCrc == nextHeightsCrc;
+            headingsLoaded = nextHeadings != NULL && nextCrc == nextHeadingsCrc;
+        }
+        if (nextTrack != NULL) {
+            fclose(nextTrack);
+        }
+        if (nextHeights != NULL) {
+            fclose(nextHeights);
+        }
+        if (nextHeadings != NULL) {
+            fclose(nextHeadings);
         }
         file++;
     } while(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME);
-    motorStopAll();
+    followSection(false);
+    interpolateSection(false);
+    if (!autonPlaying) {
+        // Whoever stopped the playback has the motors now
+        return;
+    }
+    motorFrameSetScale(FIXED_ONE);
+    motorFrameStopAll();
     printf("Completed playback.\n");
     lcdSetText(LCD_PORT, 1, "Played back!");
     lcdSetText(LCD_PORT, 2, "");
     delay(1000);
+    stopPlayback();
+}
+
+/**
+ * Ends any playback: stops the drive controllers, takes the battery scale off the motors and
+ * clears autonPlaying. The kernel kills autonomous() at the end of its period wherever it is, so
+ * operatorControl() calls this before taking over the motors; a playback still running in
+ * another task stops at its next state.
+ */
+void stopPlayback() {
+    driveTrackStop();
+    playbackFollowing = false;
+    driveInterpolateStop();
+    playbackInterpolating = false;
+    motorFrameSetScale(FIXED_ONE);
+    autonPlaying = false;
+    playbackOwner = NULL;
+}
+
+/**
+ * Prints information about the loaded autonomous routine to the serial monitor
+ */
+void printAutonStats() {
+    int activeStates = 0;
+    int lastActive = -1;
+    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
+        if (states[i].spd != 0 || states[i].horizontal != 0 || states[i].turn != 0 ||
+                states[i].sht != 0 || states[i].lift != 0) {
+            activeStates++;
+            lastActive = i;
+        }
+    }
+    printf("Loaded slot: %d\n", autonLoaded);
+    printf("Flipped: %d\n", autonFlipped);
+    printf("Skills section: %d\n", progSkills);
+    printf("Playing: %d\n", autonPlaying);
+    printf("Wheel track loaded: %d\n", trackLoaded);
+    printf("Recorded battery voltage: %u mV\n", autonVoltage);
+    printf("Lift heights loaded: %d\n", heightsLoaded);
+    printf("Gyro headings loaded: %d\n", headingsLoaded);
+    printf("Active states: %d/%d\n", activeStates, AUTON_TIME * JOY_POLL_FREQ);
+    printf("Last active state: %d (%d ms)\n", lastActive, (lastActive + 1) * 1000 / JOY_POLL_FREQ);
 }
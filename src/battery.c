@@ -0,0 +1,84 @@
+/** @file battery.c
+ * @brief File for battery-voltage compensation of played back motor commands
+ */
+
+#include "main.h"
+
+bool batteryCompensation = true;
+
+/**
+ * The sum that the filter keeps, BATTERY_FILTER_SAMPLES times the filtered voltage in millivolts,
+ * or 0 before the first sample
+ */
+static unsigned long filterSum = 0;
+
+/**
+ * Adds a reading of the main battery to the filtered voltage
+ * Run by the control task every CONTROL_PERIOD milliseconds.
+ */
+void batteryUpdate() {
+	unsigned int reading = powerLevelMain();
+	if (filterSum == 0) {
+		filterSum = (unsigned long) reading * BATTERY_FILTER_SAMPLES;
+	} else {
+		// Each sample replaces an average one, which makes an exponential moving average
+		filterSum = filterSum - filterSum / BATTERY_FILTER_SAMPLES + reading;
+	}
+}
+
+/**
+ * Gets the filtered voltage of the main battery
+ *
+ * @return the voltage in millivolts, or the last reading if the control task has not sampled it yet
+ */
+unsigned int batteryVoltage() {
+	if (filterSum == 0) {
+		return powerLevelMain();
+	}
+	return filterSum / BATTERY_FILTER_SAMPLES;
+}
+
+/**
+ * Gets the scale that makes the motors see the voltage that they saw while a routine was recorded
+ *
+ * @param recordedMillivolts The average voltage while the routine was recorded, or 0 if it is not known
+ *
+ * @return the recorded voltage over the filtered voltage, clamped to BATTERY_SCALE_MIN - BATTERY_SCALE_MAX,
+ * or FIXED_ONE if compensation is off or either voltage is not known
+ */
+fixed batteryScale(unsigned int recordedMillivolts) {
+	unsigned int millivolts = batteryVoltage();
+	if (!batteryCompensation || recordedMillivolts == 0 || millivolts == 0) {
+		return FIXED_ONE;
+	}
+	return CLAMP(fixedFromRatio(recordedMillivolts, millivolts), BATTERY_SCALE_MIN, BATTERY_SCALE_MAX);
+}
+
+/**
+ * Scales a motor command for the battery, so that the motor gets the share of the voltage it was recorded with
+ *
+ * @param command The command, from -127 to 127
+ * @param scale The scale from batteryScale()
+ *
+ * @return the scaled command, or the command itself if scale is FIXED_ONE
+ */
+int batteryScaleCommand(int command, fixed scale) {
+	if (scale == FIXED_ONE) {
+		return command;
+	}
+	int magnitude = (command < 0) ? -command : command;
+	magnitude = MIN(fixedScale(MIN(magnitude, BATTERY_FULL_COMMAND), scale), 127);
+	return (command < 0) ? -magnitude : magnitude;
+}
+
+/**
+ * Prints whether compensation is on, the filtered voltage and the scale for the loaded routine
+ */
+void printBatteryStats() {
+	char now[12], recorded[12], scale[12];
+	formatDecimal(now, sizeof(now), batteryVoltage(), 3);
+	formatDecimal(recorded, sizeof(recorded), autonVoltage, 3);
+	fixedFormat(scale, sizeof(scale), batteryScale(autonVoltage), 3);
+	printf("Battery compensation: %s, battery: %s V, recorded: %s V, scale: %s\n", batteryCompensation ? "on" : "off",
+			now, recorded, scale);
+}
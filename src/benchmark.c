@@ -0,0 +1,175 @@
+/** @file benchmark.c
+ * @brief File for timing the functions that run every tick of the robot program
+ *
+ * Contains the list of functions to time, the timing loop shared by the Cortex and the computer,
+ * and the LCD menu function that times them on the Cortex. Each function is called in a way that
+ * leaves the motors stopped, so the benchmark can be run with the robot on the ground.
+ */
+
+#include "main.h"
+
+/**
+ * Where the results of timed functions go, so that the compiler cannot leave the calls out
+ */
+static volatile int benchSink;
+
+/**
+ * Input to the input curve case, volatile so that the compiler cannot work the result out beforehand
+ */
+static volatile int benchInput = 100;
+
+/**
+ * Reads one joystick axis, as recordJoyInfo() does up to six times
+ */
+static void benchJoystick() {
+	benchSink = joystickGetAnalog(1, 4);
+}
+
+/**
+ * Applies the input curve of recordJoyInfo() to the horizontal axis
+ */
+static void benchInputCurve() {
+	benchSink = INPUT_SHAPE(horizontalCurve, benchInput);
+}
+
+/**
+ * Sets one motor
+ */
+static void benchMotorSet() {
+	motorSet(FRONT_LEFT_MOTOR, 0);
+}
+
+/**
+ * Sets the drive motors
+ */
+static void benchSetDriveMotors() {
+	setDriveMotors(0, 0, 0);
+}
+
+/**
+ * Sets every motor from the joystick globals
+ */
+static void benchMoveRobot() {
+	spd = horizontal = turn = sht = lift = 0;
+	moveRobot();
+}
+
+/**
+ * Redraws the LCD menu
+ */
+static void benchUpdateLCDMenu() {
+	updateLCDMenu(20);
+}
+
+/**
+ * Plays one state of an autonomous routine, with the loaded routine's first state replaced by a stopped one
+ * and its heights and headings left out, so that the lift is not sent to a recorded height and the
+ * robot is not turned toward a recorded heading
+ */
+static void benchPlaybackState() {
+	joyState saved = states[0];
+	bool savedHeights = heightsLoaded, savedHeadings = headingsLoaded;
+	int savedSpd = spd, savedHorizontal = horizontal, savedTurn = turn, savedSht = sht, savedLift = lift;
+	states[0] = (joyState) { 0, 0, 0, 0, 0 };
+	heightsLoaded = headingsLoaded = false;
+	playbackState(0);
+	states[0] = saved;
+	heightsLoaded = savedHeights;
+	headingsLoaded = savedHeadings;
+	spd = savedSpd;
+	horizontal = savedHorizontal;
+	turn = savedTurn;
+	sht = savedSht;
+	lift = savedLift;
+	// Playback scales every command by the loaded routine's voltage until it is stopped, and the
+	// benchmark runs in operator control
+	motorFrameSetScale(FIXED_ONE);
+}
+
+const bench_case benchCases[BENCH_CASES] = {
+	{ "recordJoyInfo", &recordJoyInfo, 2000 },
+	{ "joystickGetAnalog", &benchJoystick, 20000 },
+	{ "inputCurve", &benchInputCurve, 50000 },
+	{ "motorSet", &benchMotorSet, 50000 },
+	{ "setDriveMotors", &benchSetDriveMotors, 20000 },
+	{ "moveRobot", &benchMoveRobot, 10000 },
+	{ "updateLCDMenu", &benchUpdateLCDMenu, 100 },
+	{ "playbackState", &benchPlaybackState, 20 },
+};
+
+/**
+ * Times a function
+ *
+ * @param benchCase The function
+ * @param calls The number of calls per round
+ * @param clock Gets the current time in nanoseconds
+ * @param result Set to the time per call
+ */
+void benchMeasure(const bench_case* benchCase, unsigned int calls, uint64_t (*clock)(), bench_result* result) {
+	uint32_t rounds[BENCH_ROUNDS];
+	uint64_t sum = 0;
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		uint64_t start = clock();
+		for (unsigned int i = 0; i < calls; i++) {
+			benchCase->run();
+		}
+		rounds[round] = roundDivide64((clock() - start) * 10, calls);
+		if (round == 0 || rounds[round] < result->min) {
+			result->min = rounds[round];
+		}
+		if (round == 0 || rounds[round] > result->max) {
+			result->max = rounds[round];
+		}
+		sum += rounds[round];
+	}
+	result->mean = roundDivide64(sum, BENCH_ROUNDS);
+
+	uint64_t squares = 0;
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		int64_t difference = (int64_t) rounds[round] - result->mean;
+		squares += difference * difference;
+	}
+	result->deviation = intSqrt(squares / BENCH_ROUNDS);
+}
+
+/**
+ * Gets the time on the Cortex
+ *
+ * @return the time since the Cortex started in nanoseconds (in steps of a microsecond)
+ */
+static uint64_t targetClock() {
+	return micros() * 1000ULL;
+}
+
+/**
+ * Times every function in benchCases on the Cortex, showing each result on the LCD and printing
+ * them all to the serial monitor, then waits for an LCD button
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void runBenchmarks(int index) {
+	delay(500);
+	printf("Benchmark: %d rounds of each function\n", BENCH_ROUNDS);
+	printf("%-18s %7s %12s %12s %12s %12s\n", "function", "calls", "ns/call", "deviation", "min", "max");
+	for (int i = 0; i < BENCH_CASES; i++) {
+		const bench_case* benchCase = &benchCases[i];
+		lcdSetText(LCD_PORT, 1, benchCase->name);
+		lcdSetText(LCD_PORT, 2, "Timing...");
+		bench_result result;
+		benchMeasure(benchCase, benchCase->targetCalls, &targetClock, &result);
+		char mean[16], deviation[16], min[16], max[16];
+		formatDecimal(mean, sizeof(mean), result.mean, 1);
+		formatDecimal(deviation, sizeof(deviation), result.deviation, 1);
+		formatDecimal(min, sizeof(min), result.min, 1);
+		formatDecimal(max, sizeof(max), result.max, 1);
+		printf("%-18s %7u %12s %12s %12s %12s\n", benchCase->name, benchCase->targetCalls, mean, deviation, min, max);
+		lcdPrint(LCD_PORT, 2, "%s ns", mean);
+		delay(1000);
+	}
+	motorFrameInvalidate();
+	lcdSetText(LCD_PORT, 1, "Benchmark done");
+	lcdSetText(LCD_PORT, 2, "Results on serial");
+	while (lcdReadButtons(LCD_PORT) == 0) {
+		delay(20);
+	}
+}
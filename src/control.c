@@ -0,0 +1,52 @@
+/** @file control.c
+ * @brief File for the control task, which runs the feedback loops of the robot at a fixed rate
+ */
+
+#include "main.h"
+
+/**
+ * Runs the controllers every CONTROL_PERIOD milliseconds
+ *
+ * @param parameters Unused task parameter
+ */
+static void controlTask(void* parameters) {
+	unsigned long wakeTime = millis();
+	while (true) {
+		batteryUpdate();
+		controlLock();
+		// Every controller runs, and the motors each of them staged go out in one frame
+		bool staged = liftUpdate();
+		staged |= driveTrackUpdate();
+		staged |= driveInterpolateUpdate();
+		if (staged) {
+			motorFrameCommit();
+		}
+		controlUnlock();
+		taskDelayUntil(&wakeTime, CONTROL_PERIOD);
+	}
+}
+
+/**
+ * Finds the sensors of the controllers and starts the control task
+ */
+void initControl() {
+	initDriveEncoders();
+	initLift();
+	initHeading();
+	initOdometry();
+	taskCreate(controlTask, TASK_DEFAULT_STACK_SIZE, NULL, CONTROL_TASK_PRIORITY);
+}
+
+/**
+ * Keeps the control task (and every other task) from running until controlUnlock()
+ */
+void controlLock() {
+	taskSuspendAll();
+}
+
+/**
+ * Lets the control task run again
+ */
+void controlUnlock() {
+	taskResumeAll();
+}
@@ -0,0 +1,106 @@
+/** @file driveInterpolate.c
+ * @brief File for the interpolated drive output of open-loop playback
+ */
+
+#include "main.h"
+
+bool driveInterpolation = true;
+
+/**
+ * Whether or not playback is interpolating
+ */
+static bool interpolating = false;
+
+/**
+ * The state played before the current one, the current one and the one to be played after it
+ */
+static joyState previous;
+static joyState current;
+static joyState following;
+
+/**
+ * The time in milliseconds at which the current state started
+ */
+static unsigned long stateTime;
+
+/**
+ * Interpolates one command of the current state
+ *
+ * @param last The command of the state before
+ * @param now The command of the current state
+ * @param next The command of the state after
+ * @param elapsed The milliseconds since the current state started, up to 1000 / JOY_POLL_FREQ
+ *
+ * @return the command for the time, on the line through the states' commands at the middles of their periods
+ */
+static int interpolate(int last, int now, int next, int elapsed) {
+	int statePeriod = 1000 / JOY_POLL_FREQ;
+	if (elapsed < statePeriod / 2) {
+		return last + roundDivide((now - last) * (elapsed + statePeriod / 2), statePeriod);
+	}
+	return now + roundDivide((next - now) * (elapsed - statePeriod / 2), statePeriod);
+}
+
+/**
+ * Stages the drive motors with the commands for the time now
+ * The caller holds the control lock.
+ */
+static void stageDrive() {
+	int statePeriod = 1000 / JOY_POLL_FREQ;
+	int elapsed = MIN(millis() - stateTime, (unsigned long) statePeriod);
+	setDriveMotors(interpolate(previous.spd, current.spd, following.spd, elapsed),
+			interpolate(previous.horizontal, current.horizontal, following.horizontal, elapsed),
+			interpolate(previous.turn, current.turn, following.turn, elapsed));
+}
+
+/**
+ * Starts interpolating from a stopped drive, as playback does before its first state
+ */
+void driveInterpolateStart() {
+	controlLock();
+	previous = current = following = (joyState) { 0, 0, 0, 0, 0 };
+	stateTime = millis();
+	interpolating = true;
+	controlUnlock();
+}
+
+/**
+ * Moves on to the next state: over the next 1000 / JOY_POLL_FREQ milliseconds the drive commands
+ * move from halfway between the last state and this one, to this one, to halfway between this one
+ * and the next. The drive motors are staged for the start of the state and the motor frame is
+ * committed straight away, so motors staged by the caller change at the same time. The caller
+ * holds the control lock.
+ *
+ * @param state The joystick state to play now
+ * @param next The joystick state that will be played after it
+ */
+void driveInterpolateStep(const joyState* state, const joyState* next) {
+	previous = current;
+	current = *state;
+	following = *next;
+	stateTime = millis();
+	stageDrive();
+	motorFrameCommit();
+}
+
+/**
+ * Stops interpolating; the drive motors keep their last values until something else sets them
+ */
+void driveInterpolateStop() {
+	controlLock();
+	interpolating = false;
+	controlUnlock();
+}
+
+/**
+ * Stages the drive motors with the interpolated commands for the time now, if playback is interpolating
+ * Run by the control task every CONTROL_PERIOD milliseconds while it holds the control lock.
+ *
+ * @return true if the drive motors were staged, false otherwise
+ */
+bool driveInterpolateUpdate() {
+	if (interpolating) {
+		stageDrive();
+	}
+	return interpolating;
+}
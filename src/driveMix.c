@@ -0,0 +1,67 @@
+/** @file driveMix.c
+ * @brief File for mixing the drive commands into mecanum wheel powers
+ */
+
+#include "main.h"
+#include <string.h>
+
+drive_mix_stats driveMixStats;
+
+/**
+ * Mixes the drive commands into the power of each drive motor, with the motor directions of the robot applied
+ *
+ * @param forward The forward command
+ * @param horizontal The strafing command, positive to the right
+ * @param turn The turning command, positive clockwise
+ * @param turnPriority true to scale only the translation when a wheel saturates, false to scale everything
+ * @param powers Set to the power of each motor, indexed by DRIVE_FRONT_LEFT and the others, each within DRIVE_MAX_POWER
+ */
+void mixDrive(int forward, int horizontal, int turn, bool turnPriority, int powers[DRIVE_WHEELS]) {
+	// The front motors are mounted the other way around, hence the signs
+	int translation[DRIVE_WHEELS] = { -(forward + horizontal), forward - horizontal, forward - horizontal, -forward - horizontal };
+	turn = CLAMP(turn, -DRIVE_MAX_POWER, DRIVE_MAX_POWER);
+	int rotation[DRIVE_WHEELS] = { -turn, -turn, turn, turn };
+
+	int peak = 0;
+	int translationPeak = 0;
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		peak = MAX(peak, abs(translation[i] + rotation[i]));
+		translationPeak = MAX(translationPeak, abs(translation[i]));
+	}
+	driveMixStats.mixes++;
+	if (peak <= DRIVE_MAX_POWER) {
+		for (int i = 0; i < DRIVE_WHEELS; i++) {
+			powers[i] = translation[i] + rotation[i];
+		}
+		return;
+	}
+	driveMixStats.saturated++;
+
+	if (turnPriority) {
+		// Whatever the turn leaves of the range goes to the translation
+		int room = DRIVE_MAX_POWER - abs(turn);
+		for (int i = 0; i < DRIVE_WHEELS; i++) {
+			int scaled = (translationPeak > room) ? roundDivide(translation[i] * room, translationPeak) : translation[i];
+			powers[i] = scaled + rotation[i];
+		}
+	} else {
+		for (int i = 0; i < DRIVE_WHEELS; i++) {
+			powers[i] = roundDivide((translation[i] + rotation[i]) * DRIVE_MAX_POWER, peak);
+		}
+	}
+}
+
+/**
+ * Sets the counters back to zero
+ */
+void driveMixStatsReset() {
+	memset(&driveMixStats, 0, sizeof(driveMixStats));
+}
+
+/**
+ * Prints the counters to the serial monitor
+ */
+void printDriveMixStats() {
+	printf("Drive commands: %lu, saturated: %lu (%lu%%)\n", driveMixStats.mixes, driveMixStats.saturated,
+			(driveMixStats.mixes == 0) ? 0 : driveMixStats.saturated * 100 / driveMixStats.mixes);
+}
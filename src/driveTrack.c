@@ -0,0 +1,216 @@
+/** @file driveTrack.c
+ * @brief File for closed-loop playback, which makes the drive wheels follow their recorded positions
+ */
+
+#include "main.h"
+#include <string.h>
+
+drive_track_stats driveTrackStats;
+
+bool driveEncoders = false;
+
+bool closedLoopPlayback = true;
+
+/**
+ * The IME of each wheel, in the order of mixDrive()
+ */
+static const unsigned char wheelImes[DRIVE_WHEELS] = { FRONT_LEFT_IME, FRONT_RIGHT_IME, BACK_LEFT_IME, BACK_RIGHT_IME };
+
+/**
+ * The motor of each wheel, in the order of mixDrive()
+ */
+static const unsigned char wheelMotors[DRIVE_WHEELS] = { FRONT_LEFT_MOTOR, FRONT_RIGHT_MOTOR, BACK_LEFT_MOTOR, BACK_RIGHT_MOTOR };
+
+/**
+ * The loop of each wheel
+ */
+static pid_controller wheelPids[DRIVE_WHEELS];
+
+/**
+ * Whether or not a track is being followed
+ */
+static bool tracking = false;
+
+/**
+ * The count each wheel is to be at when the current state starts
+ */
+static long stateStart[DRIVE_WHEELS];
+
+/**
+ * The counts each wheel is to turn during the current state
+ */
+static int stateTurn[DRIVE_WHEELS];
+
+/**
+ * The time in milliseconds at which the current state started
+ */
+static unsigned long stateTime;
+
+/**
+ * The power of each wheel from the current state's joystick values
+ */
+static int feedforward[DRIVE_WHEELS];
+
+/**
+ * Starts the IMEs and checks that the four drive IMEs answer
+ * Called by initControl().
+ */
+void initDriveEncoders() {
+	unsigned int found = imeInitializeAll();
+	driveEncoders = found >= DRIVE_WHEELS;
+	printf("Found %u IMEs, %s.\n", found, driveEncoders ? "wheel tracks are recorded" : "playback is open loop");
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		pidInit(&wheelPids[i], DRIVE_TRACK_KP, DRIVE_TRACK_KI, DRIVE_TRACK_KD, DRIVE_TRACK_INTEGRAL_LIMIT);
+	}
+}
+
+/**
+ * Reads the four drive IMEs
+ *
+ * @param counts Set to the count of each wheel, in the order of mixDrive()
+ *
+ * @return true if every IME was read, false otherwise
+ */
+bool readDriveEncoders(int counts[DRIVE_WHEELS]) {
+	if (!driveEncoders) {
+		return false;
+	}
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		if (!imeGet(wheelImes[i], &counts[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Drives each wheel with its feedforward and the correction from its loop, staging the drive motors
+ * The caller holds the control lock.
+ */
+static void followTrack() {
+	int counts[DRIVE_WHEELS];
+	bool read = readDriveEncoders(counts);
+	int statePeriod = 1000 / JOY_POLL_FREQ;
+	int elapsed = MIN(millis() - stateTime, (unsigned long) statePeriod);
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		int power = feedforward[i];
+		if (read) {
+			long target = stateStart[i] + roundDivide(stateTurn[i] * elapsed, statePeriod);
+			int error = target - counts[i];
+			power += pidUpdate(&wheelPids[i], error);
+			error = (error < 0) ? -error : error;
+			driveTrackStats.errorSum += error;
+			driveTrackStats.maxError = MAX(driveTrackStats.maxError, error);
+		}
+		// The feedforward already has the battery scale; the correction must not be scaled (and capped) again
+		motorFrameSetExact(wheelMotors[i], power);
+	}
+	driveTrackStats.updates++;
+	if (!read) {
+		driveTrackStats.readFailures++;
+	}
+}
+
+/**
+ * Starts following a track from where the wheels are now
+ *
+ * @return true if the wheels are being followed, false if the IMEs could not be read
+ */
+bool driveTrackStart() {
+	int counts[DRIVE_WHEELS];
+	controlLock();
+	tracking = readDriveEncoders(counts);
+	if (tracking) {
+		for (int i = 0; i < DRIVE_WHEELS; i++) {
+			stateStart[i] = counts[i];
+			stateTurn[i] = 0;
+			feedforward[i] = 0;
+			pidReset(&wheelPids[i]);
+		}
+		stateTime = millis();
+	}
+	controlUnlock();
+	return tracking;
+}
+
+/**
+ * Moves on to the next state of the track: the wheels are to turn by the recorded amounts over
+ * the next 1000 / JOY_POLL_FREQ milliseconds, with the state's joystick values as the feedforward.
+ * The wheels are driven and the motor frame committed straight away, so motors staged by the
+ * caller (the lift and pincer) change at the same time. The caller holds the control lock.
+ *
+ * @param state The joystick state
+ * @param track How far each wheel turned while the state was recorded
+ */
+void driveTrackStep(const joyState* state, const wheelTrack* track) {
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		// The next state starts where this one was to end, however far the wheel really got
+		stateStart[i] += stateTurn[i];
+		stateTurn[i] = track->wheel[i];
+	}
+	stateTime = millis();
+	mixDrive(state->spd, state->horizontal, state->turn, DRIVE_TURN_PRIORITY, feedforward);
+	fixed scale = batteryScale(autonVoltage);
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		feedforward[i] = batteryScaleCommand(feedforward[i], scale);
+	}
+	followTrack();
+	motorFrameCommit();
+}
+
+/**
+ * Adds a turn to a state of a track, so that following it turns the robot as the turn command would
+ * (headingHold.h steers the robot this way when it has slipped off its recorded heading)
+ *
+ * @param track The state of the track
+ * @param turn The turn command to add, positive clockwise
+ */
+void driveTrackAddTurn(wheelTrack* track, int turn) {
+	int powers[DRIVE_WHEELS];
+	mixDrive(0, 0, turn, false, powers);
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		int counts = track->wheel[i] + roundDivide(powers[i], DRIVE_TRACK_TURN_PER_COUNT);
+		track->wheel[i] = CLAMP(counts, -127, 127);
+	}
+}
+
+/**
+ * Stops following the track; the drive motors keep their last values until something else sets them
+ */
+void driveTrackStop() {
+	controlLock();
+	tracking = false;
+	controlUnlock();
+}
+
+/**
+ * Drives the wheels toward their tracks if one is being followed, staging the drive motors
+ * Run by the control task every CONTROL_PERIOD milliseconds while it holds the control lock.
+ *
+ * @return true if the drive motors were staged, false otherwise
+ */
+bool driveTrackUpdate() {
+	if (tracking) {
+		followTrack();
+	}
+	return tracking;
+}
+
+/**
+ * Sets every counter back to zero
+ */
+void driveTrackStatsReset() {
+	memset(&driveTrackStats, 0, sizeof(driveTrackStats));
+}
+
+/**
+ * Prints whether closed-loop playback is on and how closely the wheels have followed their tracks
+ */
+void printDriveTrackStats() {
+	unsigned long samples = (driveTrackStats.updates - driveTrackStats.readFailures) * DRIVE_WHEELS;
+	printf("Closed-loop playback: %s, IMEs: %s, track loaded: %s\n", closedLoopPlayback ? "on" : "off",
+			driveEncoders ? "yes" : "no", trackLoaded ? "yes" : "no");
+	printf("Track updates: %lu, read failures: %lu, mean error: %lu counts, max error: %d counts\n",
+			driveTrackStats.updates, driveTrackStats.readFailures, (samples == 0) ? 0 : driveTrackStats.errorSum / samples,
+			driveTrackStats.maxError);
+}
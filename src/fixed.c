@@ -0,0 +1,251 @@
+/** @file fixed.c
+ * @brief File for fixed-point arithmetic
+ *
+ * Products are worked out in 64 bits, which the Cortex-M3 multiplies in one instruction, and are
+ * brought back to 16 fraction bits with a rounded shift. The Cortex-M3 has no 64-bit divide, so
+ * roundDivide64() is a call into the runtime library and is kept out of the functions that run every tick.
+ */
+
+#include "main.h"
+
+/**
+ * Divides two integers, rounding to the nearest integer (halves away from zero)
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, which must not be zero
+ *
+ * @return the rounded quotient
+ */
+long roundDivide(long numerator, long denominator) {
+	if ((numerator < 0) == (denominator < 0)) {
+		return (numerator + denominator / 2) / denominator;
+	}
+	return (numerator - denominator / 2) / denominator;
+}
+
+/**
+ * Divides two 64-bit integers as roundDivide() does, for numerators that do not fit in 32 bits
+ * This is a call into the runtime library on the Cortex-M3, tens of cycles long.
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, which must not be zero
+ *
+ * @return the rounded quotient
+ */
+int64_t roundDivide64(int64_t numerator, int64_t denominator) {
+	if ((numerator < 0) == (denominator < 0)) {
+		return (numerator + denominator / 2) / denominator;
+	}
+	return (numerator - denominator / 2) / denominator;
+}
+
+/**
+ * Divides a product of fixed values by FIXED_ONE, rounding as roundDivide() does
+ *
+ * @param value The product, with 32 fraction bits
+ *
+ * @return the product with 16 fraction bits
+ */
+static int32_t fixedRound(int64_t value) {
+	// A shift rounds toward minus infinity, so a negative value is rounded by its magnitude to keep halves away from zero
+	if (value < 0) {
+		return -((-value + FIXED_ONE / 2) >> FIXED_SHIFT);
+	}
+	return (value + FIXED_ONE / 2) >> FIXED_SHIFT;
+}
+
+/**
+ * Multiplies two fixed values, rounding to the nearest step
+ *
+ * @param a The first value
+ * @param b The second value
+ *
+ * @return the product
+ */
+fixed fixedMul(fixed a, fixed b) {
+	return fixedRound((int64_t) a * b);
+}
+
+/**
+ * Divides two fixed values, rounding to the nearest step
+ *
+ * @param a The dividend
+ * @param b The divisor, which must not be zero
+ *
+ * @return the quotient
+ */
+fixed fixedDiv(fixed a, fixed b) {
+	return roundDivide64((int64_t) a * FIXED_ONE, b);
+}
+
+/**
+ * Makes a fixed value from a ratio of integers, such as millivolts over 1000
+ *
+ * @param numerator The numerator
+ * @param denominator The denominator, which must not be zero
+ *
+ * @return the ratio, rounded to the nearest step
+ */
+fixed fixedFromRatio(long numerator, long denominator) {
+	return roundDivide64((int64_t) numerator * FIXED_ONE, denominator);
+}
+
+/**
+ * Rounds a fixed value to the nearest integer (halves away from zero)
+ *
+ * @param value The fixed value
+ *
+ * @return the integer
+ */
+int fixedToInt(fixed value) {
+	return fixedRound(value);
+}
+
+/**
+ * Multiplies an integer by a fixed value, such as a motor power by a gain
+ *
+ * @param value The integer
+ * @param scale The fixed value
+ *
+ * @return the product, rounded to the nearest integer
+ */
+int fixedScale(int value, fixed scale) {
+	return fixedRound((int64_t) value * scale);
+}
+
+/**
+ * Gets the integer square root of a number
+ *
+ * @param value The number
+ *
+ * @return the largest integer whose square is not more than the number
+ */
+uint32_t intSqrt(uint64_t value) {
+	// One bit of the root at a time, from the highest
+	uint64_t root = 0;
+	uint64_t bit = 1ULL << 62;
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+/**
+ * The sine of each whole degree from 0 to 90, as fixed values
+ */
+static const fixed sineTable[91] = {
+	0, 1144, 2287, 3430, 4572, 5712, 6850, 7987, 9121, 10252,
+	11380, 12505, 13626, 14742, 15855, 16962, 18064, 19161, 20252, 21336,
+	22415, 23486, 24550, 25607, 26656, 27697, 28729, 29753, 30767, 31772,
+	32768, 33754, 34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+	42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930, 48703, 49461,
+	50203, 50931, 51643, 52339, 53020, 53684, 54332, 54963, 55578, 56175,
+	56756, 57319, 57865, 58393, 58903, 59396, 59870, 60326, 60764, 61183,
+	61584, 61966, 62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+	64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446, 65496, 65526,
+	65536,
+};
+
+/**
+ * Gets the sine of an angle, from a table of whole degrees with the degrees between interpolated
+ *
+ * @param millidegrees The angle in thousandths of a degree, counterclockwise
+ *
+ * @return the sine, as a fixed value from -1 to 1
+ */
+fixed fixedSin(long millidegrees) {
+	long angle = millidegrees % 360000;
+	if (angle < 0) {
+		angle += 360000;
+	}
+	// The table holds the first quarter turn; the rest of the wave mirrors it
+	bool negative = angle >= 180000;
+	if (negative) {
+		angle -= 180000;
+	}
+	if (angle > 90000) {
+		angle = 180000 - angle;
+	}
+	int degree = angle / 1000;
+	fixed sine = sineTable[degree];
+	if (degree < 90) {
+		sine += roundDivide((sineTable[degree + 1] - sine) * (angle % 1000), 1000);
+	}
+	return negative ? -sine : sine;
+}
+
+/**
+ * Gets the cosine of an angle
+ *
+ * @param millidegrees The angle in thousandths of a degree, counterclockwise
+ *
+ * @return the cosine, as a fixed value from -1 to 1
+ */
+fixed fixedCos(long millidegrees) {
+	return fixedSin(millidegrees + 90000);
+}
+
+/**
+ * Prints an integer that counts in units of 10 ^ -decimals as a decimal number, such as 7840 with 3 decimals as "7.840"
+ *
+ * @param buffer The buffer to print to, which is always null terminated
+ * @param size The size of the buffer
+ * @param value The integer
+ * @param decimals The number of digits after the decimal point, from 0 to 9
+ *
+ * @return the number of characters printed
+ */
+int formatDecimal(char* buffer, size_t size, long value, int decimals) {
+	// The digits are worked out from the last, so they are put together backwards first
+	char reversed[32];
+	int length = 0;
+	unsigned long magnitude = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+	for (int i = 0; i < decimals; i++) {
+		reversed[length++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	}
+	if (decimals > 0) {
+		reversed[length++] = '.';
+	}
+	do {
+		reversed[length++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude > 0);
+	if (value < 0) {
+		reversed[length++] = '-';
+	}
+
+	int count = 0;
+	while (length > 0 && count < (int) size - 1) {
+		buffer[count++] = reversed[--length];
+	}
+	buffer[count] = 0;
+	return count;
+}
+
+/**
+ * Prints a fixed value as a decimal number, rounded to the nearest last digit
+ *
+ * @param buffer The buffer to print to, which is always null terminated
+ * @param size The size of the buffer
+ * @param value The fixed value
+ * @param decimals The number of digits after the decimal point, from 0 to 4
+ *
+ * @return the number of characters printed
+ */
+int fixedFormat(char* buffer, size_t size, fixed value, int decimals) {
+	long scale = 1;
+	for (int i = 0; i < decimals; i++) {
+		scale *= 10;
+	}
+	return formatDecimal(buffer, size, fixedRound((int64_t) value * scale), decimals);
+}
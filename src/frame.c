@@ -0,0 +1,139 @@
+/** @file frame.c
+ * @brief File for the binary serial frame encoder and decoder
+ *
+ * Contains the CRC, encoder and decoder for the frames described in frame.h.
+ * The decoder is fed one byte at a time so that it can be used while polling the serial port.
+ */
+
+#include "frame.h"
+
+/**
+ * Updates a CRC-16/CCITT-FALSE with more data
+ *
+ * @param crc The CRC of the data so far, or 0xFFFF to start a new CRC
+ * @param data The data to add to the CRC
+ * @param length The number of bytes of data
+ *
+ * @return the updated CRC
+ */
+uint16_t frameCrc16(uint16_t crc, const uint8_t* data, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		crc ^= (uint16_t) data[i] << 8;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+/**
+ * Updates a CRC-32 (as used by zip files) with more data
+ *
+ * @param crc The CRC of the data so far, or 0 to start a new CRC
+ * @param data The data to add to the CRC
+ * @param length The number of bytes of data
+ *
+ * @return the updated CRC
+ */
+uint32_t frameCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+		}
+	}
+	return ~crc;
+}
+
+/**
+ * Encodes a frame into a buffer
+ *
+ * @param out The buffer to write to, which must hold at least FRAME_MAX_LENGTH bytes
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ * @param payload The payload of the frame
+ * @param length The number of bytes in the payload, at most FRAME_MAX_PAYLOAD
+ *
+ * @return the number of bytes written to out
+ */
+size_t frameEncode(uint8_t* out, uint8_t type, uint8_t seq, const uint8_t* payload, uint16_t length) {
+	if (length > FRAME_MAX_PAYLOAD) {
+		length = FRAME_MAX_PAYLOAD;
+	}
+
+	out[0] = FRAME_SYNC_1;
+	out[1] = FRAME_SYNC_2;
+	out[2] = type;
+	out[3] = seq;
+	out[4] = length & 0xFF;
+	out[5] = length >> 8;
+	for (int i = 0; i < length; i++) {
+		out[FRAME_HEADER_LENGTH + i] = payload[i];
+	}
+
+	uint16_t crc = frameCrc16(0xFFFF, out + 2, FRAME_HEADER_LENGTH - 2 + length);
+	out[FRAME_HEADER_LENGTH + length] = crc & 0xFF;
+	out[FRAME_HEADER_LENGTH + length + 1] = crc >> 8;
+	return FRAME_HEADER_LENGTH + length + FRAME_CRC_LENGTH;
+}
+
+/**
+ * Prepares a decoder to look for the start of a new frame
+ *
+ * @param decoder The decoder to reset
+ */
+void frameDecoderReset(frame_decoder* decoder) {
+	decoder->position = 0;
+	decoder->length = 0;
+}
+
+/**
+ * Feeds the next received byte to a decoder
+ * Bytes outside of a frame (such as printed text) are skipped.
+ *
+ * @param decoder The decoder to feed
+ * @param byte The received byte
+ *
+ * @return FRAME_READY if a valid frame has been received, FRAME_CORRUPT if a damaged frame was received, or FRAME_INCOMPLETE otherwise
+ */
+int frameDecoderFeed(frame_decoder* decoder, uint8_t byte) {
+	int position = decoder->position++;
+
+	if (position == 0) {
+		if (byte != FRAME_SYNC_1) {
+			decoder->position = 0;
+		}
+	} else if (position == 1) {
+		if (byte == FRAME_SYNC_1) {
+			decoder->position = 1;
+		} else if (byte != FRAME_SYNC_2) {
+			decoder->position = 0;
+		}
+	} else if (position == 2) {
+		decoder->type = byte;
+	} else if (position == 3) {
+		decoder->seq = byte;
+	} else if (position == 4) {
+		decoder->length = byte;
+	} else if (position == 5) {
+		decoder->length |= (uint16_t) byte << 8;
+		if (decoder->length > FRAME_MAX_PAYLOAD) {
+			frameDecoderReset(decoder);
+			return FRAME_CORRUPT;
+		}
+	} else if (position < FRAME_HEADER_LENGTH + decoder->length) {
+		decoder->payload[position - FRAME_HEADER_LENGTH] = byte;
+	} else if (position == FRAME_HEADER_LENGTH + decoder->length) {
+		decoder->crc = byte;
+	} else {
+		decoder->crc |= (uint16_t) byte << 8;
+		decoder->position = 0;
+
+		uint8_t header[FRAME_HEADER_LENGTH - 2] = { decoder->type, decoder->seq, decoder->length & 0xFF, decoder->length >> 8 };
+		uint16_t crc = frameCrc16(0xFFFF, header, sizeof(header));
+		crc = frameCrc16(crc, decoder->payload, decoder->length);
+		return (crc == decoder->crc) ? FRAME_READY : FRAME_CORRUPT;
+	}
+	return FRAME_INCOMPLETE;
+}
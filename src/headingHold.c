@@ -0,0 +1,92 @@
+/** @file headingHold.c
+ * @brief File for the heading hold of playback, which turns the robot toward its recorded heading
+ */
+
+#include "main.h"
+#include <string.h>
+
+heading_stats headingStats;
+
+bool gyroFound = false;
+
+bool headingHoldEnabled = true;
+
+/**
+ * The gyro, or NULL if it was not found
+ */
+static Gyro gyro = NULL;
+
+/**
+ * The loop of the heading
+ */
+static pid_controller headingPid;
+
+/**
+ * Checks that the gyro is plugged in and starts it; the robot must stand still
+ * Called by initControl().
+ */
+void initHeading() {
+	int reading = analogRead(GYRO_PORT);
+	gyroFound = reading >= GYRO_REST_MIN && reading <= GYRO_REST_MAX;
+	if (gyroFound) {
+		gyro = gyroInit(GYRO_PORT, 0);
+		gyroFound = gyro != NULL;
+	}
+	printf("Gyro reads %d, %s.\n", reading, gyroFound ? "headings are recorded" : "playback turns open loop");
+	pidInit(&headingPid, HEADING_KP, HEADING_KI, HEADING_KD, HEADING_INTEGRAL_LIMIT);
+}
+
+/**
+ * Gets the heading of the robot
+ *
+ * @return the degrees the robot has turned counterclockwise since headingZero(), or 0 without a gyro
+ */
+int headingGet() {
+	return gyroFound ? gyroGet(gyro) : 0;
+}
+
+/**
+ * Takes the heading now as zero, as recording and playback do at the start of a routine
+ */
+void headingZero() {
+	if (gyroFound) {
+		gyroReset(gyro);
+	}
+	pidReset(&headingPid);
+}
+
+/**
+ * Gets the turn that steers the robot toward a recorded heading, as playback adds to each state's turn
+ *
+ * @param recorded The heading the robot had when the state started to be recorded, in degrees
+ *
+ * @return the turn command to add, positive clockwise like the turn of a joystick state
+ */
+int headingCorrection(int recorded) {
+	int error = recorded - headingGet();
+	// A robot short of a counterclockwise heading needs to turn counterclockwise, which is a negative turn
+	int correction = -pidUpdate(&headingPid, error);
+	correction = CLAMP(correction, -HEADING_MAX_CORRECTION, HEADING_MAX_CORRECTION);
+	error = (error < 0) ? -error : error;
+	headingStats.updates++;
+	headingStats.errorSum += error;
+	headingStats.maxError = MAX(headingStats.maxError, error);
+	return correction;
+}
+
+/**
+ * Sets every counter back to zero
+ */
+void headingStatsReset() {
+	memset(&headingStats, 0, sizeof(headingStats));
+}
+
+/**
+ * Prints whether the heading is held, the heading now and how closely it has been held
+ */
+void printHeadingStats() {
+	printf("Heading hold: %s, gyro: %s, headings loaded: %s, heading: %d degrees\n", headingHoldEnabled ? "on" : "off",
+			gyroFound ? "yes" : "no", headingsLoaded ? "yes" : "no", headingGet());
+	printf("Held states: %lu, mean error: %lu degrees, max error: %d degrees\n", headingStats.updates,
+			(headingStats.updates == 0) ? 0 : headingStats.errorSum / headingStats.updates, headingStats.maxError);
+}
@@ -37,12 +37,15 @@ void initializeIO() {
  * can be implemented in this task if desired.
  */
 void initialize() {
+	initInputCurves();
 	lcdInit(LCD_PORT);
 	lcdClear(LCD_PORT);
 	lcdSetBacklight(LCD_PORT, true);
 	initLCDMenu();
 	lcdSetText(LCD_PORT, 1, "Load from?");
 	initAutonRecorder();
+	initSerialShell();
+	initControl();
 	loadAuton(selectAuton(false));
 	delay(500);
 }
@@ -0,0 +1,47 @@
+/** @file inputCurve.c
+ * @brief File for shaping the joystick axes with lookup tables
+ *
+ * The tables are built with integer arithmetic (128 ^ 4 still fits in 32 bits), and for every
+ * value from -127 to 127 they match the pow() curve that recordJoyInfo() used to work out every tick.
+ */
+
+#include "main.h"
+
+input_curve speedCurve;
+input_curve horizontalCurve;
+input_curve turnCurve;
+
+/**
+ * Builds an input curve that raises the joystick value to a power, keeping its sign
+ * The output is |value| ^ exponent / 127 ^ (exponent - 1), rounded toward zero, so that full
+ * stick is still full speed; outputs inside the deadband are zero.
+ *
+ * @param curve The input curve to build
+ * @param exponent The power, from 1 (linear) to 4
+ * @param deadband Outputs closer to zero than this are set to zero
+ */
+void buildInputCurve(input_curve* curve, int exponent, int deadband) {
+	for (int value = -128; value < 128; value++) {
+		int magnitude = abs(value);
+		int power = magnitude;
+		int scale = 1;
+		for (int i = 1; i < exponent; i++) {
+			power *= magnitude;
+			scale *= 127;
+		}
+		int output = MIN(power / scale, 127);
+		if (output < deadband) {
+			output = 0;
+		}
+		curve->table[value + 128] = (value < 0) ? -output : output;
+	}
+}
+
+/**
+ * Builds the curves of every axis; must be called before recordJoyInfo()
+ */
+void initInputCurves() {
+	buildInputCurve(&speedCurve, SPEED_CURVE_EXPONENT, INPUT_DEADBAND);
+	buildInputCurve(&horizontalCurve, HORIZONTAL_CURVE_EXPONENT, INPUT_DEADBAND);
+	buildInputCurve(&turnCurve, TURN_CURVE_EXPONENT, INPUT_DEADBAND);
+}
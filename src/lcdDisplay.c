@@ -58,11 +58,14 @@ void showBatteryInfo(int index) {
 	delay(500);
 
 	while (lcdReadButtons(LCD_PORT) == 0) {
-		double primaryBatt = powerLevelMain() / 1000.0;
-		//double secondaryBatt = powerLevelExpander() / 1000.0;
-		lcdPrint(LCD_PORT, 1, "Main: %f", primaryBatt);
+		// The levels are in millivolts, so three decimals show volts exactly without floating point
+		char primaryBatt[LCD_MESSAGE_MAX_LENGTH + 1];
+		formatDecimal(primaryBatt, sizeof(primaryBatt), powerLevelMain(), 3);
+		//char secondaryBatt[LCD_MESSAGE_MAX_LENGTH + 1];
+		//formatDecimal(secondaryBatt, sizeof(secondaryBatt), powerLevelExpander(), 3);
+		lcdPrint(LCD_PORT, 1, "Main: %s V", primaryBatt);
 		lcdSetText(LCD_PORT, 2, "");
-		//lcdPrint(LCD_PORT, 2, "Expander: %f", secondaryBatt);
+		//lcdPrint(LCD_PORT, 2, "Expander: %s V", secondaryBatt);
 		delay(20);
 	}
 }
@@ -90,13 +93,27 @@ void runMotorUntilPress(int index) {
 	lcdSetText(LCD_PORT, 1, lineOne);
 	lcdSetText(LCD_PORT, 2, "Speed: 127");
 
-	motorSet(index + 1, 127);
+	// The control task commits the frame every period, so the test value is staged in it, and the
+	// lift loop is turned off so that it neither drives a lift port under test nor commits over it
+	controlLock();
+	bool hold = liftHoldEnabled;
+	liftHoldEnabled = false;
+	liftDrive(0);
+	motorFrameSetExact(index + 1, 127);
+	motorFrameCommit();
+	controlUnlock();
 
 	while (lcdReadButtons(LCD_PORT) == 0) {
 		delay(20);
 	}
 
-	motorSet(index, 0);
+	controlLock();
+	motorFrameSetExact(index + 1, 0);
+	motorFrameCommit();
+	liftHoldEnabled = hold;
+	// The lift may have moved while the loop was off, so it holds where it is now
+	liftSetHeight(liftHeight());
+	controlUnlock();
 }
 
 /**
@@ -117,7 +134,11 @@ void lcdPlaybackAuton(int index) {
  */
 void downloadAutonFromComputerWrapper() {
 	delay(500);
-	downloadAutonFromComputer(selectAuton(true));
+	int slot = selectAuton(true);
+	// The shell task would otherwise take some of the file's bytes as command lines
+	serialLock();
+	downloadAutonFromComputer(slot);
+	serialUnlock();
 }
 
 /**
@@ -125,14 +146,18 @@ void downloadAutonFromComputerWrapper() {
  */
 void uploadAutonToComputerWrapper() {
 	delay(500);
-	uploadAutonToComputer(selectAuton(true));
+	int slot = selectAuton(true);
+	// Keeps the shell's replies out of the middle of the file
+	serialLock();
+	uploadAutonToComputer(slot);
+	serialUnlock();
 }
 
 /**
  * Initializes the menus used in this program
  */
 void initLCDMenu() {
-	initialMenuItems = (menu_item*) malloc(6 * sizeof(menu_item));
+	initialMenuItems = (menu_item*) malloc(7 * sizeof(menu_item));
 
 	menu_item* motorTestMenus;
 	motorTestMenus = malloc(10 * sizeof(menu_item));
@@ -143,6 +168,7 @@ void initLCDMenu() {
 	menu_item loadAuton = { .isFunction = true, .name = "Playback Auton", .description = "", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &lcdPlaybackAuton };
 	menu_item downloadAuton = { .isFunction = true, .name = "Download Auton", .description = "Load from computer", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &downloadAutonFromComputerWrapper };
 	menu_item uploadAuton = { .isFunction = true, .name = "Upload Auton", .description = "Save to computer", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &uploadAutonToComputerWrapper };
+	menu_item benchmark = { .isFunction = true, .name = "Benchmark", .description = "Time tick code", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &runBenchmarks };
 	
 	for (int i = 0; i < 10; i++) {
 		char* name = malloc((LCD_MESSAGE_MAX_LENGTH - 2 + 1) * sizeof(char));
@@ -158,9 +184,10 @@ void initLCDMenu() {
 	initialMenuItems[3] = loadAuton;
 	initialMenuItems[4] = downloadAuton;
 	initialMenuItems[5] = uploadAuton;
+	initialMenuItems[6] = benchmark;
 
 	currentMenus = initialMenuItems;
-	numMenuItems = 6;
+	numMenuItems = 7;
 }
 
 /**
@@ -0,0 +1,178 @@
+/** @file liftControl.c
+ * @brief File for the lift controller, which holds the lift at a height read from its potentiometer
+ */
+
+#include "main.h"
+#include <string.h>
+
+lift_stats liftStats;
+
+bool liftPotFound = false;
+
+bool liftHoldEnabled = true;
+
+/**
+ * The loop of the lift
+ */
+static pid_controller liftPid;
+
+/**
+ * Whether or not a button is driving the lift at full power
+ */
+static bool manual = false;
+
+/**
+ * The power of the lift while a button drives it, positive up
+ */
+static int manualPower = 0;
+
+/**
+ * The height to hold the lift at, in counts above the bottom
+ */
+static int setpoint = 0;
+
+/**
+ * The heat count of the lift motors
+ */
+static long heat = 0;
+
+/**
+ * Whether or not the lift power is cut until the motors cool
+ */
+static bool cooling = false;
+
+/**
+ * Calibrates the lift potentiometer, which must be at the bottom, and checks that it is plugged in
+ * Called by initControl().
+ */
+void initLift() {
+	int bottom = analogCalibrate(LIFT_POT);
+	liftPotFound = bottom >= LIFT_POT_MIN && bottom <= LIFT_POT_MAX;
+	printf("Lift potentiometer reads %d, %s.\n", bottom, liftPotFound ? "the lift holds its height" : "the lift is open loop");
+	pidInit(&liftPid, LIFT_KP, LIFT_KI, LIFT_KD, LIFT_INTEGRAL_LIMIT);
+	manual = false;
+	setpoint = 0;
+}
+
+/**
+ * Gets the height of the lift
+ *
+ * @return the height in potentiometer counts above the bottom
+ */
+int liftHeight() {
+	return analogReadCalibrated(LIFT_POT);
+}
+
+/**
+ * Whether or not the lift is being driven by the controller
+ *
+ * @return true if the potentiometer was found and holding is on, false if the lift is driven open loop
+ */
+bool liftControlled() {
+	return liftPotFound && liftHoldEnabled;
+}
+
+/**
+ * Drives the lift from a button command, as operator control and open-loop playback do
+ * Without the controller this stages the lift motors as setLiftMotors() does. With it, a command
+ * drives the lift at full power, and the height at which the command goes back to 0 is held.
+ *
+ * @param command -1 to raise the lift, 1 to lower it, 0 to hold it
+ */
+void liftDrive(int command) {
+	if (!liftControlled()) {
+		setLiftMotors(command);
+		return;
+	}
+	if (command != 0) {
+		manual = true;
+		manualPower = -CLAMP(command, -1, 1) * MOTOR_SPEED;
+		setLiftPower(cooling ? CLAMP(manualPower, -LIFT_SAFE_POWER / 2, LIFT_SAFE_POWER / 2) : manualPower);
+	} else if (manual) {
+		manual = false;
+		liftSetHeight(liftHeight());
+	}
+}
+
+/**
+ * Sends the lift to a height, as playback of a recording with heights does
+ *
+ * @param height The height in counts above the bottom
+ */
+void liftSetHeight(int height) {
+	manual = false;
+	if (height != setpoint) {
+		setpoint = height;
+		// An integral built up holding one height does not belong to the next
+		pidReset(&liftPid);
+	}
+}
+
+/**
+ * Gets the height that the lift is being held at
+ *
+ * @return the setpoint in counts above the bottom, or the height now while a button drives the lift
+ */
+int liftSetpoint() {
+	return manual ? liftHeight() : setpoint;
+}
+
+/**
+ * Drives the lift toward its setpoint if the controller is on, staging the lift motors
+ * Run by the control task every CONTROL_PERIOD milliseconds while it holds the control lock.
+ *
+ * @return true if the lift motors were staged, false otherwise
+ */
+bool liftUpdate() {
+	if (!liftControlled()) {
+		return false;
+	}
+	int height = liftHeight();
+	int power;
+	if (manual) {
+		power = manualPower;
+	} else if (setpoint < LIFT_REST_HEIGHT && height < LIFT_REST_HEIGHT) {
+		// Resting on the bottom needs no power
+		pidReset(&liftPid);
+		power = 0;
+	} else {
+		int error = setpoint - height;
+		// CLAMP() evaluates its value more than once, and the loop must only be updated once a period
+		int output = LIFT_GRAVITY_POWER + pidUpdate(&liftPid, error);
+		power = CLAMP(output, -MOTOR_SPEED, MOTOR_SPEED);
+		error = (error < 0) ? -error : error;
+		liftStats.updates++;
+		liftStats.errorSum += error;
+		liftStats.maxError = MAX(liftStats.maxError, error);
+	}
+	int magnitude = (power < 0) ? -power : power;
+	heat = MAX(0, heat + magnitude - LIFT_SAFE_POWER);
+	if (heat > LIFT_HEAT_LIMIT) {
+		cooling = true;
+	} else if (heat < LIFT_HEAT_LIMIT / 2) {
+		cooling = false;
+	}
+	if (cooling) {
+		power = CLAMP(power, -LIFT_SAFE_POWER / 2, LIFT_SAFE_POWER / 2);
+		liftStats.limited++;
+	}
+	setLiftPower(power);
+	return true;
+}
+
+/**
+ * Sets every counter back to zero
+ */
+void liftStatsReset() {
+	memset(&liftStats, 0, sizeof(liftStats));
+}
+
+/**
+ * Prints whether the lift is held, its height and setpoint, and how closely it has been held
+ */
+void printLiftStats() {
+	printf("Lift hold: %s, potentiometer: %s, height: %d, setpoint: %d, heat: %ld%s\n", liftHoldEnabled ? "on" : "off",
+			liftPotFound ? "yes" : "no", liftHeight(), liftSetpoint(), heat, cooling ? " (cooling)" : "");
+	printf("Held periods: %lu, power cut: %lu, mean error: %lu counts, max error: %d counts\n", liftStats.updates,
+			liftStats.limited, (liftStats.updates == 0) ? 0 : liftStats.errorSum / liftStats.updates, liftStats.maxError);
+}
@@ -0,0 +1,119 @@
+/** @file motorFrame.c
+ * @brief File for writing the motors once per tick, skipping the ones that have not changed
+ */
+
+#include "main.h"
+#include <string.h>
+
+motor_frame_stats motorFrameStats;
+
+/**
+ * The values to write at the next commit, for channels 1 - 10
+ */
+static signed char staged[MOTOR_CHANNELS];
+
+/**
+ * The values written at the last commit
+ */
+static signed char committed[MOTOR_CHANNELS];
+
+/**
+ * Whether or not the motors may have been set since the last commit without the frame
+ */
+static bool invalid = true;
+
+/**
+ * The time in milliseconds at which every channel was last written
+ */
+static unsigned long lastRefresh = 0;
+
+/**
+ * The battery scale of staged values
+ */
+static fixed scale = FIXED_ONE;
+
+/**
+ * Stages the value of a motor for the next commit
+ *
+ * @param channel The motor channel, from 1 to MOTOR_CHANNELS
+ * @param speed The new signed speed; values outside -127 to 127 are clamped
+ */
+void motorFrameSet(unsigned char channel, int speed) {
+	motorFrameSetExact(channel, batteryScaleCommand(CLAMP(speed, -127, 127), scale));
+}
+
+/**
+ * Stages the value of a motor for the next commit without the battery scale, for a controller
+ * that already corrects for the battery
+ *
+ * @param channel The motor channel, from 1 to MOTOR_CHANNELS
+ * @param speed The new signed speed; values outside -127 to 127 are clamped
+ */
+void motorFrameSetExact(unsigned char channel, int speed) {
+	if (channel >= 1 && channel <= MOTOR_CHANNELS) {
+		staged[channel - 1] = CLAMP(speed, -127, 127);
+	}
+}
+
+/**
+ * Sets the battery scale that motorFrameSet() applies from now on (see batteryScaleCommand())
+ *
+ * @param scale The scale from batteryScale(), or FIXED_ONE to stage values as they are given
+ */
+void motorFrameSetScale(fixed newScale) {
+	scale = newScale;
+}
+
+/**
+ * Writes every staged value that differs from the last committed frame to the motors
+ */
+void motorFrameCommit() {
+	unsigned long now = millis();
+	bool writeAll = invalid || now - lastRefresh >= MOTOR_FRAME_REFRESH;
+	for (int i = 0; i < MOTOR_CHANNELS; i++) {
+		if (writeAll || staged[i] != committed[i]) {
+			motorSet(i + 1, staged[i]);
+			committed[i] = staged[i];
+			motorFrameStats.writes++;
+		} else {
+			motorFrameStats.skipped++;
+		}
+	}
+	if (writeAll) {
+		invalid = false;
+		lastRefresh = now;
+	}
+	motorFrameStats.commits++;
+}
+
+/**
+ * Makes the next commit write every channel, after the motors were set without the frame
+ */
+void motorFrameInvalidate() {
+	invalid = true;
+}
+
+/**
+ * Stops every motor at once and stages and commits a stopped frame
+ */
+void motorFrameStopAll() {
+	motorStopAll();
+	memset(staged, 0, sizeof(staged));
+	memset(committed, 0, sizeof(committed));
+}
+
+/**
+ * Sets the counters back to zero
+ */
+void motorFrameStatsReset() {
+	memset(&motorFrameStats, 0, sizeof(motorFrameStats));
+}
+
+/**
+ * Prints the counters to the serial monitor
+ */
+void printMotorFrameStats() {
+	unsigned long channels = motorFrameStats.writes + motorFrameStats.skipped;
+	printf("Motor frames: %lu, writes: %lu, skipped: %lu (%lu%%)\n", motorFrameStats.commits, motorFrameStats.writes,
+			motorFrameStats.skipped, (channels == 0) ? 0 : motorFrameStats.skipped * 100 / channels);
+}
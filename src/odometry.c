@@ -0,0 +1,253 @@
+/** @file odometry.c
+ * @brief File for the odometry task, which keeps track of where the robot is from its drive encoders
+ */
+
+#include "main.h"
+#include <string.h>
+
+odometry_stats odometryStats;
+
+bool odometryGyro = true;
+
+/**
+ * Which way each wheel rolls as its IME counts up, in the order of mixDrive(): 1 for forward
+ * (the motors are mounted as the signs of mixDrive() show)
+ */
+static const int wheelSigns[DRIVE_WHEELS] = { -1, 1, 1, -1 };
+
+/**
+ * How each wheel rolling forward moves the robot to the left, and turns it counterclockwise
+ */
+static const int leftSigns[DRIVE_WHEELS] = { -1, 1, 1, -1 };
+static const int turnSigns[DRIVE_WHEELS] = { -1, 1, -1, 1 };
+
+/**
+ * Whether or not the odometry task was started
+ */
+static bool odometryStarted = false;
+
+/**
+ * Where the robot was at the last reading
+ */
+static odometry_pose robotPose;
+
+/**
+ * Whether or not the next reading is taken as the origin instead of moving the pose
+ */
+static bool resetPending = true;
+
+/**
+ * The count of each wheel at the last reading
+ */
+static int lastCounts[DRIVE_WHEELS];
+
+/**
+ * The sum of the wheels' counts, with turnSigns, since the origin was taken
+ */
+static long turnCounts;
+
+/**
+ * The heading from the encoders alone at the last reading, in thousandths of a degree
+ */
+static long encoderHeading;
+
+/**
+ * The gyro's heading in degrees when the origin was taken
+ */
+static int gyroOrigin;
+
+/**
+ * The time in milliseconds at which the last reading started, once there has been one
+ */
+static unsigned long lastStart;
+static bool started = false;
+
+/**
+ * Gets how far the robot moved from the counts of its four wheels
+ *
+ * @param counts The sum of the four wheels' counts, each with its sign
+ *
+ * @return the mean distance the wheels rolled in micrometers (710 / 113 is 2 pi to within a millionth)
+ */
+static long wheelDistance(long counts) {
+	return roundDivide64((int64_t) counts * DRIVE_WHEEL_RADIUS * 710, 113LL * DRIVE_IME_COUNTS_PER_REV * DRIVE_WHEELS);
+}
+
+/**
+ * Gets how far the robot turned from the counts of its four wheels
+ *
+ * @param counts The sum of the four wheels' counts, with turnSigns
+ *
+ * @return the thousandths of a degree turned counterclockwise (pi cancels out of the conversion)
+ */
+static long wheelHeading(long counts) {
+	return roundDivide64((int64_t) counts * DRIVE_WHEEL_RADIUS * 90000, (int64_t) DRIVE_IME_COUNTS_PER_REV * DRIVE_WHEEL_SPAN);
+}
+
+/**
+ * Moves the pose by the wheel counts since the last reading
+ * The caller holds the control lock.
+ *
+ * @param counts The count of each wheel now
+ * @param gyroHeading The gyro's heading now in degrees
+ * @param now The time in milliseconds at which the IMEs were read
+ */
+static void movePose(const int counts[DRIVE_WHEELS], int gyroHeading, unsigned long now) {
+	long forward = 0, left = 0, turn = 0;
+	for (int i = 0; i < DRIVE_WHEELS; i++) {
+		int rolled = wheelSigns[i] * (counts[i] - lastCounts[i]);
+		forward += rolled;
+		left += leftSigns[i] * rolled;
+		turn += turnSigns[i] * rolled;
+		lastCounts[i] = counts[i];
+	}
+	// The encoder heading is worked out from the total, so its rounding does not add up reading after reading
+	turnCounts += turn;
+	long turned = wheelHeading(turnCounts) - encoderHeading;
+	encoderHeading += turned;
+	long heading = robotPose.heading + turned;
+	if (odometryGyro && gyroFound) {
+		long gap = (gyroHeading - gyroOrigin) * 1000L - heading;
+		heading += fixedScale(gap, ODOMETRY_GYRO_WEIGHT);
+	}
+
+	// The robot moved along the heading it had halfway through the period
+	long middle = robotPose.heading + (heading - robotPose.heading) / 2;
+	fixed cosine = fixedCos(middle);
+	fixed sine = fixedSin(middle);
+	int forwardDistance = wheelDistance(forward);
+	int leftDistance = wheelDistance(left);
+	robotPose.x += fixedScale(forwardDistance, cosine) - fixedScale(leftDistance, sine);
+	robotPose.y += fixedScale(forwardDistance, sine) + fixedScale(leftDistance, cosine);
+	robotPose.heading = heading;
+	// Micrometers per millisecond are millimeters per second
+	unsigned long elapsed = now - robotPose.time;
+	if (elapsed > 0) {
+		robotPose.forwardSpeed = roundDivide(forwardDistance, elapsed);
+		robotPose.leftSpeed = roundDivide(leftDistance, elapsed);
+	}
+	robotPose.time = now;
+}
+
+/**
+ * Reads the drive IMEs and the gyro and moves the pose
+ */
+static void odometryUpdate() {
+	unsigned long start = micros();
+	unsigned long now = millis();
+	int counts[DRIVE_WHEELS];
+	bool read = readDriveEncoders(counts);
+	int gyroHeading = headingGet();
+	controlLock();
+	if (!read) {
+		odometryStats.readFailures++;
+	} else if (resetPending) {
+		memcpy(lastCounts, counts, sizeof(lastCounts));
+		turnCounts = 0;
+		encoderHeading = 0;
+		gyroOrigin = gyroHeading;
+		memset(&robotPose, 0, sizeof(robotPose));
+		robotPose.time = now;
+		resetPending = false;
+	} else {
+		movePose(counts, gyroHeading, now);
+	}
+	if (read) {
+		odometryStats.updates++;
+	}
+	unsigned long busy = micros() - start;
+	odometryStats.busySum += busy;
+	odometryStats.maxBusy = MAX(odometryStats.maxBusy, busy);
+	if (started) {
+		odometryStats.maxGap = MAX(odometryStats.maxGap, now - lastStart);
+	}
+	lastStart = now;
+	started = true;
+	controlUnlock();
+}
+
+/**
+ * Reads the drive IMEs every ODOMETRY_PERIOD milliseconds
+ *
+ * @param parameters Unused task parameter
+ */
+static void odometryTask(void* parameters) {
+	unsigned long wakeTime = millis();
+	while (true) {
+		odometryUpdate();
+		taskDelayUntil(&wakeTime, ODOMETRY_PERIOD);
+	}
+}
+
+/**
+ * Starts the odometry task if the four drive IMEs answer, with the robot at the origin
+ * Called by initControl() after initDriveEncoders() and initHeading().
+ */
+void initOdometry() {
+	if (!driveEncoders) {
+		printf("Odometry is off without the drive IMEs.\n");
+		return;
+	}
+	odometryStarted = true;
+	taskCreate(odometryTask, TASK_DEFAULT_STACK_SIZE, NULL, ODOMETRY_TASK_PRIORITY);
+}
+
+/**
+ * Gets where the robot is
+ *
+ * @param pose Set to the pose at the last reading
+ *
+ * @return true if the pose is kept, false if the robot has no drive IMEs
+ */
+bool odometryGetPose(odometry_pose* pose) {
+	if (!odometryStarted) {
+		return false;
+	}
+	controlLock();
+	*pose = robotPose;
+	controlUnlock();
+	return true;
+}
+
+/**
+ * Takes where the robot is now as the origin, facing along x
+ */
+void odometryReset() {
+	if (!odometryStarted) {
+		return;
+	}
+	controlLock();
+	// Readers see the origin straight away; the next reading takes the counts that go with it
+	memset(&robotPose, 0, sizeof(robotPose));
+	robotPose.time = millis();
+	resetPending = true;
+	controlUnlock();
+}
+
+/**
+ * Sets every counter back to zero
+ */
+void odometryStatsReset() {
+	memset(&odometryStats, 0, sizeof(odometryStats));
+}
+
+/**
+ * Prints the pose and how the odometry task has kept up
+ */
+void printOdometryStats() {
+	odometry_pose pose;
+	if (!odometryGetPose(&pose)) {
+		printf("Odometry: off, IMEs: no\n");
+		return;
+	}
+	char x[16], y[16], heading[16];
+	formatDecimal(x, sizeof(x), roundDivide(pose.x, 1000), 3);
+	formatDecimal(y, sizeof(y), roundDivide(pose.y, 1000), 3);
+	formatDecimal(heading, sizeof(heading), roundDivide(pose.heading, 100), 1);
+	printf("Odometry: on, gyro: %s, x: %s m, y: %s m, heading: %s degrees, speed: %d mm/s forward, %d mm/s left\n",
+			(odometryGyro && gyroFound) ? "yes" : "no", x, y, heading, pose.forwardSpeed, pose.leftSpeed);
+	unsigned long readings = odometryStats.updates + odometryStats.readFailures;
+	printf("Readings: %lu, read failures: %lu, mean time: %lu us, max time: %lu us, max gap: %lu ms\n",
+			odometryStats.updates, odometryStats.readFailures, (readings == 0) ? 0 : odometryStats.busySum / readings,
+			odometryStats.maxBusy, odometryStats.maxGap);
+}
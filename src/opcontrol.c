@@ -56,13 +56,9 @@ bool isLocked = false;
  * Records joystick information into global variables for auton recorder and for robot motion
  */
 void recordJoyInfo() {
-	spd = joystickGetAnalog(1, 3);
-	horizontal = pow(joystickGetAnalog(1, 4) / 127.0, 4) * 127 * joystickGetAnalog(1, 4) / abs(joystickGetAnalog(1, 4));
-	turn = joystickGetAnalog(1, 1);
-
-  spd = IGNORE_LOW_VAL(spd);
-  horizontal = IGNORE_LOW_VAL(horizontal);
-  turn = IGNORE_LOW_VAL(turn);
+	spd = INPUT_SHAPE(speedCurve, joystickGetAnalog(1, 3));
+	horizontal = INPUT_SHAPE(horizontalCurve, joystickGetAnalog(1, 4));
+	turn = INPUT_SHAPE(turnCurve, joystickGetAnalog(1, 1));
 
 	if (joystickGetDigital(1, 5, JOY_UP) == true || joystickGetDigital(2, 5, JOY_UP) == true) {
 		sht = 127;
@@ -89,15 +85,23 @@ void recordJoyInfo() {
  * Move robot based on collected joystick information or based on replayed information from auton recorder
  */
 void moveRobot() {
-	setLiftMotors(lift);
+	// The control task commits the frame too, so it must not see half of it
+	controlLock();
+	liftDrive(lift);
 	setPincerMotors(sht);
 	setDriveMotors(spd, horizontal, turn);
+	motorFrameCommit();
+	controlUnlock();
 }
 
 /**
  * Runs the operator control loop
  */
 void operatorControl() {
+	// The motors were stopped while the robot was disabled
+	motorFrameInvalidate();
+	// A playback killed with autonomous() would leave its controllers driving and the joysticks ignored
+	stopPlayback();
 	while (1) {
 		if (joystickGetDigital(1, 7, JOY_RIGHT) && !isOnline()) {
 			recordAuton();
@@ -108,8 +112,10 @@ void operatorControl() {
 			playbackAuton();
 		}
 		updateLCDMenu(20);
-		recordJoyInfo();
-		moveRobot();
+		if (!autonPlaying) {
+			recordJoyInfo();
+			moveRobot();
+		}
 		delay(20);
 	}
 }
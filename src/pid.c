@@ -0,0 +1,50 @@
+/** @file pid.c
+ * @brief File for the PID controllers of the control task
+ */
+
+#include "main.h"
+
+/**
+ * Sets the gains of a controller and resets it
+ *
+ * @param pid The controller
+ * @param kp The proportional gain
+ * @param ki The integral gain
+ * @param kd The derivative gain
+ * @param integralLimit The largest magnitude of the sum of errors
+ */
+void pidInit(pid_controller* pid, fixed kp, fixed ki, fixed kd, long integralLimit) {
+	pid->kp = kp;
+	pid->ki = ki;
+	pid->kd = kd;
+	pid->integralLimit = integralLimit;
+	pidReset(pid);
+}
+
+/**
+ * Forgets the errors that a controller has seen, keeping its gains
+ *
+ * @param pid The controller
+ */
+void pidReset(pid_controller* pid) {
+	pid->integral = 0;
+	pid->lastError = 0;
+	pid->started = false;
+}
+
+/**
+ * Adds an error to a controller and gets the power that corrects it
+ *
+ * @param pid The controller
+ * @param error Where the controlled thing should be, less where it is
+ *
+ * @return the correcting power (not clamped; add the feedforward and clamp the sum)
+ */
+int pidUpdate(pid_controller* pid, int error) {
+	pid->integral = CLAMP(pid->integral + error, -pid->integralLimit, pid->integralLimit);
+	// The first call has no earlier error, so it would see the whole error as a sudden change
+	int change = pid->started ? error - pid->lastError : 0;
+	pid->lastError = error;
+	pid->started = true;
+	return fixedScale(error, pid->kp) + fixedScale((int) pid->integral, pid->ki) + fixedScale(change, pid->kd);
+}
@@ -0,0 +1,554 @@
+/** @file serialShell.c
+ * @brief File for the serial command shell
+ *
+ * Contains the task that reads command lines from the serial monitor and the commands that
+ * dispatch into the autonomous recorder. The task only reads characters that have already
+ * arrived, so it never blocks the robot while waiting for the operator to type.
+ *
+ * Every command ends its output with a line containing "OK" or "ERR" followed by a reason,
+ * which lets scripts on the computer know when a command has finished.
+ */
+
+#include "main.h"
+#include <string.h>
+
+/**
+ * The characters of the command line that is currently being typed
+ */
+static char shellLine[SHELL_LINE_MAX_LENGTH];
+
+/**
+ * The number of characters in the current command line
+ */
+static int shellLineLength = 0;
+
+/**
+ * Whether or not the current command line has been too long to store
+ */
+static bool shellLineOverflow = false;
+
+/**
+ * The task reading the serial monitor: the shell task while it reads and runs command lines, or
+ * another task between serialLock() and serialUnlock(); NULL if none is
+ * A mutex would stay taken for good if the kernel deleted operatorControl() during an LCD
+ * transfer, so the owner is a task handle, and a task that has been deleted owns nothing.
+ */
+static TaskHandle serialOwner = NULL;
+
+/**
+ * Makes the calling task the owner of the serial monitor if no live task owns it
+ *
+ * @return true if the calling task now owns the serial monitor
+ */
+static bool serialClaim() {
+	taskSuspendAll();
+	bool claimed = serialOwner == NULL || taskGetState(serialOwner) == TASK_DEAD;
+	if (claimed) {
+		serialOwner = taskGetCurrent();
+	}
+	taskResumeAll();
+	return claimed;
+}
+
+/**
+ * The number of command lines that have been run
+ */
+static int shellCommandsRun = 0;
+
+/**
+ * The number of command lines that failed or were not understood
+ */
+static int shellCommandsFailed = 0;
+
+/**
+ * Prints a line telling the computer that a command failed
+ *
+ * @param reason A short description of why the command failed
+ *
+ * @return false, so that commands can return the result directly
+ */
+static bool shellError(const char* reason) {
+	printf("ERR %s\n", reason);
+	return false;
+}
+
+/**
+ * Parses an autonomous slot typed into the shell
+ *
+ * @param text Either a slot number, a file name (a1 - a10 or p0 - p3), or "skills"
+ *
+ * @return the slot number in the format used by the recorder, or 0 if the text is not a valid slot
+ */
+int parseShellSlot(const char* text) {
+	if (strcmp(text, "skills") == 0) {
+		return MAX_AUTON_SLOTS + 1;
+	}
+
+	char prefix = 'a';
+	if (text[0] == 'a' || text[0] == 'p') {
+		prefix = text[0];
+		text++;
+	}
+	if (text[0] == 0) {
+		return 0;
+	}
+
+	int number = 0;
+	for (int i = 0; text[i] != 0; i++) {
+		if (text[i] < '0' || text[i] > '9' || i >= 2) {
+			return 0;
+		}
+		number = number * 10 + (text[i] - '0');
+	}
+
+	if (prefix == 'p') {
+		return (number < PROGSKILL_TIME / AUTON_TIME) ? -number - 1 : 0;
+	}
+	return (number >= 1 && number <= MAX_AUTON_SLOTS) ? number : 0;
+}
+
+/**
+ * Parses the slot argument of a command, printing an error if it is missing or invalid
+ *
+ * @param argc The number of words in the command line
+ * @param argv The words in the command line
+ *
+ * @return the slot number, or 0 if there is no valid slot argument
+ */
+static int shellSlotArgument(int argc, char** argv) {
+	if (argc < 2) {
+		shellError("missing slot");
+		return 0;
+	}
+	int slot = parseShellSlot(argv[1]);
+	if (slot == 0) {
+		shellError("invalid slot");
+	}
+	return slot;
+}
+
+static bool helpCommand(int argc, char** argv);
+
+/**
+ * Prints the files that a slot has none of beside its autonomous file, and ends the line
+ * The transfers move only the autonomous file, so a slot received from the computer has none.
+ *
+ * @param slot The slot, 1 - 10 or -1 to -4 for a programming skills section
+ */
+static void printMissingCompanions(int slot) {
+	bool (*const getFilenames[])(int, char*, int) = { &getTrackFilename, &getVoltageFilename, &getHeightsFilename,
+			&getHeadingsFilename };
+	const char* names[] = { "track", "voltage", "heights", "headings" };
+	bool missing = false;
+	for (int i = 0; i < 4; i++) {
+		char filename[AUTON_FILENAME_MAX_LENGTH + 2];
+		FILE* file = getFilenames[i](slot, filename, sizeof(filename)) ? fopen(filename, "r") : NULL;
+		if (file == NULL) {
+			printf(missing ? " %s" : " missing %s", names[i]);
+			missing = true;
+		} else {
+			fclose(file);
+		}
+	}
+	printf("\n");
+}
+
+/**
+ * Lists every autonomous slot, the size of its file and the files missing beside it
+ */
+static bool listCommand(int argc, char** argv) {
+	for (int slot = 1; slot <= MAX_AUTON_SLOTS + PROGSKILL_TIME / AUTON_TIME; slot++) {
+		int autonSlot = (slot <= MAX_AUTON_SLOTS) ? slot : MAX_AUTON_SLOTS - slot;
+		char filename[AUTON_FILENAME_MAX_LENGTH + 1];
+		getAutonFilename(autonSlot, filename, sizeof(filename));
+
+		FILE* autonFile = fopen(filename, "r");
+		if (autonFile == NULL) {
+			printf("%s empty\n", filename);
+		} else {
+			printf("%s %d", filename, fcount(autonFile));
+			fclose(autonFile);
+			printMissingCompanions(autonSlot);
+		}
+	}
+	return true;
+}
+
+/**
+ * Loads an autonomous slot into the states array
+ */
+static bool loadCommand(int argc, char** argv) {
+	int slot = shellSlotArgument(argc, argv);
+	if (slot == 0) {
+		return false;
+	} else if (slot < 0) {
+		return shellError("load skills instead of a section");
+	}
+	loadAuton(slot);
+	if (autonLoaded != slot) {
+		return shellError("load failed");
+	}
+	if (!trackLoaded || autonVoltage == 0 || !heightsLoaded || !headingsLoaded) {
+		printf("Loaded without:%s%s%s%s\n", trackLoaded ? "" : " track", (autonVoltage != 0) ? "" : " voltage",
+				heightsLoaded ? "" : " heights", headingsLoaded ? "" : " headings");
+	}
+	return true;
+}
+
+/**
+ * Saves the states array to an autonomous slot
+ */
+static bool saveCommand(int argc, char** argv) {
+	int slot = shellSlotArgument(argc, argv);
+	if (slot == 0) {
+		return false;
+	} else if (slot == MAX_AUTON_SLOTS + 1) {
+		return shellError("save to a skills section instead");
+	}
+	return saveAutonToSlot(slot) ? true : shellError("save failed");
+}
+
+/**
+ * Checks whether a transfer command asked for the binary protocol
+ *
+ * @param argc The number of words in the command line
+ * @param argv The words in the command line
+ *
+ * @return true if the word after the slot is "bin", false for a text transfer
+ */
+static bool shellBinaryArgument(int argc, char** argv) {
+	return argc >= 3 && strcmp(argv[2], "bin") == 0;
+}
+
+/**
+ * Sends an autonomous slot to the computer
+ */
+static bool uploadCommand(int argc, char** argv) {
+	int slot = shellSlotArgument(argc, argv);
+	if (slot == 0) {
+		return false;
+	} else if (shellBinaryArgument(argc, argv)) {
+		return uploadAutonBinary(slot) ? true : shellError("upload failed");
+	}
+	return uploadAutonToComputer(slot) ? true : shellError("upload failed");
+}
+
+/**
+ * Receives an autonomous slot from the computer
+ */
+static bool downloadCommand(int argc, char** argv) {
+	int slot = shellSlotArgument(argc, argv);
+	if (slot == 0) {
+		return false;
+	} else if (shellBinaryArgument(argc, argv)) {
+		return downloadAutonBinary(slot) ? true : shellError("download failed");
+	}
+	return downloadAutonFromComputer(slot) ? true : shellError("download failed");
+}
+
+/**
+ * Runs a sync session that brings the slots on the robot and the computer up to date
+ */
+static bool syncCommand(int argc, char** argv) {
+	return syncAutonSlots() ? true : shellError("sync failed");
+}
+
+/**
+ * Prints information about the recorder and the shell
+ */
+static bool statsCommand(int argc, char** argv) {
+	printAutonStats();
+	printf("Shell commands: %d (%d failed)\n", shellCommandsRun, shellCommandsFailed);
+	return true;
+}
+
+/**
+ * Prints how many bytes each serial link has sent, or resets the counters
+ */
+static bool uartCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+		uartStatsReset();
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printUartStats();
+	}
+	return true;
+}
+
+/**
+ * Prints how many motor writes were made and skipped and how often the drive saturated, or resets the counters
+ */
+static bool motorsCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+		motorFrameStatsReset();
+		driveMixStatsReset();
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printMotorFrameStats();
+		printDriveMixStats();
+	}
+	return true;
+}
+
+/**
+ * Prints how closely the wheels followed their tracks, turns closed-loop playback on or off, or resets the counters
+ */
+static bool trackCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "on") == 0) {
+		closedLoopPlayback = true;
+	} else if (argc >= 2 && strcmp(argv[1], "off") == 0) {
+		closedLoopPlayback = false;
+	} else if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+		driveTrackStatsReset();
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printDriveTrackStats();
+	}
+	return true;
+}
+
+/**
+ * Prints the battery voltage and the scale for the loaded autonomous, or turns battery compensation on or off
+ */
+static bool batteryCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "on") == 0) {
+		batteryCompensation = true;
+	} else if (argc >= 2 && strcmp(argv[1], "off") == 0) {
+		batteryCompensation = false;
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printBatteryStats();
+	}
+	return true;
+}
+
+/**
+ * Prints the lift's height and how closely it has been held, turns holding on or off, or resets the counters
+ */
+static bool liftCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "on") == 0) {
+		liftHoldEnabled = true;
+	} else if (argc >= 2 && strcmp(argv[1], "off") == 0) {
+		liftHoldEnabled = false;
+	} else if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+		liftStatsReset();
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printLiftStats();
+	}
+	return true;
+}
+
+/**
+ * Prints the gyro heading and how closely playback has held it, turns holding on or off, or resets the counters
+ */
+static bool headingCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "on") == 0) {
+		headingHoldEnabled = true;
+	} else if (argc >= 2 && strcmp(argv[1], "off") == 0) {
+		headingHoldEnabled = false;
+	} else if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+		headingStatsReset();
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printHeadingStats();
+	}
+	return true;
+}
+
+/**
+ * Prints where the odometry puts the robot and how it has kept up, takes the robot's place as the origin, or resets the counters
+ */
+static bool poseCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "zero") == 0) {
+		odometryReset();
+	} else if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+		odometryStatsReset();
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printOdometryStats();
+	}
+	return true;
+}
+
+/**
+ * Prints whether open-loop playback interpolates the drive commands, or turns interpolating on or off
+ */
+static bool smoothCommand(int argc, char** argv) {
+	if (argc >= 2 && strcmp(argv[1], "on") == 0) {
+		driveInterpolation = true;
+	} else if (argc >= 2 && strcmp(argv[1], "off") == 0) {
+		driveInterpolation = false;
+	} else if (argc >= 2) {
+		return shellError("unknown argument");
+	} else {
+		printf("Drive interpolation: %s\n", driveInterpolation ? "on" : "off");
+	}
+	return true;
+}
+
+/**
+ * Plays back the loaded autonomous, or loads the given slot first
+ */
+static bool playCommand(int argc, char** argv) {
+	if (argc >= 2) {
+		int slot = parseShellSlot(argv[1]);
+		if (slot <= 0) {
+			return shellError("invalid slot");
+		}
+		loadAuton(slot);
+	}
+	if (autonLoaded == 0) {
+		return shellError("no auton loaded");
+	}
+	playbackAuton();
+	return true;
+}
+
+/**
+ * The commands understood by the shell
+ */
+static const shell_command shellCommands[] = {
+	{ .name = "help", .usage = "", .runFunction = &helpCommand },
+	{ .name = "list", .usage = "", .runFunction = &listCommand },
+	{ .name = "load", .usage = "<slot>", .runFunction = &loadCommand },
+	{ .name = "save", .usage = "<slot>", .runFunction = &saveCommand },
+	{ .name = "upload", .usage = "<slot> [bin]", .runFunction = &uploadCommand },
+	{ .name = "download", .usage = "<slot> [bin]", .runFunction = &downloadCommand },
+	{ .name = "sync", .usage = "", .runFunction = &syncCommand },
+	{ .name = "stats", .usage = "", .runFunction = &statsCommand },
+	{ .name = "uart", .usage = "[reset]", .runFunction = &uartCommand },
+	{ .name = "motors", .usage = "[reset]", .runFunction = &motorsCommand },
+	{ .name = "track", .usage = "[on|off|reset]", .runFunction = &trackCommand },
+	{ .name = "battery", .usage = "[on|off]", .runFunction = &batteryCommand },
+	{ .name = "lift", .usage = "[on|off|reset]", .runFunction = &liftCommand },
+	{ .name = "heading", .usage = "[on|off|reset]", .runFunction = &headingCommand },
+	{ .name = "pose", .usage = "[zero|reset]", .runFunction = &poseCommand },
+	{ .name = "smooth", .usage = "[on|off]", .runFunction = &smoothCommand },
+	{ .name = "play", .usage = "[slot]", .runFunction = &playCommand },
+};
+
+/**
+ * The number of commands understood by the shell
+ */
+#define SHELL_NUM_COMMANDS ((int) (sizeof(shellCommands) / sizeof(shell_command)))
+
+/**
+ * Prints the commands understood by the shell
+ */
+static bool helpCommand(int argc, char** argv) {
+	for (int i = 0; i < SHELL_NUM_COMMANDS; i++) {
+		printf("%s %s\n", shellCommands[i].name, shellCommands[i].usage);
+	}
+	printf("Slots: 1-%d, a1-a%d, p0-p%d, skills\n", MAX_AUTON_SLOTS, MAX_AUTON_SLOTS, PROGSKILL_TIME / AUTON_TIME - 1);
+	return true;
+}
+
+/**
+ * Runs a single command line through the shell
+ *
+ * @param line The command line to run; it is split into words in place
+ */
+void runShellCommand(char* line) {
+	char* argv[SHELL_MAX_ARGS];
+	int argc = 0;
+
+	char* cur = line;
+	while (*cur != 0 && argc < SHELL_MAX_ARGS) {
+		while (*cur == ' ' || *cur == '\t') {
+			*cur++ = 0;
+		}
+		if (*cur == 0) {
+			break;
+		}
+		argv[argc++] = cur;
+		while (*cur != 0 && *cur != ' ' && *cur != '\t') {
+			cur++;
+		}
+	}
+	if (argc == 0) {
+		return;
+	}
+
+	shellCommandsRun++;
+	for (int i = 0; i < SHELL_NUM_COMMANDS; i++) {
+		if (strcmp(argv[0], shellCommands[i].name) == 0) {
+			if (playbackActive()) {
+				shellError("busy playing back");
+			} else if (shellCommands[i].runFunction(argc, argv)) {
+				printf("OK\n");
+				return;
+			}
+			shellCommandsFailed++;
+			return;
+		}
+	}
+	shellCommandsFailed++;
+	shellError("unknown command");
+}
+
+/**
+ * Reads any characters that have arrived on the serial monitor and runs completed command lines
+ *
+ * @param parameters Unused task parameter
+ */
+static void shellTask(void* parameters) {
+	while (true) {
+		// Input that arrives while another task holds the serial monitor is that task's to read
+		if (fcount(stdin) <= 0 || !serialClaim()) {
+			delay(SHELL_POLL_TIME);
+			continue;
+		}
+		while (fcount(stdin) > 0) {
+			int c = fgetc(stdin);
+			if (c == '\n' || c == '\r') {
+				shellLine[shellLineLength] = 0;
+				if (shellLineOverflow) {
+					shellCommandsFailed++;
+					shellError("line too long");
+				} else {
+					runShellCommand(shellLine);
+				}
+				shellLineLength = 0;
+				shellLineOverflow = false;
+			} else if (shellLineLength < SHELL_LINE_MAX_LENGTH - 1) {
+				shellLine[shellLineLength++] = c;
+			} else {
+				shellLineOverflow = true;
+			}
+		}
+		serialOwner = NULL;
+		delay(SHELL_POLL_TIME);
+	}
+}
+
+/**
+ * Starts the task that services the serial shell
+ */
+void initSerialShell() {
+	taskCreate(shellTask, TASK_DEFAULT_STACK_SIZE, NULL, SHELL_TASK_PRIORITY);
+	printf("Serial shell ready, type help for commands.\n");
+}
+
+/**
+ * Waits until the shell is between command lines and keeps it from reading the serial monitor until serialUnlock()
+ */
+void serialLock() {
+	while (!serialClaim()) {
+		delay(SHELL_POLL_TIME);
+	}
+}
+
+/**
+ * Lets the shell read the serial monitor again
+ */
+void serialUnlock() {
+	serialOwner = NULL;
+}
@@ -0,0 +1,661 @@
+/** @file serialTransfer.c
+ * @brief File for binary transfers of autonomous files over the serial monitor
+ *
+ * Contains the sending and receiving sides of the framed transfer protocol.
+ * A transfer is a stream of frames with consecutive sequence numbers. The sender keeps up to
+ * TRANSFER_WINDOW frames in flight; the receiver acknowledges each frame it accepts in order and
+ * answers a damaged or out of order frame with a NAK, after which the sender goes back and sends
+ * everything from the NAKed frame again. A damaged byte therefore costs a few blocks instead of the
+ * whole file, and an undamaged transfer never stops to wait for an acknowledgement.
+ *
+ * A single slot transfer is a BEGIN frame, one DATA frame per block of the file, and an END frame
+ * holding the CRC of the whole file. A sync session is described in syncAutonSlots().
+ */
+
+#include "main.h"
+#include "frame.h"
+#include <string.h>
+
+/**
+ * Frames that have been sent but not yet acknowledged, indexed by sequence number
+ */
+static uint8_t windowFrames[TRANSFER_WINDOW][FRAME_MAX_LENGTH];
+
+/**
+ * Number of bytes in each frame of windowFrames
+ */
+static size_t windowLengths[TRANSFER_WINDOW];
+
+/**
+ * Buffer that the payload of the next outgoing frame is built in
+ */
+static uint8_t transferBlock[FRAME_MAX_PAYLOAD];
+
+/**
+ * Decoder for frames received from the computer
+ */
+static frame_decoder decoder;
+
+/**
+ * File being read or written by the current transfer
+ */
+static FILE* transferFile;
+
+/**
+ * Name of the file being read or written by the current transfer
+ */
+static char transferFilename[AUTON_FILENAME_MAX_LENGTH + 1];
+
+/**
+ * Number of bytes in the file of the current transfer
+ */
+static int transferSize;
+
+/**
+ * Number of bytes of the file that have been sent or received
+ */
+static int transferOffset;
+
+/**
+ * Running CRC of the bytes that have been sent or received
+ */
+static uint32_t transferCrc;
+
+/**
+ * Function that builds the next frame of an outgoing stream in transferBlock
+ *
+ * @param type Set to the type of the frame
+ * @param length Set to the number of bytes in the payload
+ *
+ * @return 1 if a frame was built, 0 if the stream has ended, or -1 if the stream must be aborted
+ */
+typedef int (*stream_source)(uint8_t* type, uint16_t* length);
+
+/**
+ * Function that handles the next frame of an incoming stream, held in the decoder
+ *
+ * @return 1 to keep receiving, 0 if this was the last frame of the stream, or -1 if the stream must be aborted
+ */
+typedef int (*stream_sink)();
+
+/**
+ * Reads a byte from the serial monitor, waiting at most the given time
+ *
+ * @param timeout The maximum number of milliseconds to wait for a byte
+ *
+ * @return the byte read (0 - 255), or -1 if no byte arrived in time
+ */
+int serialReadByte(unsigned long timeout) {
+	unsigned long start = millis();
+	while (fcount(stdin) <= 0) {
+		if (millis() - start >= timeout) {
+			return -1;
+		}
+		delay(1);
+	}
+	return fgetc(stdin) & 0xFF;
+}
+
+/**
+ * Sends a control frame (ACK, NAK or ABORT) with no payload to the computer
+ *
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ */
+static void sendControlFrame(uint8_t type, uint8_t seq) {
+	uint8_t frame[FRAME_HEADER_LENGTH + FRAME_CRC_LENGTH];
+	size_t frameLength = frameEncode(frame, type, seq, NULL, 0);
+	fwrite(frame, 1, frameLength, stdout);
+}
+
+/**
+ * Waits for the next frame from the computer
+ *
+ * @param timeout The maximum number of milliseconds to wait
+ *
+ * @return FRAME_READY or FRAME_CORRUPT if a frame arrived, or FRAME_INCOMPLETE if the time ran out
+ */
+static int receiveFrame(unsigned long timeout) {
+	unsigned long start = millis();
+	while (true) {
+		unsigned long elapsed = millis() - start;
+		if (elapsed >= timeout) {
+			return FRAME_INCOMPLETE;
+		}
+		int c = serialReadByte(timeout - elapsed);
+		if (c < 0) {
+			return FRAME_INCOMPLETE;
+		}
+		int result = frameDecoderFeed(&decoder, c);
+		if (result != FRAME_INCOMPLETE) {
+			return result;
+		}
+	}
+}
+
+/**
+ * Sends a stream of frames, keeping up to TRANSFER_WINDOW of them in flight
+ *
+ * @param source The function that builds each frame of the stream
+ *
+ * @return true if every frame was acknowledged, false if the stream was aborted or the computer stopped responding
+ */
+static bool sendStream(stream_source source) {
+	uint8_t base = 0;
+	uint8_t next = 0;
+	bool ended = false;
+	int retries = 0;
+
+	frameDecoderReset(&decoder);
+	while (true) {
+		while (!ended && (uint8_t) (next - base) < TRANSFER_WINDOW) {
+			uint8_t type;
+			uint16_t length;
+			int built = source(&type, &length);
+			if (built < 0) {
+				sendControlFrame(FRAME_ABORT, next);
+				return false;
+			} else if (built == 0) {
+				ended = true;
+				break;
+			}
+			int index = next % TRANSFER_WINDOW;
+			windowLengths[index] = frameEncode(windowFrames[index], type, next, transferBlock, length);
+			fwrite(windowFrames[index], 1, windowLengths[index], stdout);
+			next++;
+		}
+		if (ended && base == next) {
+			return true;
+		}
+
+		int result = receiveFrame(TRANSFER_ACK_TIMEOUT);
+		if (result == FRAME_READY && decoder.type == FRAME_ABORT) {
+			return false;
+		} else if (result == FRAME_READY && decoder.type == FRAME_ACK) {
+			if ((uint8_t) (decoder.seq - base) < (uint8_t) (next - base)) {
+				base = decoder.seq + 1;
+				retries = 0;
+			}
+			continue;
+		} else if (result == FRAME_READY && decoder.type == FRAME_NAK) {
+			// Everything before the NAKed frame has arrived
+			if ((uint8_t) (decoder.seq - base) <= (uint8_t) (next - base)) {
+				base = decoder.seq;
+			}
+		} else if (result != FRAME_INCOMPLETE) {
+			continue;
+		}
+
+		if (++retries > TRANSFER_MAX_RETRIES) {
+			sendControlFrame(FRAME_ABORT, next);
+			return false;
+		}
+		for (uint8_t seq = base; seq != next; seq++) {
+			fwrite(windowFrames[seq % TRANSFER_WINDOW], 1, windowLengths[seq % TRANSFER_WINDOW], stdout);
+		}
+	}
+}
+
+/**
+ * Receives a stream of frames, handing each one to the sink in order
+ *
+ * @param sink The function that handles each frame
+ * @param timeout The number of milliseconds to wait for the first frame
+ *
+ * @return true if the sink accepted the whole stream, false if it was aborted or the computer stopped sending
+ */
+static bool receiveStream(stream_sink sink, unsigned long timeout) {
+	uint8_t expected = 0;
+	bool nakSent = false;
+
+	frameDecoderReset(&decoder);
+	while (true) {
+		int result = receiveFrame(timeout);
+		if (result == FRAME_INCOMPLETE) {
+			printf("Timed out waiting for frame %d.\n", expected);
+			return false;
+		} else if (result == FRAME_CORRUPT) {
+			if (!nakSent) {
+				sendControlFrame(FRAME_NAK, expected);
+				nakSent = true;
+			}
+			continue;
+		} else if (decoder.type == FRAME_ABORT) {
+			printf("Transfer aborted by computer.\n");
+			return false;
+		} else if (decoder.type == FRAME_ACK || decoder.type == FRAME_NAK) {
+			// A late answer to the stream this robot sent before
+			continue;
+		} else if (decoder.seq != expected) {
+			if ((uint8_t) (decoder.seq - expected) < 128) {
+				// A frame was lost, so everything after it has to be sent again
+				if (!nakSent) {
+					sendControlFrame(FRAME_NAK, expected);
+					nakSent = true;
+				}
+			} else {
+				// The acknowledgement was lost, so the computer sent an old frame again
+				sendControlFrame(FRAME_ACK, expected - 1);
+			}
+			continue;
+		}
+
+		int handled = sink();
+		if (handled < 0) {
+			sendControlFrame(FRAME_ABORT, expected);
+			return false;
+		}
+		sendControlFrame(FRAME_ACK, expected);
+		expected++;
+		nakSent = false;
+		timeout = TRANSFER_ACK_TIMEOUT * (TRANSFER_MAX_RETRIES + 1);
+
+		if (handled == 0) {
+			// Answer the last frame again if its acknowledgement was lost; the computer sends it
+			// again every TRANSFER_ACK_TIMEOUT, so waiting twice as long is sure to see it
+			while (receiveFrame(2 * TRANSFER_ACK_TIMEOUT) == FRAME_READY) {
+				sendControlFrame(FRAME_ACK, expected - 1);
+			}
+			return true;
+		}
+	}
+}
+
+/**
+ * Builds the frames of a single slot upload: BEGIN, the data blocks, then END
+ */
+static int uploadSource(uint8_t* type, uint16_t* length) {
+	if (transferOffset < 0) {
+		int nameLength = strlen(transferFilename);
+		transferBlock[0] = transferSize & 0xFF;
+		transferBlock[1] = transferSize >> 8;
+		memcpy(transferBlock + 2, transferFilename, nameLength);
+		*type = FRAME_BEGIN;
+		*length = 2 + nameLength;
+		transferOffset = 0;
+	} else if (transferOffset < transferSize) {
+		int blockLength = MIN(TRANSFER_BLOCK_SIZE, transferSize - transferOffset);
+		if (fread(transferBlock, 1, blockLength, transferFile) != blockLength) {
+			printf("Reading from autonomous file failed. \n");
+			return -1;
+		}
+		transferCrc = frameCrc16(transferCrc, transferBlock, blockLength);
+		*type = FRAME_DATA;
+		*length = blockLength;
+		transferOffset += blockLength;
+	} else if (transferOffset == transferSize) {
+		transferBlock[0] = transferCrc & 0xFF;
+		transferBlock[1] = (transferCrc >> 8) & 0xFF;
+		*type = FRAME_END;
+		*length = 2;
+		transferOffset++;
+	} else {
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * Sends an autonomous slot to the computer as binary frames
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if every frame was acknowledged by the computer, false otherwise
+ */
+bool uploadAutonBinary(int slot) {
+	if (!getAutonFilename(slot, transferFilename, sizeof(transferFilename))) {
+		printf("Invalid autonomous selection.\n");
+		lcdSetText(LCD_PORT, 1, "Invalid slot!");
+		return false;
+	}
+
+	transferFile = fopen(transferFilename, "r");
+	if (transferFile == NULL) {
+		printf("Reading from autonomous file failed. \n");
+		lcdSetText(LCD_PORT, 1, "Failed to open!");
+		return false;
+	}
+	lcdSetText(LCD_PORT, 1, "Uploading (bin)");
+	lcdSetText(LCD_PORT, 2, transferFilename);
+
+	transferSize = fcount(transferFile);
+	transferOffset = -1;
+	transferCrc = 0xFFFF;
+	bool success = sendStream(&uploadSource);
+	fclose(transferFile);
+
+	lcdSetText(LCD_PORT, 1, success ? "Uploaded!" : "Upload failed!");
+	return success;
+}
+
+/**
+ * Handles the frames of a single slot download, writing each block to flash as it arrives
+ */
+static int downloadSink() {
+	if (decoder.type == FRAME_BEGIN && transferOffset < 0 && decoder.length >= 2) {
+		transferSize = decoder.payload[0] | (decoder.payload[1] << 8);
+		if (transferSize != AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE) {
+			printf("Autonomous file has the wrong size (%d bytes).\n", transferSize);
+			return -1;
+		}
+		transferOffset = 0;
+		return 1;
+	} else if (decoder.type == FRAME_DATA && transferOffset >= 0 && transferOffset + decoder.length <= transferSize) {
+		// The payload buffer of the decoder is the only copy of the block between serial and flash
+		if (fwrite(decoder.payload, 1, decoder.length, transferFile) != decoder.length) {
+			printf("Writing to autonomous file failed. \n");
+			return -1;
+		}
+		transferCrc = frameCrc16(transferCrc, decoder.payload, decoder.length);
+		transferOffset += decoder.length;
+		lcdPrint(LCD_PORT, 2, "%s %d/%d", transferFilename, transferOffset, transferSize);
+		return 1;
+	} else if (decoder.type == FRAME_END && transferOffset == transferSize && decoder.length >= 2 &&
+			(decoder.payload[0] | (decoder.payload[1] << 8)) == transferCrc) {
+		return 0;
+	}
+	printf("Unexpected frame %c %d.\n", decoder.type, decoder.seq);
+	return -1;
+}
+
+/**
+ * Receives an autonomous slot from the computer as binary frames
+ * The file is written to flash as each block arrives; the loaded autonomous is not changed.
+ *
+ * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ *
+ * @return true if a full autonomous was received and saved, false otherwise
+ */
+bool downloadAutonBinary(int slot) {
+	motorFrameStopAll();
+
+	if (!getAutonFilename(slot, transferFilename, sizeof(transferFilename))) {
+		printf("Invalid autonomous selection.\n");
+		lcdSetText(LCD_PORT, 1, "Invalid slot!");
+		return false;
+	}
+
+	transferFile = fopen(transferFilename, "w");
+	if (transferFile == NULL) {
+		printf("Writing to autonomous file failed. \n");
+		lcdSetText(LCD_PORT, 1, "Failed to open!");
+		return false;
+	}
+	// The companions belong to the recording being replaced, and the computer does not send them
+	deleteAutonCompanions(slot);
+	printf("Waiting for binary autonomous file...\n");
+	lcdSetText(LCD_PORT, 1, "Waiting (bin)...");
+	lcdSetText(LCD_PORT, 2, transferFilename);
+
+	transferOffset = -1;
+	transferCrc = 0xFFFF;
+	bool success = receiveStream(&downloadSink, TRANSFER_START_TIMEOUT);
+	fclose(transferFile);
+
+	if (!success) {
+		// A partial file would play back as a truncated routine, so do not leave one behind
+		fdelete(transferFilename);
+		lcdSetText(LCD_PORT, 1, "Download failed!");
+		return false;
+	}
+	printf("Completed saving autonomous to file %s.\n", transferFilename);
+	lcdSetText(LCD_PORT, 1, "Downloaded!");
+	if (slot == autonLoaded) {
+		printf("Slot %d is loaded; load it again to use the new file.\n", slot);
+	}
+	return true;
+}
+
+/**
+ * Gets the recorder slot number of a slot index used in a sync session
+ *
+ * @param index A slot index from 0 to SYNC_NUM_SLOTS - 1
+ *
+ * @return the slot number (1 - 10 for a1 - a10, -1 to -4 for p0 - p3)
+ */
+int syncIndexToSlot(int index) {
+	return (index < MAX_AUTON_SLOTS) ? index + 1 : MAX_AUTON_SLOTS - 1 - index;
+}
+
+/**
+ * The action planned for each slot in the current sync session
+ */
+static uint8_t syncActions[SYNC_NUM_SLOTS];
+
+/**
+ * The size of each slot the computer is sending in the current sync session
+ */
+static int syncSizes[SYNC_NUM_SLOTS];
+
+/**
+ * The CRC of each slot the computer is sending in the current sync session
+ */
+static uint32_t syncCrcs[SYNC_NUM_SLOTS];
+
+/**
+ * The slot currently being sent or received in a sync session, or -1 if there is none
+ */
+static int syncIndex;
+
+/**
+ * The number of planned slots that could not be transferred
+ */
+static int syncFailures;
+
+/**
+ * Builds the manifest frame listing the size and CRC of every slot
+ */
+static int manifestSource(uint8_t* type, uint16_t* length) {
+	if (syncIndex >= 0) {
+		return 0;
+	}
+
+	// The end of the payload buffer is free while the manifest is built, so read the files through it
+	uint8_t* readBuffer = transferBlock + SYNC_NUM_SLOTS * SYNC_ENTRY_SIZE;
+	int readBufferSize = FRAME_MAX_PAYLOAD - SYNC_NUM_SLOTS * SYNC_ENTRY_SIZE;
+	for (int index = 0; index < SYNC_NUM_SLOTS; index++) {
+		uint8_t* entry = transferBlock + index * SYNC_ENTRY_SIZE;
+		uint8_t state = SYNC_EMPTY;
+		int size = 0;
+		uint32_t crc = 0;
+
+		getAutonFilename(syncIndexToSlot(index), transferFilename, sizeof(transferFilename));
+		FILE* autonFile = fopen(transferFilename, "r");
+		if (autonFile != NULL) {
+			state = SYNC_PRESENT;
+			int read;
+			while ((read = fread(readBuffer, 1, readBufferSize, autonFile)) > 0) {
+				crc = frameCrc32(crc, readBuffer, read);
+				size += read;
+			}
+			fclose(autonFile);
+		}
+
+		entry[0] = index;
+		entry[1] = state;
+		entry[2] = size & 0xFF;
+		entry[3] = size >> 8;
+		for (int i = 0; i < 4; i++) {
+			entry[4 + i] = (crc >> (8 * i)) & 0xFF;
+		}
+	}
+	*type = FRAME_MANIFEST;
+	*length = SYNC_NUM_SLOTS * SYNC_ENTRY_SIZE;
+	syncIndex = 0;
+	return 1;
+}
+
+/**
+ * Closes the slot being received in a sync session and checks that it arrived intact
+ */
+static void finishSyncReceive() {
+	if (syncIndex < 0 || transferFile == NULL) {
+		return;
+	}
+	fclose(transferFile);
+	transferFile = NULL;
+	if (transferOffset != syncSizes[syncIndex] || transferCrc != syncCrcs[syncIndex]) {
+		printf("Slot %s did not arrive intact, removing it.\n", transferFilename);
+		fdelete(transferFilename);
+		syncFailures++;
+	} else {
+		printf("Received %s (%d bytes).\n", transferFilename, transferOffset);
+	}
+	syncActions[syncIndex] = SYNC_EMPTY;
+}
+
+/**
+ * Handles the plan and the slots sent by the computer in a sync session
+ */
+static int syncReceiveSink() {
+	if (decoder.type == FRAME_PLAN) {
+		for (int i = 0; i + SYNC_ENTRY_SIZE <= decoder.length; i += SYNC_ENTRY_SIZE) {
+			uint8_t* entry = decoder.payload + i;
+			if (entry[0] >= SYNC_NUM_SLOTS) {
+				return -1;
+			}
+			int size = entry[2] | (entry[3] << 8);
+			// Refused before any slot is touched, as downloadSink() refuses a single slot
+			if (entry[1] == SYNC_RECEIVE && size != AUTON_TIME * JOY_POLL_FREQ * AUTON_STATE_SIZE) {
+				printf("Autonomous file %d has the wrong size (%d bytes).\n", entry[0], size);
+				return -1;
+			}
+			syncActions[entry[0]] = entry[1];
+			syncSizes[entry[0]] = size;
+			syncCrcs[entry[0]] = entry[4] | (entry[5] << 8) | ((uint32_t) entry[6] << 16) | ((uint32_t) entry[7] << 24);
+		}
+		return 1;
+	} else if (decoder.type == FRAME_DATA && decoder.length >= SYNC_DATA_HEADER) {
+		int index = decoder.payload[0];
+		int offset = decoder.payload[1] | (decoder.payload[2] << 8);
+		int length = decoder.length - SYNC_DATA_HEADER;
+		if (index >= SYNC_NUM_SLOTS || syncActions[index] != SYNC_RECEIVE || offset + length > syncSizes[index]) {
+			return -1;
+		}
+		if (index != syncIndex) {
+			finishSyncReceive();
+			syncIndex = index;
+			transferOffset = 0;
+			transferCrc = 0;
+			getAutonFilename(syncIndexToSlot(index), transferFilename, sizeof(transferFilename));
+			transferFile = fopen(transferFilename, "w");
+			if (transferFile == NULL) {
+				printf("Writing to autonomous file failed. \n");
+				return -1;
+			}
+			deleteAutonCompanions(syncIndexToSlot(index));
+			lcdPrint(LCD_PORT, 2, "Receiving %s", transferFilename);
+		}
+		if (offset != transferOffset || fwrite(decoder.payload + SYNC_DATA_HEADER, 1, length, transferFile) != length) {
+			return -1;
+		}
+		transferCrc = frameCrc32(transferCrc, decoder.payload + SYNC_DATA_HEADER, length);
+		transferOffset += length;
+		return 1;
+	} else if (decoder.type == FRAME_END) {
+		finishSyncReceive();
+		return 0;
+	}
+	return -1;
+}
+
+/**
+ * Builds the data frames of every slot the computer asked for in a sync session, then END
+ */
+static int syncSendSource(uint8_t* type, uint16_t* length) {
+	while (transferFile == NULL || transferOffset >= transferSize) {
+		if (transferFile != NULL) {
+			fclose(transferFile);
+			transferFile = NULL;
+			syncIndex++;
+		}
+		while (syncIndex < SYNC_NUM_SLOTS && syncActions[syncIndex] != SYNC_SEND) {
+			syncIndex++;
+		}
+		if (syncIndex > SYNC_NUM_SLOTS) {
+			return 0;
+		} else if (syncIndex == SYNC_NUM_SLOTS) {
+			*type = FRAME_END;
+			*length = 0;
+			syncIndex++;
+			return 1;
+		}
+
+		getAutonFilename(syncIndexToSlot(syncIndex), transferFilename, sizeof(transferFilename));
+		transferFile = fopen(transferFilename, "r");
+		if (transferFile == NULL) {
+			printf("Reading from autonomous file %s failed. \n", transferFilename);
+			return -1;
+		}
+		transferSize = fcount(transferFile);
+		transferOffset = 0;
+		lcdPrint(LCD_PORT, 2, "Sending %s", transferFilename);
+	}
+
+	int blockLength = MIN(TRANSFER_BLOCK_SIZE, transferSize - transferOffset);
+	transferBlock[0] = syncIndex;
+	transferBlock[1] = transferOffset & 0xFF;
+	transferBlock[2] = transferOffset >> 8;
+	if (fread(transferBlock + SYNC_DATA_HEADER, 1, blockLength, transferFile) != blockLength) {
+		printf("Reading from autonomous file %s failed. \n", transferFilename);
+		return -1;
+	}
+	*type = FRAME_DATA;
+	*length = SYNC_DATA_HEADER + blockLength;
+	transferOffset += blockLength;
+	return 1;
+}
+
+/**
+ * Runs a sync session with the computer
+ * The robot sends a manifest of every slot with its size and CRC, the computer answers with a plan
+ * followed by the slots it is sending, and the robot then sends the slots the computer asked for.
+ * Only slots that differ need to appear in the plan, and each direction is a single pipelined stream.
+ * Only the autonomous files are exchanged: a slot that is received or removed loses its track,
+ * voltage, heights and headings files, and a plan to receive a file of the wrong size is refused.
+ *
+ * @return true if every planned slot was transferred, false otherwise
+ */
+bool syncAutonSlots() {
+	motorFrameStopAll();
+	lcdSetText(LCD_PORT, 1, "Syncing...");
+	lcdSetText(LCD_PORT, 2, "");
+	memset(syncActions, SYNC_EMPTY, sizeof(syncActions));
+	syncFailures = 0;
+	transferFile = NULL;
+
+	syncIndex = -1;
+	bool success = sendStream(&manifestSource);
+
+	syncIndex = -1;
+	success = success && receiveStream(&syncReceiveSink, TRANSFER_START_TIMEOUT);
+	if (transferFile != NULL) {
+		fclose(transferFile);
+		fdelete(transferFilename);
+		transferFile = NULL;
+	}
+
+	int removed = 0;
+	for (int index = 0; success && index < SYNC_NUM_SLOTS; index++) {
+		if (syncActions[index] == SYNC_RECEIVE && syncSizes[index] > 0) {
+			syncFailures++;
+		} else if (syncActions[index] == SYNC_REMOVE) {
+			getAutonFilename(syncIndexToSlot(index), transferFilename, sizeof(transferFilename));
+			fdelete(transferFilename);
+			deleteAutonCompanions(syncIndexToSlot(index));
+			removed++;
+		}
+	}
+
+	syncIndex = 0;
+	success = success && sendStream(&syncSendSource);
+	if (transferFile != NULL) {
+		fclose(transferFile);
+		transferFile = NULL;
+	}
+
+	printf("Sync finished: %d removed, %d failed.\n", removed, syncFailures);
+	success = success && syncFailures == 0;
+	lcdSetText(LCD_PORT, 1, success ? "Synced!" : "Sync failed!");
+	return success;
+}
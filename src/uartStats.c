@@ -0,0 +1,128 @@
+/** @file uartStats.c
+ * @brief File for counting the bytes sent over each serial link
+ *
+ * The queue is a model: the bytes written so far, less what the link could have sent at its line
+ * rate since. It only needs micros(), so the Cortex and the simulator measure it the same way.
+ * The LCD has no queue, as its counts are lines set rather than bytes sent.
+ */
+
+#include "main.h"
+
+uart_stats uartStats[UART_PORTS] = {
+	{ .name = "lcd lines", .baud = 0 },
+	{ .name = "telemetry", .baud = 115200 },
+	{ .name = "stdout", .baud = 115200 },
+};
+
+/**
+ * Gets the counters of a serial link
+ *
+ * @param port uart1, uart2 or stdout
+ *
+ * @return the counters, or NULL if the stream is not a serial link
+ */
+static uart_stats* getStats(FILE* port) {
+	if (port == uart1) {
+		return &uartStats[0];
+	} else if (port == uart2) {
+		return &uartStats[1];
+	} else if (port == stdout) {
+		return &uartStats[2];
+	}
+	return NULL;
+}
+
+/**
+ * Moves a link's counters forward to the current time: drains its queue at the line rate and
+ * starts a new second if one has begun
+ *
+ * @param stats The counters
+ */
+static void advance(uart_stats* stats) {
+	unsigned long now = micros();
+	unsigned long drained = (unsigned long) ((uint64_t) (now - stats->drainedAt) * stats->baud / 10000000);
+	if (drained > 0) {
+		// Only whole bytes are drained, so the time of the rest carries over
+		stats->queued = (drained >= stats->queued) ? 0 : stats->queued - drained;
+		stats->drainedAt += (unsigned long) ((uint64_t) drained * 10000000 / stats->baud);
+	}
+	if (stats->queued == 0) {
+		stats->drainedAt = now;
+	}
+
+	unsigned long second = millis() / 1000;
+	if (second != stats->second) {
+		stats->lastSecondBytes = (second == stats->second + 1) ? stats->secondBytes : 0;
+		stats->second = second;
+		stats->secondBytes = 0;
+	}
+}
+
+/**
+ * Counts bytes written to a serial link
+ *
+ * @param port uart1, uart2 or stdout; other streams (flash files) are ignored
+ * @param bytes The number of bytes written, or of lines set for the LCD
+ */
+void uartCount(FILE* port, unsigned int bytes) {
+	uart_stats* stats = getStats(port);
+	if (stats == NULL) {
+		return;
+	}
+	advance(stats);
+	stats->bytes += bytes;
+	stats->secondBytes += bytes;
+	if (stats->secondBytes > stats->peakSecondBytes) {
+		stats->peakSecondBytes = stats->secondBytes;
+	}
+	// The LCD's lines are sent by PROS at its own pace, so nothing queues behind them here
+	if (stats->baud == 0) {
+		return;
+	}
+	stats->queued += bytes;
+	if (stats->queued > stats->peakQueued) {
+		stats->peakQueued = stats->queued;
+	}
+}
+
+/**
+ * Sets every counter back to zero
+ */
+void uartStatsReset() {
+	for (int i = 0; i < UART_PORTS; i++) {
+		uart_stats* stats = &uartStats[i];
+		stats->bytes = 0;
+		stats->second = millis() / 1000;
+		stats->secondBytes = 0;
+		stats->lastSecondBytes = 0;
+		stats->peakSecondBytes = 0;
+		stats->queued = 0;
+		stats->peakQueued = 0;
+		stats->drainedAt = micros();
+	}
+}
+
+/**
+ * Prints the bytes, throughput, busiest second and deepest queue of each link to the serial monitor,
+ * and the lines set on the LCD
+ */
+void printUartStats() {
+	// Read every link before printing, so that this report's own output is not in the figures
+	uart_stats copies[UART_PORTS];
+	for (int i = 0; i < UART_PORTS; i++) {
+		advance(&uartStats[i]);
+		copies[i] = uartStats[i];
+	}
+	printf("%-10s %10s %8s %8s %8s %6s %8s\n", "link", "bytes", "last s", "peak s", "capacity", "peak%", "queue");
+	for (int i = 0; i < UART_PORTS; i++) {
+		uart_stats* stats = &copies[i];
+		if (stats->baud == 0) {
+			printf("%-10s %10lu %8lu %8lu %8s %6s %8s\n", stats->name, stats->bytes, stats->lastSecondBytes,
+					stats->peakSecondBytes, "-", "-", "-");
+			continue;
+		}
+		unsigned int capacity = stats->baud / 10;
+		printf("%-10s %10lu %8lu %8lu %8u %5lu%% %8lu\n", stats->name, stats->bytes, stats->lastSecondBytes,
+				stats->peakSecondBytes, capacity, stats->peakSecondBytes * 100 / capacity, stats->peakQueued);
+	}
+}
@@ -0,0 +1,87 @@
+/** @file uartWrap.c
+ * @brief File for counting the bytes that the PROS library sends over the serial links
+ *
+ * The linker sends every call to the functions below to __wrap_<name> (the --wrap flags in
+ * common.mk), which counts the bytes with uartCount() and calls the PROS function __real_<name>.
+ * printf() and the other formatted functions in the PROS library write through fputc(), so
+ * wrapping it counts them too. The LCD functions count the lines they set rather than bytes, as
+ * PROS sends the LCD's frames itself; lcdPrint() and lcdClear() set the lines without calling the
+ * wrapped lcdSetText(), so they are wrapped as well.
+ *
+ * The simulator counts the same bytes in its PROS functions, so this file is only built for the Cortex.
+ */
+
+#include "main.h"
+#include <stdarg.h>
+
+int __real_fputc(int value, FILE* stream);
+size_t __real_fwrite(const void* ptr, size_t size, size_t count, FILE* stream);
+void __real_lcdSetText(FILE* lcdPort, unsigned char line, const char* buffer);
+void __real_lcdClear(FILE* lcdPort);
+int vsnprintf(char* buffer, size_t limit, const char* format, va_list args);
+
+/**
+ * Counts a character written to a stream and writes it
+ *
+ * @param value The character
+ * @param stream The stream to write to
+ *
+ * @return the character written, or EOF on failure
+ */
+int __wrap_fputc(int value, FILE* stream) {
+	uartCount(stream, 1);
+	return __real_fputc(value, stream);
+}
+
+/**
+ * Counts the bytes of a block written to a stream and writes it
+ *
+ * @param ptr The data to write
+ * @param size The size of each item
+ * @param count The number of items
+ * @param stream The stream to write to
+ *
+ * @return the number of items written
+ */
+size_t __wrap_fwrite(const void* ptr, size_t size, size_t count, FILE* stream) {
+	uartCount(stream, size * count);
+	return __real_fwrite(ptr, size, count, stream);
+}
+
+/**
+ * Counts a line set on the LCD and sets it
+ *
+ * @param lcdPort The port of the LCD
+ * @param line The line to set, 1 or 2
+ * @param buffer The text to show
+ */
+void __wrap_lcdSetText(FILE* lcdPort, unsigned char line, const char* buffer) {
+	uartCount(lcdPort, 1);
+	__real_lcdSetText(lcdPort, line, buffer);
+}
+
+/**
+ * Formats a line of the LCD and sets it through __wrap_lcdSetText(), so it is counted once
+ *
+ * @param lcdPort The port of the LCD
+ * @param line The line to set, 1 or 2
+ * @param formatString The printf() format of the text
+ */
+void __wrap_lcdPrint(FILE* lcdPort, unsigned char line, const char* formatString, ...) {
+	char text[LCD_MESSAGE_MAX_LENGTH + 1];
+	va_list args;
+	va_start(args, formatString);
+	vsnprintf(text, sizeof(text), formatString, args);
+	va_end(args);
+	__wrap_lcdSetText(lcdPort, line, text);
+}
+
+/**
+ * Counts the two lines that clearing the LCD sets and clears it
+ *
+ * @param lcdPort The port of the LCD
+ */
+void __wrap_lcdClear(FILE* lcdPort) {
+	uartCount(lcdPort, 2);
+	__real_lcdClear(lcdPort);
+}